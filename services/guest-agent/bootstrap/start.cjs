@@ -0,0 +1,53 @@
+"use strict";
+// Entry point of the bundled guest agent in the guest image.
+//
+// agent.cjs is the whole agent (Fastify and its dependencies included) in one CommonJS file, so
+// boot does a single read instead of resolving and compiling hundreds of node_modules files.
+// agent.cjs.cache is a V8 code cache produced at image build time by the same node binary with
+// the same flags (`--build-code-cache`); V8 validates it and silently recompiles on mismatch.
+const fs = require("node:fs");
+const path = require("node:path");
+const vm = require("node:vm");
+const Module = require("node:module");
+
+const bundlePath = path.join(__dirname, "agent.cjs");
+const cachePath = `${bundlePath}.cache`;
+const buildCache = process.argv.includes("--build-code-cache");
+
+let cachedData;
+if (!buildCache) {
+  try {
+    cachedData = fs.readFileSync(cachePath);
+  } catch {
+    // No cache shipped; compile from source.
+  }
+}
+
+const script = new vm.Script(Module.wrap(fs.readFileSync(bundlePath, "utf8")), {
+  filename: bundlePath,
+  cachedData
+});
+if (cachedData && script.cachedDataRejected) {
+  console.warn("[guest-agent] code cache rejected (node binary or flags changed); compiling from source");
+}
+
+if (buildCache) {
+  // Run the agent's warmup path (build the app, no side effects) so functions compiled lazily
+  // during startup are in the cache too, then write it once the event loop drains.
+  process.env.RDS_AGENT_WARMUP = "1";
+  process.once("beforeExit", () => {
+    fs.writeFileSync(cachePath, script.createCachedData());
+    console.info("[guest-agent] wrote code cache", { path: cachePath });
+  });
+}
+
+const agentModule = new Module(bundlePath, module);
+agentModule.filename = bundlePath;
+agentModule.paths = Module._nodeModulePaths(__dirname);
+script.runInThisContext()(
+  agentModule.exports,
+  Module.createRequire(bundlePath),
+  agentModule,
+  bundlePath,
+  __dirname
+);
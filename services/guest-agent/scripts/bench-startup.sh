@@ -0,0 +1,32 @@
+#!/bin/sh
+# Compare guest agent startup: tsc output + node_modules vs. the single-file bundle, with and
+# without its V8 code cache. Each run uses the agent's warmup mode (build the Fastify app, no side
+# effects) and reports `startupMs`, the time from process start until the app is ready.
+#
+# Run from services/guest-agent after `npm run build` and the bundle step (see the guest image
+# Dockerfile), e.g. `sh scripts/bench-startup.sh 10`.
+set -eu
+
+RUNS=${1:-10}
+BUNDLE_DIR=${BUNDLE_DIR:-bundle}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+median_startup() {
+  label=$1
+  shift
+  i=0
+  : >"$WORK/samples"
+  while [ "$i" -lt "$RUNS" ]; do
+    RDS_AGENT_WARMUP=1 node --expose-gc "$@" 2>/dev/null \
+      | sed -n 's/.*startupMs: \([0-9]*\).*/\1/p' >>"$WORK/samples"
+    i=$((i + 1))
+  done
+  printf '%-28s median startupMs=%s (runs=%s)\n' "$label" "$(sort -n "$WORK/samples" | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }')" "$RUNS"
+}
+
+cp "$BUNDLE_DIR/agent.cjs" "$BUNDLE_DIR/start.cjs" "$WORK/"
+median_startup "dist + node_modules" dist/index.js
+median_startup "bundle, no code cache" "$WORK/start.cjs"
+node --expose-gc "$WORK/start.cjs" --build-code-cache >/dev/null
+median_startup "bundle + code cache" "$WORK/start.cjs"
@@ -1,8 +1,28 @@
-import type { FastifyPluginAsync } from "fastify";
+import type { FastifyPluginAsync, FastifyReply } from "fastify";
 import { Readable } from "node:stream";
-import type { ExecRequest, NetConfigRequest, RunJsRequest, RunTsRequest, TimeSyncRequest } from "../types/agent.js";
+import type {
+  CheckpointCreateRequest,
+  EntropySeedRequest,
+  ExecRequest,
+  NetConfigRequest,
+  RunJsRequest,
+  RunTsRequest,
+  SnapshotPrepareRequest,
+  TimeSyncRequest
+} from "../types/agent.js";
 import type { ExecRunner, FileService, FirewallManager, NetworkConfigurator } from "../types/interfaces.js";
 import { syncSystemTime } from "../time/timeSync.js";
+import { prepareForSnapshot } from "../snapshot/snapshotPrepare.js";
+import { addEntropySeed } from "../entropy/entropySeed.js";
+import { resetForNextTenant } from "../recycle/tenantReset.js";
+import { readGuestStats } from "../stats/guestStats.js";
+import {
+  CheckpointError,
+  createCheckpoint,
+  listCheckpoints,
+  rollbackToCheckpoint
+} from "../checkpoint/workspaceCheckpoints.js";
+import { MAX_RAW_WRITE_BYTES } from "../files/rawFile.js";
 
 export interface ApiPluginOptions {
   execRunner: ExecRunner;
@@ -15,7 +35,8 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
   const BODY_LIMITS = {
     json: 256 * 1024,
     uploadCompressed: 10 * 1024 * 1024,
-    internalReplaceTreeCompressed: 100 * 1024 * 1024
+    internalReplaceTreeCompressed: 100 * 1024 * 1024,
+    rawFile: MAX_RAW_WRITE_BYTES
   };
 
   app.get("/health", async () => ({ status: "ok" }));
@@ -45,6 +66,58 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     reply.code(204);
   });
 
+  app.post("/entropy/seed", { bodyLimit: BODY_LIMITS.json }, async (request, reply) => {
+    const payload = request.body as EntropySeedRequest;
+    try {
+      await addEntropySeed(payload?.seedHex);
+    } catch (err) {
+      reply.code(400);
+      const detail = String((err as any)?.message ?? err);
+      return { message: "Invalid entropy seed", detail: detail.slice(0, 500) };
+    }
+    reply.code(204);
+  });
+
+  // Called by the manager right before it pauses the VM for a memory snapshot.
+  app.post("/snapshot/prepare", { bodyLimit: BODY_LIMITS.json }, async (request) => {
+    const payload = (request.body ?? {}) as SnapshotPrepareRequest;
+    return prepareForSnapshot(payload);
+  });
+
+  app.get("/stats", async () => readGuestStats());
+
+  app.get("/checkpoints", async () => ({ checkpoints: await listCheckpoints() }));
+
+  app.post("/checkpoints", { bodyLimit: BODY_LIMITS.json }, async (request, reply) => {
+    const payload = (request.body ?? {}) as CheckpointCreateRequest;
+    try {
+      reply.code(201);
+      return await createCheckpoint(payload.label);
+    } catch (err) {
+      return sendCheckpointError(reply, err, "Checkpoint failed");
+    }
+  });
+
+  app.post("/checkpoints/:id/rollback", { bodyLimit: BODY_LIMITS.json }, async (request, reply) => {
+    const { id } = request.params as { id: string };
+    try {
+      return await rollbackToCheckpoint(id);
+    } catch (err) {
+      return sendCheckpointError(reply, err, "Rollback failed");
+    }
+  });
+
+  // Called by the manager before handing this VM to a new tenant from the warm pool.
+  app.post("/internal/recycle", { bodyLimit: BODY_LIMITS.json }, async (_request, reply) => {
+    try {
+      return await resetForNextTenant();
+    } catch (err) {
+      reply.code(409);
+      const detail = String((err as any)?.message ?? err);
+      return { message: "Guest cannot be recycled", detail: detail.slice(0, 500) };
+    }
+  });
+
   app.post("/exec", { bodyLimit: BODY_LIMITS.json }, async (request, reply) => {
     const payload = request.body as ExecRequest;
     try {
@@ -115,6 +188,50 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     }
   });
 
+  app.get("/files/raw", async (request, reply) => {
+    const path = (request.query as { path?: string }).path ?? "";
+    if (!path) {
+      reply.code(400);
+      return { message: "path is required" };
+    }
+    const range = headerValue(request.headers.range);
+    const ifMatch = headerValue(request.headers["if-match"]);
+    try {
+      const file = await opts.fileService.readRaw(path, { range, ifMatch });
+      reply.header("accept-ranges", "bytes");
+      reply.header("etag", `"${file.sha256}"`);
+      reply.header("content-type", "application/octet-stream");
+      reply.header("content-length", String(file.end - file.start + 1));
+      if (file.partial) {
+        reply.code(206);
+        reply.header("content-range", `bytes ${file.start}-${file.end}/${file.size}`);
+      } else {
+        reply.code(200);
+      }
+      return reply.send(file.stream);
+    } catch (err) {
+      return sendFileError(reply, err, "Invalid raw file path");
+    }
+  });
+
+  app.put("/files/raw", { bodyLimit: BODY_LIMITS.rawFile }, async (request, reply) => {
+    const path = (request.query as { path?: string }).path ?? "";
+    if (!path) {
+      reply.code(400);
+      return { message: "path is required" };
+    }
+    const body = request.body as unknown;
+    const stream = Buffer.isBuffer(body) ? Readable.from([body]) : request.raw;
+    const ifMatch = headerValue(request.headers["if-match"]);
+    try {
+      const written = await opts.fileService.writeRaw(path, stream, { ifMatch, maxBytes: BODY_LIMITS.rawFile });
+      reply.header("etag", `"${written.sha256}"`);
+      return written;
+    } catch (err) {
+      return sendFileError(reply, err, "Invalid raw file write");
+    }
+  });
+
   app.post("/internal/files/replace-tree", { bodyLimit: BODY_LIMITS.internalReplaceTreeCompressed }, async (request, reply) => {
     const query = request.query as { dest?: string; ownership?: "root" | "user"; readOnly?: string } | undefined;
     const dest = query?.dest ?? "";
@@ -137,3 +254,37 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     }
   });
 };
+
+function headerValue(value: string | string[] | undefined): string | undefined {
+  if (Array.isArray(value)) return value[0];
+  return value || undefined;
+}
+
+function sendFileError(reply: FastifyReply, err: unknown, message: string) {
+  const statusCode = (err as any)?.statusCode;
+  const detail = String((err as any)?.message ?? err);
+  if (typeof statusCode === "number" && statusCode >= 400 && statusCode < 500) {
+    reply.code(statusCode);
+    if (statusCode === 416 && typeof (err as any)?.size === "number") {
+      reply.header("content-range", `bytes */${(err as any).size}`);
+    }
+    return { message: detail.slice(0, 500) };
+  }
+  if ((err as any)?.code === "ENOENT") {
+    reply.code(404);
+    return { message: "File not found" };
+  }
+  reply.code(400);
+  return { message, detail: detail.slice(0, 500) };
+}
+
+function sendCheckpointError(reply: FastifyReply, err: unknown, message: string) {
+  const detail = String((err as any)?.message ?? err);
+  if (err instanceof CheckpointError) {
+    reply.code(err.statusCode);
+    return { message: detail.slice(0, 500) };
+  }
+  // Mount/umount failures are guest-side faults, not bad requests.
+  reply.code(500);
+  return { message, detail: detail.slice(0, 500) };
+}
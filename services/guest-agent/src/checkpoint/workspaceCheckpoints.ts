@@ -0,0 +1,300 @@
+import { spawn } from "node:child_process";
+import { randomBytes } from "node:crypto";
+import { readFileSync } from "node:fs";
+import fs from "node:fs/promises";
+import path from "node:path";
+import { SANDBOX_ROOT, USER_HOME, WORKSPACE_DISK_MOUNT } from "../config/constants.js";
+import { killJailedProcesses } from "../exec/jailProcesses.js";
+import type { WorkspaceCheckpoint } from "../types/agent.js";
+
+// Layers live on a plain ext4 mount next to the data they stack over: the workspace disk when
+// present, otherwise the overlay disk (mounted by guest-init at /oldroot/mnt/overlay), outside the
+// root overlay's upper dir since overlayfs cannot use another overlayfs as upperdir.
+// guest-init mounts both disks before the agent starts, so the choice is fixed at load time.
+const OVERLAY_DISK_MOUNT = "/oldroot/mnt/overlay";
+const HAS_WORKSPACE_DISK = mountedAtLoad(WORKSPACE_DISK_MOUNT);
+const CHECKPOINT_ROOT = `${HAS_WORKSPACE_DISK ? WORKSPACE_DISK_MOUNT : OVERLAY_DISK_MOUNT}/ckpt`;
+const STATE_FILE = `${CHECKPOINT_ROOT}/state.json`;
+// The pre-checkpoint /home/user, kept reachable after the stack is mounted over it.
+const BASE_MOUNT = "/run/rds-ckpt-base";
+// Each frozen layer is one more overlayfs lowerdir; lookups walk them all.
+const MAX_CHECKPOINTS = 32;
+const SANDBOX_BINDS = [`${SANDBOX_ROOT}/home/user`, `${SANDBOX_ROOT}/workspace`];
+
+type CheckpointRecord = WorkspaceCheckpoint & {
+  /** Frozen layer ids (oldest first) that make up the workspace as of this checkpoint. */
+  layers: string[];
+};
+
+type CheckpointState = {
+  checkpoints: CheckpointRecord[];
+  /** Writable layer currently mounted as upperdir. */
+  activeLayer: string;
+};
+
+export class CheckpointError extends Error {
+  constructor(
+    readonly statusCode: number,
+    message: string
+  ) {
+    super(message);
+  }
+}
+
+let queue: Promise<unknown> = Promise.resolve();
+
+// Checkpoint operations remount /home/user; run them one at a time.
+function serialized<T>(fn: () => Promise<T>): Promise<T> {
+  const next = queue.then(fn, fn);
+  queue = next.catch(() => undefined);
+  return next;
+}
+
+export function listCheckpoints(): Promise<WorkspaceCheckpoint[]> {
+  return serialized(async () => ((await readState())?.checkpoints ?? []).map(toPublic));
+}
+
+/**
+ * Freeze the current workspace contents and continue writing into a fresh layer.
+ * Jailed processes that keep files open across the call still write to the layer they opened,
+ * so checkpoints are meant to be taken between commands.
+ */
+export function createCheckpoint(label?: string): Promise<WorkspaceCheckpoint> {
+  return serialized(async () => {
+    await requireLayerDisk();
+    const state = await readState();
+    const count = state?.checkpoints.length ?? 0;
+    if (count >= MAX_CHECKPOINTS) {
+      throw new CheckpointError(409, `checkpoint limit reached (max=${MAX_CHECKPOINTS}); roll back to free layers`);
+    }
+    if (typeof label === "string" && label.length > 200) {
+      throw new CheckpointError(400, "label must be at most 200 characters");
+    }
+    await run("sync", []);
+
+    const checkpoint: CheckpointRecord = {
+      id: newId(),
+      createdAt: new Date().toISOString(),
+      ...(label ? { label } : {}),
+      layers: state ? [...(state.checkpoints.at(-1)?.layers ?? []), state.activeLayer] : []
+    };
+    const activeLayer = await createLayer();
+    if (!state) await ensureBaseMount();
+    await mountStack(checkpoint.layers, activeLayer, state ? stackOf(state) : null).catch(async (err) => {
+      await removeLayer(activeLayer);
+      throw err;
+    });
+    await writeState({ checkpoints: [...(state?.checkpoints ?? []), checkpoint], activeLayer });
+    return toPublic(checkpoint);
+  });
+}
+
+/**
+ * Discard everything written since `checkpointId` and drop newer checkpoints. Jailed processes are
+ * killed first: they would otherwise keep reading and writing the abandoned layers.
+ */
+export function rollbackToCheckpoint(checkpointId: string): Promise<WorkspaceCheckpoint> {
+  return serialized(async () => {
+    const state = await readState();
+    const index = state?.checkpoints.findIndex((c) => c.id === checkpointId) ?? -1;
+    if (!state || index < 0) throw new CheckpointError(404, "checkpoint not found");
+    const target = state.checkpoints[index];
+
+    await killJailedProcesses();
+    const activeLayer = await createLayer();
+    // On failure the previous stack is mounted again and the new layer was never used.
+    await mountStack(target.layers, activeLayer, stackOf(state)).catch(async (err) => {
+      await removeLayer(activeLayer);
+      throw err;
+    });
+    const kept = state.checkpoints.slice(0, index + 1);
+    await writeState({ checkpoints: kept, activeLayer });
+
+    const live = new Set([...target.layers, activeLayer]);
+    await removeLayersExcept(live);
+    return toPublic(target);
+  });
+}
+
+/**
+ * Unmount the stack and delete every layer, returning /home/user to its pre-checkpoint state.
+ * Used when a VM is reset for another tenant.
+ */
+export function discardCheckpoints(): Promise<void> {
+  return serialized(async () => {
+    if (!(await readState())) return;
+    await killJailedProcesses();
+    await detachSandboxBinds();
+    if (await isMountPoint(USER_HOME)) await run("umount", ["-l", USER_HOME]);
+    if (await isMountPoint(BASE_MOUNT)) await run("umount", ["-l", BASE_MOUNT]);
+    // The stack replaced guest-init's workspace-disk bind; put it back.
+    if (HAS_WORKSPACE_DISK) await run("mount", ["--bind", `${WORKSPACE_DISK_MOUNT}/home`, USER_HOME]);
+    await bindIntoSandbox();
+    await fs.rm(CHECKPOINT_ROOT, { recursive: true, force: true });
+  });
+}
+
+/** Re-mount the layer stack after a cold boot (stop/start keeps the overlay disk, not mounts). */
+export function restoreCheckpointMounts(): Promise<void> {
+  return serialized(async () => {
+    const state = await readState();
+    if (!state || (await isOverlayMount(USER_HOME))) return;
+    await ensureBaseMount();
+    const stack = stackOf(state);
+    await mountStack(stack.frozenLayers, stack.activeLayer, null);
+  });
+}
+
+function stackOf(state: CheckpointState): { frozenLayers: string[]; activeLayer: string } {
+  return { frozenLayers: state.checkpoints.at(-1)?.layers ?? [], activeLayer: state.activeLayer };
+}
+
+/**
+ * Replace whatever is mounted on /home/user with the given layer stack. If the new mount fails,
+ * `previous` is mounted again so the workspace never silently falls back to the base layer.
+ */
+async function mountStack(
+  frozenLayers: string[],
+  activeLayer: string,
+  previous: { frozenLayers: string[]; activeLayer: string } | null
+): Promise<void> {
+  await detachSandboxBinds();
+  try {
+    if (await isMountPoint(USER_HOME)) await run("umount", ["-l", USER_HOME]);
+    try {
+      await run("mount", ["-t", "overlay", "overlay", "-o", overlayOptions(frozenLayers, activeLayer), USER_HOME]);
+    } catch (err) {
+      if (previous) {
+        await run("mount", [
+          "-t",
+          "overlay",
+          "overlay",
+          "-o",
+          overlayOptions(previous.frozenLayers, previous.activeLayer),
+          USER_HOME
+        ]).catch(() => undefined);
+      }
+      throw err;
+    }
+  } finally {
+    await bindIntoSandbox();
+  }
+}
+
+function overlayOptions(frozenLayers: string[], activeLayer: string): string {
+  // Newest frozen layer first; the original /home/user is the bottom layer.
+  const lowers = [...frozenLayers].reverse().map((id) => layerPaths(id).upper);
+  lowers.push(BASE_MOUNT);
+  const active = layerPaths(activeLayer);
+  return `lowerdir=${lowers.join(":")},upperdir=${active.upper},workdir=${active.work}`;
+}
+
+async function ensureBaseMount(): Promise<void> {
+  if (await isMountPoint(BASE_MOUNT)) return;
+  await fs.mkdir(BASE_MOUNT, { recursive: true });
+  await run("mount", ["--bind", USER_HOME, BASE_MOUNT]);
+}
+
+async function detachSandboxBinds(): Promise<void> {
+  for (const target of SANDBOX_BINDS) {
+    if (await isMountPoint(target)) await run("umount", ["-l", target]);
+  }
+}
+
+async function bindIntoSandbox(): Promise<void> {
+  for (const target of SANDBOX_BINDS) {
+    await fs.mkdir(target, { recursive: true });
+    await run("mount", ["--bind", USER_HOME, target]);
+  }
+}
+
+async function createLayer(): Promise<string> {
+  const id = newId();
+  const paths = layerPaths(id);
+  await fs.mkdir(paths.upper, { recursive: true });
+  await fs.mkdir(paths.work, { recursive: true });
+  return id;
+}
+
+async function removeLayer(id: string): Promise<void> {
+  await fs.rm(`${CHECKPOINT_ROOT}/l/${id}`, { recursive: true, force: true }).catch(() => undefined);
+}
+
+async function removeLayersExcept(live: Set<string>): Promise<void> {
+  const dir = `${CHECKPOINT_ROOT}/l`;
+  for (const id of await fs.readdir(dir).catch(() => [] as string[])) {
+    if (live.has(id)) continue;
+    await fs.rm(path.join(dir, id), { recursive: true, force: true }).catch(() => undefined);
+  }
+}
+
+function layerPaths(id: string): { upper: string; work: string } {
+  // Short paths: the whole lowerdir list must fit in one page of mount options.
+  return { upper: `${CHECKPOINT_ROOT}/l/${id}/u`, work: `${CHECKPOINT_ROOT}/l/${id}/w` };
+}
+
+function newId(): string {
+  return randomBytes(6).toString("hex");
+}
+
+function toPublic(record: CheckpointRecord): WorkspaceCheckpoint {
+  return { id: record.id, createdAt: record.createdAt, ...(record.label ? { label: record.label } : {}) };
+}
+
+async function requireLayerDisk(): Promise<void> {
+  if (!HAS_WORKSPACE_DISK && !(await isMountPoint(OVERLAY_DISK_MOUNT))) {
+    throw new CheckpointError(409, "workspace checkpoints require the overlay or workspace disk");
+  }
+}
+
+async function readState(): Promise<CheckpointState | null> {
+  try {
+    return JSON.parse(await fs.readFile(STATE_FILE, "utf-8")) as CheckpointState;
+  } catch {
+    return null;
+  }
+}
+
+async function writeState(state: CheckpointState): Promise<void> {
+  const tmp = `${STATE_FILE}.tmp`;
+  await fs.mkdir(CHECKPOINT_ROOT, { recursive: true });
+  await fs.writeFile(tmp, JSON.stringify(state), "utf-8");
+  await fs.rename(tmp, STATE_FILE);
+}
+
+async function isMountPoint(mountPoint: string): Promise<boolean> {
+  const content = await fs.readFile("/proc/self/mountinfo", "utf-8");
+  return content.split("\n").some((line) => line.split(" ")[4] === mountPoint);
+}
+
+// With a workspace disk /home/user is always a mount point (guest-init's bind); only an overlay
+// there means the checkpoint stack is already mounted.
+async function isOverlayMount(mountPoint: string): Promise<boolean> {
+  const content = await fs.readFile("/proc/self/mountinfo", "utf-8");
+  return content
+    .split("\n")
+    .some((line) => line.split(" ")[4] === mountPoint && line.split(" - ")[1]?.startsWith("overlay "));
+}
+
+function mountedAtLoad(mountPoint: string): boolean {
+  try {
+    return readFileSync("/proc/self/mountinfo", "utf-8")
+      .split("\n")
+      .some((line) => line.split(" ")[4] === mountPoint);
+  } catch {
+    return false;
+  }
+}
+
+async function run(cmd: string, args: string[]): Promise<void> {
+  await new Promise<void>((resolve, reject) => {
+    const proc = spawn(cmd, args, { stdio: ["ignore", "ignore", "pipe"] });
+    let stderr = "";
+    proc.stderr.on("data", (d) => (stderr += String(d)));
+    proc.on("error", reject);
+    proc.on("close", (code) => {
+      if (code === 0) return resolve();
+      reject(new Error(`${cmd} ${args.join(" ")} exited with code ${code ?? -1}: ${stderr.slice(0, 200)}`));
+    });
+  });
+}
@@ -3,3 +3,13 @@ export const USER_HOME = "/home/user";
 // Dedicated chroot root for `/exec` so `/home/user` can exist as a normal directory inside the chroot.
 // The guest-agent bind-mounts the real USER_HOME into `${SANDBOX_ROOT}/home/user` and `${SANDBOX_ROOT}/workspace`.
 export const SANDBOX_ROOT = "/opt/sandbox";
+
+// Optional workspace data disk (rds_workspace_dev): guest-init mounts it here and binds its
+// `home/` subdirectory over USER_HOME.
+export const WORKSPACE_DISK_MOUNT = "/mnt/workspace";
+
+// tmpfs set up by guest-init so per-exec scratch files never touch the overlay disk: the jail's /tmp.
+export const SANDBOX_TMP = `${SANDBOX_ROOT}/tmp`;
+// Root-only, disk-backed staging for upload archives, outside the jail. Archives can reach
+// 100 MiB each, too much to hold in guest RAM.
+export const AGENT_STAGING_DIR = "/var/lib/rds-agent/staging";
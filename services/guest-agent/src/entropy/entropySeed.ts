@@ -0,0 +1,26 @@
+import { spawn } from "node:child_process";
+
+// guest-init doubles as the RNDADDENTROPY helper (Node cannot issue the ioctl itself).
+const INIT_BIN = "/sbin/init";
+const MAX_SEED_BYTES = 64;
+
+/**
+ * Mix host-provided seed bytes into the kernel CRNG and force a reseed.
+ * Called after snapshot restore so clones of the same memory image diverge immediately.
+ */
+export async function addEntropySeed(seedHex: string): Promise<void> {
+  if (typeof seedHex !== "string" || !/^(?:[0-9a-fA-F]{2})+$/.test(seedHex) || seedHex.length / 2 > MAX_SEED_BYTES) {
+    throw new Error(`seedHex must be 1-${MAX_SEED_BYTES} bytes of hex`);
+  }
+  await new Promise<void>((resolve, reject) => {
+    const proc = spawn(INIT_BIN, ["--add-entropy"], { stdio: ["pipe", "ignore", "pipe"] });
+    let stderr = "";
+    proc.stderr.on("data", (d) => (stderr += String(d)));
+    proc.on("error", reject);
+    proc.on("close", (code) => {
+      if (code === 0) return resolve();
+      reject(new Error(`add-entropy exited with code ${code ?? -1}: ${stderr.slice(0, 200)}`));
+    });
+    proc.stdin.end(seedHex);
+  });
+}
@@ -0,0 +1,86 @@
+import { spawn } from "node:child_process";
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { createExecCgroup, releaseExecCgroup, type ExecCgroup, type ExecCgroupPaths } from "../execCgroup.js";
+import { withJailEntry } from "../jail.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+function makeRoots(): ExecCgroupPaths {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), "exec-cgroup-"));
+  tempDirs.push(root);
+  const paths = { jailCgroup: path.join(root, "jail"), memguardDir: path.join(root, "memguard") };
+  fs.mkdirSync(paths.jailCgroup);
+  fs.mkdirSync(paths.memguardDir);
+  return paths;
+}
+
+// On cgroupfs a group's control files vanish with it; a plain directory has to be emptied first.
+function emptyLikeCgroupfs(cgroup: ExecCgroup): void {
+  for (const name of fs.readdirSync(cgroup.dir)) fs.rmSync(path.join(cgroup.dir, name));
+}
+
+function runEntry(cgroup: ExecCgroup): Promise<string> {
+  return new Promise((resolve, reject) => {
+    const proc = spawn(...withJailEntry("/bin/sh", ["-c", "echo $$"], cgroup.procsPath));
+    let stdout = "";
+    proc.stdout.on("data", (chunk) => (stdout += String(chunk)));
+    proc.on("error", reject);
+    proc.on("close", (code) => (code === 0 ? resolve(stdout.trim()) : reject(new Error(`exit ${code}`))));
+  });
+}
+
+describe("exec cgroups", () => {
+  it("creates a group per command that the jail entry shell joins before exec'ing it", async () => {
+    const paths = makeRoots();
+    const cgroup = await createExecCgroup(paths);
+    expect(cgroup).not.toBeNull();
+    expect(cgroup!.dir).toBe(path.join(paths.jailCgroup, cgroup!.name));
+    expect(fs.readFileSync(path.join(cgroup!.dir, "memory.oom.group"), "utf-8")).toBe("1");
+
+    const pid = await runEntry(cgroup!);
+    expect(fs.readFileSync(cgroup!.procsPath, "utf-8").trim()).toBe(pid);
+  });
+
+  it("reports a memory guard kill from the marker named after the group and removes both", async () => {
+    const paths = makeRoots();
+    const killed = (await createExecCgroup(paths))!;
+    const clean = (await createExecCgroup(paths))!;
+    fs.writeFileSync(path.join(paths.memguardDir, killed.name), "");
+
+    emptyLikeCgroupfs(killed);
+    emptyLikeCgroupfs(clean);
+    expect(await releaseExecCgroup(killed, paths)).toEqual({ memoryPressureKilled: true });
+    expect(await releaseExecCgroup(clean, paths)).toEqual({ memoryPressureKilled: false });
+    expect(fs.readdirSync(paths.memguardDir)).toEqual([]);
+    expect(fs.readdirSync(paths.jailCgroup)).toEqual([]);
+  });
+
+  it("prunes empty leftover groups on the next create, but not busy, pending or foreign ones", async () => {
+    const paths = makeRoots();
+    const pending = (await createExecCgroup(paths))!;
+    emptyLikeCgroupfs(pending);
+    fs.mkdirSync(path.join(paths.jailCgroup, "xstale"));
+    // A group whose background processes are still running cannot be removed yet.
+    fs.mkdirSync(path.join(paths.jailCgroup, "xbusy"));
+    fs.writeFileSync(path.join(paths.jailCgroup, "xbusy", "cgroup.procs"), "4242\n");
+    fs.mkdirSync(path.join(paths.jailCgroup, "agent"));
+
+    const next = (await createExecCgroup(paths))!;
+    expect(fs.readdirSync(paths.jailCgroup).sort()).toEqual(["agent", next.name, pending.name, "xbusy"].sort());
+
+    // Once released, an emptied group is removed and a drained leftover goes on the next create.
+    await releaseExecCgroup(pending, paths);
+    fs.rmSync(path.join(paths.jailCgroup, "xbusy", "cgroup.procs"));
+    emptyLikeCgroupfs(next);
+    await releaseExecCgroup(next, paths);
+    const last = (await createExecCgroup(paths))!;
+    expect(fs.readdirSync(paths.jailCgroup).sort()).toEqual(["agent", last.name].sort());
+  });
+});
@@ -0,0 +1,72 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { diffLoginEnv, loginEnvKey, parseEnvDump } from "../loginEnv.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+function makeSandbox() {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), "login-env-"));
+  tempDirs.push(root);
+  fs.mkdirSync(path.join(root, "etc", "skel"), { recursive: true });
+  fs.writeFileSync(path.join(root, "etc", "skel", ".bashrc"), 'export NVM_DIR="/workspace/.nvm"\n');
+  return root;
+}
+
+describe("parseEnvDump", () => {
+  it("splits NUL-separated entries and keeps newlines and '=' inside values", () => {
+    const dump = "PATH=/a:/b\0MULTI=line1\nline2\0EQ=a=b\0\0";
+    expect(parseEnvDump(dump)).toEqual({ PATH: "/a:/b", MULTI: "line1\nline2", EQ: "a=b" });
+  });
+});
+
+describe("diffLoginEnv", () => {
+  it("keeps only variables the login script added or changed", () => {
+    const base = { PATH: "/usr/bin", HOME: "/home/user", NODE_OPTIONS: "--jitless" };
+    const login = {
+      PATH: "/workspace/.nvm/versions/node/v20.0.0/bin:/usr/bin",
+      HOME: "/home/user",
+      NODE_OPTIONS: "--jitless",
+      NVM_DIR: "/workspace/.nvm",
+      NVM_BIN: "/workspace/.nvm/versions/node/v20.0.0/bin",
+      PWD: "/",
+      SHLVL: "1",
+      _: "/usr/bin/env"
+    };
+    expect(diffLoginEnv(base, login)).toEqual({
+      PATH: "/workspace/.nvm/versions/node/v20.0.0/bin:/usr/bin",
+      NVM_DIR: "/workspace/.nvm",
+      NVM_BIN: "/workspace/.nvm/versions/node/v20.0.0/bin"
+    });
+  });
+});
+
+describe("loginEnvKey", () => {
+  it("changes when the default alias or installed versions change", async () => {
+    const root = makeSandbox();
+    const nvmDir = path.join(root, "workspace", ".nvm");
+    const initial = await loginEnvKey(root, "/workspace/.nvm");
+    expect(await loginEnvKey(root, "/workspace/.nvm")).toBe(initial);
+
+    fs.mkdirSync(path.join(nvmDir, "versions", "node", "v20.0.0"), { recursive: true });
+    const installed = await loginEnvKey(root, "/workspace/.nvm");
+    expect(installed).not.toBe(initial);
+
+    fs.mkdirSync(path.join(nvmDir, "alias"), { recursive: true });
+    fs.writeFileSync(path.join(nvmDir, "alias", "default"), "20\n");
+    expect(await loginEnvKey(root, "/workspace/.nvm")).not.toBe(installed);
+  });
+
+  it("ignores NVM state until NVM_DIR is known", async () => {
+    const root = makeSandbox();
+    const key = await loginEnvKey(root);
+    fs.mkdirSync(path.join(root, "workspace", ".nvm", "alias"), { recursive: true });
+    fs.writeFileSync(path.join(root, "workspace", ".nvm", "alias", "default"), "20\n");
+    expect(await loginEnvKey(root)).toBe(key);
+  });
+});
@@ -0,0 +1,56 @@
+import { randomBytes } from "node:crypto";
+import fs from "node:fs/promises";
+
+// guest-init mounts cgroup2 and enables the memory controller for this subtree. Its PSI memory
+// guard kills the largest child group under sustained memory pressure and leaves a marker file
+// named after the group in MEMGUARD_DIR before doing so.
+export type ExecCgroupPaths = { jailCgroup: string; memguardDir: string };
+
+const DEFAULT_PATHS: ExecCgroupPaths = { jailCgroup: "/sys/fs/cgroup/jail", memguardDir: "/run/rds-memguard" };
+
+export type ExecCgroup = { name: string; dir: string; procsPath: string };
+
+// Groups created but possibly not yet joined by their process; pruning must not race them.
+const pending = new Set<string>();
+
+/** Create a fresh cgroup for one jailed command, or null when the guest has no cgroup v2. */
+export async function createExecCgroup(paths: ExecCgroupPaths = DEFAULT_PATHS): Promise<ExecCgroup | null> {
+  await pruneEmptyCgroups(paths.jailCgroup);
+  const name = `x${randomBytes(6).toString("hex")}`;
+  const dir = `${paths.jailCgroup}/${name}`;
+  try {
+    await fs.mkdir(dir);
+  } catch {
+    return null;
+  }
+  pending.add(name);
+  // A kernel OOM inside the group takes the whole command down rather than one arbitrary child.
+  await fs.writeFile(`${dir}/memory.oom.group`, "1").catch(() => undefined);
+  return { name, dir, procsPath: `${dir}/cgroup.procs` };
+}
+
+/**
+ * Called once the command exited. Background processes it left behind keep running in the group
+ * (it is removed later, once empty). Returns whether the memory guard killed the command.
+ */
+export async function releaseExecCgroup(
+  cgroup: ExecCgroup,
+  paths: ExecCgroupPaths = DEFAULT_PATHS
+): Promise<{ memoryPressureKilled: boolean }> {
+  pending.delete(cgroup.name);
+  const memoryPressureKilled = await fs
+    .rm(`${paths.memguardDir}/${cgroup.name}`)
+    .then(() => true)
+    .catch(() => false);
+  await fs.rmdir(cgroup.dir).catch(() => undefined);
+  return { memoryPressureKilled };
+}
+
+async function pruneEmptyCgroups(jailCgroup: string): Promise<void> {
+  const names = await fs.readdir(jailCgroup).catch(() => [] as string[]);
+  for (const name of names) {
+    if (!name.startsWith("x") || pending.has(name)) continue;
+    // rmdir fails with EBUSY while the group still has processes.
+    await fs.rmdir(`${jailCgroup}/${name}`).catch(() => undefined);
+  }
+}
@@ -1,3 +1,4 @@
+import { constants as fsConstants } from "node:fs";
 import fs from "node:fs/promises";
 import path from "node:path";
 import { randomUUID } from "node:crypto";
@@ -5,7 +6,7 @@ import type { ExecRunner } from "../types/interfaces.js";
 import type { ExecRequest, ExecResult, RunJsRequest, RunTsRequest } from "../types/agent.js";
 import { resolveWorkspacePathToChroot, resolveWorkspacePathToHost } from "../files/pathPolicy.js";
 import { JAIL_GROUP_ID, JAIL_USER_ID, runInJailShell, shellQuoteSingle } from "./jail.js";
-import { SANDBOX_ROOT } from "../config/constants.js";
+import { SANDBOX_TMP } from "../config/constants.js";
 
 export class ExecRunnerImpl implements ExecRunner {
   async exec(payload: ExecRequest): Promise<ExecResult> {
@@ -18,11 +19,6 @@ export class ExecRunnerImpl implements ExecRunner {
     const { entry, cleanupPaths, resultPath } = await prepareRunTsEntry(payload);
     const denoBin = "/usr/bin/deno";
 
-    // Ensure /tmp inside the chroot is writable by the jail user (for TMPDIR).
-    const tmpDirHost = path.join(SANDBOX_ROOT, "tmp");
-    await fs.mkdir(tmpDirHost, { recursive: true });
-    await fs.chown(tmpDirHost, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
-
     const extraEnv = parseEnvArray(payload.env);
     const allowEnvNames = Object.keys(extraEnv);
 
@@ -59,22 +55,20 @@ export class ExecRunnerImpl implements ExecRunner {
       timeoutMs: payload.timeoutMs
     })
       .then(async (result) => {
-        const parsed = resultPath ? await readResultFile(resultPath) : undefined;
+        const parsed = await readResultFile(resultPath);
         return {
           exitCode: result.exitCode,
           stdout: stripAnsi(result.stdout),
           stderr: stripAnsi(result.stderr),
           ...(parsed?.result !== undefined ? { result: parsed.result } : {}),
-          ...(parsed?.error !== undefined ? { error: parsed.error } : {})
+          ...(parsed?.error !== undefined ? { error: parsed.error } : {}),
+          ...(result.memoryPressureKilled ? { memoryPressureKilled: true } : {})
         };
       })
       .finally(async () => {
-        // Delete any files created to execute this request.
+        // Delete any files created to execute this request (host paths).
         for (const p of cleanupPaths) {
-          await fs.rm(resolveWorkspacePathToHost(p), { force: true }).catch(() => undefined);
-        }
-        if (resultPath) {
-          await fs.rm(resolveWorkspacePathToHost(resultPath), { force: true }).catch(() => undefined);
+          await fs.rm(p, { force: true }).catch(() => undefined);
         }
     });
   }
@@ -91,110 +85,102 @@ export class ExecRunnerImpl implements ExecRunner {
     const cmd = `${shellQuoteSingle(nodeBin)} ${args.map((a) => shellQuoteSingle(a)).join(" ")}`;
     return runInJailShell(cmd, { cwdInWorkspace: cwd, env: extraEnv, timeoutMs: payload.timeoutMs })
       .then(async (result) => {
-        const parsed = resultPath ? await readResultFile(resultPath) : undefined;
+        const parsed = await readResultFile(resultPath);
         return {
           exitCode: result.exitCode,
           // Preserve ANSI in Node output; the admin UI renders it like a real console.
           stdout: result.stdout,
           stderr: result.stderr,
           ...(parsed?.result !== undefined ? { result: parsed.result } : {}),
-          ...(parsed?.error !== undefined ? { error: parsed.error } : {})
+          ...(parsed?.error !== undefined ? { error: parsed.error } : {}),
+          ...(result.memoryPressureKilled ? { memoryPressureKilled: true } : {})
         };
       })
       .finally(async () => {
-        // Delete any files created to execute this request.
+        // Delete any files created to execute this request (host paths).
         for (const p of cleanupPaths) {
-          await fs.rm(resolveWorkspacePathToHost(p), { force: true }).catch(() => undefined);
-        }
-        if (resultPath) {
-          await fs.rm(resolveWorkspacePathToHost(resultPath), { force: true }).catch(() => undefined);
+          await fs.rm(p, { force: true }).catch(() => undefined);
         }
       });
   }
 }
 
-async function prepareRunTsEntry(payload: RunTsRequest): Promise<{ entry: string; cleanupPaths: string[]; resultPath?: string }> {
+type RunEntry = {
+  /** Wrapper module path inside the chroot. */
+  entry: string;
+  /** Host paths to delete once the run finishes (wrapper, snippet, result file). */
+  cleanupPaths: string[];
+  /** Host path of the {result,error} JSON written by the wrapper. */
+  resultPath: string;
+};
+
+// Wrappers and result files live on the jail's tmpfs /tmp, so a run costs no overlay-disk writes.
+// The wrapper imports its target by absolute URL and does not need to sit next to it; inline
+// snippets stay in /workspace so their relative imports and node_modules lookups keep working.
+function scratchFile(name: string): { host: string; chroot: string } {
+  return { host: path.join(SANDBOX_TMP, name), chroot: `/tmp/${name}` };
+}
+
+async function prepareRunTsEntry(payload: RunTsRequest): Promise<RunEntry> {
   // We always execute a wrapper as the entrypoint so a built-in `result` helper is available,
   // and so we can persist a structured {result,error} payload to a known file.
   const id = randomUUID();
-  const cleanupPaths: string[] = [];
-  const resultPath = `/workspace/.run-ts-result-${id}.json`;
-  const wrapperPath = `/workspace/.run-ts-wrapper-${id}.ts`;
-
-  const dirHostWorkspace = resolveWorkspacePathToHost("/workspace");
-  await fs.mkdir(dirHostWorkspace, { recursive: true });
-  // Ensure /workspace is writable by the jail user so Deno can write files (result, TMPDIR, etc).
-  await fs.chown(dirHostWorkspace, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
+  const result = scratchFile(`.run-ts-result-${id}.json`);
+  // Plain JS (no type annotations): Deno runs it without emitting into DENO_DIR.
+  const wrapper = scratchFile(`.run-ts-wrapper-${id}.js`);
+  const cleanupPaths: string[] = [result.host];
 
   let targetUrl = "";
   if (payload.path) {
     // Import the target module by absolute file URL so its relative imports still resolve against its own location.
     targetUrl = `file://${resolveWorkspacePathToChroot(payload.path)}`;
   } else if (payload.code) {
-    // Keep the snippet as its own module so stack traces point to it.
-    const snippetPath = `/workspace/.run-ts-snippet-${id}.ts`;
-    const fullHostPath = path.join(dirHostWorkspace, path.posix.basename(snippetPath));
-    await fs.writeFile(fullHostPath, payload.code, { encoding: "utf-8", mode: 0o644 });
-    await fs.chown(fullHostPath, JAIL_USER_ID, JAIL_GROUP_ID);
-    cleanupPaths.push(snippetPath);
-    targetUrl = `file://${resolveWorkspacePathToChroot(snippetPath)}`;
+    targetUrl = await writeWorkspaceSnippet(`.run-ts-snippet-${id}.ts`, payload.code, cleanupPaths);
   } else {
     throw new Error("path or code is required");
   }
 
-  const wrapperCode = buildRunTsWrapper({ targetUrl, resultPath });
-  const wrapperHostPath = path.join(dirHostWorkspace, path.posix.basename(wrapperPath));
-  await fs.writeFile(wrapperHostPath, wrapperCode, { encoding: "utf-8", mode: 0o644 });
-  await fs.chown(wrapperHostPath, JAIL_USER_ID, JAIL_GROUP_ID);
-  cleanupPaths.push(wrapperPath);
-
-  return {
-    entry: resolveWorkspacePathToChroot(wrapperPath),
-    cleanupPaths,
-    resultPath
-  };
+  await fs.writeFile(wrapper.host, buildRunTsWrapper({ targetUrl, resultPath: result.chroot }), { encoding: "utf-8", mode: 0o644 });
+  cleanupPaths.push(wrapper.host);
+  return { entry: wrapper.chroot, cleanupPaths, resultPath: result.host };
 }
 
-async function prepareRunJsEntry(payload: RunJsRequest): Promise<{ entry: string; cleanupPaths: string[]; resultPath?: string }> {
+async function prepareRunJsEntry(payload: RunJsRequest): Promise<RunEntry> {
   // We always execute a wrapper as the entrypoint so a built-in `result` helper is available,
   // and so we can persist a structured {result,error} payload to a known file.
   const id = randomUUID();
-  const cleanupPaths: string[] = [];
-  const resultPath = `/workspace/.run-js-result-${id}.json`;
-  const wrapperPath = `/workspace/.run-js-wrapper-${id}.js`;
-
-  const dirHostWorkspace = resolveWorkspacePathToHost("/workspace");
-  await fs.mkdir(dirHostWorkspace, { recursive: true });
-  // Ensure /workspace is writable by the jail user so Node can write files (result, npm caches, etc).
-  await fs.chown(dirHostWorkspace, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
+  const result = scratchFile(`.run-js-result-${id}.json`);
+  // .cjs: the wrapper uses require() whatever package.json "type" applies to the target.
+  const wrapper = scratchFile(`.run-js-wrapper-${id}.cjs`);
+  const cleanupPaths: string[] = [result.host];
 
   let targetUrl = "";
   if (payload.path) {
     // Import the target module by absolute file URL so its relative imports still resolve against its own location.
     targetUrl = `file://${resolveWorkspacePathToChroot(payload.path)}`;
   } else if (payload.code) {
-    // Keep the snippet as its own module so stack traces point to it.
-    const snippetPath = `/workspace/.run-js-snippet-${id}.js`;
-    const fullHostPath = path.join(dirHostWorkspace, path.posix.basename(snippetPath));
-    await fs.writeFile(fullHostPath, payload.code, { encoding: "utf-8", mode: 0o644 });
-    await fs.chown(fullHostPath, JAIL_USER_ID, JAIL_GROUP_ID);
-    cleanupPaths.push(snippetPath);
-    targetUrl = `file://${resolveWorkspacePathToChroot(snippetPath)}`;
+    targetUrl = await writeWorkspaceSnippet(`.run-js-snippet-${id}.js`, payload.code, cleanupPaths);
   } else {
     throw new Error("path or code is required");
   }
 
-  const wrapperCode = buildRunJsWrapper({ targetUrl, resultPath });
-  const wrapperHostPath = path.join(dirHostWorkspace, path.posix.basename(wrapperPath));
-  await fs.writeFile(wrapperHostPath, wrapperCode, { encoding: "utf-8", mode: 0o644 });
-  await fs.chown(wrapperHostPath, JAIL_USER_ID, JAIL_GROUP_ID);
-  cleanupPaths.push(wrapperPath);
+  await fs.writeFile(wrapper.host, buildRunJsWrapper({ targetUrl, resultPath: result.chroot }), { encoding: "utf-8", mode: 0o644 });
+  cleanupPaths.push(wrapper.host);
+  return { entry: wrapper.chroot, cleanupPaths, resultPath: result.host };
+}
 
-  return {
-    entry: resolveWorkspacePathToChroot(wrapperPath),
-    cleanupPaths,
-    resultPath
-  };
+// Keep the snippet as its own module in /workspace so stack traces point to it and imports resolve.
+async function writeWorkspaceSnippet(name: string, code: string, cleanupPaths: string[]): Promise<string> {
+  const dirHostWorkspace = resolveWorkspacePathToHost("/workspace");
+  await fs.mkdir(dirHostWorkspace, { recursive: true });
+  // Ensure /workspace is writable by the jail user so the runtime can write files (caches, etc).
+  await fs.chown(dirHostWorkspace, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
+  const snippetPath = `/workspace/${name}`;
+  const fullHostPath = path.join(dirHostWorkspace, name);
+  await fs.writeFile(fullHostPath, code, { encoding: "utf-8", mode: 0o644 });
+  await fs.chown(fullHostPath, JAIL_USER_ID, JAIL_GROUP_ID);
+  cleanupPaths.push(fullHostPath);
+  return `file://${resolveWorkspacePathToChroot(snippetPath)}`;
 }
 
 async function resolveCwd(input?: string): Promise<string> {
@@ -236,7 +222,9 @@ function parseEnvArray(env?: string[]): Record<string, string> {
 
 async function readResultFile(resultPath: string): Promise<{ result?: unknown; error?: unknown } | undefined> {
   try {
-    const text = await fs.readFile(resolveWorkspacePathToHost(resultPath), "utf-8");
+    // The jail user owns /tmp entries; never follow a link it swapped in for the result file.
+    const handle = await fs.open(resultPath, fsConstants.O_RDONLY | fsConstants.O_NOFOLLOW);
+    const text = await handle.readFile("utf-8").finally(() => handle.close());
     if (!text) return undefined;
     const parsed = JSON.parse(text) as any;
     if (!parsed || typeof parsed !== "object") return undefined;
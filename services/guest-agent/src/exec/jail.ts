@@ -1,7 +1,10 @@
 import { spawn, type SpawnOptionsWithoutStdio } from "node:child_process";
+import { createReadStream } from "node:fs";
 import path from "node:path";
 import type { ExecResult } from "../types/agent.js";
 import { SANDBOX_ROOT } from "../config/constants.js";
+import { createExecCgroup, releaseExecCgroup } from "./execCgroup.js";
+import { JAIL_BASHRC, LAZY_NVM_PROLOGUE, diffLoginEnv, loginEnvKey, parseEnvDump } from "./loginEnv.js";
 
 const USER_ID = 1000;
 const GROUP_ID = 1000;
@@ -59,6 +62,14 @@ export function buildChrootArgs(command: string, args: string[]): string[] {
   return ["--userspec=1000:1000", SANDBOX_ROOT, command, ...args];
 }
 
+// The agent inherits oom_score_adj=-1000 from guest-init; jailed processes must not. The entry
+// shell drops it back to 0 and joins the exec cgroup ($1, may be empty) before exec'ing the command.
+const JAIL_ENTRY_SCRIPT = `echo 0 >/proc/self/oom_score_adj && { [ -z "$1" ] || echo $$ >"$1"; } && shift && exec "$@"; exit 125`;
+
+export function withJailEntry(cmd: string, args: string[], procsPath = ""): [string, string[]] {
+  return ["/bin/sh", ["-c", JAIL_ENTRY_SCRIPT, "jail-entry", procsPath, cmd, ...args]];
+}
+
 export async function runInJailShell(
   cmd: string,
   opts: { cwdInWorkspace?: string; env?: Record<string, string>; timeoutMs?: number; maxOutputBytes?: number }
@@ -66,12 +77,14 @@ export async function runInJailShell(
   const cwd = normalizeWorkspaceCwd(opts.cwdInWorkspace);
 
   if (JAIL_SHELL === "bash") {
-    // Bash: source /etc/skel/.bashrc for NVM support, then run command.
-    // NOTE: We use /etc/skel/.bashrc (baked into the image) instead of ~/.bashrc
-    // because /home/user is bind-mounted at runtime and would override any image .bashrc.
-    const script = `source /etc/skel/.bashrc 2>/dev/null || true; cd ${shellQuoteSingle(cwd)} && ${cmd}`;
+    // Bash: run with the cached .bashrc environment (NVM PATH etc.) instead of sourcing it per exec.
+    const loginEnv = await jailLoginEnv();
+    const script = loginEnv
+      ? `${LAZY_NVM_PROLOGUE}; cd ${shellQuoteSingle(cwd)} && ${cmd}`
+      : `source ${JAIL_BASHRC} 2>/dev/null || true; cd ${shellQuoteSingle(cwd)} && ${cmd}`;
     return runRootCommand(["chroot", buildChrootArgs("/bin/bash", ["-c", script])], {
-      env: buildJailEnv(opts.env),
+      // Caller-provided variables win over the login env, as they would over an interactive profile.
+      env: buildJailEnv({ ...loginEnv, ...opts.env }),
       timeoutMs: opts.timeoutMs,
       maxOutputBytes: opts.maxOutputBytes
     });
@@ -86,15 +99,54 @@ export async function runInJailShell(
   });
 }
 
+let loginEnvCache: { key: string; env: Record<string, string> | null } | null = null;
+let loginEnvCapture: Promise<Record<string, string> | null> | null = null;
+
+/**
+ * Variables /etc/skel/.bashrc adds to the jail env, captured once and reused until the files it
+ * depends on change. null (cached like a success) means the capture failed and callers should
+ * fall back to sourcing .bashrc per command.
+ */
+async function jailLoginEnv(): Promise<Record<string, string> | null> {
+  const key = await loginEnvKey(SANDBOX_ROOT, loginEnvCache?.env?.NVM_DIR);
+  if (loginEnvCache?.key === key) return loginEnvCache.env;
+  // Concurrent first execs share one capture.
+  loginEnvCapture ??= captureLoginEnv().finally(() => {
+    loginEnvCapture = null;
+  });
+  return loginEnvCapture;
+}
+
+async function captureLoginEnv(): Promise<Record<string, string> | null> {
+  const startedAt = Date.now();
+  const base = buildJailEnv();
+  const script = `source ${JAIL_BASHRC} >/dev/null 2>&1; env -0`;
+  const result = await runRootCommand(["chroot", buildChrootArgs("/bin/bash", ["-c", script])], { env: base, timeoutMs: 10_000 });
+  const env = result.exitCode === 0 ? diffLoginEnv(base, parseEnvDump(result.stdout)) : null;
+  loginEnvCache = { key: await loginEnvKey(SANDBOX_ROOT, env?.NVM_DIR), env };
+  // eslint-disable-next-line no-console
+  console.info("[jail] captured bash login env", {
+    ok: env !== null,
+    vars: env ? Object.keys(env) : [],
+    ms: Date.now() - startedAt
+  });
+  return env;
+}
+
+/**
+ * Run a single command in the jail. `stdinPath` is a host path streamed to the command's stdin,
+ * so agent-private files can be fed in without exposing them inside the chroot.
+ */
 export async function runInJail(
   command: string,
   args: string[],
-  opts?: { env?: Record<string, string>; timeoutMs?: number; maxOutputBytes?: number }
+  opts?: { env?: Record<string, string>; timeoutMs?: number; maxOutputBytes?: number; stdinPath?: string }
 ): Promise<ExecResult> {
   return runRootCommand(["chroot", buildChrootArgs(command, args)], {
     env: buildJailEnv(opts?.env),
     timeoutMs: opts?.timeoutMs,
-    maxOutputBytes: opts?.maxOutputBytes
+    maxOutputBytes: opts?.maxOutputBytes,
+    stdinPath: opts?.stdinPath
   });
 }
 
@@ -104,17 +156,26 @@ export function spawnInJail(
   opts?: { env?: Record<string, string> } & SpawnOptionsWithoutStdio
 ) {
   // Intentionally does not inherit env.
-  return spawn("chroot", buildChrootArgs(command, args), { ...opts, env: buildJailEnv(opts?.env as any) });
+  const [cmd, entryArgs] = withJailEntry("chroot", buildChrootArgs(command, args));
+  return spawn(cmd, entryArgs, { ...opts, env: buildJailEnv(opts?.env as any) });
 }
 
 async function runRootCommand(
   [cmd, args]: [string, string[]],
-  options: { env?: Record<string, string>; timeoutMs?: number; maxOutputBytes?: number }
+  options: { env?: Record<string, string>; timeoutMs?: number; maxOutputBytes?: number; stdinPath?: string }
 ): Promise<ExecResult> {
-  return new Promise((resolve) => {
-    const proc = spawn(cmd, args, {
+  const cgroup = await createExecCgroup();
+  const result = await new Promise<ExecResult>((resolve) => {
+    const proc = spawn(...withJailEntry(cmd, args, cgroup?.procsPath), {
       env: options.env
     });
+    if (options.stdinPath) {
+      // The command may exit without draining stdin (e.g. tar rejecting a bad archive).
+      proc.stdin.on("error", () => undefined);
+      const input = createReadStream(options.stdinPath);
+      input.on("error", () => proc.stdin.destroy());
+      input.pipe(proc.stdin);
+    }
 
     let stdout = "";
     let stderr = "";
@@ -152,6 +213,14 @@ async function runRootCommand(
       resolve({ exitCode: code ?? -1, stdout, stderr });
     });
   });
+  if (cgroup && (await releaseExecCgroup(cgroup)).memoryPressureKilled) {
+    return {
+      ...result,
+      stderr: `${result.stderr}\nKilled by the guest memory guard (sustained memory pressure)`,
+      memoryPressureKilled: true
+    };
+  }
+  return result;
 }
 
 // Export for potential callers that still need raw IDs (e.g., chown on host files).
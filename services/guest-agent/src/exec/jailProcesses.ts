@@ -0,0 +1,48 @@
+import fs from "node:fs/promises";
+import { JAIL_USER_ID } from "./jail.js";
+
+const KILL_PASSES = 10;
+
+/**
+ * SIGKILL every process running as the jail user, repeating until none are left
+ * (a dying shell can still fork). Returns the number of signals delivered.
+ */
+export async function killJailedProcesses(): Promise<number> {
+  return killUserProcesses(JAIL_USER_ID);
+}
+
+async function killUserProcesses(uid: number): Promise<number> {
+  let killed = 0;
+  for (let pass = 0; pass < KILL_PASSES; pass++) {
+    const pids = await listProcessesOwnedBy(uid);
+    if (pids.length === 0) return killed;
+    for (const pid of pids) {
+      try {
+        process.kill(pid, "SIGKILL");
+        killed++;
+      } catch {
+        // Already gone.
+      }
+    }
+    await new Promise((resolve) => setTimeout(resolve, 50));
+  }
+  if ((await listProcessesOwnedBy(uid)).length > 0) {
+    throw new Error(`processes owned by uid ${uid} survived ${KILL_PASSES} kill passes`);
+  }
+  return killed;
+}
+
+async function listProcessesOwnedBy(uid: number): Promise<number[]> {
+  const pids: number[] = [];
+  for (const name of await fs.readdir("/proc")) {
+    if (!/^\d+$/.test(name)) continue;
+    const status = await fs.readFile(`/proc/${name}/status`, "utf-8").catch(() => "");
+    // Zombies are already dead; they only wait to be reaped.
+    if (/^State:\s+Z/m.test(status)) continue;
+    // Uid: real effective saved fs
+    const match = /^Uid:\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)/m.exec(status);
+    if (match && match.slice(1).some((v) => Number(v) === uid)) pids.push(Number(name));
+  }
+  return pids;
+}
+
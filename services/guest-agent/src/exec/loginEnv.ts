@@ -0,0 +1,62 @@
+import fs from "node:fs/promises";
+import path from "node:path";
+
+// Baked into the bash image variant; sets NVM_DIR and loads nvm.sh (see guest-image build-rootfs.sh).
+// NOTE: /etc/skel/.bashrc instead of ~/.bashrc because /home/user is bind-mounted at runtime and
+// would hide any .bashrc shipped in the image.
+export const JAIL_BASHRC = "/etc/skel/.bashrc";
+
+// Per-process shell bookkeeping that must not be replayed into later commands.
+const SHELL_LOCAL_VARS = new Set(["PWD", "OLDPWD", "SHLVL", "_"]);
+
+/**
+ * Prologue for bash commands run with a cached login env. PATH already points at the default Node,
+ * so nvm.sh (hundreds of ms to source) is only loaded the first time a command calls `nvm`.
+ * The loader runs in its own function so nvm.sh does not see the `nvm` arguments as its own.
+ */
+export const LAZY_NVM_PROLOGUE =
+  `__rds_load_nvm() { source ${JAIL_BASHRC} >/dev/null 2>&1; }; ` +
+  `nvm() { unset -f nvm; __rds_load_nvm; nvm "$@"; }`;
+
+/** Parse `env -0` output. */
+export function parseEnvDump(dump: string): Record<string, string> {
+  const out: Record<string, string> = {};
+  for (const entry of dump.split("\0")) {
+    const idx = entry.indexOf("=");
+    if (idx <= 0) continue;
+    out[entry.slice(0, idx)] = entry.slice(idx + 1);
+  }
+  return out;
+}
+
+/** Variables the login script added or changed relative to the env it was started with. */
+export function diffLoginEnv(base: Record<string, string>, login: Record<string, string>): Record<string, string> {
+  const out: Record<string, string> = {};
+  for (const [key, value] of Object.entries(login)) {
+    if (SHELL_LOCAL_VARS.has(key) || base[key] === value) continue;
+    out[key] = value;
+  }
+  return out;
+}
+
+async function statStamp(p: string): Promise<string> {
+  const st = await fs.stat(p).catch(() => null);
+  return st ? `${st.mtimeMs}:${st.size}` : "-";
+}
+
+/**
+ * What the captured env depends on: the .bashrc itself and, once NVM_DIR is known, the default
+ * alias and installed versions that `nvm use default` resolves PATH from. `nvm install` or
+ * `nvm alias default` in one exec (or a workspace rollback) changes the key for the next one.
+ */
+export async function loginEnvKey(sandboxRoot: string, nvmDir?: string): Promise<string> {
+  const parts = [await statStamp(path.join(sandboxRoot, JAIL_BASHRC))];
+  if (nvmDir && path.posix.isAbsolute(nvmDir)) {
+    const hostNvmDir = path.join(sandboxRoot, nvmDir);
+    parts.push(
+      await fs.readFile(path.join(hostNvmDir, "alias", "default"), "utf-8").catch(() => "-"),
+      await statStamp(path.join(hostNvmDir, "versions", "node"))
+    );
+  }
+  return parts.join("|");
+}
@@ -1,7 +1,7 @@
 import { spawn } from "node:child_process";
 import fs from "node:fs/promises";
 import path from "node:path";
-import { SANDBOX_ROOT, USER_HOME } from "../config/constants.js";
+import { SANDBOX_ROOT, SANDBOX_TMP, USER_HOME, WORKSPACE_DISK_MOUNT } from "../config/constants.js";
 
 async function isMountPoint(mountPoint: string): Promise<boolean> {
   const content = await fs.readFile("/proc/self/mountinfo", "utf-8");
@@ -123,12 +123,30 @@ async function ensureResolvConfFromGateway(): Promise<void> {
     .catch(() => undefined);
 }
 
+// guest-init binds a blank workspace disk over /home/user; copy the image's home into it once.
+async function seedWorkspaceDisk(): Promise<void> {
+  if (!(await isMountPoint(WORKSPACE_DISK_MOUNT))) return;
+  const marker = `${WORKSPACE_DISK_MOUNT}/.rds-seeded`;
+  if (await fs.stat(marker).then(() => true, () => false)) return;
+  // The image's /home/user is still reachable through the overlay's lower layer.
+  const imageHome = `/oldroot${USER_HOME}`;
+  if (await fs.stat(imageHome).then((st) => st.isDirectory(), () => false)) {
+    await run("cp", ["-a", `${imageHome}/.`, `${USER_HOME}/`]);
+  }
+  await fs.writeFile(marker, "", { mode: 0o600 });
+}
+
 let sandboxReadyPromise: Promise<void> | null = null;
 
 async function setupExecSandboxReady(): Promise<void> {
-  // Ensure standard temp paths exist inside the sandbox root.
+  await seedWorkspaceDisk();
+
+  // Ensure standard temp paths exist inside the sandbox root. /tmp is normally guest-init's tmpfs;
+  // on images without it the directory simply lives on the root filesystem.
   await ensureDir(`${SANDBOX_ROOT}/var/tmp`);
   await fs.chmod(`${SANDBOX_ROOT}/var/tmp`, 0o1777).catch(() => undefined);
+  await ensureDir(SANDBOX_TMP);
+  await fs.chmod(SANDBOX_TMP, 0o1777).catch(() => undefined);
 
   await ensureDir(SANDBOX_ROOT);
   await ensureDir(`${SANDBOX_ROOT}/dev`);
@@ -177,3 +195,12 @@ export async function ensureExecSandboxReady(): Promise<void> {
     throw error;
   }
 }
+
+/**
+ * Re-run sandbox setup after a tenant reset reverted the overlay (recreates temp dirs,
+ * restores their modes and rewrites resolver config). Existing bind mounts are kept.
+ */
+export async function resetExecSandbox(): Promise<void> {
+  sandboxReadyPromise = null;
+  await ensureExecSandboxReady();
+}
@@ -0,0 +1,89 @@
+import { createHash } from "node:crypto";
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { cachedSha256OfHandle, parseByteRange } from "../rawFile.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+describe("parseByteRange", () => {
+  it("ignores missing or unsupported headers", () => {
+    expect(parseByteRange(undefined, 100)).toBeNull();
+    expect(parseByteRange("bytes=0-1,5-6", 100)).toBeNull();
+    expect(parseByteRange("items=0-1", 100)).toBeNull();
+  });
+
+  it("parses bounded and open-ended ranges", () => {
+    expect(parseByteRange("bytes=0-9", 100)).toEqual({ start: 0, end: 9 });
+    expect(parseByteRange("bytes=90-", 100)).toEqual({ start: 90, end: 99 });
+    expect(parseByteRange("bytes=90-500", 100)).toEqual({ start: 90, end: 99 });
+  });
+
+  it("parses suffix ranges", () => {
+    expect(parseByteRange("bytes=-10", 100)).toEqual({ start: 90, end: 99 });
+    expect(parseByteRange("bytes=-500", 100)).toEqual({ start: 0, end: 99 });
+  });
+
+  it("reports unsatisfiable ranges", () => {
+    expect(parseByteRange("bytes=100-", 100)).toBe("unsatisfiable");
+    expect(parseByteRange("bytes=5-1", 100)).toBe("unsatisfiable");
+    expect(parseByteRange("bytes=-0", 100)).toBe("unsatisfiable");
+    expect(parseByteRange("bytes=0-", 0)).toBe("unsatisfiable");
+  });
+});
+
+describe("cachedSha256OfHandle", () => {
+  const sha256 = (text: string) => createHash("sha256").update(text).digest("hex");
+
+  it("never serves a stale hash after a same-size rewrite", async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), "raw-file-"));
+    tempDirs.push(dir);
+    const file = path.join(dir, "notes.txt");
+    fs.writeFileSync(file, "aaaa");
+    const handle = await fs.promises.open(file, "r");
+    try {
+      expect(await cachedSha256OfHandle(handle)).toBe(sha256("aaaa"));
+      expect(await cachedSha256OfHandle(handle)).toBe(sha256("aaaa"));
+      fs.writeFileSync(file, "bbbb");
+      expect(await cachedSha256OfHandle(handle)).toBe(sha256("bbbb"));
+    } finally {
+      await handle.close();
+    }
+  });
+
+  it("serves an unchanged file's hash from the cache and rehashes once it changes", async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), "raw-file-"));
+    tempDirs.push(dir);
+    const file = path.join(dir, "data.bin");
+    fs.writeFileSync(file, "first version");
+    const handle = await fs.promises.open(file, "r");
+    let reads = 0;
+    const counting = {
+      stat: handle.stat.bind(handle),
+      read: (...args: Parameters<typeof handle.read>) => {
+        reads += 1;
+        return handle.read(...args);
+      }
+    } as unknown as typeof handle;
+    // Evaluate as if the file was written long enough ago for its timestamps to be trusted.
+    const later = () => Date.now() + 60_000;
+    try {
+      expect(await cachedSha256OfHandle(counting, later())).toBe(sha256("first version"));
+      const afterFirst = reads;
+      expect(afterFirst).toBeGreaterThan(0);
+      expect(await cachedSha256OfHandle(counting, later())).toBe(sha256("first version"));
+      expect(reads).toBe(afterFirst);
+
+      fs.writeFileSync(file, "second version!");
+      expect(await cachedSha256OfHandle(counting, later())).toBe(sha256("second version!"));
+      expect(reads).toBeGreaterThan(afterFirst);
+    } finally {
+      await handle.close();
+    }
+  });
+});
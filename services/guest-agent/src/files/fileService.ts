@@ -2,9 +2,11 @@ import fs from "node:fs/promises";
 import path from "node:path";
 import { randomUUID } from "node:crypto";
 import type { FileService } from "../types/interfaces.js";
+import type { RawFileReadOptions, RawFileReadResult, RawFileWriteOptions, RawFileWriteResult } from "../types/agent.js";
 import { resolveWorkspacePathToChroot, resolveWorkspacePathToHost } from "./pathPolicy.js";
 import { JAIL_GROUP_ID, JAIL_USER_ID, spawnInJail, runInJail } from "../exec/jail.js";
-import { SANDBOX_ROOT } from "../config/constants.js";
+import { AGENT_STAGING_DIR } from "../config/constants.js";
+import { readRawFile, writeRawFile } from "./rawFile.js";
 const MAX_UPLOAD_COMPRESSED_BYTES = 10 * 1024 * 1024;
 const MAX_UPLOAD_UNCOMPRESSED_BYTES = 50 * 1024 * 1024;
 const MAX_REPLACE_TREE_COMPRESSED_BYTES = 100 * 1024 * 1024;
@@ -19,26 +21,26 @@ export class TarFileService implements FileService {
     // Ensure extracted files are writable when extraction runs as uid/gid 1000 inside the jail.
     await fs.chown(destHost, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
 
-    // Use /tmp inside the chroot (outside /workspace) so temp files don't interfere with user workflows.
-    const tmpName = `upload-${randomUUID()}.tar.gz`;
-    const tmpDirHost = path.join(SANDBOX_ROOT, "tmp");
-    await fs.mkdir(tmpDirHost, { recursive: true });
-    const tmpHost = path.join(tmpDirHost, tmpName);
-    const tmpChroot = `/tmp/${tmpName}`;
-
-    await streamToFile(payload, tmpHost, { maxBytes: MAX_REPLACE_TREE_COMPRESSED_BYTES });
-    await fs.chown(tmpHost, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
-    await validateTarInJail(tmpChroot, {
-      maxEntries: MAX_TAR_ENTRIES,
-      maxUncompressedBytes: MAX_REPLACE_TREE_UNCOMPRESSED_BYTES
-    });
+    const tmpHost = await stagingPath("upload");
+    try {
+      await streamToFile(payload, tmpHost, { maxBytes: MAX_REPLACE_TREE_COMPRESSED_BYTES });
+      await validateTarInJail(tmpHost, {
+        maxEntries: MAX_TAR_ENTRIES,
+        maxUncompressedBytes: MAX_REPLACE_TREE_UNCOMPRESSED_BYTES
+      });
 
-    // Extract as uid/gid 1000 and prevent archives from controlling ownership or modes.
-    const extract = await runInJail("/bin/tar", ["--no-same-owner", "--no-same-permissions", "--numeric-owner", "-xzf", tmpChroot, "-C", destChroot]);
-    if (extract.exitCode !== 0) {
-      throw new Error(`Failed to extract archive: ${extract.stderr.slice(0, 500)}`);
+      // Extract as uid/gid 1000 and prevent archives from controlling ownership or modes.
+      const extract = await runInJail(
+        "/bin/tar",
+        ["--no-same-owner", "--no-same-permissions", "--numeric-owner", "-xzf", "-", "-C", destChroot],
+        { stdinPath: tmpHost }
+      );
+      if (extract.exitCode !== 0) {
+        throw new Error(`Failed to extract archive: ${extract.stderr.slice(0, 500)}`);
+      }
+    } finally {
+      await fs.rm(tmpHost, { force: true }).catch(() => undefined);
     }
-    await fs.rm(tmpHost, { force: true }).catch(() => undefined);
   }
 
   async download(pathInput: string, replyStream: NodeJS.WritableStream): Promise<void> {
@@ -70,33 +72,49 @@ export class TarFileService implements FileService {
   ): Promise<void> {
     const destHost = resolveWorkspacePathToHost(dest);
     const destChroot = resolveWorkspacePathToChroot(dest);
-    const tmpName = `replace-tree-${randomUUID()}.tar.gz`;
-    const tmpDirHost = path.join(SANDBOX_ROOT, "tmp");
-    await fs.mkdir(tmpDirHost, { recursive: true });
-    const tmpHost = path.join(tmpDirHost, tmpName);
-    const tmpChroot = `/tmp/${tmpName}`;
-
-    await streamToFile(payload, tmpHost, { maxBytes: MAX_UPLOAD_COMPRESSED_BYTES });
-    await fs.chown(tmpHost, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
-    await validateTarInJail(tmpChroot, { maxEntries: MAX_TAR_ENTRIES, maxUncompressedBytes: MAX_UPLOAD_UNCOMPRESSED_BYTES });
-
-    await fs.rm(destHost, { recursive: true, force: true }).catch(() => undefined);
-    await fs.mkdir(destHost, { recursive: true });
-    await fs.chown(destHost, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
+    const tmpHost = await stagingPath("replace-tree");
+    try {
+      await streamToFile(payload, tmpHost, { maxBytes: MAX_UPLOAD_COMPRESSED_BYTES });
+      await validateTarInJail(tmpHost, { maxEntries: MAX_TAR_ENTRIES, maxUncompressedBytes: MAX_UPLOAD_UNCOMPRESSED_BYTES });
+
+      await fs.rm(destHost, { recursive: true, force: true }).catch(() => undefined);
+      await fs.mkdir(destHost, { recursive: true });
+      await fs.chown(destHost, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
+
+      const extract = await runInJail(
+        "/bin/tar",
+        ["--no-same-owner", "--no-same-permissions", "--numeric-owner", "-xzf", "-", "-C", destChroot],
+        { stdinPath: tmpHost }
+      );
+      if (extract.exitCode !== 0) {
+        throw new Error(`Failed to extract archive: ${extract.stderr.slice(0, 500)}`);
+      }
 
-    const extract = await runInJail("/bin/tar", ["--no-same-owner", "--no-same-permissions", "--numeric-owner", "-xzf", tmpChroot, "-C", destChroot]);
-    if (extract.exitCode !== 0) {
-      throw new Error(`Failed to extract archive: ${extract.stderr.slice(0, 500)}`);
+      const ownership = options.ownership ?? "root";
+      const ownerUid = ownership === "root" ? 0 : JAIL_USER_ID;
+      const ownerGid = ownership === "root" ? 0 : JAIL_GROUP_ID;
+      await applyOwnershipAndMode(destHost, { uid: ownerUid, gid: ownerGid, readOnly: options.readOnly ?? false });
+    } finally {
+      await fs.rm(tmpHost, { force: true }).catch(() => undefined);
     }
+  }
+
+  async readRaw(pathInput: string, options?: RawFileReadOptions): Promise<RawFileReadResult> {
+    return readRawFile(pathInput, options);
+  }
 
-    const ownership = options.ownership ?? "root";
-    const ownerUid = ownership === "root" ? 0 : JAIL_USER_ID;
-    const ownerGid = ownership === "root" ? 0 : JAIL_GROUP_ID;
-    await applyOwnershipAndMode(destHost, { uid: ownerUid, gid: ownerGid, readOnly: options.readOnly ?? false });
-    await fs.rm(tmpHost, { force: true }).catch(() => undefined);
+  async writeRaw(pathInput: string, payload: NodeJS.ReadableStream, options?: RawFileWriteOptions): Promise<RawFileWriteResult> {
+    return writeRawFile(pathInput, payload, options);
   }
 }
 
+// Archives are staged in a root-only directory outside the jail and fed to the jailed tar on stdin,
+// so jailed processes can neither see them nor swap them between validation and extraction.
+async function stagingPath(prefix: string): Promise<string> {
+  await fs.mkdir(AGENT_STAGING_DIR, { recursive: true, mode: 0o700 });
+  return path.join(AGENT_STAGING_DIR, `${prefix}-${randomUUID()}.tar.gz`);
+}
+
 async function streamToFile(stream: NodeJS.ReadableStream, target: string, opts: { maxBytes: number }): Promise<void> {
   const handle = await fs.open(target, "w");
   try {
@@ -129,12 +147,12 @@ async function streamToFile(stream: NodeJS.ReadableStream, target: string, opts:
 }
 
 async function validateTarInJail(
-  archiveChrootPath: string,
+  archiveHostPath: string,
   opts: { maxEntries: number; maxUncompressedBytes: number }
 ): Promise<void> {
   // Tar listing can be large; allow a bit more output for validation than generic exec.
   const maxOutputBytes = 6_000_000;
-  const listRes = await runInJail("/bin/tar", ["-tzf", archiveChrootPath], { maxOutputBytes });
+  const listRes = await runInJail("/bin/tar", ["-tzf", "-"], { maxOutputBytes, stdinPath: archiveHostPath });
   if (listRes.exitCode !== 0) {
     throw new Error("Invalid tar archive");
   }
@@ -149,7 +167,7 @@ async function validateTarInJail(
     }
   }
 
-  const verboseRes = await runInJail("/bin/tar", ["-tvzf", archiveChrootPath], { maxOutputBytes });
+  const verboseRes = await runInJail("/bin/tar", ["-tvzf", "-"], { maxOutputBytes, stdinPath: archiveHostPath });
   if (verboseRes.exitCode !== 0) {
     throw new Error("Invalid tar archive");
   }
@@ -0,0 +1,294 @@
+import fs from "node:fs/promises";
+import { constants as fsConstants, type BigIntStats } from "node:fs";
+import path from "node:path";
+import { createHash, randomUUID } from "node:crypto";
+import { Readable } from "node:stream";
+import type { FileHandle } from "node:fs/promises";
+import type { RawFileReadOptions, RawFileReadResult, RawFileWriteOptions, RawFileWriteResult } from "../types/agent.js";
+import { USER_HOME } from "../config/constants.js";
+import { JAIL_GROUP_ID, JAIL_USER_ID } from "../exec/jail.js";
+import { WORKSPACE_ROOT, resolveWorkspacePathToHost } from "./pathPolicy.js";
+
+export const MAX_RAW_WRITE_BYTES = 10 * 1024 * 1024;
+const HASH_CHUNK_BYTES = 64 * 1024;
+const SHA256_CACHE_ENTRIES = 1024;
+// Filesystem timestamps tick coarsely (a few ms on ext4), so a same-size rewrite right after a hash
+// can leave every stat field unchanged; files changed this recently are always hashed afresh.
+const SHA256_CACHE_MIN_AGE_NS = 2_000_000_000n;
+
+// Content hashes by file identity, size and change times, so repeated and ranged GETs of an
+// unchanged file do not read it end to end again. Any write moves ctime, which user code cannot
+// set back. Oldest entries are evicted first.
+const sha256Cache = new Map<string, string>();
+
+/**
+ * Error carrying the HTTP status the API layer should surface (404/412/416/...).
+ */
+export class RawFileError extends Error {
+  constructor(
+    public readonly statusCode: number,
+    message: string,
+    public readonly size?: number
+  ) {
+    super(message);
+    this.name = "RawFileError";
+  }
+}
+
+export async function readRawFile(pathInput: string, options: RawFileReadOptions = {}): Promise<RawFileReadResult> {
+  const hostPath = await resolveExistingInWorkspace(pathInput);
+  // The agent runs as root outside the chroot, so never follow a final-component symlink.
+  const handle = await openNoFollow(hostPath, fsConstants.O_RDONLY);
+  try {
+    const stats = await handle.stat();
+    if (!stats.isFile()) {
+      throw new RawFileError(400, "Path is not a regular file");
+    }
+    const sha256 = await cachedSha256OfHandle(handle);
+    checkIfMatch(options.ifMatch, sha256);
+
+    const size = stats.size;
+    const range = parseByteRange(options.range, size);
+    if (range === "unsatisfiable") {
+      throw new RawFileError(416, "Requested range not satisfiable", size);
+    }
+    const start = range?.start ?? 0;
+    const end = range?.end ?? size - 1;
+
+    if (size === 0) {
+      await handle.close();
+      return { stream: Readable.from([]), size, start: 0, end: -1, partial: false, sha256 };
+    }
+    // The stream owns the descriptor from here on (autoClose defaults to true).
+    const stream = handle.createReadStream({ start, end });
+    return { stream, size, start, end, partial: Boolean(range), sha256 };
+  } catch (err) {
+    await handle.close().catch(() => undefined);
+    throw err;
+  }
+}
+
+export async function writeRawFile(
+  pathInput: string,
+  payload: NodeJS.ReadableStream,
+  options: RawFileWriteOptions = {}
+): Promise<RawFileWriteResult> {
+  const hostPath = resolveWorkspacePathToHost(pathInput);
+  if (hostPath === USER_HOME) {
+    throw new RawFileError(400, "Path must name a file inside /workspace");
+  }
+  const parentHost = await ensureParentInWorkspace(path.dirname(hostPath));
+  const targetHost = path.join(parentHost, path.basename(hostPath));
+
+  // Write next to the target and rename into place so readers never observe a partial file.
+  const tmpHost = path.join(parentHost, `.raw-${randomUUID()}.tmp`);
+  const existingMode = await fs
+    .lstat(targetHost)
+    .then((st) => {
+      if (st.isDirectory()) throw new RawFileError(400, "Path is a directory");
+      return st.isFile() ? st.mode & 0o777 : undefined;
+    })
+    .catch((err) => {
+      if (err instanceof RawFileError) throw err;
+      return undefined;
+    });
+
+  const handle = await fs.open(tmpHost, "wx", existingMode ?? 0o644);
+  let size = 0;
+  let sha256 = "";
+  try {
+    const hash = createHash("sha256");
+    const maxBytes = options.maxBytes ?? MAX_RAW_WRITE_BYTES;
+    for await (const chunk of payload as AsyncIterable<Buffer | string>) {
+      const buf = Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk);
+      size += buf.length;
+      if (size > maxBytes) {
+        throw new RawFileError(413, `Upload exceeds max bytes (${maxBytes})`);
+      }
+      hash.update(buf);
+      await handle.write(buf);
+    }
+    sha256 = hash.digest("hex");
+    await handle.chown(JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
+    await handle.close();
+
+    if (options.ifMatch) {
+      // Check as late as possible to keep the compare-and-swap window small.
+      const current = await currentSha256(targetHost);
+      if (current === null) {
+        throw new RawFileError(412, "Precondition failed: file does not exist");
+      }
+      checkIfMatch(options.ifMatch, current);
+    }
+    await fs.rename(tmpHost, targetHost);
+  } catch (err) {
+    await handle.close().catch(() => undefined);
+    await fs.rm(tmpHost, { force: true }).catch(() => undefined);
+    throw err;
+  }
+
+  return { path: toWorkspacePath(targetHost), size, sha256 };
+}
+
+/**
+ * Parse a single `bytes=` range (RFC 9110). Returns null when the header is absent or
+ * unsupported (the caller then serves the whole file), or "unsatisfiable" for 416.
+ */
+export function parseByteRange(
+  header: string | undefined,
+  size: number
+): { start: number; end: number } | null | "unsatisfiable" {
+  if (!header) return null;
+  const match = /^bytes=(\d*)-(\d*)$/.exec(header.trim());
+  if (!match) return null;
+  const [, startRaw, endRaw] = match;
+  if (!startRaw && !endRaw) return null;
+
+  if (!startRaw) {
+    // Suffix range: last N bytes.
+    const suffix = Number(endRaw);
+    if (suffix === 0 || size === 0) return "unsatisfiable";
+    return { start: Math.max(0, size - suffix), end: size - 1 };
+  }
+
+  const start = Number(startRaw);
+  const end = endRaw ? Math.min(Number(endRaw), size - 1) : size - 1;
+  if (start >= size || (endRaw && Number(endRaw) < start)) return "unsatisfiable";
+  return { start, end };
+}
+
+function checkIfMatch(ifMatch: string | undefined, sha256: string): void {
+  if (!ifMatch) return;
+  const candidates = ifMatch
+    .split(",")
+    .map((v) => v.trim().replace(/^W\//, "").replace(/^"|"$/g, "").replace(/^sha256:/, "").toLowerCase())
+    .filter(Boolean);
+  if (candidates.includes("*") || candidates.includes(sha256)) return;
+  throw new RawFileError(412, "Precondition failed: content hash does not match");
+}
+
+async function currentSha256(hostPath: string): Promise<string | null> {
+  let handle: FileHandle;
+  try {
+    handle = await openNoFollow(hostPath, fsConstants.O_RDONLY);
+  } catch (err: any) {
+    if (err?.code === "ENOENT") return null;
+    throw err;
+  }
+  try {
+    return await cachedSha256OfHandle(handle);
+  } finally {
+    await handle.close().catch(() => undefined);
+  }
+}
+
+/** sha256 of an open file, served from the cache while its inode, size, mtime and ctime are unchanged. */
+export async function cachedSha256OfHandle(handle: FileHandle, nowMs = Date.now()): Promise<string> {
+  const stats = await handle.stat({ bigint: true });
+  const before = statKey(stats);
+  const cached = sha256Cache.get(before);
+  if (cached !== undefined) return cached;
+  const sha256 = await sha256OfHandle(handle);
+  const settled = BigInt(nowMs) * 1_000_000n - stats.ctimeNs >= SHA256_CACHE_MIN_AGE_NS;
+  // Only a hash of content that did not change while it was being read may be reused.
+  if (settled && statKey(await handle.stat({ bigint: true })) === before) {
+    if (sha256Cache.size >= SHA256_CACHE_ENTRIES) {
+      sha256Cache.delete(sha256Cache.keys().next().value!);
+    }
+    sha256Cache.set(before, sha256);
+  }
+  return sha256;
+}
+
+function statKey(st: BigIntStats): string {
+  return `${st.dev}:${st.ino}:${st.size}:${st.mtimeNs}:${st.ctimeNs}`;
+}
+
+async function sha256OfHandle(handle: FileHandle): Promise<string> {
+  const hash = createHash("sha256");
+  const buf = Buffer.allocUnsafe(HASH_CHUNK_BYTES);
+  let position = 0;
+  for (;;) {
+    const { bytesRead } = await handle.read(buf, 0, buf.length, position);
+    if (bytesRead === 0) break;
+    hash.update(buf.subarray(0, bytesRead));
+    position += bytesRead;
+  }
+  return hash.digest("hex");
+}
+
+async function openNoFollow(hostPath: string, flags: number): Promise<FileHandle> {
+  try {
+    return await fs.open(hostPath, flags | fsConstants.O_NOFOLLOW);
+  } catch (err: any) {
+    if (err?.code === "ELOOP") throw new RawFileError(400, "Symlinks are not allowed");
+    throw err;
+  }
+}
+
+function isInsideUserHome(realPath: string): boolean {
+  return realPath === USER_HOME || realPath.startsWith(USER_HOME + path.sep);
+}
+
+async function resolveExistingInWorkspace(pathInput: string): Promise<string> {
+  const hostPath = resolveWorkspacePathToHost(pathInput);
+  let real: string;
+  try {
+    real = await fs.realpath(path.dirname(hostPath));
+  } catch (err: any) {
+    if (err?.code === "ENOENT") throw new RawFileError(404, "File not found");
+    throw err;
+  }
+  if (!isInsideUserHome(real)) {
+    throw new RawFileError(400, "Path escapes /workspace");
+  }
+  const target = path.join(real, path.basename(hostPath));
+  try {
+    await fs.lstat(target);
+  } catch (err: any) {
+    if (err?.code === "ENOENT") throw new RawFileError(404, "File not found");
+    throw err;
+  }
+  return target;
+}
+
+/**
+ * Create the parent directory chain (owned by the jail user) and return its real path,
+ * refusing to traverse symlinks that point outside /workspace.
+ */
+async function ensureParentInWorkspace(parentHost: string): Promise<string> {
+  const missing: string[] = [];
+  let existing = parentHost;
+  for (;;) {
+    try {
+      await fs.lstat(existing);
+      break;
+    } catch (err: any) {
+      if (err?.code !== "ENOENT") throw err;
+      missing.unshift(path.basename(existing));
+      existing = path.dirname(existing);
+    }
+  }
+  const real = await fs.realpath(existing);
+  if (!isInsideUserHome(real)) {
+    throw new RawFileError(400, "Path escapes /workspace");
+  }
+  const realStats = await fs.stat(real);
+  if (!realStats.isDirectory()) {
+    throw new RawFileError(400, "Parent path is not a directory");
+  }
+  let current = real;
+  for (const segment of missing) {
+    current = path.join(current, segment);
+    await fs.mkdir(current).catch((err) => {
+      if (err?.code !== "EEXIST") throw err;
+    });
+    await fs.chown(current, JAIL_USER_ID, JAIL_GROUP_ID).catch(() => undefined);
+  }
+  return current;
+}
+
+function toWorkspacePath(hostPath: string): string {
+  const rel = path.relative(USER_HOME, hostPath);
+  return rel ? path.posix.join(WORKSPACE_ROOT, rel.split(path.sep).join("/")) : WORKSPACE_ROOT;
+}
@@ -5,23 +5,52 @@ import { ensureExecSandboxReady } from "./exec/sandboxSetup.js";
 import { TarFileService } from "./files/fileService.js";
 import { IptablesFirewallManager } from "./firewall/firewallManager.js";
 import { IpNetworkConfigurator } from "./network/networkConfigurator.js";
+import { captureResetBaseline } from "./recycle/tenantReset.js";
+import { restoreCheckpointMounts } from "./checkpoint/workspaceCheckpoints.js";
 
 (async () => {
   const env = loadEnv();
+  if (process.env.RDS_AGENT_WARMUP === "1") {
+    // Image build (V8 code cache) and startup benchmarks: run the startup code paths without
+    // touching the sandbox, the network or the filesystem.
+    await warmup();
+    return;
+  }
   await ensureExecSandboxReady();
-
-  const app = buildApp({
-    execRunner: new ExecRunnerImpl(),
-    fileService: new TarFileService(),
-    firewallManager: new IptablesFirewallManager(),
-    networkConfigurator: new IpNetworkConfigurator()
+  await restoreCheckpointMounts().catch((err) => {
+    // eslint-disable-next-line no-console
+    console.error("Failed to restore workspace checkpoints", err);
   });
+  // Anything written to the overlay after this point is tenant state and is reverted on recycle.
+  await captureResetBaseline();
+
+  const app = createApp();
 
   // The guest agent is accessed via the vsock->TCP bridge (socat) on guest loopback.
   // Binding to 127.0.0.1 reduces exposure on the guest network interface.
   await app.listen({ port: env.port, host: "127.0.0.1" });
+  // Time from process start, so boots with and without the bundle/code cache can be compared.
+  app.log.info({ startupMs: Math.round(performance.now()) }, "guest agent listening");
 })().catch((err) => {
   // eslint-disable-next-line no-console
   console.error("Failed to start guest agent", err);
   process.exit(1);
 });
+
+function createApp() {
+  return buildApp({
+    execRunner: new ExecRunnerImpl(),
+    fileService: new TarFileService(),
+    firewallManager: new IptablesFirewallManager(),
+    networkConfigurator: new IpNetworkConfigurator()
+  });
+}
+
+async function warmup(): Promise<void> {
+  const started = performance.now();
+  const app = createApp();
+  await app.ready();
+  await app.close();
+  // eslint-disable-next-line no-console
+  console.info("[guest-agent] warmup", { startupMs: Math.round(performance.now()), readyMs: Math.round(performance.now() - started) });
+}
@@ -0,0 +1,85 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { revertOverlayChanges, snapshotUpperLayer } from "../tenantReset.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+// Simulates an overlay mount with three plain directories: the test writes every tenant change
+// to both `merged` (what the guest sees) and `upper` (what overlayfs would copy up).
+function makeLayers() {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), "tenant-reset-"));
+  tempDirs.push(root);
+  const layers = {
+    lower: path.join(root, "lower"),
+    upper: path.join(root, "upper"),
+    merged: path.join(root, "merged")
+  };
+  for (const dir of Object.values(layers)) fs.mkdirSync(dir);
+  const write = (layer: string, rel: string, content: string) => {
+    const p = path.join(layer, rel);
+    fs.mkdirSync(path.dirname(p), { recursive: true });
+    fs.writeFileSync(p, content);
+  };
+  const tenantWrite = (rel: string, content: string) => {
+    write(layers.upper, rel, content);
+    write(layers.merged, rel, content);
+  };
+  return { ...layers, write, tenantWrite };
+}
+
+describe("revertOverlayChanges", () => {
+  it("removes new files and restores modified image files", async () => {
+    const l = makeLayers();
+    l.write(l.lower, "home/user/.profile", "image");
+    l.write(l.merged, "home/user/.profile", "image");
+    l.tenantWrite("etc/boot.conf", "written at boot");
+    const baseline = await snapshotUpperLayer(l.upper);
+
+    l.tenantWrite("home/user/.profile", "tenant");
+    l.tenantWrite("home/user/secret/key.pem", "private");
+    l.tenantWrite("tmp/scratch", "data");
+
+    const result = await revertOverlayChanges({
+      upperDir: l.upper,
+      lowerRoot: l.lower,
+      mergedRoot: l.merged,
+      baseline,
+      mountPoints: new Set()
+    });
+
+    expect(fs.readFileSync(path.join(l.merged, "home/user/.profile"), "utf-8")).toBe("image");
+    expect(fs.existsSync(path.join(l.merged, "home/user/secret"))).toBe(false);
+    expect(fs.existsSync(path.join(l.merged, "tmp"))).toBe(false);
+    expect(fs.readFileSync(path.join(l.merged, "etc/boot.conf"), "utf-8")).toBe("written at boot");
+    expect(result).toEqual({ removedPaths: 2, restoredPaths: 1 });
+  });
+
+  it("restores deleted image files and never touches mount points", async () => {
+    const l = makeLayers();
+    l.write(l.lower, "opt/tool/bin", "image");
+    l.tenantWrite("opt/sandbox/workspace/keep", "bind mounted");
+    const baseline = await snapshotUpperLayer(l.upper);
+
+    // A whiteout: the tenant deleted an image file, overlayfs recorded it in upper.
+    fs.mkdirSync(path.join(l.upper, "opt/tool"), { recursive: true });
+    fs.writeFileSync(path.join(l.upper, "opt/tool/bin"), "");
+    l.tenantWrite("opt/sandbox/workspace/new", "bind mounted");
+
+    await revertOverlayChanges({
+      upperDir: l.upper,
+      lowerRoot: l.lower,
+      mergedRoot: l.merged,
+      baseline,
+      mountPoints: new Set([path.join(l.merged, "opt/sandbox/workspace")])
+    });
+
+    expect(fs.readFileSync(path.join(l.merged, "opt/tool/bin"), "utf-8")).toBe("image");
+    expect(fs.existsSync(path.join(l.merged, "opt/sandbox/workspace/new"))).toBe(true);
+  });
+});
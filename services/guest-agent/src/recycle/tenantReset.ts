@@ -0,0 +1,195 @@
+import { spawn } from "node:child_process";
+import fs from "node:fs/promises";
+import type { Stats } from "node:fs";
+import path from "node:path";
+import { AGENT_STAGING_DIR, SANDBOX_TMP } from "../config/constants.js";
+import { discardCheckpoints } from "../checkpoint/workspaceCheckpoints.js";
+import { killJailedProcesses } from "../exec/jailProcesses.js";
+import { resetExecSandbox } from "../exec/sandboxSetup.js";
+import { prepareForSnapshot } from "../snapshot/snapshotPrepare.js";
+import type { TenantResetResult } from "../types/agent.js";
+
+// guest-init pivots into an overlayfs whose lower layer (the image) stays mounted at /oldroot
+// and whose upper layer lives on the overlay disk mounted at /oldroot/mnt/overlay.
+const LOWER_ROOT = "/oldroot";
+const UPPER_DIR = "/oldroot/mnt/overlay/upper";
+// tmpfs mounts are not part of the overlay; wipe them wholesale, along with any archive an upload
+// left staged.
+const EPHEMERAL_DIRS = ["/dev/shm", SANDBOX_TMP, AGENT_STAGING_DIR];
+
+/** Upper-layer entry fingerprint; ctime cannot be forged from userspace, unlike mtime. */
+export type OverlayBaseline = Map<string, string>;
+
+let baseline: OverlayBaseline | null = null;
+
+/**
+ * Record the upper-layer state right after boot (or, for snapshot clones, the state the snapshot
+ * was taken in). Anything that differs from it at reset time belongs to the tenant.
+ */
+export async function captureResetBaseline(): Promise<void> {
+  baseline = await snapshotUpperLayer(UPPER_DIR).catch(() => null);
+}
+
+/**
+ * Return the guest to its post-boot state so it can serve another tenant:
+ * kill every jailed process, revert every overlay change made since the baseline,
+ * wipe tmpfs scratch space, re-run sandbox setup and scrub free memory.
+ *
+ * Throws if the guest cannot guarantee a clean reset (legacy rootfs, missing baseline,
+ * processes that refuse to die); the caller must then destroy the VM instead.
+ */
+export async function resetForNextTenant(): Promise<TenantResetResult> {
+  const started = Date.now();
+  if (!baseline) throw new Error("no overlay baseline; recycling requires an overlay root");
+  await fs.access(UPPER_DIR);
+
+  const killedProcesses = await killJailedProcesses();
+  // Checkpoint layers sit outside the root overlay; drop them before reverting it.
+  await discardCheckpoints();
+  const overlay = await revertOverlayChanges({
+    upperDir: UPPER_DIR,
+    lowerRoot: LOWER_ROOT,
+    mergedRoot: "/",
+    baseline,
+    mountPoints: await readMountPoints()
+  });
+  for (const dir of EPHEMERAL_DIRS) await emptyDir(dir).catch(() => undefined);
+
+  await resetExecSandbox();
+  const memory = await prepareForSnapshot();
+
+  return {
+    durationMs: Date.now() - started,
+    killedProcesses,
+    removedPaths: overlay.removedPaths,
+    restoredPaths: overlay.restoredPaths,
+    memory
+  };
+}
+
+export async function snapshotUpperLayer(upperDir: string): Promise<OverlayBaseline> {
+  const out: OverlayBaseline = new Map();
+  const walk = async (rel: string) => {
+    const entries = await fs.readdir(path.join(upperDir, rel), { withFileTypes: true });
+    for (const entry of entries) {
+      const child = path.posix.join(rel, entry.name);
+      const st = await fs.lstat(path.join(upperDir, child));
+      out.set(child, fingerprint(st));
+      if (st.isDirectory()) await walk(child);
+    }
+  };
+  await walk("");
+  return out;
+}
+
+export type OverlayRevertOptions = {
+  upperDir: string;
+  lowerRoot: string;
+  mergedRoot: string;
+  baseline: OverlayBaseline;
+  /** Merged-view paths that must never be removed or descended into. */
+  mountPoints: Set<string>;
+};
+
+/**
+ * Walk the upper layer and undo every entry that is new or changed since `baseline`:
+ * entries without a lower counterpart are removed, others are copied back from the lower layer.
+ * Whiteouts (deleted image files) show up as changed entries and are restored the same way.
+ */
+export async function revertOverlayChanges(
+  opts: OverlayRevertOptions
+): Promise<{ removedPaths: number; restoredPaths: number }> {
+  let removedPaths = 0;
+  let restoredPaths = 0;
+  const merged = (rel: string) => path.join(opts.mergedRoot, rel);
+  const lower = (rel: string) => path.join(opts.lowerRoot, rel);
+
+  const walk = async (rel: string) => {
+    const entries = await fs.readdir(path.join(opts.upperDir, rel)).catch(() => [] as string[]);
+    for (const name of entries) {
+      const child = path.posix.join(rel, name);
+      if (opts.mountPoints.has(merged(child))) continue;
+      const upperSt = await fs.lstat(path.join(opts.upperDir, child)).catch(() => null);
+      if (!upperSt) continue;
+      const known = opts.baseline.get(child);
+      const changed = known !== fingerprint(upperSt);
+      const lowerSt = await fs.lstat(lower(child)).catch(() => null);
+      const wasDir = known !== undefined && (Number(known.split(":")[0]) & 0o170000) === 0o040000;
+
+      // Directories that existed at baseline (or in the image) are kept and reverted entry by entry.
+      if (upperSt.isDirectory() && (wasDir || lowerSt?.isDirectory())) {
+        if (changed && lowerSt?.isDirectory()) {
+          await fs.lchown(merged(child), lowerSt.uid, lowerSt.gid).catch(() => undefined);
+          await fs.chmod(merged(child), lowerSt.mode & 0o7777).catch(() => undefined);
+        }
+        await walk(child);
+        // An opaque directory hides every lower child; bring back whatever is missing.
+        if (changed && lowerSt?.isDirectory()) restoredPaths += await restoreMissingChildren(child);
+        continue;
+      }
+      if (!changed) continue;
+
+      await fs.rm(merged(child), { recursive: true, force: true });
+      if (lowerSt) {
+        await copyFromLower(lower(child), merged(child));
+        restoredPaths++;
+      } else {
+        removedPaths++;
+      }
+    }
+  };
+
+  const restoreMissingChildren = async (rel: string) => {
+    let restored = 0;
+    const names = await fs.readdir(lower(rel)).catch(() => [] as string[]);
+    for (const name of names) {
+      const child = path.posix.join(rel, name);
+      if (opts.mountPoints.has(merged(child))) continue;
+      if (await fs.lstat(merged(child)).then(() => true, () => false)) continue;
+      await copyFromLower(lower(child), merged(child));
+      restored++;
+    }
+    return restored;
+  };
+
+  await walk("");
+  return { removedPaths, restoredPaths };
+}
+
+function fingerprint(st: Stats): string {
+  return `${st.mode}:${st.uid}:${st.gid}:${st.size}:${st.rdev}:${st.ctimeMs}`;
+}
+
+async function copyFromLower(src: string, dest: string): Promise<void> {
+  await fs.mkdir(path.dirname(dest), { recursive: true });
+  await run("cp", ["-a", src, dest]);
+}
+
+async function emptyDir(dir: string): Promise<void> {
+  for (const name of await fs.readdir(dir)) {
+    await fs.rm(path.join(dir, name), { recursive: true, force: true });
+  }
+}
+
+async function readMountPoints(): Promise<Set<string>> {
+  const content = await fs.readFile("/proc/self/mountinfo", "utf-8");
+  const out = new Set<string>();
+  for (const line of content.split("\n")) {
+    const parts = line.split(" ");
+    if (parts.length >= 5) out.add(parts[4]);
+  }
+  return out;
+}
+
+async function run(cmd: string, args: string[]): Promise<void> {
+  await new Promise<void>((resolve, reject) => {
+    const proc = spawn(cmd, args, { stdio: ["ignore", "ignore", "pipe"] });
+    let stderr = "";
+    proc.stderr.on("data", (d) => (stderr += String(d)));
+    proc.on("error", reject);
+    proc.on("close", (code) => {
+      if (code === 0) return resolve();
+      reject(new Error(`${cmd} exited with code ${code ?? -1}: ${stderr.slice(0, 200)}`));
+    });
+  });
+}
@@ -0,0 +1,87 @@
+import fs from "node:fs/promises";
+import { spawn } from "node:child_process";
+import type { SnapshotPrepareRequest, SnapshotPrepareResult } from "../types/agent.js";
+
+const ZERO_FILL_CHUNK_BYTES = 16 * 1024 * 1024;
+const MIN_RESERVE_BYTES = 32 * 1024 * 1024;
+
+// Runs in a short-lived child so the touched memory is returned to the kernel (zeroed) on exit.
+const ZERO_FILL_SCRIPT = `
+const total = Number(process.argv[1]);
+const chunk = ${ZERO_FILL_CHUNK_BYTES};
+const held = [];
+for (let n = 0; n < total; n += chunk) held.push(Buffer.allocUnsafe(Math.min(chunk, total - n)).fill(0));
+`;
+
+/**
+ * Shrink what a memory snapshot captures: flush dirty data, drop page cache/slab, compact,
+ * collect the agent heap, then overwrite free pages with zeros so the host can store them as holes.
+ * Every step is best-effort; failures are reported in `warnings`.
+ */
+export async function prepareForSnapshot(request: SnapshotPrepareRequest = {}): Promise<SnapshotPrepareResult> {
+  const started = Date.now();
+  const warnings: string[] = [];
+  const step = async (name: string, fn: () => Promise<unknown>) => {
+    try {
+      await fn();
+    } catch (err) {
+      warnings.push(`${name}: ${String((err as any)?.message ?? err)}`);
+    }
+  };
+
+  const memFreeKbBefore = await readMemInfoKb("MemFree");
+
+  await step("sync", () => run("sync", []));
+  if (request.dropCaches !== false) {
+    await step("drop_caches", () => fs.writeFile("/proc/sys/vm/drop_caches", "3"));
+  }
+  if (request.gc !== false) {
+    // Only available when the agent runs with --expose-gc (guest-init passes it).
+    const gc = (globalThis as { gc?: () => void }).gc;
+    if (gc) gc();
+    else warnings.push("gc: not exposed");
+  }
+  if (request.compactMemory !== false) {
+    await step("compact_memory", () => fs.writeFile("/proc/sys/vm/compact_memory", "1"));
+  }
+
+  let zeroedBytes = 0;
+  if (request.zeroFreeMemory !== false) {
+    await step("zero_free_memory", async () => {
+      const freeKb = await readMemInfoKb("MemFree");
+      const totalKb = await readMemInfoKb("MemTotal");
+      const reserve = Math.max(MIN_RESERVE_BYTES, Math.floor(totalKb * 1024 * 0.05));
+      const target = freeKb * 1024 - reserve;
+      if (target <= 0) return;
+      await run(process.execPath, ["-e", ZERO_FILL_SCRIPT, String(target)]);
+      zeroedBytes = target;
+    });
+  }
+
+  return {
+    durationMs: Date.now() - started,
+    memFreeKbBefore,
+    memFreeKbAfter: await readMemInfoKb("MemFree"),
+    zeroedBytes,
+    warnings
+  };
+}
+
+async function readMemInfoKb(field: string): Promise<number> {
+  const text = await fs.readFile("/proc/meminfo", "utf-8").catch(() => "");
+  const match = new RegExp(`^${field}:\\s+(\\d+) kB`, "m").exec(text);
+  return match ? Number(match[1]) : 0;
+}
+
+async function run(cmd: string, args: string[]): Promise<void> {
+  await new Promise<void>((resolve, reject) => {
+    const proc = spawn(cmd, args, { stdio: ["ignore", "ignore", "pipe"] });
+    let stderr = "";
+    proc.stderr.on("data", (d) => (stderr += String(d)));
+    proc.on("error", reject);
+    proc.on("close", (code) => {
+      if (code === 0) return resolve();
+      reject(new Error(`${cmd} exited with code ${code ?? -1}: ${stderr.slice(0, 200)}`));
+    });
+  });
+}
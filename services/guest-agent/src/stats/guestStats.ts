@@ -0,0 +1,48 @@
+import fs from "node:fs/promises";
+import type { GuestStats } from "../types/agent.js";
+
+// guest-init sets up zram0 as swap when the manager passes rds_zram_mb.
+const ZRAM_SYSFS = "/sys/block/zram0";
+
+export async function readGuestStats(): Promise<GuestStats> {
+  const [meminfo, vmstat, uptime] = await Promise.all([
+    fs.readFile("/proc/meminfo", "utf-8").catch(() => ""),
+    fs.readFile("/proc/vmstat", "utf-8").catch(() => ""),
+    fs.readFile("/proc/uptime", "utf-8").catch(() => "")
+  ]);
+  const kb = (field: string) => {
+    const match = new RegExp(`^${field}:\\s+(\\d+) kB`, "m").exec(meminfo);
+    return match ? Number(match[1]) : 0;
+  };
+  const counter = (field: string) => {
+    const match = new RegExp(`^${field} (\\d+)$`, "m").exec(vmstat);
+    return match ? Number(match[1]) : 0;
+  };
+  const zram = await readZramStats();
+
+  return {
+    uptimeSec: Math.floor(Number(uptime.split(" ")[0]) || 0),
+    memory: {
+      memTotalKb: kb("MemTotal"),
+      memAvailableKb: kb("MemAvailable"),
+      swapTotalKb: kb("SwapTotal"),
+      swapFreeKb: kb("SwapFree"),
+      swapInPages: counter("pswpin"),
+      swapOutPages: counter("pswpout"),
+      ...(zram ? { zram } : {})
+    }
+  };
+}
+
+async function readZramStats(): Promise<GuestStats["memory"]["zram"] | null> {
+  const diskSize = Number((await fs.readFile(`${ZRAM_SYSFS}/disksize`, "utf-8").catch(() => "0")).trim());
+  if (!diskSize) return null;
+  // mm_stat: orig_data_size compr_data_size mem_used_total mem_limit mem_used_max same_pages ...
+  const mmStat = (await fs.readFile(`${ZRAM_SYSFS}/mm_stat`, "utf-8").catch(() => "")).trim().split(/\s+/).map(Number);
+  return {
+    diskSizeBytes: diskSize,
+    origDataBytes: mmStat[0] || 0,
+    comprDataBytes: mmStat[1] || 0,
+    memUsedBytes: mmStat[2] || 0
+  };
+}
@@ -44,6 +44,8 @@ export interface ExecResult {
    * Optional structured error from the executed script (set via global `result.error(...)`).
    */
   error?: unknown;
+  /** Set when the guest memory guard killed the command to keep the VM responsive. */
+  memoryPressureKilled?: boolean;
 }
 
 export interface TimeSyncRequest {
@@ -53,6 +55,71 @@ export interface TimeSyncRequest {
   unixTimeMs: number;
 }
 
+export interface EntropySeedRequest {
+  /** Host-generated random bytes (hex, up to 64 bytes) credited to the guest CRNG. */
+  seedHex: string;
+}
+
+export interface SnapshotPrepareRequest {
+  /** Drop page cache, dentries and inodes (default true). */
+  dropCaches?: boolean;
+  /** Ask the kernel to compact free memory (default true). */
+  compactMemory?: boolean;
+  /** Run a full GC of the agent heap (default true). */
+  gc?: boolean;
+  /** Overwrite free pages with zeros so they are stored as holes (default true). */
+  zeroFreeMemory?: boolean;
+}
+
+export interface SnapshotPrepareResult {
+  durationMs: number;
+  memFreeKbBefore: number;
+  memFreeKbAfter: number;
+  zeroedBytes: number;
+  warnings: string[];
+}
+
+export interface GuestStats {
+  uptimeSec: number;
+  memory: {
+    memTotalKb: number;
+    memAvailableKb: number;
+    swapTotalKb: number;
+    swapFreeKb: number;
+    /** Pages swapped in/out since boot (/proc/vmstat pswpin/pswpout). */
+    swapInPages: number;
+    swapOutPages: number;
+    /** Present when swap is backed by a zram device. */
+    zram?: {
+      diskSizeBytes: number;
+      origDataBytes: number;
+      comprDataBytes: number;
+      memUsedBytes: number;
+    };
+  };
+}
+
+export interface WorkspaceCheckpoint {
+  id: string;
+  createdAt: string;
+  label?: string;
+}
+
+export interface CheckpointCreateRequest {
+  label?: string;
+}
+
+export interface TenantResetResult {
+  durationMs: number;
+  /** Jailed processes killed before the filesystem was reverted. */
+  killedProcesses: number;
+  /** Overlay entries with no image counterpart that were deleted. */
+  removedPaths: number;
+  /** Overlay entries copied back from the image (modified or deleted by the tenant). */
+  restoredPaths: number;
+  memory: SnapshotPrepareResult;
+}
+
 export interface NetConfigRequest {
   /**
    * Only eth0 is supported for now.
@@ -73,3 +140,42 @@ export interface NetConfigRequest {
    */
   dnsOnly?: boolean;
 }
+
+export interface RawFileReadOptions {
+  /**
+   * HTTP Range header value. Only a single `bytes=` range is honoured; multi-range
+   * requests fall back to the full body.
+   */
+  range?: string;
+  /**
+   * Optional precondition: the request fails with 412 unless the file's current
+   * sha256 (hex, optionally quoted) matches. `*` only requires the file to exist.
+   */
+  ifMatch?: string;
+}
+
+export interface RawFileReadResult {
+  stream: NodeJS.ReadableStream;
+  /** Total file size in bytes. */
+  size: number;
+  /** Inclusive byte range being served. */
+  start: number;
+  end: number;
+  partial: boolean;
+  sha256: string;
+}
+
+export interface RawFileWriteOptions {
+  /**
+   * Optional precondition, same semantics as RawFileReadOptions.ifMatch.
+   * `*` requires the file to exist; a hash requires the current content to match.
+   */
+  ifMatch?: string;
+  maxBytes?: number;
+}
+
+export interface RawFileWriteResult {
+  path: string;
+  size: number;
+  sha256: string;
+}
@@ -1,4 +1,13 @@
-import type { ExecRequest, ExecResult, RunJsRequest, RunTsRequest } from "./agent.js";
+import type {
+  ExecRequest,
+  ExecResult,
+  RawFileReadOptions,
+  RawFileReadResult,
+  RawFileWriteOptions,
+  RawFileWriteResult,
+  RunJsRequest,
+  RunTsRequest
+} from "./agent.js";
 import type { NetConfigRequest } from "./agent.js";
 
 export interface FirewallManager {
@@ -28,6 +37,12 @@ export interface FileService {
     payload: NodeJS.ReadableStream,
     options?: { ownership?: "root" | "user"; readOnly?: boolean }
   ): Promise<void>;
+  /**
+   * Single-file access without archive processing. Paths follow the same /workspace policy
+   * as upload/download; symlinks that resolve outside /workspace are rejected.
+   */
+  readRaw(path: string, options?: RawFileReadOptions): Promise<RawFileReadResult>;
+  writeRaw(path: string, payload: NodeJS.ReadableStream, options?: RawFileWriteOptions): Promise<RawFileWriteResult>;
 }
 
 export interface NetworkConfigurator {
@@ -1,13 +1,18 @@
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
+#include <sys/swap.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -25,6 +30,36 @@
 #define MERGED_ROOT "/mnt/merged"
 #define OLD_ROOT "/mnt/merged/oldroot"
 
+// Optional workspace data disk: mounted here, its home/ subdir is bound over /home/user.
+#define WORKSPACE_MNT "/mnt/workspace"
+#define WORKSPACE_HOME WORKSPACE_MNT "/home"
+#define USER_HOME "/home/user"
+#define SANDBOX_UID 1000
+#define SANDBOX_GID 1000
+
+// Per-exec scratch files (run-ts/run-js wrappers and results) live on tmpfs so they never hit the
+// overlay block device. SANDBOX_TMP is the jail's /tmp (rds_sandbox_tmp_mb caps it, default a
+// quarter of RAM). Upload archives stay disk-backed: they can be far larger than is worth keeping
+// in guest RAM.
+#define SANDBOX_TMP "/opt/sandbox/tmp"
+
+// Bundled guest agent (single file + V8 code cache); images without it run the tsc output.
+#define AGENT_BUNDLE_ENTRY "/opt/guest-agent/start.cjs"
+#define AGENT_LEGACY_ENTRY "/opt/guest-agent/dist/index.js"
+
+// Compressed swap in RAM, sized by rds_zram_mb (0 or absent disables it).
+#define ZRAM_DEV "/dev/zram0"
+#define ZRAM_SYSFS "/sys/block/zram0"
+
+// The agent runs each jailed exec in its own cgroup under JAIL_CGROUP. The memory guard kills
+// the largest one when PSI reports sustained memory stalls, before the kernel OOM killer has to
+// choose (and possibly pick the agent). Kills are recorded in MEMGUARD_DIR for the exec result.
+#define CGROUP_ROOT "/sys/fs/cgroup"
+#define JAIL_CGROUP CGROUP_ROOT "/jail"
+#define MEMGUARD_DIR "/run/rds-memguard"
+// Only act when MemAvailable is below this share of MemTotal; stalls alone may be I/O churn.
+#define MEMGUARD_AVAILABLE_PCT 10
+
 static void log_line(const char *fmt, ...) {
   va_list ap;
   va_start(ap, fmt);
@@ -83,6 +118,15 @@ static int run_wait(const char *path, char *const argv[]) {
   return status;
 }
 
+static bool write_file(const char *path, const char *value) {
+  int fd = open(path, O_WRONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  size_t len = strlen(value);
+  bool ok = write(fd, value, len) == (ssize_t)len;
+  close(fd);
+  return ok;
+}
+
 static bool file_exists(const char *path) {
   struct stat st;
   return stat(path, &st) == 0;
@@ -106,6 +150,76 @@ static bool wait_for_device(const char *path, int timeout_ms) {
   return false;
 }
 
+// Copy the value of `key=` from the kernel cmdline into out; returns false when absent.
+static bool cmdline_str(const char *key, char *out, size_t out_len) {
+  FILE *f = fopen("/proc/cmdline", "r");
+  if (!f) return false;
+  char buf[4096];
+  size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+  fclose(f);
+  if (n == 0) return false;
+  buf[n] = '\0';
+
+  char pattern[128];
+  snprintf(pattern, sizeof(pattern), "%s=", key);
+  char *p = strstr(buf, pattern);
+  if (!p) return false;
+  p += strlen(pattern);
+  size_t len = strcspn(p, " \n");
+  if (len == 0 || len >= out_len) return false;
+  memcpy(out, p, len);
+  out[len] = '\0';
+  return true;
+}
+
+static int hex_nibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Mix host-provided seed bytes into the kernel pool, credit them, and force a CRNG reseed.
+// Only for seeds the guest-agent received over vsock after boot and restore: a seed on the kernel
+// cmdline is readable from /proc/cmdline and the console log, so it must never be credited.
+#define ENTROPY_MAX_BYTES 64
+// From <linux/random.h>; defined here so musl builds do not need kernel headers.
+#ifndef RNDADDENTROPY
+#define RNDADDENTROPY _IOW('R', 0x03, int[2])
+#endif
+#ifndef RNDRESEEDCRNG
+#define RNDRESEEDCRNG _IO('R', 0x07)
+#endif
+static bool add_entropy_hex(const char *hex) {
+  struct {
+    int entropy_count;
+    int buf_size;
+    unsigned char buf[ENTROPY_MAX_BYTES];
+  } info;
+  size_t len = strcspn(hex, " \r\n");
+  if (len == 0 || len % 2 != 0 || len / 2 > ENTROPY_MAX_BYTES) return false;
+  for (size_t i = 0; i < len / 2; i++) {
+    int hi = hex_nibble(hex[i * 2]);
+    int lo = hex_nibble(hex[i * 2 + 1]);
+    if (hi < 0 || lo < 0) return false;
+    info.buf[i] = (unsigned char)((hi << 4) | lo);
+  }
+  info.buf_size = (int)(len / 2);
+  info.entropy_count = info.buf_size * 8;
+
+  int fd = open("/dev/urandom", O_WRONLY | O_CLOEXEC);
+  if (fd < 0) {
+    log_line("[init] open /dev/urandom failed: %s", strerror(errno));
+    return false;
+  }
+  bool ok = ioctl(fd, RNDADDENTROPY, &info) == 0;
+  if (!ok) log_line("[init] RNDADDENTROPY failed: %s", strerror(errno));
+  if (ok && ioctl(fd, RNDRESEEDCRNG) != 0) log_line("[init] RNDRESEEDCRNG failed: %s", strerror(errno));
+  close(fd);
+  memset(&info, 0, sizeof(info));
+  return ok;
+}
+
 static int cmdline_int(const char *key, int fallback) {
   FILE *f = fopen("/proc/cmdline", "r");
   if (!f) return fallback;
@@ -210,6 +324,247 @@ static bool setup_overlay(void) {
   return true;
 }
 
+// Mount the workspace disk named by rds_workspace_dev (e.g. /dev/vdc) and bind its home/
+// directory over /home/user, so user data lives on its own drive instead of the overlay.
+static void setup_workspace_disk(int wait_ms) {
+  char dev[32];
+  if (!cmdline_str("rds_workspace_dev", dev, sizeof(dev))) return;
+  if (strncmp(dev, "/dev/vd", 7) != 0 || strlen(dev) != 8) {
+    log_line("[init] ignoring invalid rds_workspace_dev=%s", dev);
+    return;
+  }
+  if (!wait_for_device(dev, wait_ms)) {
+    log_line("[init] workspace device %s not found; /home/user stays on the root filesystem", dev);
+    return;
+  }
+
+  ensure_dir("/mnt", 0755);
+  ensure_dir(WORKSPACE_MNT, 0700);
+  if (mount(dev, WORKSPACE_MNT, "ext4", MS_NOATIME, NULL) != 0) {
+    log_line("[init] failed to mount workspace disk: %s", strerror(errno));
+    return;
+  }
+  // A freshly formatted disk has no home/ yet; the agent seeds it from the image on first boot.
+  if (mkdir(WORKSPACE_HOME, 0755) == 0) {
+    if (chown(WORKSPACE_HOME, SANDBOX_UID, SANDBOX_GID) != 0) {
+      log_line("[init] chown %s failed: %s", WORKSPACE_HOME, strerror(errno));
+    }
+  } else if (errno != EEXIST) {
+    log_line("[init] mkdir(%s) failed: %s", WORKSPACE_HOME, strerror(errno));
+    return;
+  }
+
+  ensure_dir("/home", 0755);
+  ensure_dir(USER_HOME, 0755);
+  if (mount(WORKSPACE_HOME, USER_HOME, NULL, MS_BIND, NULL) != 0) {
+    log_line("[init] bind %s -> %s failed: %s", WORKSPACE_HOME, USER_HOME, strerror(errno));
+    return;
+  }
+  log_line("[init] workspace disk %s mounted at %s", dev, USER_HOME);
+}
+
+static void mount_tmpfs(const char *target, const char *options) {
+  ensure_dir(target, 0755);
+  if (mount("tmpfs", target, "tmpfs", MS_NOSUID | MS_NODEV, options) != 0) {
+    log_line("[init] tmpfs %s (%s) failed: %s; falling back to disk", target, options, strerror(errno));
+    return;
+  }
+  log_line("[init] tmpfs %s mounted (%s)", target, options);
+}
+
+static void setup_scratch_tmpfs(void) {
+  char options[64];
+  int tmp_mb = cmdline_int("rds_sandbox_tmp_mb", 0);
+  if (tmp_mb > 0) {
+    snprintf(options, sizeof(options), "mode=1777,size=%dm", tmp_mb);
+  } else {
+    snprintf(options, sizeof(options), "mode=1777,size=25%%");
+  }
+  ensure_dir("/opt/sandbox", 0755);
+  mount_tmpfs(SANDBOX_TMP, options);
+}
+
+// Let small VMs absorb short allocation spikes (npm install, tsc) by compressing cold pages
+// instead of OOM-killing. zram swap is cheap to read back, so favour it over dropping page cache.
+static void setup_zram_swap(void) {
+  int zram_mb = cmdline_int("rds_zram_mb", 0);
+  if (zram_mb <= 0) return;
+  if (!file_exists(ZRAM_SYSFS)) {
+    log_line("[init] rds_zram_mb=%d but kernel has no zram device", zram_mb);
+    return;
+  }
+
+  // lz4 trades a little ratio for much cheaper (de)compression than the lzo default.
+  if (!write_file(ZRAM_SYSFS "/comp_algorithm", "lz4")) {
+    log_line("[init] zram lz4 unavailable, using kernel default compressor");
+  }
+  char size[32];
+  snprintf(size, sizeof(size), "%dM", zram_mb);
+  if (!write_file(ZRAM_SYSFS "/disksize", size)) {
+    log_line("[init] zram disksize=%s failed: %s", size, strerror(errno));
+    return;
+  }
+  char *mkswap_argv[] = { (char *)"mkswap", (char *)ZRAM_DEV, NULL };
+  int status = run_wait("/sbin/mkswap", mkswap_argv);
+  if (status != 0) {
+    log_line("[init] mkswap %s failed status=%d", ZRAM_DEV, status);
+    return;
+  }
+  if (swapon(ZRAM_DEV, SWAP_FLAG_PREFER | (100 << SWAP_FLAG_PRIO_SHIFT)) != 0) {
+    log_line("[init] swapon %s failed: %s", ZRAM_DEV, strerror(errno));
+    return;
+  }
+
+  char swappiness[16];
+  snprintf(swappiness, sizeof(swappiness), "%d", cmdline_int("rds_swappiness", 100));
+  write_file("/proc/sys/vm/swappiness", swappiness);
+  // Swap readahead only helps rotating media; zram reads are page-sized memcpy+decompress.
+  write_file("/proc/sys/vm/page-cluster", "0");
+  log_line("[init] zram swap %dMiB enabled (swappiness=%s)", zram_mb, swappiness);
+}
+
+static void setup_exec_cgroups(void) {
+  if (mount("cgroup2", CGROUP_ROOT, "cgroup2", MS_NOSUID | MS_NODEV | MS_NOEXEC, NULL) != 0) {
+    log_line("[init] mount cgroup2 failed: %s (exec cgroups disabled)", strerror(errno));
+    return;
+  }
+  if (!write_file(CGROUP_ROOT "/cgroup.subtree_control", "+memory")) {
+    log_line("[init] enabling memory controller failed: %s", strerror(errno));
+    return;
+  }
+  ensure_dir(JAIL_CGROUP, 0755);
+  if (!write_file(JAIL_CGROUP "/cgroup.subtree_control", "+memory")) {
+    log_line("[init] enabling memory controller for %s failed: %s", JAIL_CGROUP, strerror(errno));
+  }
+}
+
+static long meminfo_kb(const char *field) {
+  FILE *f = fopen("/proc/meminfo", "r");
+  if (!f) return -1;
+  char line[256];
+  size_t field_len = strlen(field);
+  long value = -1;
+  while (fgets(line, sizeof(line), f)) {
+    if (strncmp(line, field, field_len) == 0 && line[field_len] == ':') {
+      value = strtol(line + field_len + 1, NULL, 10);
+      break;
+    }
+  }
+  fclose(f);
+  return value;
+}
+
+static long long read_ll(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) return -1;
+  long long v = -1;
+  if (fscanf(f, "%lld", &v) != 1) v = -1;
+  fclose(f);
+  return v;
+}
+
+// Kill every process of the exec cgroup using the most memory. 5.10 has no cgroup.kill, so
+// freeze the group first: frozen tasks cannot fork away from the SIGKILL sweep.
+static void memguard_kill_largest(void) {
+  DIR *d = opendir(JAIL_CGROUP);
+  if (!d) return;
+  char victim[NAME_MAX + 1] = "";
+  long long victim_bytes = -1;
+  struct dirent *ent;
+  while ((ent = readdir(d)) != NULL) {
+    if (ent->d_type != DT_DIR || ent->d_name[0] == '.') continue;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s/memory.current", JAIL_CGROUP, ent->d_name);
+    long long bytes = read_ll(path);
+    if (bytes > victim_bytes) {
+      victim_bytes = bytes;
+      snprintf(victim, sizeof(victim), "%s", ent->d_name);
+    }
+  }
+  closedir(d);
+  if (victim[0] == '\0') return;
+
+  char path[PATH_MAX];
+  char note[64];
+  // Record the kill before it happens so the agent sees it as soon as the exec exits.
+  snprintf(path, sizeof(path), "%s/%s", MEMGUARD_DIR, victim);
+  snprintf(note, sizeof(note), "%lld\n", victim_bytes);
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd >= 0) {
+    if (write(fd, note, strlen(note)) < 0) log_line("[memguard] write %s failed: %s", path, strerror(errno));
+    close(fd);
+  }
+
+  snprintf(path, sizeof(path), "%s/%s/cgroup.freeze", JAIL_CGROUP, victim);
+  write_file(path, "1");
+  snprintf(path, sizeof(path), "%s/%s/cgroup.procs", JAIL_CGROUP, victim);
+  int killed = 0;
+  FILE *procs = fopen(path, "r");
+  if (procs) {
+    int pid;
+    while (fscanf(procs, "%d", &pid) == 1) {
+      if (kill(pid, SIGKILL) == 0) killed++;
+    }
+    fclose(procs);
+  }
+  snprintf(path, sizeof(path), "%s/%s/cgroup.freeze", JAIL_CGROUP, victim);
+  write_file(path, "0");
+  log_line("[memguard] memory pressure: killed exec cgroup %s (%lld bytes, %d processes)", victim, victim_bytes, killed);
+}
+
+static void memguard_loop(int stall_ms) {
+  int fd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    log_line("[memguard] PSI unavailable: %s", strerror(errno));
+    return;
+  }
+  // Fire when tasks were stalled on memory for stall_ms within any 1s window.
+  char trigger[64];
+  snprintf(trigger, sizeof(trigger), "some %d 1000000", stall_ms * 1000);
+  if (write(fd, trigger, strlen(trigger) + 1) < 0) {
+    log_line("[memguard] PSI trigger \"%s\" rejected: %s", trigger, strerror(errno));
+    close(fd);
+    return;
+  }
+  struct pollfd pfd = { .fd = fd, .events = POLLPRI };
+  for (;;) {
+    if (poll(&pfd, 1, -1) < 0) {
+      if (errno == EINTR) continue;
+      log_line("[memguard] poll failed: %s", strerror(errno));
+      break;
+    }
+    if (pfd.revents & POLLERR) {
+      log_line("[memguard] PSI trigger closed");
+      break;
+    }
+    if (!(pfd.revents & POLLPRI)) continue;
+    long total = meminfo_kb("MemTotal");
+    long available = meminfo_kb("MemAvailable");
+    if (total <= 0 || available < 0 || available * 100 >= total * MEMGUARD_AVAILABLE_PCT) continue;
+    memguard_kill_largest();
+  }
+  close(fd);
+}
+
+static void start_memguard(void) {
+  // 0 disables; the PSI trigger threshold must stay below its 1s window.
+  int stall_ms = cmdline_int("rds_memguard_stall_ms", 150);
+  if (stall_ms <= 0 || stall_ms >= 1000) return;
+  if (!file_exists(JAIL_CGROUP)) return;
+  ensure_dir("/run", 0755);
+  ensure_dir(MEMGUARD_DIR, 0700);
+  pid_t pid = fork();
+  if (pid < 0) {
+    log_line("[memguard] fork failed: %s", strerror(errno));
+    return;
+  }
+  if (pid == 0) {
+    memguard_loop(stall_ms);
+    _exit(0);
+  }
+  log_line("[init] memory guard pid=%d (stall threshold %dms/s)", (int)pid, stall_ms);
+}
+
 static void start_services(void) {
   // Minimal rootfs doesn't bring up loopback automatically, but we rely on 127.0.0.1
   // for the vsock->tcp bridge (socat) to reach the guest agent.
@@ -226,9 +581,12 @@ static void start_services(void) {
   log_line("[init] starting guest-agent");
   setenv("PORT", "8080", 1);
   chdir("/opt/guest-agent");
-  char *node_argv[] = { (char *)"node", (char *)"/opt/guest-agent/dist/index.js", NULL };
+  // --expose-gc lets POST /snapshot/prepare collect the agent heap before a memory snapshot; the
+  // code cache is built with the same flag, since V8 rejects caches made under different flags.
+  const char *agent_entry = file_exists(AGENT_BUNDLE_ENTRY) ? AGENT_BUNDLE_ENTRY : AGENT_LEGACY_ENTRY;
+  char *node_argv[] = { (char *)"node", (char *)"--expose-gc", (char *)agent_entry, NULL };
   pid_t node_pid = spawn("/usr/local/bin/node", node_argv);
-  if (node_pid > 0) log_line("[init] guest-agent pid=%d", (int)node_pid);
+  if (node_pid > 0) log_line("[init] guest-agent pid=%d entry=%s", (int)node_pid, agent_entry);
 
   log_line("[init] starting socat vsock->tcp");
   char *socat_argv[] = { (char *)"socat", (char *)"VSOCK-LISTEN:8080,fork", (char *)"TCP:127.0.0.1:8080", NULL };
@@ -246,7 +604,17 @@ static void start_services(void) {
   }
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+  // Helper mode for the guest-agent: `/sbin/init --add-entropy` reads a hex seed from stdin.
+  if (argc >= 2 && strcmp(argv[1], "--add-entropy") == 0) {
+    char hex[ENTROPY_MAX_BYTES * 2 + 2];
+    size_t n = fread(hex, 1, sizeof(hex) - 1, stdin);
+    hex[n] = '\0';
+    bool ok = add_entropy_hex(hex);
+    memset(hex, 0, sizeof(hex));
+    return ok ? 0 : 1;
+  }
+
   ensure_dir("/var", 0755);
   ensure_dir("/var/log", 0755);
   redirect_stdio_to_console();
@@ -291,6 +659,18 @@ int main(void) {
     }
   }
 
+  setup_workspace_disk(overlay_wait_ms);
+  setup_scratch_tmpfs();
+  setup_zram_swap();
+
+  // Everything spawned from here on inherits this: the memory guard, socat and the agent are
+  // never OOM victims. The agent resets it to 0 for jailed exec processes.
+  if (!write_file("/proc/self/oom_score_adj", "-1000")) {
+    log_line("[init] oom_score_adj failed: %s", strerror(errno));
+  }
+  setup_exec_cgroups();
+  start_memguard();
+
   // Start services (guest-agent, socat)
   start_services();
 
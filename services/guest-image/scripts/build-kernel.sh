@@ -35,6 +35,12 @@ fi
 ./scripts/config -e SERIAL_8250 -e SERIAL_8250_CONSOLE -e SERIAL_CORE -e SERIAL_CORE_CONSOLE
 # Enable overlayfs for copy-on-write root filesystem (base rootfs + per-VM overlay)
 ./scripts/config -e OVERLAY_FS
+# virtio-rng (Firecracker entropy device) feeds the CRNG so early getrandom() never stalls.
+./scripts/config -e HW_RANDOM -e HW_RANDOM_VIRTIO
+# zram swap (set up by guest-init from rds_zram_mb) lets small VMs ride out memory spikes.
+./scripts/config -e SWAP -e ZSMALLOC -e ZRAM -e CRYPTO_LZ4 -e LZ4_COMPRESS -e LZ4_DECOMPRESS
+# cgroup v2 memory accounting + PSI back the guest memory guard (per-exec cgroups, pressure triggers).
+./scripts/config -e CGROUPS -e MEMCG -e PSI -d PSI_DEFAULT_DISABLED
 make olddefconfig
 make -j"$(nproc)" vmlinux
 
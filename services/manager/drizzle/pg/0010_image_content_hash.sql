@@ -0,0 +1,3 @@
+ALTER TABLE "guest_images" ADD COLUMN "kernel_sha256" text;
+--> statement-breakpoint
+ALTER TABLE "guest_images" ADD COLUMN "rootfs_sha256" text;
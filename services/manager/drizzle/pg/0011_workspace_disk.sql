@@ -0,0 +1,3 @@
+ALTER TABLE "vms" ADD COLUMN "workspace_disk_path" text;
+--> statement-breakpoint
+ALTER TABLE "vms" ADD COLUMN "workspace_disk_mb" integer;
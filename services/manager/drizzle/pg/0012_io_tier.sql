@@ -0,0 +1 @@
+ALTER TABLE "vms" ADD COLUMN "io_tier" text;
@@ -0,0 +1 @@
+ALTER TABLE "vms" ADD COLUMN "huge_pages" boolean;
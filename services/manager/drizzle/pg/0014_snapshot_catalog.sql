@@ -0,0 +1,15 @@
+CREATE TABLE "snapshots" (
+  "id" text PRIMARY KEY NOT NULL,
+  "kind" text NOT NULL,
+  "image_id" text,
+  "source_vm_id" text,
+  "internal" boolean NOT NULL,
+  "created_at" text NOT NULL,
+  "meta_json" text NOT NULL
+);
+--> statement-breakpoint
+CREATE INDEX "snapshots_kind_created_at_idx" ON "snapshots" ("kind", "created_at");
+--> statement-breakpoint
+CREATE INDEX "snapshots_image_id_idx" ON "snapshots" ("image_id");
+--> statement-breakpoint
+CREATE INDEX "snapshots_created_at_idx" ON "snapshots" ("created_at", "id");
@@ -0,0 +1 @@
+ALTER TABLE "vms" ADD COLUMN "memory_page_size_kb" integer;
@@ -0,0 +1,3 @@
+ALTER TABLE `guest_images` ADD `kernel_sha256` text;
+--> statement-breakpoint
+ALTER TABLE `guest_images` ADD `rootfs_sha256` text;
@@ -0,0 +1 @@
+ALTER TABLE `vms` ADD `io_tier` text;
@@ -0,0 +1 @@
+ALTER TABLE `vms` ADD `huge_pages` integer;
@@ -0,0 +1 @@
+ALTER TABLE `vms` ADD `memory_page_size_kb` integer;
@@ -0,0 +1,32 @@
+// Compare VM boot and memory-heavy exec latency with guest memory on 4 KiB pages and on 2 MiB
+// hugepages (GUEST_HUGE_PAGES). Each configuration restarts the manager, boots VMS VMs, then runs a
+// command that allocates and touches MEM_TOUCH_MB of memory on all of them at once, and reports
+// p50/p99 latencies plus how many VMs really got hugepages (`memoryPageSizeKb`).
+//
+// Run as root from services/manager after `npm run build`, with the manager's usual env, no other
+// manager on the host and a hugepage pool of at least VMS * MEM_MB, e.g.
+// `HUGEPAGES_POOL_MB=8192 VMS=8 node scripts/bench-hugepages.mjs`.
+import { api, createVms, deleteVms, execLatencies, percentile, withManager } from "./bench-lib.mjs";
+
+const VMS = Number(process.env.VMS ?? 8);
+const ROUNDS = Number(process.env.ROUNDS ?? 10);
+const MEM_MB = Number(process.env.MEM_MB ?? 1024);
+const MEM_TOUCH_MB = Number(process.env.MEM_TOUCH_MB ?? 384);
+const TOUCH_CMD = `node -e 'const a = []; for (let i = 0; i < ${MEM_TOUCH_MB / 4}; i++) a.push(Buffer.alloc(4 << 20, 1));'`;
+
+for (const hugePages of [false, true]) {
+  await withManager({ GUEST_HUGE_PAGES: String(hugePages) }, async () => {
+    const { ids, bootMs } = await createVms(VMS, { cpu: 1, memMb: MEM_MB, allowIps: [] });
+    try {
+      const backed = (await Promise.all(ids.map((id) => api("GET", `/v1/vms/${id}`)))).filter((vm) => vm.memoryPageSizeKb === 2048);
+      const touchMs = await execLatencies(ids, TOUCH_CMD, ROUNDS);
+      console.log(
+        `${(hugePages ? "2 MiB pages" : "4 KiB pages").padEnd(12)} hugepage-backed=${backed.length}/${ids.length}  ` +
+          `boot p50=${percentile(bootMs, 50)}ms p99=${percentile(bootMs, 99)}ms  ` +
+          `touch ${MEM_TOUCH_MB}MiB p50=${percentile(touchMs, 50)}ms p99=${percentile(touchMs, 99)}ms`
+      );
+    } finally {
+      await deleteVms(ids);
+    }
+  });
+}
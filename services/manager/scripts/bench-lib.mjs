@@ -0,0 +1,86 @@
+// Shared helpers for the VM benches: run the built manager under one set of env overrides, drive
+// it over its HTTP API, and summarize latencies. The manager inherits this process's environment
+// (API_KEY, ADMIN_*, storage and image settings), so run the benches with the env it normally uses.
+import { spawn } from "node:child_process";
+
+export const PORT = Number(process.env.BENCH_PORT ?? 3900);
+const BASE_URL = `http://127.0.0.1:${PORT}`;
+
+export async function api(method, pathname, body) {
+  const res = await fetch(`${BASE_URL}${pathname}`, {
+    method,
+    headers: { "x-api-key": process.env.API_KEY ?? "", ...(body ? { "content-type": "application/json" } : {}) },
+    body: body ? JSON.stringify(body) : undefined
+  });
+  const text = await res.text();
+  if (!res.ok) throw new Error(`${method} ${pathname} -> ${res.status}: ${text.slice(0, 300)}`);
+  return text ? JSON.parse(text) : null;
+}
+
+export async function timed(fn) {
+  const start = performance.now();
+  const result = await fn();
+  return { ms: performance.now() - start, result };
+}
+
+/** Nearest-rank percentile, like the exec fan-out summary. */
+export function percentile(samples, p) {
+  if (samples.length === 0) return "n/a";
+  const sorted = [...samples].sort((a, b) => a - b);
+  return sorted[Math.min(sorted.length - 1, Math.max(0, Math.ceil((p / 100) * sorted.length) - 1))].toFixed(1);
+}
+
+/** Start `node dist/index.js` with `env` on top of this process's environment and wait until it serves requests. */
+export async function withManager(env, fn) {
+  const proc = spawn(process.execPath, ["dist/index.js"], {
+    env: { ...process.env, ENABLE_WARM_POOL: "false", ...env, PORT: String(PORT) },
+    stdio: ["ignore", "ignore", "inherit"]
+  });
+  const exited = new Promise((resolve) => proc.once("exit", resolve));
+  try {
+    for (let i = 0; ; i += 1) {
+      if (proc.exitCode !== null) throw new Error(`manager exited with code ${proc.exitCode}`);
+      if (await api("GET", "/v1/vms").then(() => true, () => false)) break;
+      if (i >= 600) throw new Error("manager did not come up within 60s");
+      await new Promise((resolve) => setTimeout(resolve, 100));
+    }
+    return await fn();
+  } finally {
+    proc.kill("SIGTERM");
+    await exited;
+  }
+}
+
+/**
+ * Create `count` VMs one after another and return their ids with per-VM create latency (boot until
+ * the guest agent answers). The caller deletes them with `deleteVms`.
+ */
+export async function createVms(count, request) {
+  const ids = [];
+  const bootMs = [];
+  for (let i = 0; i < count; i += 1) {
+    const { ms, result } = await timed(() => api("POST", "/v1/vms", request));
+    ids.push(result.id);
+    bootMs.push(ms);
+  }
+  return { ids, bootMs };
+}
+
+export async function deleteVms(ids) {
+  await Promise.all(ids.map((id) => api("DELETE", `/v1/vms/${id}`).catch(() => undefined)));
+}
+
+/** Run `cmd` on every VM at once, `rounds` times, and return each exec's latency. */
+export async function execLatencies(ids, cmd, rounds) {
+  const samples = [];
+  for (let round = 0; round < rounds; round += 1) {
+    await Promise.all(
+      ids.map(async (id) => {
+        const { ms, result } = await timed(() => api("POST", `/v1/vms/${id}/exec`, { cmd, timeoutMs: 60_000 }));
+        if (result.exitCode !== 0) throw new Error(`exec on ${id} exited with ${result.exitCode}: ${result.stderr}`);
+        samples.push(ms);
+      })
+    );
+  }
+  return samples;
+}
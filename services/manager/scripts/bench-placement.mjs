@@ -0,0 +1,35 @@
+// Compare VM boot and exec latency without cgroups, with per-VM cgroups (FIRECRACKER_CGROUPS), and
+// with cgroups plus vCPU pinning (FIRECRACKER_PIN_VCPUS). Each configuration restarts the manager,
+// boots VMS VMs, then runs a short and a CPU-bound command on all of them at once so the VMs
+// compete for host CPUs, and reports p50/p99 latencies.
+//
+// Run as root from services/manager after `npm run build`, with the manager's usual env and no
+// other manager on the host, e.g. `VMS=8 ROUNDS=10 node scripts/bench-placement.mjs`.
+import { createVms, deleteVms, execLatencies, percentile, withManager } from "./bench-lib.mjs";
+
+const VMS = Number(process.env.VMS ?? 8);
+const ROUNDS = Number(process.env.ROUNDS ?? 10);
+const CPU_CMD = "i=0; while [ $i -lt 300000 ]; do i=$((i+1)); done";
+
+const configs = [
+  { label: "no cgroups", env: { FIRECRACKER_CGROUPS: "false", FIRECRACKER_PIN_VCPUS: "false" } },
+  { label: "cgroups", env: { FIRECRACKER_CGROUPS: "true", FIRECRACKER_PIN_VCPUS: "false" } },
+  { label: "cgroups + pinning", env: { FIRECRACKER_CGROUPS: "true", FIRECRACKER_PIN_VCPUS: "true" } }
+];
+
+for (const { label, env } of configs) {
+  await withManager(env, async () => {
+    const { ids, bootMs } = await createVms(VMS, { cpu: 1, memMb: 512, allowIps: [] });
+    try {
+      const trueMs = await execLatencies(ids, "true", ROUNDS);
+      const cpuMs = await execLatencies(ids, CPU_CMD, ROUNDS);
+      console.log(
+        `${label.padEnd(18)} boot p50=${percentile(bootMs, 50)}ms p99=${percentile(bootMs, 99)}ms  ` +
+          `exec true p50=${percentile(trueMs, 50)}ms p99=${percentile(trueMs, 99)}ms  ` +
+          `exec cpu p50=${percentile(cpuMs, 50)}ms p99=${percentile(cpuMs, 99)}ms`
+      );
+    } finally {
+      await deleteVms(ids);
+    }
+  });
+}
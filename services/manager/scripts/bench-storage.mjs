@@ -0,0 +1,84 @@
+// Compare disk clone cost of the file backend (reflink or full copy) against the dm-thin backend.
+// For each backend: build an overlay template, clone it N times, then clone a disk with
+// DATA_MB of written data (what stop/start and user snapshots do), and report median times.
+//
+// Run as root from services/manager after `npm run build`, e.g.
+// `BENCH_ROOT=/var/lib/rds-bench node scripts/bench-storage.mjs 20`. BENCH_ROOT must be on the
+// filesystem under test (ext4 to see the copy fallback) and is removed afterwards.
+import { execFileSync } from "node:child_process";
+import fs from "node:fs/promises";
+import path from "node:path";
+import { LocalStorageProvider } from "../dist/storage/storageProvider.js";
+import { ThinStorageProvider } from "../dist/storage/thinStorageProvider.js";
+
+const RUNS = Number(process.argv[2] ?? 20);
+const DATA_MB = Number(process.env.DATA_MB ?? 256);
+const OVERLAY_BYTES = 512 * 1024 * 1024;
+const BENCH_ROOT = process.env.BENCH_ROOT ?? "/var/lib/rds-bench";
+
+async function timed(fn) {
+  const start = performance.now();
+  await fn();
+  return performance.now() - start;
+}
+
+function median(samples) {
+  const sorted = [...samples].sort((a, b) => a - b);
+  return sorted[Math.floor((sorted.length - 1) / 2)].toFixed(1);
+}
+
+async function bench(label, storage, storageRoot) {
+  const dirty = path.join(storageRoot, "bench", "dirty.ext4");
+  await fs.mkdir(path.dirname(dirty), { recursive: true });
+
+  // First workspace disk: template creation plus one clone.
+  const firstMs = await timed(() => storage.prepareWorkspaceDisk("bench-0", { sizeBytes: OVERLAY_BYTES }));
+  const cloneMs = [];
+  for (let i = 1; i <= RUNS; i += 1) {
+    cloneMs.push(await timed(() => storage.prepareWorkspaceDisk(`bench-${i}`, { sizeBytes: OVERLAY_BYTES })));
+  }
+
+  // A disk with real data, cloned like stop/start saves it.
+  const src = await storage.prepareWorkspaceDisk("bench-src", { sizeBytes: OVERLAY_BYTES });
+  execFileSync("dd", ["if=/dev/urandom", `of=${src}`, "bs=1M", `count=${DATA_MB}`, "seek=64", "conv=notrunc,fsync", "status=none"]);
+  const dirtyMs = [];
+  for (let i = 0; i < Math.max(3, Math.floor(RUNS / 4)); i += 1) {
+    dirtyMs.push(await timed(() => storage.cloneDisk(src, dirty)));
+  }
+
+  console.log(
+    `${label.padEnd(12)} template+first=${firstMs.toFixed(1)}ms  median blank clone=${median(cloneMs)}ms  ` +
+      `median ${DATA_MB}MiB clone=${median(dirtyMs)}ms`
+  );
+  console.log(`${"".padEnd(12)} usage=${JSON.stringify(await storage.storageUsage())}`);
+}
+
+for (const backend of ["file", "thin"]) {
+  const storageRoot = path.join(BENCH_ROOT, backend);
+  const options = { storageRoot, jailerChrootBaseDir: path.join(storageRoot, "jailer"), rootfsCloneMode: "auto" };
+  await fs.rm(storageRoot, { recursive: true, force: true });
+  await fs.mkdir(storageRoot, { recursive: true });
+  let thin = null;
+  try {
+    if (backend === "thin") {
+      thin = new ThinStorageProvider({ ...options, thinPool: { name: "rds-bench", dataSizeBytes: 20 * 1024 ** 3 } });
+      await thin.init();
+    }
+    await bench(backend, thin ?? new LocalStorageProvider(options), storageRoot);
+  } finally {
+    if (thin) {
+      // Tear the pool down completely: volumes, pool, then loop devices.
+      const names = execFileSync("dmsetup", ["ls"], { encoding: "utf-8" })
+        .split("\n")
+        .map((line) => line.split(/\s+/)[0])
+        .filter((name) => name.startsWith("rds-bench-") && name !== "rds-bench-pool");
+      for (const name of names) execFileSync("dmsetup", ["remove", name]);
+      execFileSync("dmsetup", ["remove", "rds-bench-pool"]);
+      for (const file of ["data.img", "metadata.img"]) {
+        const loops = execFileSync("losetup", ["-j", path.join(storageRoot, ".thin", file)], { encoding: "utf-8" });
+        for (const line of loops.split("\n").filter(Boolean)) execFileSync("losetup", ["-d", line.split(":")[0]]);
+      }
+    }
+    await fs.rm(storageRoot, { recursive: true, force: true });
+  }
+}
@@ -0,0 +1,33 @@
+#!/bin/sh
+# Container entrypoint: restarts the manager in place when it exits abnormally, so the container
+# (and every Firecracker process in it) outlives a manager crash and the new manager re-adopts the
+# running VMs. SIGTERM/SIGINT stop the manager and the supervisor; a clean exit ends both.
+set -u
+
+child=0
+stopping=0
+
+stop() {
+  stopping=1
+  if [ "$child" -ne 0 ]; then
+    kill -TERM "$child" 2>/dev/null
+  fi
+}
+trap stop TERM INT
+
+while :; do
+  node dist/index.js "$@" &
+  child=$!
+  wait "$child"
+  status=$?
+  if [ "$stopping" -eq 1 ]; then
+    # `wait` returns as soon as a trapped signal arrives; let the manager finish shutting down.
+    wait "$child" 2>/dev/null
+    exit 0
+  fi
+  if [ "$status" -eq 0 ]; then
+    exit 0
+  fi
+  echo "[supervise] manager exited with status $status; restarting in 1s" >&2
+  sleep 1
+done
@@ -1,9 +1,19 @@
 import fs from "node:fs/promises";
 import path from "node:path";
 import type { AgentClient } from "../types/interfaces.js";
-import type { VmExecRequest, VmRunJsRequest, VmRunTsRequest } from "../types/vm.js";
+import type {
+  VmExecRequest,
+  VmGuestResetResult,
+  VmGuestStats,
+  VmRawFileReadResult,
+  VmRawFileWriteResult,
+  VmRunJsRequest,
+  VmRunTsRequest,
+  VmSnapshotPrepareResult,
+  VmWorkspaceCheckpoint
+} from "../types/vm.js";
 import { buildBinaryRequest, buildJsonRequest } from "./httpRequest.js";
-import { parseHttpResponse } from "./httpResponse.js";
+import { parseHttpResponse, type ParsedHttpResponse } from "./httpResponse.js";
 import { shouldRetryVsock } from "./retryPolicy.js";
 import { execVsockUdsRaw } from "./vsockTransport.js";
 
@@ -50,17 +60,48 @@ export class VsockAgentClient implements AgentClient {
     await this.request(vmId, "POST", "/time/sync", payload);
   }
 
-  async exec(vmId: string, payload: VmExecRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown }> {
+  async seedEntropy(vmId: string, payload: { seedHex: string }): Promise<void> {
+    await this.request(vmId, "POST", "/entropy/seed", payload);
+  }
+
+  async prepareForSnapshot(vmId: string): Promise<VmSnapshotPrepareResult> {
+    // Dropping caches and zero-filling free memory scales with guest RAM; allow more than the default.
+    return this.request(vmId, "POST", "/snapshot/prepare", {}, { timeoutMs: 60_000 });
+  }
+
+  async resetGuestForRecycle(vmId: string): Promise<VmGuestResetResult> {
+    // Reverting the overlay and scrubbing memory can take a while on a busy guest.
+    return this.request(vmId, "POST", "/internal/recycle", {}, { timeoutMs: 120_000 });
+  }
+
+  async guestStats(vmId: string): Promise<VmGuestStats> {
+    return this.request(vmId, "GET", "/stats");
+  }
+
+  async listCheckpoints(vmId: string): Promise<VmWorkspaceCheckpoint[]> {
+    const result = await this.request(vmId, "GET", "/checkpoints");
+    return result.checkpoints ?? [];
+  }
+
+  async createCheckpoint(vmId: string, payload: { label?: string }): Promise<VmWorkspaceCheckpoint> {
+    return this.request(vmId, "POST", "/checkpoints", payload);
+  }
+
+  async rollbackCheckpoint(vmId: string, checkpointId: string): Promise<VmWorkspaceCheckpoint> {
+    return this.request(vmId, "POST", `/checkpoints/${encodeURIComponent(checkpointId)}/rollback`, {});
+  }
+
+  async exec(vmId: string, payload: VmExecRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown; memoryPressureKilled?: boolean }> {
     const timeoutMs = typeof payload.timeoutMs === "number" ? payload.timeoutMs : undefined;
     return this.request(vmId, "POST", "/exec", payload, { timeoutMs });
   }
 
-  async runTs(vmId: string, payload: VmRunTsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown }> {
+  async runTs(vmId: string, payload: VmRunTsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown; memoryPressureKilled?: boolean }> {
     const timeoutMs = typeof payload.timeoutMs === "number" ? payload.timeoutMs : undefined;
     return this.request(vmId, "POST", "/run-ts", payload, { timeoutMs });
   }
 
-  async runJs(vmId: string, payload: VmRunJsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown }> {
+  async runJs(vmId: string, payload: VmRunJsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown; memoryPressureKilled?: boolean }> {
     const timeoutMs = typeof payload.timeoutMs === "number" ? payload.timeoutMs : undefined;
     return this.request(vmId, "POST", "/run-js", payload, { timeoutMs });
   }
@@ -80,6 +121,32 @@ export class VsockAgentClient implements AgentClient {
     await this.requestBinary(vmId, "POST", query, data);
   }
 
+  async readRawFile(vmId: string, path: string, options?: { range?: string; ifMatch?: string }): Promise<VmRawFileReadResult> {
+    const headers: Record<string, string> = {};
+    if (options?.range) headers.Range = options.range;
+    if (options?.ifMatch) headers["If-Match"] = options.ifMatch;
+    const { statusCode, headers: responseHeaders, body } = await this.requestBinaryResponse(
+      vmId,
+      "GET",
+      `/files/raw?path=${encodeURIComponent(path)}`,
+      undefined,
+      headers
+    );
+    return {
+      statusCode: statusCode === 206 ? 206 : 200,
+      data: body,
+      sha256: (responseHeaders.etag ?? "").replace(/"/g, ""),
+      contentRange: responseHeaders["content-range"]
+    };
+  }
+
+  async writeRawFile(vmId: string, path: string, data: Buffer, options?: { ifMatch?: string }): Promise<VmRawFileWriteResult> {
+    const headers: Record<string, string> = {};
+    if (options?.ifMatch) headers["If-Match"] = options.ifMatch;
+    const { body } = await this.requestBinaryResponse(vmId, "PUT", `/files/raw?path=${encodeURIComponent(path)}`, data, headers);
+    return JSON.parse(body.toString("utf-8")) as VmRawFileWriteResult;
+  }
+
   private async request<T>(
     vmId: string,
     method: string,
@@ -139,13 +206,25 @@ export class VsockAgentClient implements AgentClient {
   }
 
   private async requestBinary(vmId: string, method: string, pathName: string, body?: Buffer): Promise<Buffer> {
+    const { body: responseBody } = await this.requestBinaryResponse(vmId, method, pathName, body);
+    return responseBody;
+  }
+
+  private async requestBinaryResponse(
+    vmId: string,
+    method: string,
+    pathName: string,
+    body?: Buffer,
+    headers?: Record<string, string>
+  ): Promise<ParsedHttpResponse> {
     await this.ensureVsockDevice();
     const maxBytes = this.options.limits?.maxBinaryResponseBytes ?? 50_000_000;
-    const response = await this.execVsockUdsWithRetry(vmId, buildBinaryRequest(method, pathName, body), {
+    const response = await this.execVsockUdsWithRetry(vmId, buildBinaryRequest(method, pathName, body, headers), {
       timeoutMs: this.options.timeouts?.binaryMs ?? this.options.timeouts?.defaultMs,
       maxResponseBytes: maxBytes
     });
-    const { statusCode, body: responseBody } = parseHttpResponse(response.stdout);
+    const parsed = parseHttpResponse(response.stdout);
+    const { statusCode, body: responseBody } = parsed;
     if (!statusCode) {
       throw new Error(`Agent request returned no HTTP response (${method} ${pathName})`);
     }
@@ -155,7 +234,7 @@ export class VsockAgentClient implements AgentClient {
       (err as any).statusCode = statusCode;
       throw err;
     }
-    return responseBody;
+    return parsed;
   }
 
   private async execVsockUdsWithRetry(
@@ -12,13 +12,18 @@ export function buildJsonRequest(method: string, pathName: string, body?: unknow
   return Buffer.from(requestLines.join("\r\n"));
 }
 
-export function buildBinaryRequest(method: string, pathName: string, body?: Buffer): Buffer {
+export function buildBinaryRequest(method: string, pathName: string, body?: Buffer, extraHeaders?: Record<string, string>): Buffer {
   const payload = body ?? Buffer.alloc(0);
+  const extraLines = Object.entries(extraHeaders ?? {})
+    // Header values come from API callers; drop anything that could split the request.
+    .filter(([key, value]) => /^[A-Za-z0-9-]+$/.test(key) && !/[\r\n]/.test(value))
+    .map(([key, value]) => `${key}: ${value}`);
   const headerLines = [
     `${method} ${pathName} HTTP/1.1`,
     "Host: localhost",
     "Content-Type: application/octet-stream",
     "Connection: close",
+    ...extraLines,
     `Content-Length: ${payload.length}`,
     "",
     ""
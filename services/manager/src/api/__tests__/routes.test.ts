@@ -8,6 +8,7 @@ class FakeVmService {
   public created: VmPublic | null = null;
   public listResult: VmPublic[] = [];
   public listSnapshotsCalls: Array<"user" | "internal" | "all" | undefined> = [];
+  public listSnapshotsPages: Array<{ limit?: number; cursor?: string } | undefined> = [];
   public lastCreatePayload: any = null;
   public startIds: string[] = [];
   public stopIds: string[] = [];
@@ -16,6 +17,10 @@ class FakeVmService {
   public peerSourceModeUpdates: Array<{ id: string; alias: string; sourceMode: "hidden" | "mounted" }> = [];
   public execCalls: Array<{ id: string; cmd: string }> = [];
   public runTsCalls: Array<{ id: string; payload: Record<string, unknown> }> = [];
+  public rawReads: Array<{ id: string; path: string; options?: { range?: string; ifMatch?: string } }> = [];
+  public rawWrites: Array<{ id: string; path: string; data: Buffer; options?: { ifMatch?: string } }> = [];
+  public checkpointCalls: Array<{ id: string; label?: string; rollbackTo?: string }> = [];
+  public ioTierCalls: Array<{ id: string; tier: string }> = [];
 
   async list() {
     return this.listResult;
@@ -48,15 +53,26 @@ class FakeVmService {
     return vm;
   }
 
-  async listSnapshots(scope?: "user" | "internal" | "all") {
+  async listSnapshots(scope?: "user" | "internal" | "all", page?: { limit?: number; cursor?: string }) {
     this.listSnapshotsCalls.push(scope);
-    return [];
+    this.listSnapshotsPages.push(page);
+    return { items: [], nextCursor: page?.limit ? "next-page" : null };
   }
 
   async ensureImageSeedSnapshot(_imageId: string) {
     return null;
   }
 
+  async planExecFanout(request: { selector: { vmIds?: string[] }; cmd: string }) {
+    if (!request.selector.vmIds) throw new HttpError(400, "selector needs vmIds, imageId or all: true");
+    return { vmIds: request.selector.vmIds, cmd: request.cmd };
+  }
+
+  async execFanout(plan: { vmIds: string[] }, onResult: (result: any) => Promise<void> | void) {
+    for (const vmId of plan.vmIds) await onResult({ vmId, ok: true, exitCode: 0, stdout: "ok\n", stderr: "", durationMs: 1 });
+    return { total: plan.vmIds.length, succeeded: plan.vmIds.length, failed: 0, timedOut: 0, skipped: 0, p50Ms: 1, p99Ms: 1, durationMs: 2 };
+  }
+
   async start(id: string) {
     this.startIds.push(id);
   }
@@ -86,6 +102,53 @@ class FakeVmService {
     this.runTsCalls.push({ id, payload });
     return { exitCode: 0, stdout: "ok", stderr: "" };
   }
+
+  async readRawFile(id: string, path: string, options?: { range?: string; ifMatch?: string }) {
+    this.rawReads.push({ id, path, options });
+    if (options?.range) {
+      return { statusCode: 206 as const, data: Buffer.from("ell"), sha256: "abc", contentRange: "bytes 1-3/5" };
+    }
+    return { statusCode: 200 as const, data: Buffer.from("hello"), sha256: "abc" };
+  }
+
+  async writeRawFile(id: string, path: string, data: Buffer, options?: { ifMatch?: string }) {
+    this.rawWrites.push({ id, path, data, options });
+    return { path, size: data.length, sha256: "def" };
+  }
+
+  async getGuestStats(_id: string) {
+    return {
+      uptimeSec: 42,
+      memory: {
+        memTotalKb: 250_000,
+        memAvailableKb: 100_000,
+        swapTotalKb: 128_000,
+        swapFreeKb: 120_000,
+        swapInPages: 10,
+        swapOutPages: 2_000,
+        zram: { diskSizeBytes: 131_072_000, origDataBytes: 8_192_000, comprDataBytes: 2_048_000, memUsedBytes: 2_200_000 }
+      }
+    };
+  }
+
+  async setIoTier(id: string, tier: string) {
+    this.ioTierCalls.push({ id, tier });
+    return { id, state: "RUNNING", ioTier: tier };
+  }
+
+  async listCheckpoints(_id: string) {
+    return [{ id: "0123456789ab", createdAt: "2026-01-01T00:00:00.000Z", label: "before" }];
+  }
+
+  async createCheckpoint(id: string, payload: { label?: string }) {
+    this.checkpointCalls.push({ id, label: payload.label });
+    return { id: "0123456789ab", createdAt: "2026-01-01T00:00:00.000Z", label: payload.label };
+  }
+
+  async rollbackCheckpoint(id: string, checkpointId: string) {
+    this.checkpointCalls.push({ id, rollbackTo: checkpointId });
+    return { id: checkpointId, createdAt: "2026-01-01T00:00:00.000Z" };
+  }
 }
 
 const apiKey = "test-key";
@@ -212,6 +275,46 @@ describe("manager API", () => {
     expect(service.listSnapshotsCalls[0]).toBe("internal");
   });
 
+  it("pages snapshot listings through limit/cursor and X-Next-Cursor", async () => {
+    const service = new FakeVmService();
+    const app = buildTestApp(service);
+
+    const res = await app.inject({ method: "GET", url: "/v1/snapshots?limit=20&cursor=abc", headers: { "x-api-key": apiKey } });
+    expect(res.statusCode).toBe(200);
+    expect(service.listSnapshotsPages[0]).toMatchObject({ limit: 20, cursor: "abc" });
+    expect(res.headers["x-next-cursor"]).toBe("next-page");
+  });
+
+  it("streams exec fan-out results as NDJSON with a closing summary", async () => {
+    const service = new FakeVmService();
+    const app = buildTestApp(service);
+
+    const res = await app.inject({
+      method: "POST",
+      url: "/v1/exec/fanout",
+      headers: { "x-api-key": apiKey },
+      payload: { selector: { vmIds: ["vm-1", "vm-2"] }, cmd: "true" }
+    });
+    expect(res.statusCode).toBe(200);
+    expect(res.headers["content-type"]).toContain("application/x-ndjson");
+    const lines = res.body.trim().split("\n").map((line) => JSON.parse(line));
+    expect(lines.map((line) => line.type)).toEqual(["result", "result", "summary"]);
+    expect(lines[2]).toMatchObject({ total: 2, succeeded: 2 });
+  });
+
+  it("rejects exec fan-out without a selector before streaming", async () => {
+    const service = new FakeVmService();
+    const app = buildTestApp(service);
+
+    const res = await app.inject({
+      method: "POST",
+      url: "/v1/exec/fanout",
+      headers: { "x-api-key": apiKey },
+      payload: { selector: {}, cmd: "true" }
+    });
+    expect(res.statusCode).toBe(400);
+  });
+
   it("starts/stops/destroys a VM", async () => {
     const service = new FakeVmService();
     const app = buildTestApp(service);
@@ -278,6 +381,111 @@ describe("manager API", () => {
     expect(service.runTsCalls.length).toBe(1);
   });
 
+  it("reads and writes raw files", async () => {
+    const service = new FakeVmService();
+    const app = buildTestApp(service);
+
+    const full = await app.inject({
+      method: "GET",
+      url: "/v1/vms/vm-1/files/raw?path=%2Fworkspace%2Fa.txt",
+      headers: { "x-api-key": apiKey }
+    });
+    expect(full.statusCode).toBe(200);
+    expect(full.body).toBe("hello");
+    expect(full.headers.etag).toBe('"abc"');
+
+    const partial = await app.inject({
+      method: "GET",
+      url: "/v1/vms/vm-1/files/raw?path=%2Fworkspace%2Fa.txt",
+      headers: { "x-api-key": apiKey, range: "bytes=1-3" }
+    });
+    expect(partial.statusCode).toBe(206);
+    expect(partial.headers["content-range"]).toBe("bytes 1-3/5");
+    expect(service.rawReads[1]?.options?.range).toBe("bytes=1-3");
+
+    const write = await app.inject({
+      method: "PUT",
+      url: "/v1/vms/vm-1/files/raw?path=%2Fworkspace%2Fa.txt",
+      headers: { "x-api-key": apiKey, "content-type": "application/octet-stream", "if-match": '"abc"' },
+      payload: Buffer.from("new content")
+    });
+    expect(write.statusCode).toBe(200);
+    expect(JSON.parse(write.body)).toEqual({ path: "/workspace/a.txt", size: 11, sha256: "def" });
+    expect(service.rawWrites[0]?.data.toString()).toBe("new content");
+    expect(service.rawWrites[0]?.options?.ifMatch).toBe('"abc"');
+  });
+
+  it("creates, lists and rolls back workspace checkpoints", async () => {
+    const service = new FakeVmService();
+    const app = buildTestApp(service);
+
+    const created = await app.inject({
+      method: "POST",
+      url: "/v1/vms/vm-1/checkpoints",
+      headers: { "x-api-key": apiKey },
+      payload: { label: "before" }
+    });
+    expect(created.statusCode).toBe(201);
+    expect(JSON.parse(created.body).id).toBe("0123456789ab");
+
+    const list = await app.inject({
+      method: "GET",
+      url: "/v1/vms/vm-1/checkpoints",
+      headers: { "x-api-key": apiKey }
+    });
+    expect(list.statusCode).toBe(200);
+    expect(JSON.parse(list.body).checkpoints).toHaveLength(1);
+
+    const rollback = await app.inject({
+      method: "POST",
+      url: "/v1/vms/vm-1/checkpoints/0123456789ab/rollback",
+      headers: { "x-api-key": apiKey }
+    });
+    expect(rollback.statusCode).toBe(200);
+    expect(service.checkpointCalls).toEqual([
+      { id: "vm-1", label: "before" },
+      { id: "vm-1", rollbackTo: "0123456789ab" }
+    ]);
+  });
+
+  it("returns guest swap stats", async () => {
+    const service = new FakeVmService();
+    const app = buildTestApp(service);
+
+    const res = await app.inject({
+      method: "GET",
+      url: "/v1/vms/vm-1/stats",
+      headers: { "x-api-key": apiKey }
+    });
+    expect(res.statusCode).toBe(200);
+    const body = JSON.parse(res.body);
+    expect(body.memory.swapOutPages).toBe(2_000);
+    expect(body.memory.zram.comprDataBytes).toBe(2_048_000);
+  });
+
+  it("changes the VM io tier and rejects unknown tiers", async () => {
+    const service = new FakeVmService();
+    const app = buildTestApp(service);
+
+    const ok = await app.inject({
+      method: "PATCH",
+      url: "/v1/vms/vm-1/io",
+      headers: { "x-api-key": apiKey },
+      payload: { tier: "small" }
+    });
+    expect(ok.statusCode).toBe(200);
+    expect(JSON.parse(ok.body).ioTier).toBe("small");
+
+    const bad = await app.inject({
+      method: "PATCH",
+      url: "/v1/vms/vm-1/io",
+      headers: { "x-api-key": apiKey },
+      payload: { tier: "turbo" }
+    });
+    expect(bad.statusCode).toBe(400);
+    expect(service.ioTierCalls).toEqual([{ id: "vm-1", tier: "small" }]);
+  });
+
   it("returns 400 for invalid VM id (undefined)", async () => {
     const service = new FakeVmService();
     const app = buildTestApp(service);
@@ -1,12 +1,19 @@
 import type { FastifyPluginAsync } from "fastify";
 import type { AppDeps } from "../types/deps.js";
 import { DashboardService } from "../telemetry/dashboardService.js";
+import { EventRing, SseConnection } from "../telemetry/eventRing.js";
 import { BodyTooLargeError, readStreamToBuffer, writeStreamToFile } from "../utils/streams.js";
 import { HttpError } from "./httpErrors.js";
 import fs from "node:fs/promises";
-import path from "node:path";
+import { once } from "node:events";
+import { createHash } from "node:crypto";
 import AdmZip from "adm-zip";
 import { ExecLogService } from "../services/execLogService.js";
+import { IO_TIERS } from "../firecracker/ioTiers.js";
+import type { VmIoTier } from "../types/vm.js";
+
+/** Per-connection cap on unsent SSE bytes; beyond it events wait in the shared ring. */
+const SSE_MAX_BUFFERED_BYTES = 256 * 1024;
 
 export interface ApiPluginOptions {
   deps: AppDeps;
@@ -18,7 +25,9 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     jsonMedium: 1024 * 1024,
     uploadCompressed: 10 * 1024 * 1024,
     // Images can be large; we stream uploads to disk but still enforce an upper bound.
-    imageBinary: 3 * 1024 * 1024 * 1024
+    imageBinary: 3 * 1024 * 1024 * 1024,
+    // Resumable uploads send images in chunks; a failed chunk only costs this much to retry.
+    imageChunk: 256 * 1024 * 1024
   };
 
   // NOTE: AJV is configured to remove unknown properties. If an error response schema is
@@ -38,6 +47,24 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     }
   };
 
+  // One buffer of serialized activity events shared by every /v1/admin/events connection.
+  let activityRing: EventRing | null = null;
+  if (opts.deps.activityService) {
+    const safeJsonParse = (s: string | undefined) => {
+      if (!s) return undefined;
+      try {
+        return JSON.parse(s);
+      } catch {
+        return undefined;
+      }
+    };
+    const ring = new EventRing({ capacity: 1000, maxBytes: 4 * 1024 * 1024 });
+    opts.deps.activityService.subscribe((ev) => {
+      ring.push("activity", { ...ev, meta: safeJsonParse(ev.metaJson) });
+    });
+    activityRing = ring;
+  }
+
   const sessions = (app as any).sessions as { get: (id?: string | null) => any } | undefined;
   const requireSession = (request: any, reply: any) => {
     const sid = request.cookies?.rds_session;
@@ -90,7 +117,11 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
       }
     },
     async () => {
-      const svc = new DashboardService(opts.deps.store, opts.deps.storage, opts.deps.storageRoot);
+      const svc = new DashboardService(
+        opts.deps.store,
+        { counts: () => opts.deps.vmService.countSnapshots() },
+        opts.deps.storageRoot
+      );
       return svc.getOverview();
     }
   );
@@ -201,12 +232,14 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
         reply.code(404);
         return { message: "Image not found" };
       }
-      const dir = opts.deps.images.imageDirForId(id);
-      await fs.mkdir(dir, { recursive: true });
-      const dest = path.join(dir, "vmlinux");
+      const staging = await opts.deps.images.stagingPath();
       const bodyStream = request.body as any;
-      await writeStreamToFile(bodyStream, dest, BODY_LIMITS.imageBinary);
-      await opts.deps.images.markKernelUploaded(id, "vmlinux");
+      try {
+        const written = await writeStreamToFile(bodyStream, staging, BODY_LIMITS.imageBinary);
+        await opts.deps.images.ingestArtifact(id, "kernel", { sha256: written.sha256, srcPath: staging });
+      } finally {
+        await fs.rm(staging, { force: true }).catch(() => undefined);
+      }
       void opts.deps.vmService.ensureImageSeedSnapshot(id);
       await opts.deps.activityService
         ?.logEvent({
@@ -240,12 +273,14 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
         reply.code(404);
         return { message: "Image not found" };
       }
-      const dir = opts.deps.images.imageDirForId(id);
-      await fs.mkdir(dir, { recursive: true });
-      const dest = path.join(dir, "rootfs.ext4");
+      const staging = await opts.deps.images.stagingPath();
       const bodyStream = request.body as any;
-      await writeStreamToFile(bodyStream, dest, BODY_LIMITS.imageBinary);
-      await opts.deps.images.markRootfsUploaded(id, "rootfs.ext4");
+      try {
+        const written = await writeStreamToFile(bodyStream, staging, BODY_LIMITS.imageBinary);
+        await opts.deps.images.ingestArtifact(id, "rootfs", { sha256: written.sha256, srcPath: staging });
+      } finally {
+        await fs.rm(staging, { force: true }).catch(() => undefined);
+      }
       void opts.deps.vmService.ensureImageSeedSnapshot(id);
       await opts.deps.activityService
         ?.logEvent({
@@ -280,9 +315,6 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
         reply.code(404);
         return { message: "Image not found" };
       }
-      const dir = opts.deps.images.imageDirForId(id);
-      await fs.mkdir(dir, { recursive: true });
-
       // Read the zip into a buffer
       const bodyStream = request.body as any;
       const zipBuffer = await readStreamToBuffer(bodyStream, BODY_LIMITS.imageBinary);
@@ -299,17 +331,18 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
         return { message: "Zip must contain vmlinux and/or rootfs.ext4" };
       }
 
-      // Extract files
-      if (kernelEntry) {
-        const kernelData = kernelEntry.getData();
-        await fs.writeFile(path.join(dir, "vmlinux"), kernelData);
-        await opts.deps.images.markKernelUploaded(id, "vmlinux");
-      }
-
-      if (rootfsEntry) {
-        const rootfsData = rootfsEntry.getData();
-        await fs.writeFile(path.join(dir, "rootfs.ext4"), rootfsData);
-        await opts.deps.images.markRootfsUploaded(id, "rootfs.ext4");
+      // Extract files into the content-addressed store
+      for (const [kind, entry] of [["kernel", kernelEntry], ["rootfs", rootfsEntry]] as const) {
+        if (!entry) continue;
+        const data = entry.getData();
+        const staging = await opts.deps.images.stagingPath();
+        try {
+          await fs.writeFile(staging, data);
+          const sha256 = createHash("sha256").update(data).digest("hex");
+          await opts.deps.images.ingestArtifact(id, kind, { sha256, srcPath: staging });
+        } finally {
+          await fs.rm(staging, { force: true }).catch(() => undefined);
+        }
       }
       void opts.deps.vmService.ensureImageSeedSnapshot(id);
 
@@ -331,6 +364,169 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     }
   );
 
+  const UPLOAD_SESSION_RESPONSE = {
+    type: "object",
+    additionalProperties: true,
+    properties: {
+      id: { type: "string" },
+      imageId: { type: "string" },
+      kind: { type: "string" },
+      sizeBytes: { type: "number" },
+      sha256: { type: ["string", "null"] },
+      offset: { type: "number" },
+      deduplicated: { type: "boolean" }
+    }
+  };
+
+  const requireImageUploads = () => {
+    const svc = opts.deps.imageUploads;
+    if (!svc) throw new HttpError(503, "Resumable uploads are not available");
+    return svc;
+  };
+
+  app.post(
+    "/v1/images/:id/uploads",
+    {
+      bodyLimit: BODY_LIMITS.jsonSmall,
+      schema: {
+        summary: "Start resumable artifact upload",
+        description:
+          "Starts a chunked upload for the image kernel or rootfs. When `sha256` is given and identical content is already stored, the artifact is attached immediately and `deduplicated: true` is returned (no upload needed).",
+        tags: ["images"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        body: {
+          type: "object",
+          required: ["kind", "sizeBytes"],
+          properties: {
+            kind: { type: "string", enum: ["kernel", "rootfs"] },
+            sizeBytes: { type: "number" },
+            sha256: { type: "string", description: "Expected sha256 (hex); verified on completion" }
+          }
+        },
+        response: { 200: UPLOAD_SESSION_RESPONSE, 201: UPLOAD_SESSION_RESPONSE, 400: ERROR_RESPONSE, 404: ERROR_RESPONSE }
+      }
+    },
+    async (request, reply) => {
+      const { id } = request.params as { id: string };
+      const body = request.body as { kind: "kernel" | "rootfs"; sizeBytes: number; sha256?: string };
+      const result = await requireImageUploads().begin(id, body);
+      if ("deduplicated" in result) {
+        void opts.deps.vmService.ensureImageSeedSnapshot(id);
+        await opts.deps.activityService
+          ?.logEvent({
+            type: `image.${result.kind}_uploaded`,
+            entityType: "image",
+            entityId: id,
+            message: `Image ${result.kind} attached from existing content`,
+            meta: { imageId: id, sha256: result.sha256, deduplicated: true }
+          })
+          .catch(() => undefined);
+        reply.code(200);
+        return result;
+      }
+      reply.code(201);
+      return result;
+    }
+  );
+
+  app.get(
+    "/v1/images/:id/uploads/:uploadId",
+    {
+      schema: {
+        summary: "Get resumable upload status",
+        description: "Returns the current offset so an interrupted client can resume from there.",
+        tags: ["images"],
+        params: {
+          type: "object",
+          required: ["id", "uploadId"],
+          properties: { id: { type: "string" }, uploadId: { type: "string" } }
+        },
+        response: { 200: UPLOAD_SESSION_RESPONSE, 404: ERROR_RESPONSE }
+      }
+    },
+    async (request) => {
+      const { id, uploadId } = request.params as { id: string; uploadId: string };
+      return requireImageUploads().get(id, uploadId);
+    }
+  );
+
+  app.patch(
+    "/v1/images/:id/uploads/:uploadId",
+    {
+      bodyLimit: BODY_LIMITS.imageChunk,
+      schema: {
+        summary: "Upload a chunk",
+        description: "Appends raw bytes at `offset`, which must equal the upload's current offset (409 otherwise).",
+        tags: ["images"],
+        params: {
+          type: "object",
+          required: ["id", "uploadId"],
+          properties: { id: { type: "string" }, uploadId: { type: "string" } }
+        },
+        querystring: { type: "object", required: ["offset"], properties: { offset: { type: "number" } } },
+        response: { 200: UPLOAD_SESSION_RESPONSE, 404: ERROR_RESPONSE, 409: ERROR_RESPONSE, 413: ERROR_RESPONSE }
+      }
+    },
+    async (request) => {
+      const { id, uploadId } = request.params as { id: string; uploadId: string };
+      const offset = Number((request.query as { offset?: number }).offset);
+      return requireImageUploads().appendChunk(id, uploadId, offset, request.body as any, BODY_LIMITS.imageChunk);
+    }
+  );
+
+  app.post(
+    "/v1/images/:id/uploads/:uploadId/complete",
+    {
+      schema: {
+        summary: "Complete resumable upload",
+        description: "Verifies the sha256 and attaches the artifact to the image via the content-addressed store.",
+        tags: ["images"],
+        params: {
+          type: "object",
+          required: ["id", "uploadId"],
+          properties: { id: { type: "string" }, uploadId: { type: "string" } }
+        },
+        response: { 200: UPLOAD_SESSION_RESPONSE, 404: ERROR_RESPONSE, 409: ERROR_RESPONSE, 422: ERROR_RESPONSE }
+      }
+    },
+    async (request) => {
+      const { id, uploadId } = request.params as { id: string; uploadId: string };
+      const result = await requireImageUploads().complete(id, uploadId);
+      void opts.deps.vmService.ensureImageSeedSnapshot(id);
+      await opts.deps.activityService
+        ?.logEvent({
+          type: `image.${result.kind}_uploaded`,
+          entityType: "image",
+          entityId: id,
+          message: `Image ${result.kind} uploaded`,
+          meta: { imageId: id, sha256: result.sha256, deduplicated: result.deduplicated }
+        })
+        .catch(() => undefined);
+      return result;
+    }
+  );
+
+  app.delete(
+    "/v1/images/:id/uploads/:uploadId",
+    {
+      schema: {
+        summary: "Abort resumable upload",
+        tags: ["images"],
+        params: {
+          type: "object",
+          required: ["id", "uploadId"],
+          properties: { id: { type: "string" }, uploadId: { type: "string" } }
+        },
+        response: { 204: { type: "null" }, 404: ERROR_RESPONSE }
+      }
+    },
+    async (request, reply) => {
+      const { id, uploadId } = request.params as { id: string; uploadId: string };
+      await requireImageUploads().abort(id, uploadId);
+      reply.code(204);
+    }
+  );
+
   app.delete(
     "/v1/images/:id",
     {
@@ -363,6 +559,75 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     }
   );
 
+  app.get(
+    "/v1/admin/hugepages",
+    {
+      schema: {
+        summary: "Hugepage pool",
+        description: "Host 2 MiB hugepage pool counters and the pages held by hugepage-backed VMs.",
+        tags: ["admin"],
+        response: {
+          200: {
+            type: "object",
+            properties: {
+              pageSizeKb: { type: "integer" },
+              totalPages: { type: "integer" },
+              freePages: { type: "integer" },
+              reservedPages: { type: "integer" },
+              availablePages: { type: "integer" },
+              vms: { type: "object", additionalProperties: { type: "integer" } },
+              fallbacks: { type: "integer" }
+            }
+          }
+        }
+      }
+    },
+    async () => opts.deps.firecracker.hugePageUsage()
+  );
+
+  app.get(
+    "/v1/admin/storage",
+    {
+      schema: {
+        summary: "Storage backend",
+        description: "Disk backend in use (STORAGE_BACKEND), dm-thin pool occupancy and pre-cloned overlay pool metrics.",
+        tags: ["admin"],
+        response: {
+          200: {
+            type: "object",
+            properties: {
+              backend: { type: "string", enum: ["file", "thin"] },
+              thinPool: {
+                type: "object",
+                properties: {
+                  dataUsedBytes: { type: "integer" },
+                  dataTotalBytes: { type: "integer" },
+                  metadataUsedBytes: { type: "integer" },
+                  metadataTotalBytes: { type: "integer" },
+                  mode: { type: "string" },
+                  volumes: { type: "integer" }
+                }
+              },
+              overlayPool: {
+                type: "object",
+                properties: {
+                  depth: { type: "integer" },
+                  ready: { type: "object", additionalProperties: { type: "integer" } },
+                  hits: { type: "integer" },
+                  misses: { type: "integer" },
+                  refills: { type: "integer" },
+                  refillErrors: { type: "integer" },
+                  avgRefillMs: { type: "integer" }
+                }
+              }
+            }
+          }
+        }
+      }
+    },
+    async () => opts.deps.storage.storageUsage()
+  );
+
   app.get(
     "/v1/admin/activity",
     {
@@ -392,15 +657,15 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     {
       schema: {
         summary: "Admin events (SSE)",
-        description: "Streams activity events as Server-Sent Events (SSE).",
+        description:
+          "Streams activity events as Server-Sent Events (SSE). Reconnects with `Last-Event-ID` replay the events missed meanwhile, as far as the shared buffer reaches; a `resync` event reports how many were lost.",
         tags: ["admin"],
         response: { 200: { type: "string" }, 401: { type: "object" } }
       }
     },
     async (request, reply) => {
       if (!requireSession(request, reply)) return;
-      const svc = opts.deps.activityService;
-      if (!svc) {
+      if (!activityRing) {
         reply.code(503);
         return { message: "Activity service not available" };
       }
@@ -413,42 +678,18 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
       raw.setHeader("Connection", "keep-alive");
       raw.flushHeaders?.();
 
-      const safeJsonParse = (s: string | undefined) => {
-        if (!s) return undefined;
-        try {
-          return JSON.parse(s);
-        } catch {
-          return undefined;
-        }
-      };
-
-      const send = (eventName: string, id: string | undefined, data: unknown) => {
-        if (raw.destroyed) return;
-        raw.write(`event: ${eventName}\n`);
-        if (id) raw.write(`id: ${id}\n`);
-        raw.write(`data: ${JSON.stringify(data)}\n\n`);
-      };
-
       // Initial comment so browsers treat the stream as open quickly.
       raw.write(`: connected\n\n`);
 
-      const unsubscribe = svc.subscribe((ev) => {
-        const payload = {
-          ...ev,
-          meta: safeJsonParse(ev.metaJson)
-        };
-        send("activity", ev.id, payload);
+      // Replays anything after Last-Event-ID, then follows the ring as events arrive.
+      const lastEventId = request.headers["last-event-id"];
+      const connection = new SseConnection(activityRing, raw, {
+        maxBufferedBytes: SSE_MAX_BUFFERED_BYTES,
+        lastEventId: Array.isArray(lastEventId) ? lastEventId[0] : lastEventId
       });
 
-      const heartbeat = setInterval(() => {
-        if (raw.destroyed) return;
-        raw.write(`: ping\n\n`);
-      }, 15_000);
-
-      raw.on("close", () => {
-        clearInterval(heartbeat);
-        unsubscribe();
-      });
+      const heartbeat = setInterval(() => connection.comment("ping"), 15_000);
+      raw.on("close", () => clearInterval(heartbeat));
     }
   );
 
@@ -712,12 +953,15 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
       schema: {
         summary: "List snapshots",
         description:
-          "Lists snapshots stored under STORAGE_ROOT/snapshots. By default returns user overlay snapshots only. Use ?scope=internal|user|all for filtering.",
+          "Lists snapshots from the snapshot catalog, newest first. By default returns user overlay snapshots only. Use ?scope=internal|user|all for filtering. With `limit`, the `X-Next-Cursor` response header carries the `cursor` for the next page.",
         tags: ["snapshots"],
         querystring: {
           type: "object",
           properties: {
-            scope: { type: "string", enum: ["user", "internal", "all"] }
+            scope: { type: "string", enum: ["user", "internal", "all"] },
+            imageId: { type: "string" },
+            limit: { type: "integer", minimum: 1, maximum: 500 },
+            cursor: { type: "string" }
           }
         },
         response: {
@@ -725,10 +969,17 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
         }
       }
     },
-    async (request) => {
-      const scopeRaw = String((request.query as any)?.scope ?? "user").trim().toLowerCase();
+    async (request, reply) => {
+      const query = (request.query ?? {}) as { scope?: string; imageId?: string; limit?: number; cursor?: string };
+      const scopeRaw = String(query.scope ?? "user").trim().toLowerCase();
       const scope = scopeRaw === "internal" || scopeRaw === "all" ? (scopeRaw as "internal" | "all") : "user";
-      return opts.deps.vmService.listSnapshots(scope);
+      const page = await opts.deps.vmService.listSnapshots(scope, {
+        imageId: query.imageId,
+        limit: query.limit,
+        cursor: query.cursor
+      });
+      if (page.nextCursor) reply.header("x-next-cursor", page.nextCursor);
+      return page.items;
     }
   );
 
@@ -762,6 +1013,216 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     }
   );
 
+  const GUEST_STATS_SCHEMA = {
+    type: "object",
+    properties: {
+      uptimeSec: { type: "number" },
+      memory: {
+        type: "object",
+        properties: {
+          memTotalKb: { type: "number" },
+          memAvailableKb: { type: "number" },
+          swapTotalKb: { type: "number" },
+          swapFreeKb: { type: "number" },
+          swapInPages: { type: "number" },
+          swapOutPages: { type: "number" },
+          zram: {
+            type: "object",
+            properties: {
+              diskSizeBytes: { type: "number" },
+              origDataBytes: { type: "number" },
+              comprDataBytes: { type: "number" },
+              memUsedBytes: { type: "number" }
+            }
+          }
+        }
+      }
+    }
+  } as const;
+
+  app.get(
+    "/v1/vms/:id/stats",
+    {
+      schema: {
+        summary: "Guest stats",
+        description: "Memory and swap usage reported by the guest, including zram compression when swap is enabled.",
+        tags: ["vms"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        response: { 200: GUEST_STATS_SCHEMA, 404: ERROR_RESPONSE, 409: ERROR_RESPONSE }
+      }
+    },
+    async (request) => {
+      const { id } = request.params as { id: string };
+      requireValidVmId(id);
+      return opts.deps.vmService.getGuestStats(id);
+    }
+  );
+
+  const IO_DEVICE_SCHEMA = {
+    type: "object",
+    properties: {
+      readBytes: { type: "number" },
+      writeBytes: { type: "number" },
+      readOps: { type: "number" },
+      writeOps: { type: "number" },
+      throttledEvents: { type: "number" }
+    }
+  } as const;
+
+  const IO_STATS_SCHEMA = {
+    type: "object",
+    properties: {
+      tier: { type: "string" },
+      drives: { type: "object", additionalProperties: IO_DEVICE_SCHEMA },
+      net: {
+        type: "object",
+        properties: {
+          rxBytes: { type: "number" },
+          txBytes: { type: "number" },
+          rxThrottled: { type: "number" },
+          txThrottled: { type: "number" }
+        }
+      }
+    }
+  } as const;
+
+  app.get(
+    "/v1/vms/:id/io",
+    {
+      schema: {
+        summary: "Disk and network I/O",
+        description:
+          "The VM's rate-limit tier plus cumulative Firecracker block/net counters, including how often each device was throttled.",
+        tags: ["vms"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        response: { 200: IO_STATS_SCHEMA, 404: ERROR_RESPONSE }
+      }
+    },
+    async (request) => {
+      const { id } = request.params as { id: string };
+      requireValidVmId(id);
+      return opts.deps.vmService.getIoStats(id);
+    }
+  );
+
+  app.patch(
+    "/v1/vms/:id/io",
+    {
+      bodyLimit: BODY_LIMITS.jsonSmall,
+      schema: {
+        summary: "Change I/O tier",
+        description: "Swaps the VM's disk and network rate limiters. Running VMs are updated live; stopped VMs on next start.",
+        tags: ["vms"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        body: {
+          type: "object",
+          required: ["tier"],
+          properties: { tier: { type: "string", enum: [...IO_TIERS] } }
+        },
+        response: {
+          200: { type: "object", additionalProperties: true, properties: { id: { type: "string" }, ioTier: { type: "string" } } },
+          400: ERROR_RESPONSE,
+          404: ERROR_RESPONSE,
+          409: ERROR_RESPONSE
+        }
+      }
+    },
+    async (request) => {
+      const { id } = request.params as { id: string };
+      requireValidVmId(id);
+      const body = request.body as { tier: VmIoTier };
+      return opts.deps.vmService.setIoTier(id, body.tier);
+    }
+  );
+
+  const CHECKPOINT_SCHEMA = {
+    type: "object",
+    properties: {
+      id: { type: "string" },
+      createdAt: { type: "string" },
+      label: { type: "string" }
+    }
+  } as const;
+
+  app.get(
+    "/v1/vms/:id/checkpoints",
+    {
+      schema: {
+        summary: "List workspace checkpoints",
+        description: "Lists in-guest workspace checkpoints, oldest first.",
+        tags: ["vms"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        response: {
+          200: { type: "object", properties: { checkpoints: { type: "array", items: CHECKPOINT_SCHEMA } } },
+          404: ERROR_RESPONSE
+        }
+      }
+    },
+    async (request) => {
+      const { id } = request.params as { id: string };
+      requireValidVmId(id);
+      return { checkpoints: await opts.deps.vmService.listCheckpoints(id) };
+    }
+  );
+
+  app.post(
+    "/v1/vms/:id/checkpoints",
+    {
+      bodyLimit: BODY_LIMITS.jsonSmall,
+      schema: {
+        summary: "Create workspace checkpoint",
+        description:
+          "Freezes the current /workspace contents inside the guest and continues on a fresh overlay layer. Takes milliseconds and does not touch host storage.",
+        tags: ["vms"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        body: {
+          type: "object",
+          properties: { label: { type: "string", maxLength: 200 } }
+        },
+        response: {
+          201: CHECKPOINT_SCHEMA,
+          400: ERROR_RESPONSE,
+          404: ERROR_RESPONSE,
+          409: ERROR_RESPONSE
+        }
+      }
+    },
+    async (request, reply) => {
+      const { id } = request.params as { id: string };
+      requireValidVmId(id);
+      const body = (request.body ?? {}) as { label?: string };
+      const checkpoint = await opts.deps.vmService.createCheckpoint(id, { label: body.label });
+      reply.code(201);
+      return checkpoint;
+    }
+  );
+
+  app.post(
+    "/v1/vms/:id/checkpoints/:checkpointId/rollback",
+    {
+      schema: {
+        summary: "Roll back to workspace checkpoint",
+        description:
+          "Discards every /workspace change made after the checkpoint and drops newer checkpoints. Running sandboxed processes are killed.",
+        tags: ["vms"],
+        params: {
+          type: "object",
+          required: ["id", "checkpointId"],
+          properties: { id: { type: "string" }, checkpointId: { type: "string", pattern: "^[a-f0-9]{12}$" } }
+        },
+        response: {
+          200: CHECKPOINT_SCHEMA,
+          404: ERROR_RESPONSE
+        }
+      }
+    },
+    async (request) => {
+      const { id, checkpointId } = request.params as { id: string; checkpointId: string };
+      requireValidVmId(id);
+      return opts.deps.vmService.rollbackCheckpoint(id, checkpointId);
+    }
+  );
+
   app.get(
     "/v1/vms",
     {
@@ -929,6 +1390,9 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
                     snapshotId: { type: "string" },
                     imageId: { type: "string" },
                     diskSizeMb: { type: "number" },
+                    workspaceDiskMb: { type: "integer" },
+                    ioTier: { type: "string", enum: [...IO_TIERS] },
+                    hugePages: { type: "boolean" },
                     secretEnv: { type: "array", items: { type: "string" } },
                     peerLinks: {
                       type: "array",
@@ -983,6 +1447,21 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
             },
             imageId: { type: "string", description: "Optional guest image id (defaults to the configured default image)" },
             diskSizeMb: { type: "number", description: "Optional disk size (MiB). Must be >= base rootfs size." },
+            workspaceDiskMb: {
+              type: "integer",
+              description:
+                "Optional dedicated /home/user disk (MiB). Snapshots and stop/start then persist only this disk; the system overlay is reset on every boot."
+            },
+            ioTier: {
+              type: "string",
+              enum: [...IO_TIERS],
+              description: "Disk and network rate-limit tier (defaults to DEFAULT_IO_TIER). Adjustable later via PATCH /v1/vms/:id/io."
+            },
+            hugePages: {
+              type: "boolean",
+              description:
+                "Back guest memory with 2 MiB hugepages (defaults to GUEST_HUGE_PAGES). Always cold boots; falls back to 4 KiB pages when the host pool is exhausted."
+            },
             secretEnv: { type: "array", items: { type: "string" }, description: 'Secret environment variables in the format "KEY=value"' },
             peerLinks: {
               type: "array",
@@ -1042,6 +1521,9 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
             snapshotId?: string;
             imageId?: string;
             diskSizeMb?: number;
+            workspaceDiskMb?: number;
+            ioTier?: VmIoTier;
+            hugePages?: boolean;
             secretEnv?: string[];
             peerLinks?: Array<{ alias?: string; vmId?: string; sourceMode?: "hidden" | "mounted" }>;
           }
@@ -1059,6 +1541,9 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
         snapshotId: body.snapshotId,
         imageId: body.imageId,
         diskSizeMb: body.diskSizeMb,
+        workspaceDiskMb: body.workspaceDiskMb,
+        ioTier: body.ioTier,
+        hugePages: body.hugePages,
         secretEnv: body.secretEnv,
         peerLinks: body.peerLinks?.map((link) => ({
           alias: String(link.alias ?? ""),
@@ -1251,7 +1736,11 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
             properties: {
               exitCode: { type: "number", description: "Process exit code" },
               stdout: { type: "string", description: "UTF-8 stdout" },
-              stderr: { type: "string", description: "UTF-8 stderr" }
+              stderr: { type: "string", description: "UTF-8 stderr" },
+              memoryPressureKilled: {
+                type: "boolean",
+                description: "Set when the guest memory guard killed the command under sustained memory pressure"
+              }
             },
             examples: [{ exitCode: 0, stdout: "hello\n", stderr: "" }]
           },
@@ -1276,6 +1765,83 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
     }
   );
 
+  app.post(
+    "/v1/exec/fanout",
+    {
+      bodyLimit: BODY_LIMITS.jsonMedium,
+      config: { rateLimit: { max: 30, timeWindow: "1 minute" } },
+      schema: {
+        summary: "Execute command across VMs",
+        description:
+          "Runs one shell command in every RUNNING VM matched by `selector`, at most `concurrency` VMs at a time (capped by MAX_FANOUT_CONCURRENCY). " +
+          "The response is NDJSON: one `result` line per VM in completion order, then a `summary` line with success/failure counts and p50/p99 durations.",
+        tags: ["exec"],
+        body: {
+          type: "object",
+          required: ["selector", "cmd"],
+          properties: {
+            selector: {
+              type: "object",
+              properties: {
+                vmIds: { type: "array", items: { type: "string" }, description: "Explicit VM ids (missing or stopped VMs are reported as failed)" },
+                imageId: { type: "string", description: "Only VMs running this image" },
+                all: { type: "boolean", description: "Target every running VM; required when neither vmIds nor imageId is set" }
+              }
+            },
+            cmd: { type: "string", description: "Shell command (bash -lc)" },
+            cwd: { type: "string", description: "Working directory (defaults to /workspace)" },
+            env: { type: "object", additionalProperties: { type: "string" }, description: "Environment variables" },
+            timeoutMs: { type: "number", description: "Per-VM timeout in milliseconds" },
+            concurrency: { type: "integer", minimum: 1, description: "VMs in flight at once" }
+          },
+          examples: [{ selector: { imageId: "img-123" }, cmd: "/opt/health.sh", timeoutMs: 10000, concurrency: 20 }]
+        },
+        response: { 400: ERROR_RESPONSE }
+      }
+    },
+    async (request, reply) => {
+      const body = request.body as {
+        selector: { vmIds?: string[]; imageId?: string; all?: boolean };
+        cmd: string;
+        cwd?: string;
+        env?: Record<string, string>;
+        timeoutMs?: number;
+        concurrency?: number;
+      };
+      const plan = await opts.deps.vmService.planExecFanout(body);
+
+      const raw = reply.raw;
+      reply.hijack();
+      raw.setHeader("Content-Type", "application/x-ndjson; charset=utf-8");
+      raw.setHeader("Cache-Control", "no-cache, no-transform");
+      raw.flushHeaders?.();
+
+      let closed = false;
+      raw.on("close", () => {
+        closed = true;
+      });
+      const writeLine = async (value: unknown) => {
+        if (closed || raw.destroyed) return;
+        if (!raw.write(`${JSON.stringify(value)}\n`)) {
+          await Promise.race([once(raw, "drain"), once(raw, "close")]);
+        }
+      };
+
+      try {
+        const summary = await opts.deps.vmService.execFanout(
+          plan,
+          (result) => writeLine({ type: "result", ...result }),
+          () => closed
+        );
+        await writeLine({ type: "summary", ...summary });
+      } catch (err) {
+        await writeLine({ type: "error", message: String((err as any)?.message ?? err) });
+      } finally {
+        raw.end();
+      }
+    }
+  );
+
   app.post(
     "/v1/vms/:id/run-ts",
     {
@@ -1345,7 +1911,11 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
               // Optional structured output captured inside the VM via global `result.set(...)`.
               result: { type: "object", additionalProperties: true, description: "Structured result payload (if set)" },
               // Optional structured error captured inside the VM via global `result.error(...)`.
-              error: { type: "object", additionalProperties: true, description: "Structured error payload (if set)" }
+              error: { type: "object", additionalProperties: true, description: "Structured error payload (if set)" },
+              memoryPressureKilled: {
+                type: "boolean",
+                description: "Set when the guest memory guard killed the program under sustained memory pressure"
+              }
             },
             examples: [{ exitCode: 0, stdout: "4\n", stderr: "" }]
           },
@@ -1436,7 +2006,11 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
               // Optional structured output captured inside the VM via global `result.set(...)`.
               result: { type: "object", additionalProperties: true, description: "Structured result payload (if set)" },
               // Optional structured error captured inside the VM via global `result.error(...)`.
-              error: { type: "object", additionalProperties: true, description: "Structured error payload (if set)" }
+              error: { type: "object", additionalProperties: true, description: "Structured error payload (if set)" },
+              memoryPressureKilled: {
+                type: "boolean",
+                description: "Set when the guest memory guard killed the program under sustained memory pressure"
+              }
             },
             examples: [{ exitCode: 0, stdout: "4\n", stderr: "" }]
           },
@@ -1584,4 +2158,107 @@ export const apiPlugin: FastifyPluginAsync<ApiPluginOptions> = async (app, opts)
       }
     }
   );
+
+  app.get(
+    "/v1/vms/:id/files/raw",
+    {
+      config: { rateLimit: { max: 300, timeWindow: "1 minute" } },
+      schema: {
+        summary: "Read a single file",
+        description:
+          "Returns the raw bytes of one file without archive processing. Path must be confined to /workspace. Supports a single `Range: bytes=` range and `If-Match` with the sha256 returned in `ETag`.",
+        tags: ["files"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        querystring: { type: "object", required: ["path"], properties: { path: { type: "string" } } },
+        response: {
+          200: { type: "string", description: "File bytes" },
+          206: { type: "string", description: "Requested byte range" },
+          400: ERROR_RESPONSE,
+          404: ERROR_RESPONSE,
+          412: ERROR_RESPONSE,
+          416: ERROR_RESPONSE
+        }
+      }
+    },
+    async (request, reply) => {
+      const { id } = request.params as { id: string };
+      requireValidVmId(id);
+      const path = (request.query as { path?: string }).path ?? "";
+      if (!path) {
+        reply.code(400);
+        return { message: "path is required" };
+      }
+      const range = typeof request.headers.range === "string" ? request.headers.range : undefined;
+      const ifMatch = typeof request.headers["if-match"] === "string" ? request.headers["if-match"] : undefined;
+      const file = await opts.deps.vmService.readRawFile(id, path, { range, ifMatch });
+      reply.code(file.statusCode);
+      reply.header("content-type", "application/octet-stream");
+      reply.header("accept-ranges", "bytes");
+      if (file.sha256) reply.header("etag", `"${file.sha256}"`);
+      if (file.contentRange) reply.header("content-range", file.contentRange);
+      return reply.send(file.data);
+    }
+  );
+
+  app.put(
+    "/v1/vms/:id/files/raw",
+    {
+      bodyLimit: BODY_LIMITS.uploadCompressed,
+      config: { rateLimit: { max: 300, timeWindow: "1 minute" } },
+      schema: {
+        summary: "Write a single file",
+        description:
+          "Atomically replaces (or creates) one file with the raw request body. Path must be confined to /workspace; missing parent directories are created. Send `If-Match` with a previous ETag to avoid overwriting concurrent changes.",
+        tags: ["files"],
+        params: { type: "object", required: ["id"], properties: { id: { type: "string" } } },
+        querystring: { type: "object", required: ["path"], properties: { path: { type: "string" } } },
+        consumes: ["application/octet-stream"],
+        body: {
+          // Runtime parser leaves the body as a stream; keep the schema permissive.
+          type: "object",
+          additionalProperties: true,
+          description: "File bytes (request body is treated as raw bytes)"
+        },
+        response: {
+          200: {
+            type: "object",
+            required: ["path", "size", "sha256"],
+            properties: {
+              path: { type: "string" },
+              size: { type: "number" },
+              sha256: { type: "string" }
+            }
+          },
+          400: ERROR_RESPONSE,
+          412: ERROR_RESPONSE,
+          413: ERROR_RESPONSE
+        }
+      }
+    },
+    async (request, reply) => {
+      const { id } = request.params as { id: string };
+      requireValidVmId(id);
+      const path = (request.query as { path?: string }).path ?? "";
+      if (!path) {
+        reply.code(400);
+        return { message: "path is required" };
+      }
+      const ifMatch = typeof request.headers["if-match"] === "string" ? request.headers["if-match"] : undefined;
+      let body: Buffer;
+      try {
+        // text/plain bodies are already parsed into a string by Fastify.
+        const raw = typeof request.body === "string" ? Buffer.from(request.body, "utf-8") : (request.body as any);
+        body = await readStreamToBuffer(raw, BODY_LIMITS.uploadCompressed);
+      } catch (err: any) {
+        if (err instanceof BodyTooLargeError) {
+          reply.code(413);
+          return { message: "Body too large" };
+        }
+        throw err;
+      }
+      const written = await opts.deps.vmService.writeRawFile(id, path, body, { ifMatch });
+      reply.header("etag", `"${written.sha256}"`);
+      return written;
+    }
+  );
 };
@@ -119,6 +119,22 @@ export function buildApp(options: BuildAppOptions) {
         };
       }
 
+      const rawPut = openapiObject.paths?.["/v1/vms/{id}/files/raw"]?.put;
+      if (rawPut) {
+        rawPut.requestBody = {
+          required: true,
+          content: { "application/octet-stream": { schema: { type: "string", format: "binary" } } }
+        };
+      }
+
+      const rawGet = openapiObject.paths?.["/v1/vms/{id}/files/raw"]?.get;
+      for (const code of ["200", "206"]) {
+        const res = rawGet?.responses?.[code];
+        if (res && !("$ref" in res)) {
+          res.content = { "application/octet-stream": { schema: { type: "string", format: "binary" } } };
+        }
+      }
+
       return openapiObject;
     }
   });
@@ -1,3 +1,6 @@
+import { IO_TIERS } from "../firecracker/ioTiers.js";
+import type { VmIoTier } from "../types/vm.js";
+
 export interface EnvConfig {
   apiKey: string;
   adminEmail: string;
@@ -22,14 +25,43 @@ export interface EnvConfig {
   };
   rootfsCloneMode: "auto" | "reflink" | "copy";
   overlaySizeBytes: number;
+  overlayPoolDepth: number;
+  /** `thin` keeps writable disks in a dm-thin pool (see ThinStorageProvider). */
+  storageBackend: "file" | "thin";
+  thinPool: {
+    name: string;
+    dataSizeBytes: number;
+  };
   firecrackerLogLevel: "Error" | "Warning" | "Info" | "Debug";
   overlayDeviceWaitMs: number;
+  firecrackerEntropyDevice: boolean;
+  firecrackerCgroups?: {
+    parentCgroup: string;
+    memoryOverheadMb: number;
+    pinVcpus: boolean;
+  };
+  guestZramPercent: number;
+  defaultIoTier: VmIoTier;
+  guestHugePages: boolean;
+  hugePagesPoolMb: number;
+  vmLogRotation: {
+    maxFileBytes: number;
+    maxFiles: number;
+    compress: boolean;
+    bytesPerSec: number;
+  };
   snapshotTemplateCpu: number;
   snapshotTemplateMemMb: number;
+  seedSnapshots: {
+    diskBudgetBytes: number;
+    minRequests: number;
+    maxConcurrentBuilds: number;
+  };
   warmPool: {
     enabled: boolean;
     target: number;
     maxVms: number;
+    recycle: boolean;
   };
   limits: {
     maxVms: number;
@@ -38,6 +70,8 @@ export interface EnvConfig {
     maxAllowIps: number;
     maxExecTimeoutMs: number;
     maxRunTsTimeoutMs: number;
+    maxWorkspaceDiskMb: number;
+    maxFanoutConcurrency: number;
   };
   vsock: {
     retryAttempts: number;
@@ -137,7 +171,54 @@ export function loadEnv(): EnvConfig {
 
   // Overlay mode is always enabled; this controls only the writable overlay disk size.
   const overlaySizeBytes = parsePositiveInt(process.env.OVERLAY_SIZE_BYTES, "OVERLAY_SIZE_BYTES", 512 * 1024 * 1024);
+  const overlayPoolDepth = parseNonNegativeInt(process.env.OVERLAY_POOL_DEPTH, "OVERLAY_POOL_DEPTH", 2);
+  const storageBackendRaw = (process.env.STORAGE_BACKEND ?? "file").toLowerCase();
+  if (storageBackendRaw !== "file" && storageBackendRaw !== "thin") {
+    throw new Error("STORAGE_BACKEND must be one of: file, thin");
+  }
+  const thinPoolSizeGb = parsePositiveInt(process.env.THIN_POOL_SIZE_GB, "THIN_POOL_SIZE_GB", 100);
+  const thinPoolName = (process.env.THIN_POOL_NAME ?? "rds-thin").trim();
+  if (!/^[A-Za-z0-9_.-]+$/.test(thinPoolName)) {
+    throw new Error("THIN_POOL_NAME may only contain letters, digits, '.', '_' and '-'");
+  }
   const overlayDeviceWaitMs = parsePositiveInt(process.env.OVERLAY_DEVICE_WAIT_MS, "OVERLAY_DEVICE_WAIT_MS", 200);
+  const firecrackerEntropyDevice = (process.env.FIRECRACKER_ENTROPY_DEVICE ?? "true").toLowerCase() !== "false";
+  const guestZramPercent = parseNonNegativeInt(process.env.GUEST_ZRAM_PERCENT, "GUEST_ZRAM_PERCENT", 50);
+  if (guestZramPercent > 200) {
+    throw new Error("GUEST_ZRAM_PERCENT must be at most 200");
+  }
+
+  // Per-VM cgroup v2 placement via the jailer (requires a cgroup v2 host with cpuset/cpu/memory delegated).
+  const firecrackerCgroupsEnabled = (process.env.FIRECRACKER_CGROUPS ?? "false").toLowerCase() === "true";
+  const firecrackerParentCgroup = (process.env.FIRECRACKER_PARENT_CGROUP ?? "rundatsheesh").trim();
+  if (
+    !/^[A-Za-z0-9._-]+(?:\/[A-Za-z0-9._-]+)*$/.test(firecrackerParentCgroup) ||
+    firecrackerParentCgroup.split("/").some((part) => part === "." || part === "..")
+  ) {
+    throw new Error("FIRECRACKER_PARENT_CGROUP must be a relative cgroup path (e.g. rundatsheesh or machine/vms)");
+  }
+  const firecrackerMemoryOverheadMb = parseNonNegativeInt(
+    process.env.FIRECRACKER_MEMORY_OVERHEAD_MB,
+    "FIRECRACKER_MEMORY_OVERHEAD_MB",
+    128
+  );
+  const firecrackerPinVcpus = (process.env.FIRECRACKER_PIN_VCPUS ?? "false").toLowerCase() === "true";
+
+  const defaultIoTierRaw = (process.env.DEFAULT_IO_TIER ?? "unlimited").trim().toLowerCase();
+  const defaultIoTier = IO_TIERS.includes(defaultIoTierRaw as VmIoTier) ? (defaultIoTierRaw as VmIoTier) : null;
+  if (!defaultIoTier) {
+    throw new Error(`DEFAULT_IO_TIER must be one of: ${IO_TIERS.join(", ")}`);
+  }
+
+  // Hugepage-backed guest memory: per-VM default, and the host 2 MiB pool to provision at startup.
+  const guestHugePages = (process.env.GUEST_HUGE_PAGES ?? "false").toLowerCase() === "true";
+  const hugePagesPoolMb = parseNonNegativeInt(process.env.HUGEPAGES_POOL_MB, "HUGEPAGES_POOL_MB", 0);
+
+  // VM stdout/stderr (serial console) logs: live file size, rotated segments kept, write budget.
+  const vmLogMaxFileMb = parsePositiveInt(process.env.VM_LOG_MAX_FILE_MB, "VM_LOG_MAX_FILE_MB", 8);
+  const vmLogMaxFiles = parseNonNegativeInt(process.env.VM_LOG_MAX_FILES, "VM_LOG_MAX_FILES", 3);
+  const vmLogCompress = (process.env.VM_LOG_COMPRESS ?? "true").toLowerCase() === "true";
+  const vmLogRateKbps = parseNonNegativeInt(process.env.VM_LOG_RATE_KBPS, "VM_LOG_RATE_KBPS", 1024);
 
   const firecrackerLogLevelRaw = (process.env.FIRECRACKER_LOG_LEVEL ?? "Warning").trim();
   const firecrackerLogLevel = (["Error", "Warning", "Info", "Debug"] as const).includes(firecrackerLogLevelRaw as any)
@@ -159,6 +240,15 @@ export function loadEnv(): EnvConfig {
     throw new Error("SNAPSHOT_TEMPLATE_MEM_MB must be a positive number");
   }
 
+  // Seed snapshots per (image, cpu, memMb) class; 0 MB budget means "never evict".
+  const seedSnapshotDiskBudgetMb = parseNonNegativeInt(process.env.SEED_SNAPSHOT_DISK_BUDGET_MB, "SEED_SNAPSHOT_DISK_BUDGET_MB", 0);
+  const seedSnapshotMinRequests = parsePositiveInt(process.env.SEED_SNAPSHOT_MIN_REQUESTS, "SEED_SNAPSHOT_MIN_REQUESTS", 2);
+  const seedSnapshotMaxConcurrentBuilds = parsePositiveInt(
+    process.env.SEED_SNAPSHOT_MAX_CONCURRENT_BUILDS,
+    "SEED_SNAPSHOT_MAX_CONCURRENT_BUILDS",
+    1
+  );
+
   const dnsServerIpRaw = (process.env.DNS_SERVER_IP ?? "").trim();
   const dnsServerIp = dnsServerIpRaw ? dnsServerIpRaw : undefined;
   if (dnsServerIp && !/^(?:\d{1,3}\.){3}\d{1,3}$/.test(dnsServerIp)) {
@@ -193,14 +283,37 @@ export function loadEnv(): EnvConfig {
     },
     rootfsCloneMode,
     overlaySizeBytes,
+    overlayPoolDepth,
+    storageBackend: storageBackendRaw,
+    thinPool: { name: thinPoolName, dataSizeBytes: thinPoolSizeGb * 1024 * 1024 * 1024 },
     firecrackerLogLevel,
     overlayDeviceWaitMs,
+    firecrackerEntropyDevice,
+    firecrackerCgroups: firecrackerCgroupsEnabled
+      ? { parentCgroup: firecrackerParentCgroup, memoryOverheadMb: firecrackerMemoryOverheadMb, pinVcpus: firecrackerPinVcpus }
+      : undefined,
+    guestZramPercent,
+    defaultIoTier,
+    guestHugePages,
+    hugePagesPoolMb,
+    vmLogRotation: {
+      maxFileBytes: vmLogMaxFileMb * 1024 * 1024,
+      maxFiles: vmLogMaxFiles,
+      compress: vmLogCompress,
+      bytesPerSec: vmLogRateKbps * 1024
+    },
     snapshotTemplateCpu,
     snapshotTemplateMemMb,
+    seedSnapshots: {
+      diskBudgetBytes: seedSnapshotDiskBudgetMb * 1024 * 1024,
+      minRequests: seedSnapshotMinRequests,
+      maxConcurrentBuilds: seedSnapshotMaxConcurrentBuilds
+    },
     warmPool: {
       enabled: warmPoolEnabled,
       target: warmPoolEnabled ? warmPoolTarget : 0,
-      maxVms: warmPoolMaxVms
+      maxVms: warmPoolMaxVms,
+      recycle: warmPoolEnabled && (process.env.WARM_POOL_RECYCLE ?? "false").toLowerCase() === "true"
     },
     limits: {
       maxVms: parsePositiveInt(process.env.MAX_VMS, "MAX_VMS", 20),
@@ -208,7 +321,9 @@ export function loadEnv(): EnvConfig {
       maxMemMb: parsePositiveInt(process.env.MAX_MEM_MB, "MAX_MEM_MB", 2048),
       maxAllowIps: parsePositiveInt(process.env.MAX_ALLOW_IPS, "MAX_ALLOW_IPS", 64),
       maxExecTimeoutMs: parsePositiveInt(process.env.MAX_EXEC_TIMEOUT_MS, "MAX_EXEC_TIMEOUT_MS", 120_000),
-      maxRunTsTimeoutMs: parsePositiveInt(process.env.MAX_RUNTS_TIMEOUT_MS, "MAX_RUNTS_TIMEOUT_MS", 120_000)
+      maxRunTsTimeoutMs: parsePositiveInt(process.env.MAX_RUNTS_TIMEOUT_MS, "MAX_RUNTS_TIMEOUT_MS", 120_000),
+      maxWorkspaceDiskMb: parsePositiveInt(process.env.MAX_WORKSPACE_DISK_MB, "MAX_WORKSPACE_DISK_MB", 10_240),
+      maxFanoutConcurrency: parsePositiveInt(process.env.MAX_FANOUT_CONCURRENCY, "MAX_FANOUT_CONCURRENCY", 16)
     },
     vsock: {
       retryAttempts: parsePositiveInt(process.env.VSOCK_RETRY_ATTEMPTS, "VSOCK_RETRY_ATTEMPTS", 150),
@@ -28,6 +28,7 @@ export function createDb(input: { dialect: DbDialect; sqlitePath: string; databa
       activityEvents: sqliteSchema.activityEvents,
       apiKeys: sqliteSchema.apiKeys,
       webhooks: sqliteSchema.webhooks,
+      snapshots: sqliteSchema.snapshots,
       close: async () => {
         sqlite.close();
       }
@@ -47,6 +48,7 @@ export function createDb(input: { dialect: DbDialect; sqlitePath: string; databa
     activityEvents: pgSchema.activityEvents,
     apiKeys: pgSchema.apiKeys,
     webhooks: pgSchema.webhooks,
+    snapshots: pgSchema.snapshots,
     close: async () => {
       await pool.end();
     }
@@ -14,6 +14,11 @@ export const vms = pgTable("vms", {
   imageId: text("image_id"),
   rootfsPath: text("rootfs_path").notNull(),
   overlayPath: text("overlay_path"),
+  workspaceDiskPath: text("workspace_disk_path"),
+  workspaceDiskMb: integer("workspace_disk_mb"),
+  ioTier: text("io_tier"),
+  hugePages: boolean("huge_pages"),
+  memoryPageSizeKb: integer("memory_page_size_kb"),
   kernelPath: text("kernel_path").notNull(),
   logsDir: text("logs_dir").notNull(),
   createdAt: text("created_at").notNull(),
@@ -41,6 +46,8 @@ export const guestImages = pgTable("guest_images", {
   baseRootfsBytes: integer("base_rootfs_bytes"),
   kernelUploadedAt: text("kernel_uploaded_at"),
   rootfsUploadedAt: text("rootfs_uploaded_at"),
+  kernelSha256: text("kernel_sha256"),
+  rootfsSha256: text("rootfs_sha256"),
   seedSnapshotId: text("seed_snapshot_id"),
   seedStatus: text("seed_status"),
   seedUpdatedAt: text("seed_updated_at"),
@@ -82,3 +89,16 @@ export const webhooks = pgTable("webhooks", {
   eventTypesJson: text("event_types_json").notNull(),
   createdAt: text("created_at").notNull()
 });
+
+// Snapshot catalog: artifacts live under STORAGE_ROOT/snapshots/<id>; this row mirrors meta.json
+// so listings and counts never scan the directory.
+export const snapshots = pgTable("snapshots", {
+  id: text("id").primaryKey(),
+  kind: text("kind").notNull(),
+  imageId: text("image_id"),
+  sourceVmId: text("source_vm_id"),
+  internal: boolean("internal").notNull(),
+  createdAt: text("created_at").notNull(),
+  // Full SnapshotMeta as JSON; the columns above are the indexed projection of it.
+  metaJson: text("meta_json").notNull()
+});
@@ -0,0 +1,35 @@
+import { describe, expect, it } from "vitest";
+import { summarizeIoMetrics } from "../fcMetrics.js";
+
+describe("summarizeIoMetrics", () => {
+  it("sums per-drive and net deltas across flushes", () => {
+    const text = [
+      JSON.stringify({
+        block: { read_bytes: 300, write_bytes: 30 },
+        block_rootfs: { read_bytes: 100, read_count: 1, rate_limiter_throttled_events: 0 },
+        block_overlay: { read_bytes: 200, write_bytes: 30, write_count: 3, rate_limiter_throttled_events: 2 },
+        net: { rx_bytes_count: 1000, tx_bytes_count: 10, rx_rate_limiter_throttled: 1 }
+      }),
+      JSON.stringify({
+        block_overlay: { write_bytes: 70, write_count: 7, rate_limiter_throttled_events: 5 },
+        net: { rx_bytes_count: 500, tx_rate_limiter_throttled: 4 }
+      }),
+      '{"block_overlay": {"write_by'
+    ].join("\n");
+
+    expect(summarizeIoMetrics(text)).toEqual({
+      drives: {
+        rootfs: { readBytes: 100, writeBytes: 0, readOps: 1, writeOps: 0, throttledEvents: 0 },
+        overlay: { readBytes: 200, writeBytes: 100, readOps: 0, writeOps: 10, throttledEvents: 7 }
+      },
+      net: { rxBytes: 1500, txBytes: 10, rxThrottled: 1, txThrottled: 4 }
+    });
+  });
+
+  it("falls back to the aggregated block counters", () => {
+    const text = JSON.stringify({ block: { read_bytes: 5, rate_limiter_throttled_events: 1 } });
+    expect(summarizeIoMetrics(text).drives).toEqual({
+      all: { readBytes: 5, writeBytes: 0, readOps: 0, writeOps: 0, throttledEvents: 1 }
+    });
+  });
+});
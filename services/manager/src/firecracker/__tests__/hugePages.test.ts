@@ -0,0 +1,45 @@
+import { mkdtempSync, writeFileSync } from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { describe, expect, it } from "vitest";
+import { HugePagePool, availableHugePages } from "../hugePages.js";
+
+function fakeSysfs(counters: { total: number; free: number; reserved: number }): string {
+  const dir = mkdtempSync(path.join(os.tmpdir(), "hugepages-"));
+  writeFileSync(path.join(dir, "nr_hugepages"), `${counters.total}\n`);
+  writeFileSync(path.join(dir, "free_hugepages"), `${counters.free}\n`);
+  writeFileSync(path.join(dir, "resv_hugepages"), `${counters.reserved}\n`);
+  return dir;
+}
+
+describe("availableHugePages", () => {
+  it("is bounded by our own holdings and by other hugetlb users", () => {
+    // 100 pages, 20 used by another process, 30 held by a VM that has not faulted them in.
+    expect(availableHugePages({ total: 100, free: 80, reserved: 0 }, 30, 0)).toBe(70);
+    // A VM still starting is invisible to the kernel.
+    expect(availableHugePages({ total: 100, free: 100, reserved: 0 }, 30, 30)).toBe(70);
+    expect(availableHugePages({ total: 100, free: 10, reserved: 20 }, 0, 0)).toBe(0);
+  });
+});
+
+describe("HugePagePool", () => {
+  it("falls back once the pool is exhausted and frees pages on release", () => {
+    const pool = new HugePagePool(fakeSysfs({ total: 512, free: 512, reserved: 0 }));
+    expect(pool.tryReserve("a", 512)).toBe(true);
+    expect(pool.tryReserve("b", 512)).toBe(true);
+    expect(pool.tryReserve("c", 2)).toBe(false);
+    expect(pool.usage()).toMatchObject({ availablePages: 0, vms: { a: 256, b: 256 }, fallbacks: 1 });
+
+    pool.settle("a");
+    pool.release("b");
+    expect(pool.tryReserve("c", 256)).toBe(true);
+    pool.rename("c", "d");
+    expect(pool.holds("d")).toBe(true);
+    expect(pool.usage().vms).toEqual({ a: 256, d: 128 });
+  });
+
+  it("rejects odd sizes and hosts without hugetlb", () => {
+    expect(new HugePagePool(fakeSysfs({ total: 512, free: 512, reserved: 0 })).tryReserve("a", 257)).toBe(false);
+    expect(new HugePagePool(path.join(os.tmpdir(), "no-such-hugepages")).tryReserve("a", 256)).toBe(false);
+  });
+});
@@ -0,0 +1,104 @@
+import { mkdtempSync, readFileSync, readdirSync, writeFileSync } from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { PassThrough, Readable } from "node:stream";
+import { finished, pipeline } from "node:stream/promises";
+import { gunzipSync } from "node:zlib";
+import { describe, expect, it } from "vitest";
+import { RotatingLogSink, readLogTail } from "../logCollector.js";
+
+function tmpLog(name: string): string {
+  return path.join(mkdtempSync(path.join(os.tmpdir(), "vm-logs-")), name);
+}
+
+describe("RotatingLogSink", () => {
+  it("rotates by size, compresses old segments and keeps a bounded ring", async () => {
+    const logPath = tmpLog("firecracker.stdout.log");
+    const sink = new RotatingLogSink(logPath, { maxFileBytes: 300, maxFiles: 3, compress: true, bytesPerSec: 0 });
+    const lines = Array.from({ length: 200 }, (_, i) => Buffer.from(`line ${i}\n`));
+    await pipeline(Readable.from(lines), sink);
+
+    expect(readdirSync(path.dirname(logPath)).sort()).toEqual([
+      "firecracker.stdout.log",
+      "firecracker.stdout.log.1",
+      "firecracker.stdout.log.2.gz",
+      "firecracker.stdout.log.3.gz"
+    ]);
+    expect(sink.recentText().endsWith("line 198\nline 199\n")).toBe(true);
+    // Compressed in the background, but complete once the stream has finished.
+    const older = gunzipSync(readFileSync(`${logPath}.2.gz`)).toString("utf-8");
+    expect(older.startsWith("line ")).toBe(true);
+    expect(older.endsWith("\n")).toBe(true);
+
+    // The tail spans the live file and the plain `.1` segment.
+    const tail = await readLogTail(logPath, 100_000);
+    expect(tail?.truncated).toBe(true);
+    const tailLines = tail!.text.trimEnd().split("\n");
+    expect(tailLines[tailLines.length - 1]).toBe("line 199");
+    expect(readFileSync(`${logPath}.1`, "utf-8").length).toBeLessThanOrEqual(300);
+    expect(tailLines.length).toBeGreaterThan(readFileSync(logPath, "utf-8").trimEnd().split("\n").length);
+  });
+
+  it("drops output over the byte budget and records how much", async () => {
+    const logPath = tmpLog("firecracker.stderr.log");
+    const sink = new RotatingLogSink(logPath, { maxFileBytes: 1_000_000, maxFiles: 1, compress: false, bytesPerSec: 10 });
+    await pipeline(Readable.from([Buffer.alloc(30, "a"), Buffer.alloc(30, "b"), Buffer.from("x\n")]), sink);
+
+    expect(readFileSync(logPath, "utf-8")).toBe(
+      `${"a".repeat(30)}\n[log-collector] dropped 30 bytes over the 10 B/s budget\nx\n`
+    );
+  });
+
+  it("removes the live file and every segment on reset, then starts a fresh file", async () => {
+    const logPath = tmpLog("firecracker.stdout.log");
+    const sink = new RotatingLogSink(logPath, { maxFileBytes: 100, maxFiles: 3, compress: true, bytesPerSec: 0 });
+    const source = new PassThrough();
+    source.pipe(sink);
+    for (let i = 0; i < 40; i += 1) source.write(`tenant-a ${i}\n`);
+    await new Promise((resolve) => setTimeout(resolve, 50));
+    expect(readdirSync(path.dirname(logPath)).length).toBe(4);
+
+    await sink.reset();
+    expect(readdirSync(path.dirname(logPath))).toEqual([]);
+    expect(sink.recentText()).toBe("");
+
+    source.end("tenant-b\n");
+    await finished(sink);
+    expect(readFileSync(logPath, "utf-8")).toBe("tenant-b\n");
+  });
+});
+
+describe("readLogTail", () => {
+  it("returns null for missing logs", async () => {
+    expect(await readLogTail(tmpLog("missing.log"), 1024)).toBeNull();
+  });
+
+  it("reports a partial first line only when the read starts mid-line", async () => {
+    const logPath = tmpLog("firecracker.stdout.log");
+    writeFileSync(logPath, "first\nsecond\n");
+    expect(await readLogTail(logPath, 1024)).toMatchObject({ text: "first\nsecond\n", truncated: false, startsMidLine: false });
+    expect(await readLogTail(logPath, 7)).toMatchObject({ text: "second\n", truncated: true, startsMidLine: false });
+    expect(await readLogTail(logPath, 4)).toMatchObject({ text: "ond\n", truncated: true, startsMidLine: true });
+  });
+
+  it("looks at the previous segment to tell whether the live file starts mid-line", async () => {
+    const logPath = tmpLog("firecracker.stdout.log");
+    writeFileSync(logPath, "new\n");
+    writeFileSync(`${logPath}.1`, "old\n");
+    expect(await readLogTail(logPath, 4)).toMatchObject({ text: "new\n", truncated: true, startsMidLine: false });
+
+    // Rotation happens between writes, not lines.
+    writeFileSync(logPath, "ne\n");
+    writeFileSync(`${logPath}.1`, "old\nli");
+    expect(await readLogTail(logPath, 3)).toMatchObject({ text: "ne\n", truncated: true, startsMidLine: true });
+    expect(await readLogTail(logPath, 5)).toMatchObject({ text: "line\n", truncated: true, startsMidLine: false });
+  });
+
+  it("ignores the previous segment when the live file alone exceeds the tail", async () => {
+    const logPath = tmpLog("firecracker.stdout.log");
+    writeFileSync(logPath, "aaaa\nbbbb\n");
+    writeFileSync(`${logPath}.1`, "old\n");
+    expect(await readLogTail(logPath, 4)).toMatchObject({ text: "bbb\n", truncated: true, startsMidLine: true });
+    expect(await readLogTail(logPath, 5)).toMatchObject({ text: "bbbb\n", truncated: true, startsMidLine: false });
+  });
+});
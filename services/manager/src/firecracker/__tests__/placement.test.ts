@@ -0,0 +1,48 @@
+import { describe, expect, it } from "vitest";
+import { PlacementScheduler, formatCpuList, parseCpuList } from "../placement.js";
+
+const twoSockets = [
+  { id: 0, cpus: [0, 1, 2, 3] },
+  { id: 1, cpus: [4, 5, 6, 7] }
+];
+
+describe("cpulist helpers", () => {
+  it("round-trips kernel cpulists", () => {
+    expect(parseCpuList("0-3,8,10-11\n")).toEqual([0, 1, 2, 3, 8, 10, 11]);
+    expect(formatCpuList([11, 0, 1, 2, 3, 8, 10])).toBe("0-3,8,10-11");
+  });
+});
+
+describe("PlacementScheduler", () => {
+  it("spreads VMs across NUMA nodes by committed vCPUs", () => {
+    const scheduler = new PlacementScheduler(twoSockets);
+    const a = scheduler.place("a", 2);
+    const b = scheduler.place("b", 1);
+    const c = scheduler.place("c", 1);
+
+    expect(a).toEqual({ node: 0, cpuset: [0, 1, 2, 3], mems: [0], vcpuCpus: [0, 1] });
+    expect(b).toMatchObject({ node: 1, vcpuCpus: [4] });
+    // Node 1 has 1/4 committed vs 2/4 on node 0.
+    expect(c).toMatchObject({ node: 1, vcpuCpus: [5] });
+  });
+
+  it("frees CPUs on release and spans nodes for oversized VMs", () => {
+    const scheduler = new PlacementScheduler(twoSockets);
+    scheduler.place("a", 4);
+    scheduler.release("a");
+    expect(scheduler.place("b", 2)).toMatchObject({ node: 0, vcpuCpus: [0, 1] });
+
+    const wide = scheduler.place("wide", 6);
+    expect(wide.node).toBeNull();
+    expect(wide.mems).toEqual([0, 1]);
+    expect(wide.vcpuCpus).toEqual([2, 3, 4, 5, 6, 7]);
+  });
+
+  it("charges restored placements so new VMs avoid the CPUs adopted VMs run on", () => {
+    const before = new PlacementScheduler(twoSockets).place("adopted", 2);
+    const scheduler = new PlacementScheduler(twoSockets);
+    scheduler.restore("adopted", before);
+    expect(scheduler.get("adopted")).toEqual(before);
+    expect(scheduler.place("new", 2)).toMatchObject({ node: 1, vcpuCpus: [4, 5] });
+  });
+});
@@ -0,0 +1,67 @@
+import { spawn } from "node:child_process";
+import { closeSync, mkdirSync, mkdtempSync, writeFileSync } from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { describe, expect, it } from "vitest";
+import {
+  createConsoleFifo,
+  identifyVmm,
+  isVmmAlive,
+  openConsoleFifo,
+  readProcStat,
+  readVmmRecord,
+  signalVmm,
+  waitForVmmExit,
+  writeVmmRecord
+} from "../vmmProcess.js";
+
+describe("readProcStat", () => {
+  it("finds state and start time after a command name containing spaces and parentheses", async () => {
+    const procRoot = mkdtempSync(path.join(os.tmpdir(), "proc-"));
+    mkdirSync(path.join(procRoot, "42"));
+    const after = ["S", "1", "42", "42", "0", "-1", "4194560", "0", "0", "0", "0", "0", "0", "0", "0", "20", "0", "1", "0", "987654"];
+    writeFileSync(path.join(procRoot, "42", "stat"), `42 (fc_vcpu (0) x) ${after.join(" ")} 1000 200\n`);
+    expect(await readProcStat(42, procRoot)).toEqual({ state: "S", startTime: "987654" });
+    expect(await readProcStat(43, procRoot)).toBeNull();
+  });
+});
+
+describe("VMM process identity", () => {
+  it("tracks a detached process by pid and start time and sees it exit", async () => {
+    const child = spawn("sleep", ["30"], { detached: true, stdio: "ignore" });
+    child.unref();
+    const identity = await identifyVmm(child.pid!);
+    expect(identity).not.toBeNull();
+    expect(await isVmmAlive(identity!)).toBe(true);
+    // Same pid, different start time: a recycled pid must never count as the VM.
+    expect(await isVmmAlive({ pid: identity!.pid, startTime: "1" })).toBe(false);
+
+    expect(signalVmm(identity!, "SIGTERM")).toBe(true);
+    expect(await waitForVmmExit(identity!, 5_000)).toBe(true);
+    expect(signalVmm(identity!, "SIGTERM")).toBe(false);
+  });
+
+  it("round-trips the record kept next to the jail root", async () => {
+    const dir = mkdtempSync(path.join(os.tmpdir(), "vmm-record-"));
+    expect(await readVmmRecord(dir)).toBeNull();
+    const record = { pid: 1234, startTime: "5678", cgroupDir: "/sys/fs/cgroup/fc/vm-1", hugePages: true };
+    await writeVmmRecord(dir, record);
+    expect(await readVmmRecord(dir)).toEqual(record);
+  });
+});
+
+describe("console FIFOs", () => {
+  it("keeps a writer's output buffered until a reader attaches", async () => {
+    const fifo = path.join(mkdtempSync(path.join(os.tmpdir(), "vmm-fifo-")), "stdout.fifo");
+    const fd = await createConsoleFifo(fifo);
+    spawn("sh", ["-c", "echo before; sleep 0.2; echo after"], { stdio: ["ignore", fd, "ignore"] });
+    closeSync(fd);
+    // Attach late, as a restarted manager would.
+    await new Promise((resolve) => setTimeout(resolve, 100));
+    const reader = await openConsoleFifo(fifo);
+    let text = "";
+    reader!.on("data", (chunk) => (text += String(chunk)));
+    await new Promise((resolve) => reader!.once("end", resolve));
+    expect(text).toBe("before\nafter\n");
+  });
+});
@@ -0,0 +1,58 @@
+import type { VmIoDeviceStats, VmIoStats } from "../types/vm.js";
+
+type MetricsLine = Record<string, Record<string, unknown> | undefined>;
+
+/**
+ * Sum the block/net counters in a Firecracker metrics file. Firecracker appends one JSON object per
+ * flush and its counters are deltas since the previous flush, so totals are the sum of all lines.
+ * Newer builds report each drive as `block_<drive_id>` next to the aggregated `block`; older ones
+ * only have the aggregate, which is returned as drive `all`.
+ */
+export function summarizeIoMetrics(text: string): Omit<VmIoStats, "tier"> {
+  const perDrive: Record<string, VmIoDeviceStats> = {};
+  const aggregate = emptyDevice();
+  const net = { rxBytes: 0, txBytes: 0, rxThrottled: 0, txThrottled: 0 };
+
+  // Firecracker does not open the file O_APPEND, so after a truncation its next write leaves a run of NULs.
+  for (const line of text.replace(/\0+/g, "").split("\n")) {
+    if (!line.trim()) continue;
+    let parsed: MetricsLine;
+    try {
+      parsed = JSON.parse(line) as MetricsLine;
+    } catch {
+      // A line may be cut short while Firecracker is writing it.
+      continue;
+    }
+    for (const [key, value] of Object.entries(parsed)) {
+      if (!value || typeof value !== "object") continue;
+      if (key === "block") {
+        addDevice(aggregate, value);
+      } else if (key.startsWith("block_")) {
+        addDevice((perDrive[key.slice("block_".length)] ??= emptyDevice()), value);
+      } else if (key === "net") {
+        net.rxBytes += num(value.rx_bytes_count);
+        net.txBytes += num(value.tx_bytes_count);
+        net.rxThrottled += num(value.rx_rate_limiter_throttled);
+        net.txThrottled += num(value.tx_rate_limiter_throttled);
+      }
+    }
+  }
+
+  return { drives: Object.keys(perDrive).length ? perDrive : { all: aggregate }, net };
+}
+
+function emptyDevice(): VmIoDeviceStats {
+  return { readBytes: 0, writeBytes: 0, readOps: 0, writeOps: 0, throttledEvents: 0 };
+}
+
+function addDevice(target: VmIoDeviceStats, m: Record<string, unknown>): void {
+  target.readBytes += num(m.read_bytes);
+  target.writeBytes += num(m.write_bytes);
+  target.readOps += num(m.read_count);
+  target.writeOps += num(m.write_count);
+  target.throttledEvents += num(m.rate_limiter_throttled_events);
+}
+
+function num(value: unknown): number {
+  return typeof value === "number" && Number.isFinite(value) ? value : 0;
+}
@@ -1,18 +1,39 @@
 import fs from "node:fs/promises";
-import { createWriteStream } from "node:fs";
+import { closeSync } from "node:fs";
 import http from "node:http";
 import net from "node:net";
 import path from "node:path";
-import { spawn } from "node:child_process";
+import { spawn, type ChildProcess } from "node:child_process";
 import type { FirecrackerManager } from "../types/interfaces.js";
-import type { VmRecord } from "../types/vm.js";
+import type { HugePageUsage, VmIoStats, VmIoTier, VmRecord } from "../types/vm.js";
+import { copySparse } from "../utils/sparseFile.js";
+import { summarizeIoMetrics } from "./fcMetrics.js";
+import { HUGE_PAGE_MB, HugePagePool } from "./hugePages.js";
+import { RotatingLogSink, type LogRotationOptions } from "./logCollector.js";
+import { ioLimitsForTier, patchRateLimiter } from "./ioTiers.js";
+import { PlacementScheduler, formatCpuList, readHostTopology } from "./placement.js";
 import {
   firecrackerApiSocketPath,
   firecrackerVsockUdsPath,
   inChrootPathForHostPath,
+  jailerExecDir,
   jailerRootDir,
-  jailerVmDir
+  jailerVmDir,
+  rebaseVmPath
 } from "./socketPaths.js";
+import {
+  CONSOLE_FIFO_FILES,
+  VMM_RECORD_FILE,
+  createConsoleFifo,
+  identifyVmm,
+  isVmmAlive,
+  openConsoleFifo,
+  readVmmRecord,
+  signalVmm,
+  waitForVmmExit,
+  writeVmmRecord,
+  type VmmRecord
+} from "./vmmProcess.js";
 
 export interface FirecrackerOptions {
   firecrackerBin: string;
@@ -22,14 +43,87 @@ export interface FirecrackerOptions {
   jailerGid: number;
   logLevel?: "Error" | "Warning" | "Info" | "Debug";
   overlayDeviceWaitMs?: number;
+  /** Attach a virtio-rng device (Firecracker >= 1.4) so the guest CRNG is ready at boot. Default true. */
+  entropyDevice?: boolean;
+  /** Guest zram swap size as a percentage of VM memory (uncompressed capacity); 0 disables. Default 0. */
+  zramPercent?: number;
+  /**
+   * Run each VM in its own cgroup v2 (created by the jailer under `parentCgroup`) with cpu.max,
+   * memory.max and a NUMA-local cpuset chosen by the placement scheduler.
+   */
+  cgroups?: {
+    parentCgroup: string;
+    /** Added to guest memory for memory.max (VMM, device buffers, page cache for disk I/O). */
+    memoryOverheadMb: number;
+    /** Pin each vCPU thread to the host CPU the scheduler assigned it. */
+    pinVcpus: boolean;
+  };
+  /** Size cap, rotation and byte budget for each VM's stdout/stderr logs (serial console). */
+  logRotation?: LogRotationOptions;
+  /** Grow the host 2 MiB hugepage pool to this size at startup (0 leaves the pool as provisioned). */
+  hugePagesPoolMb?: number;
 }
 
-export class FirecrackerManagerImpl implements FirecrackerManager {
-  private readonly processes = new Map<string, ReturnType<typeof spawn>>();
+const CGROUP_V2_ROOT = "/sys/fs/cgroup";
+const CPU_PERIOD_US = 100_000;
+// Quota on top of the vCPUs for the VMM thread and virtio I/O workers.
+const VMM_CPU_SHARE = 0.1;
+// A Firecracker that is alive but does not answer its API this quickly is not adopted.
+const ADOPT_API_TIMEOUT_MS = 2_000;
 
-  constructor(private readonly options: FirecrackerOptions) {}
+export class FirecrackerManagerImpl implements FirecrackerManager {
+  /** Firecracker processes by VM id, whether this manager started them or adopted them after a restart. */
+  private readonly processes = new Map<string, VmmRecord>();
+  private readonly placement: PlacementScheduler | null;
+  /** Jailer-created cgroup per VM; keyed by current id, named after the id the VM was started with. */
+  private readonly cgroupDirs = new Map<string, string>();
+  /** Console log sinks of the VMs whose output this manager is collecting. */
+  private readonly outputs = new Map<string, { stdout: RotatingLogSink; stderr: RotatingLogSink }>();
+  private readonly hugePages = new HugePagePool();
+
+  constructor(private readonly options: FirecrackerOptions) {
+    this.placement = options.cgroups ? new PlacementScheduler(readHostTopology()) : null;
+    if (options.hugePagesPoolMb) {
+      this.hugePages.configure(options.hugePagesPoolMb);
+    }
+  }
 
   async createAndStart(vm: VmRecord, rootfsPath: string, kernelPath: string, tapName: string, overlayPath?: string | null): Promise<void> {
+    await this.releaseOnFailure(vm, () => this.boot(vm, rootfsPath, kernelPath, tapName, overlayPath));
+  }
+
+  async restoreFromSnapshot(
+    vm: VmRecord,
+    rootfsPath: string,
+    kernelPath: string,
+    tapName: string,
+    snapshot: { memPath: string; statePath: string },
+    overlayPath?: string | null
+  ): Promise<void> {
+    await this.releaseOnFailure(vm, () => this.restore(vm, rootfsPath, kernelPath, tapName, snapshot, overlayPath));
+  }
+
+  /**
+   * A start that fails after the CPU slot, hugepages or cgroup were claimed (jailer exits, API
+   * socket never appears, a config call is rejected) goes down the same release path as a killed
+   * VM, so the host resources and a possibly running VMM do not outlive the failed start.
+   */
+  private async releaseOnFailure(vm: VmRecord, start: () => Promise<void>): Promise<void> {
+    try {
+      await start();
+    } catch (err) {
+      await this.terminate(vm.id).catch((cleanupErr) => {
+        // eslint-disable-next-line no-console
+        console.warn("[firecracker] cleanup after failed start failed", {
+          vmId: vm.id,
+          err: String((cleanupErr as any)?.message ?? cleanupErr)
+        });
+      });
+      throw err;
+    }
+  }
+
+  private async boot(vm: VmRecord, rootfsPath: string, kernelPath: string, tapName: string, overlayPath?: string | null): Promise<void> {
     const jailRoot = jailerRootDir(this.options.jailerChrootBaseDir, vm.id);
     const apiSockHost = firecrackerApiSocketPath(this.options.jailerChrootBaseDir, vm.id);
     await fs.rm(apiSockHost, { force: true }).catch(() => undefined);
@@ -51,74 +145,39 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
     const apiSockInChroot = inChrootPathForHostPath(jailRoot, apiSockHost);
     const fcLogInChroot = inChrootPathForHostPath(jailRoot, fcLogPath);
     const fcMetricsInChroot = inChrootPathForHostPath(jailRoot, fcMetricsPath);
-
-    const proc = spawn(
-      this.options.jailerBin,
-      [
-        "--id",
-        vm.id,
-        "--exec-file",
-        this.options.firecrackerBin,
-        "--uid",
-        String(this.options.jailerUid),
-        "--gid",
-        String(this.options.jailerGid),
-        "--chroot-base-dir",
-        this.options.jailerChrootBaseDir,
-        "--",
-        "--api-sock",
-        apiSockInChroot,
-        "--log-path",
-        fcLogInChroot,
-        "--level",
-        this.options.logLevel ?? "Warning",
-        "--show-level",
-        "--show-log-origin",
-        "--metrics-path",
-        fcMetricsInChroot
-      ],
-      {
-        stdio: ["ignore", "pipe", "pipe"]
-      }
-    );
-    this.processes.set(vm.id, proc);
-
-    // Keep a small preview of jailer/firecracker stderr/stdout so failures are diagnosable
-    // even when the API socket never comes up.
-    const stdoutPreview: Buffer[] = [];
-    const stderrPreview: Buffer[] = [];
-    const capPreview = (arr: Buffer[], chunk: Buffer) => {
-      const max = 8 * 1024;
-      const current = arr.reduce((n, b) => n + b.length, 0);
-      if (current >= max) return;
-      arr.push(chunk.subarray(0, Math.min(chunk.length, max - current)));
-    };
-    proc.stdout?.on("data", (c) => capPreview(stdoutPreview, Buffer.from(c)));
-    proc.stderr?.on("data", (c) => capPreview(stderrPreview, Buffer.from(c)));
-
-    // Capture microVM serial output (console=ttyS0) and Firecracker logs for debugging.
-    // This is especially useful when the guest agent fails to come up.
-    try {
-      const stdoutLog = createWriteStream(path.join(vm.logsDir, "firecracker.stdout.log"), { flags: "a" });
-      const stderrLog = createWriteStream(path.join(vm.logsDir, "firecracker.stderr.log"), { flags: "a" });
-      // Never crash the manager on log I/O errors (e.g., permission changes inside the jail root).
-      stdoutLog.on("error", () => undefined);
-      stderrLog.on("error", () => undefined);
-      proc.stdout?.pipe(stdoutLog);
-      proc.stderr?.pipe(stderrLog);
-      proc.on("close", () => {
-        stdoutLog.end();
-        stderrLog.end();
-      });
-    } catch {
-      // Best-effort only; do not fail VM start if logging can't be initialized.
-    }
+    // Claimed before the jailer starts so the cgroup's memory.max can leave hugetlb memory out.
+    const hugePages = vm.hugePages === true && this.reserveHugePages(vm);
+
+    const { proc, output } = await this.spawnJailer(vm, [
+      "--id",
+      vm.id,
+      "--exec-file",
+      this.options.firecrackerBin,
+      "--uid",
+      String(this.options.jailerUid),
+      "--gid",
+      String(this.options.jailerGid),
+      "--chroot-base-dir",
+      this.options.jailerChrootBaseDir,
+      ...this.cgroupArgs(vm),
+      "--",
+      "--api-sock",
+      apiSockInChroot,
+      "--log-path",
+      fcLogInChroot,
+      "--level",
+      this.options.logLevel ?? "Warning",
+      "--show-level",
+      "--show-log-origin",
+      "--metrics-path",
+      fcMetricsInChroot
+    ]);
 
     try {
       await waitForSocket(apiSockHost, 15000);
     } catch (err) {
-      const stderrText = Buffer.concat(stderrPreview).toString("utf-8");
-      const stdoutText = Buffer.concat(stdoutPreview).toString("utf-8");
+      const stderrText = output.stderr.recentText();
+      const stdoutText = output.stdout.recentText();
       throw new Error(
         `Firecracker API socket not ready (vmId=${vm.id}, exitCode=${proc.exitCode ?? "null"}): ${String(
           (err as any)?.message ?? err
@@ -129,7 +188,9 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
     await this.request(apiSockHost, "PUT", "/machine-config", {
       vcpu_count: vm.cpu,
       mem_size_mib: vm.memMb,
-      smt: false
+      smt: false,
+      // Firecracker >= 1.7; fewer TLB misses and page faults for memory-heavy guests.
+      ...(hugePages ? { huge_pages: "2M" } : {})
     });
 
     const kernelInChroot = inChrootPathForHostPath(jailRoot, kernelPath);
@@ -137,11 +198,15 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
 
     // Determine if we're using overlay mode (read-only base + overlay disk)
     const useOverlay = !!overlayPath;
+    // The workspace disk is attached after the overlay, so it is only addressable with one.
+    const workspacePath = useOverlay ? vm.workspaceDiskPath : null;
+    const zramMb = Math.floor((vm.memMb * (this.options.zramPercent ?? 0)) / 100);
+    const io = ioLimitsForTier(vm.ioTier);
 
     await this.request(apiSockHost, "PUT", "/boot-source", {
       kernel_image_path: kernelInChroot,
       // rootfs is attached as the first virtio-blk device (typically /dev/vda)
-      // overlay disk (if present) is attached as /dev/vdb
+      // overlay disk (if present) is attached as /dev/vdb, the workspace disk as /dev/vdc
       boot_args:
         [
           "console=ttyS0,115200",
@@ -157,6 +222,8 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
           "rootwait",
           "init=/sbin/init",
           `rds_overlay_wait_ms=${this.options.overlayDeviceWaitMs ?? 200}`,
+          ...(workspacePath ? ["rds_workspace_dev=/dev/vdc"] : []),
+          ...(zramMb > 0 ? [`rds_zram_mb=${zramMb}`] : []),
           // Bring up guest networking without userspace DHCP/systemd.
           // Format: ip=<client-ip>::<gateway-ip>:<netmask>:<hostname>:<device>:<autoconf>
           `ip=${vm.guestIp}::172.16.0.1:255.255.255.0::eth0:off`
@@ -170,7 +237,8 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
       is_root_device: true,
       // With overlay: base rootfs is read-only (shared across VMs)
       // Without overlay: base rootfs is read-write (legacy mode)
-      is_read_only: useOverlay
+      is_read_only: useOverlay,
+      ...(io ? { rate_limiter: io.rootfs } : {})
     });
 
     // If overlay is enabled, add the overlay disk as a second drive
@@ -180,14 +248,26 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
         drive_id: "overlay",
         path_on_host: overlayInChroot,
         is_root_device: false,
-        is_read_only: false
+        is_read_only: false,
+        ...(io ? { rate_limiter: io.disk } : {})
+      });
+    }
+
+    if (workspacePath) {
+      await this.request(apiSockHost, "PUT", "/drives/workspace", {
+        drive_id: "workspace",
+        path_on_host: inChrootPathForHostPath(jailRoot, workspacePath),
+        is_root_device: false,
+        is_read_only: false,
+        ...(io ? { rate_limiter: io.disk } : {})
       });
     }
 
     await this.request(apiSockHost, "PUT", "/network-interfaces/eth0", {
       iface_id: "eth0",
       host_dev_name: tapName,
-      guest_mac: generateMac(vm.id)
+      guest_mac: generateMac(vm.id),
+      ...(io ? { rx_rate_limiter: io.netRx, tx_rate_limiter: io.netTx } : {})
     });
 
     const vsockUdsHost = firecrackerVsockUdsPath(this.options.jailerChrootBaseDir, vm.id);
@@ -197,12 +277,22 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
       uds_path: vsockUdsInChroot
     });
 
+    if (this.options.entropyDevice !== false) {
+      // Older Firecracker builds reject /entropy; the vsock seed posted once the agent answers still applies there.
+      await this.request(apiSockHost, "PUT", "/entropy", {}).catch((err) => {
+        // eslint-disable-next-line no-console
+        console.warn("[firecracker] entropy device not configured", { vmId: vm.id, err: String((err as any)?.message ?? err) });
+      });
+    }
+
     await this.request(apiSockHost, "PUT", "/actions", {
       action_type: "InstanceStart"
     });
+    this.hugePages.settle(vm.id);
+    await this.pinVcpuThreads(vm);
   }
 
-  async restoreFromSnapshot(
+  private async restore(
     vm: VmRecord,
     rootfsPath: string,
     kernelPath: string,
@@ -227,66 +317,36 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
     const fcLogInChroot = inChrootPathForHostPath(jailRoot, fcLogPath);
     const fcMetricsInChroot = inChrootPathForHostPath(jailRoot, fcMetricsPath);
 
-    const proc = spawn(
-      this.options.jailerBin,
-      [
-        "--id",
-        vm.id,
-        "--exec-file",
-        this.options.firecrackerBin,
-        "--uid",
-        String(this.options.jailerUid),
-        "--gid",
-        String(this.options.jailerGid),
-        "--chroot-base-dir",
-        this.options.jailerChrootBaseDir,
-        "--",
-        "--api-sock",
-        apiSockInChroot,
-        "--log-path",
-        fcLogInChroot,
-        "--level",
-        this.options.logLevel ?? "Warning",
-        "--show-level",
-        "--show-log-origin",
-        "--metrics-path",
-        fcMetricsInChroot
-      ],
-      { stdio: ["ignore", "pipe", "pipe"] }
-    );
-    this.processes.set(vm.id, proc);
-
-    const stdoutPreview: Buffer[] = [];
-    const stderrPreview: Buffer[] = [];
-    const capPreview = (arr: Buffer[], chunk: Buffer) => {
-      const max = 8 * 1024;
-      const current = arr.reduce((n, b) => n + b.length, 0);
-      if (current >= max) return;
-      arr.push(chunk.subarray(0, Math.min(chunk.length, max - current)));
-    };
-    proc.stdout?.on("data", (c) => capPreview(stdoutPreview, Buffer.from(c)));
-    proc.stderr?.on("data", (c) => capPreview(stderrPreview, Buffer.from(c)));
-
-    try {
-      const stdoutLog = createWriteStream(path.join(vm.logsDir, "firecracker.stdout.log"), { flags: "a" });
-      const stderrLog = createWriteStream(path.join(vm.logsDir, "firecracker.stderr.log"), { flags: "a" });
-      stdoutLog.on("error", () => undefined);
-      stderrLog.on("error", () => undefined);
-      proc.stdout?.pipe(stdoutLog);
-      proc.stderr?.pipe(stderrLog);
-      proc.on("close", () => {
-        stdoutLog.end();
-        stderrLog.end();
-      });
-    } catch {
-      // Best-effort only.
-    }
+    const { proc, output } = await this.spawnJailer(vm, [
+      "--id",
+      vm.id,
+      "--exec-file",
+      this.options.firecrackerBin,
+      "--uid",
+      String(this.options.jailerUid),
+      "--gid",
+      String(this.options.jailerGid),
+      "--chroot-base-dir",
+      this.options.jailerChrootBaseDir,
+      ...this.cgroupArgs(vm),
+      "--",
+      "--api-sock",
+      apiSockInChroot,
+      "--log-path",
+      fcLogInChroot,
+      "--level",
+      this.options.logLevel ?? "Warning",
+      "--show-level",
+      "--show-log-origin",
+      "--metrics-path",
+      fcMetricsInChroot
+    ]);
 
     try {
       await waitForSocket(apiSockHost, 15000);
     } catch (err) {
-      const stderrText = Buffer.concat(stderrPreview).toString("utf-8");
-      const stdoutText = Buffer.concat(stdoutPreview).toString("utf-8");
+      const stderrText = output.stderr.recentText();
+      const stdoutText = output.stdout.recentText();
       throw new Error(
         `Firecracker API socket not ready (vmId=${vm.id}, exitCode=${proc.exitCode ?? "null"}): ${String(
           (err as any)?.message ?? err
@@ -311,10 +371,13 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
 
     const rootfsInChroot = inChrootPathForHostPath(jailRoot, rootfsPath);
     const useOverlay = !!overlayPath;
+    // The snapshot carries the source VM's rate limiters; always replace them with this VM's tier.
+    const io = ioLimitsForTier(vm.ioTier);
     await this.request(apiSockHost, "PATCH", "/drives/rootfs", {
       drive_id: "rootfs",
       path_on_host: rootfsInChroot,
-      is_read_only: useOverlay
+      is_read_only: useOverlay,
+      rate_limiter: patchRateLimiter(io?.rootfs)
     });
 
     if (overlayPath) {
@@ -322,14 +385,17 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
       await this.request(apiSockHost, "PATCH", "/drives/overlay", {
         drive_id: "overlay",
         path_on_host: overlayInChroot,
-        is_read_only: false
+        is_read_only: false,
+        rate_limiter: patchRateLimiter(io?.disk)
       });
     }
 
     await this.request(apiSockHost, "PATCH", "/network-interfaces/eth0", {
       iface_id: "eth0",
       host_dev_name: tapName,
-      guest_mac: generateMac(vm.id)
+      guest_mac: generateMac(vm.id),
+      rx_rate_limiter: patchRateLimiter(io?.netRx),
+      tx_rate_limiter: patchRateLimiter(io?.netTx)
     });
 
     const vsockUdsHost = firecrackerVsockUdsPath(this.options.jailerChrootBaseDir, vm.id);
@@ -340,6 +406,7 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
     });
 
     await this.request(apiSockHost, "PATCH", "/vm", { state: "Resumed" });
+    await this.pinVcpuThreads(vm);
   }
 
   async createSnapshot(vm: VmRecord, snapshot: { memPath: string; statePath: string }): Promise<void> {
@@ -365,8 +432,55 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
     await this.request(apiSockHost, "PATCH", "/vm", { state: "Resumed" });
 
     // Copy the snapshot artifacts out of the jail root into the requested storage paths.
+    // Guest memory is mostly zero pages; copy it sparsely so they never hit the disk.
     await fs.copyFile(stateHost, snapshot.statePath);
-    await fs.copyFile(memHost, snapshot.memPath);
+    const mem = await copySparse(memHost, snapshot.memPath);
+    await fs.rm(memHost, { force: true }).catch(() => undefined);
+    // eslint-disable-next-line no-console
+    console.info("[snapshot] memory file", {
+      vmId: vm.id,
+      sizeBytes: mem.sizeBytes,
+      dataBytes: mem.dataBytes,
+      savedBytes: mem.sizeBytes - mem.dataBytes
+    });
+  }
+
+  async updateIoTier(vm: VmRecord, tier: VmIoTier): Promise<void> {
+    const apiSockHost = firecrackerApiSocketPath(this.options.jailerChrootBaseDir, vm.id);
+    const io = ioLimitsForTier(tier);
+    await this.request(apiSockHost, "PATCH", "/drives/rootfs", {
+      drive_id: "rootfs",
+      rate_limiter: patchRateLimiter(io?.rootfs)
+    });
+    const disks = [vm.overlayPath ? "overlay" : null, vm.overlayPath && vm.workspaceDiskPath ? "workspace" : null];
+    for (const driveId of disks) {
+      if (!driveId) continue;
+      await this.request(apiSockHost, "PATCH", `/drives/${driveId}`, {
+        drive_id: driveId,
+        rate_limiter: patchRateLimiter(io?.disk)
+      });
+    }
+    await this.request(apiSockHost, "PATCH", "/network-interfaces/eth0", {
+      iface_id: "eth0",
+      rx_rate_limiter: patchRateLimiter(io?.netRx),
+      tx_rate_limiter: patchRateLimiter(io?.netTx)
+    });
+  }
+
+  async readIoMetrics(vm: VmRecord): Promise<Omit<VmIoStats, "tier">> {
+    const apiSockHost = firecrackerApiSocketPath(this.options.jailerChrootBaseDir, vm.id);
+    // Firecracker only writes metrics periodically; flush so the counters are current.
+    await this.request(apiSockHost, "PUT", "/actions", { action_type: "FlushMetrics" }).catch(() => undefined);
+    const text = await fs.readFile(path.join(vm.logsDir, "firecracker.metrics"), "utf-8").catch(() => "");
+    return summarizeIoMetrics(text);
+  }
+
+  hugePageUsage(): HugePageUsage {
+    return this.hugePages.usage();
+  }
+
+  memoryPageSizeKb(vmId: string): number {
+    return this.hugePages.holds(vmId) ? HUGE_PAGE_MB * 1024 : 4;
   }
 
   async stop(vm: VmRecord): Promise<void> {
@@ -377,42 +491,273 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
     // filesystem data (e.g. integration test power-cycle marker) even if the guest called `sync`.
     const proc = this.processes.get(vm.id);
     if (proc) {
-      const exited = await waitForExit(proc, 15_000).catch(() => false);
+      const exited = await waitForVmmExit(proc, 15_000);
       if (!exited) {
-        const termSent = signalSafe(proc, "SIGTERM");
-        const termExited = await waitForExit(proc, termSent ? 5_000 : 1_000).catch(() => false);
+        const termSent = signalVmm(proc, "SIGTERM");
+        const termExited = await waitForVmmExit(proc, termSent ? 5_000 : 1_000);
         if (!termExited) {
-          signalSafe(proc, "SIGKILL");
-          await waitForExit(proc, 2_000).catch(() => undefined);
+          signalVmm(proc, "SIGKILL");
+          await waitForVmmExit(proc, 2_000);
         }
       }
       this.processes.delete(vm.id);
     }
+    this.outputs.delete(vm.id);
+    this.placement?.release(vm.id);
+    this.hugePages.release(vm.id);
+    await this.removeCgroup(vm.id);
   }
 
   async destroy(vm: VmRecord): Promise<void> {
     const proc = this.processes.get(vm.id);
     if (proc) {
-      const killSafe = (sig: NodeJS.Signals) => {
-        try {
-          proc.kill(sig);
-          return true;
-        } catch {
-          return false;
-        }
-      };
-      killSafe("SIGTERM");
-      const exited = await waitForExit(proc, 3_000).catch(() => false);
+      signalVmm(proc, "SIGTERM");
+      const exited = await waitForVmmExit(proc, 3_000);
       if (!exited) {
-        killSafe("SIGKILL");
-        await waitForExit(proc, 2_000).catch(() => undefined);
+        signalVmm(proc, "SIGKILL");
+        await waitForVmmExit(proc, 2_000);
       }
       this.processes.delete(vm.id);
     }
+    this.outputs.delete(vm.id);
+    this.placement?.release(vm.id);
+    this.hugePages.release(vm.id);
+    await this.removeCgroup(vm.id);
     // Remove the entire jail subtree (sockets, logs, staged snapshots, etc.).
     await fs.rm(jailerVmDir(this.options.jailerChrootBaseDir, vm.id), { recursive: true, force: true });
   }
 
+  async rekey(vm: VmRecord, newId: string): Promise<void> {
+    // Firecracker keeps its open sockets/disks across the rename; path-based lookups
+    // (API socket, vsock UDS) resolve under the new id afterwards.
+    await fs.rename(jailerVmDir(this.options.jailerChrootBaseDir, vm.id), jailerVmDir(this.options.jailerChrootBaseDir, newId));
+    const proc = this.processes.get(vm.id);
+    if (proc) {
+      this.processes.delete(vm.id);
+      this.processes.set(newId, proc);
+    }
+    const output = this.outputs.get(vm.id);
+    if (output) {
+      this.outputs.delete(vm.id);
+      this.outputs.set(newId, output);
+      // The sinks still name files under the old id; later output and resets must use the new one.
+      await Promise.all([
+        output.stdout.retarget(rebaseVmPath(output.stdout.path, vm.id, newId)),
+        output.stderr.retarget(rebaseVmPath(output.stderr.path, vm.id, newId))
+      ]);
+    }
+    // The jailer's cgroup keeps its original name; only the scheduler's bookkeeping moves.
+    this.placement?.rename(vm.id, newId);
+    this.hugePages.rename(vm.id, newId);
+    const cgroupDir = this.cgroupDirs.get(vm.id);
+    if (cgroupDir) {
+      this.cgroupDirs.delete(vm.id);
+      this.cgroupDirs.set(newId, cgroupDir);
+    }
+  }
+
+  /**
+   * Empty a running VM's logs before it serves another tenant: the console sinks drop the live files
+   * and their rotated segments, and Firecracker's own log and metrics files are truncated in place
+   * (it keeps them open, so they cannot be replaced).
+   */
+  async resetLogs(vm: VmRecord): Promise<void> {
+    const output = this.outputs.get(vm.id);
+    if (output) {
+      await Promise.all([output.stdout.reset(), output.stderr.reset()]);
+    }
+    for (const file of ["firecracker.log", "firecracker.metrics"]) {
+      await fs.truncate(path.join(vm.logsDir, file), 0).catch((err) => {
+        if ((err as NodeJS.ErrnoException | undefined)?.code !== "ENOENT") throw err;
+      });
+    }
+  }
+
+  /**
+   * Re-attach to a VM whose Firecracker process outlived the manager that started it. Restores the
+   * process handle, cgroup, CPU placement and hugepage bookkeeping from the jail's VMM record and
+   * reopens the console FIFOs. False when the process is gone or its API does not answer.
+   */
+  async adopt(vm: VmRecord): Promise<boolean> {
+    const record = await readVmmRecord(jailerVmDir(this.options.jailerChrootBaseDir, vm.id));
+    if (!record || !(await isVmmAlive(record))) return false;
+    const apiSockHost = firecrackerApiSocketPath(this.options.jailerChrootBaseDir, vm.id);
+    const answered = await Promise.race([
+      this.request(apiSockHost, "GET", "/").then(
+        () => true,
+        () => false
+      ),
+      new Promise<boolean>((resolve) => setTimeout(() => resolve(false), ADOPT_API_TIMEOUT_MS).unref())
+    ]);
+    if (!answered) return false;
+
+    this.processes.set(vm.id, record);
+    if (record.cgroupDir) this.cgroupDirs.set(vm.id, record.cgroupDir);
+    if (record.placement) this.placement?.restore(vm.id, record.placement);
+    if (record.hugePages) this.hugePages.restore(vm.id, vm.memMb);
+    await this.collectOutput(vm);
+    return true;
+  }
+
+  /** Ids of jails whose Firecracker process is alive, whether or not this manager started it. */
+  async discover(): Promise<string[]> {
+    const ids = await fs.readdir(jailerExecDir(this.options.jailerChrootBaseDir)).catch(() => [] as string[]);
+    const live = await Promise.all(
+      ids.map(async (id) => {
+        const record = await readVmmRecord(jailerVmDir(this.options.jailerChrootBaseDir, id));
+        return record && (await isVmmAlive(record)) ? id : null;
+      })
+    );
+    return live.filter((id): id is string => id !== null);
+  }
+
+  /**
+   * Kill a VM's Firecracker process without a guest shutdown and release its CPU slot, hugepages and
+   * cgroup, for processes a restarted manager cannot adopt and for starts that failed. The jail is
+   * kept (its disks may still be needed) unless `removeJail` is set.
+   */
+  async terminate(vmId: string, options?: { removeJail?: boolean }): Promise<void> {
+    const vmDir = jailerVmDir(this.options.jailerChrootBaseDir, vmId);
+    const record = this.processes.get(vmId) ?? (await readVmmRecord(vmDir));
+    if (record && (await isVmmAlive(record))) {
+      signalVmm(record, "SIGKILL");
+      await waitForVmmExit(record, 2_000);
+    }
+    this.processes.delete(vmId);
+    this.outputs.delete(vmId);
+    this.placement?.release(vmId);
+    this.hugePages.release(vmId);
+    if (record?.cgroupDir && !this.cgroupDirs.has(vmId)) this.cgroupDirs.set(vmId, record.cgroupDir);
+    await this.removeCgroup(vmId);
+    await fs.rm(path.join(vmDir, VMM_RECORD_FILE), { force: true }).catch(() => undefined);
+    if (options?.removeJail) {
+      await fs.rm(vmDir, { recursive: true, force: true });
+    }
+  }
+
+  /**
+   * Start the jailer in its own session and process group, so the VM survives the manager exiting,
+   * crashing or getting a Ctrl-C. Its stdout (the serial console) and stderr go into FIFOs in the
+   * jail directory rather than pipes, which a restarted manager can reopen; the process identity
+   * and bookkeeping go into the VMM record that `adopt` reads back.
+   */
+  private async spawnJailer(
+    vm: VmRecord,
+    args: string[]
+  ): Promise<{ proc: ChildProcess; output: { stdout: RotatingLogSink; stderr: RotatingLogSink } }> {
+    const vmDir = jailerVmDir(this.options.jailerChrootBaseDir, vm.id);
+    await fs.mkdir(vmDir, { recursive: true });
+    const fds: number[] = [];
+    try {
+      fds.push(await createConsoleFifo(path.join(vmDir, CONSOLE_FIFO_FILES.stdout)));
+      fds.push(await createConsoleFifo(path.join(vmDir, CONSOLE_FIFO_FILES.stderr)));
+    } catch (err) {
+      for (const fd of fds) closeSync(fd);
+      throw err;
+    }
+    const proc = spawn(this.options.jailerBin, args, { stdio: ["ignore", fds[0], fds[1]], detached: true });
+    proc.unref();
+    // Capture microVM serial output (console=ttyS0) and jailer output for debugging.
+    // This is especially useful when the guest agent fails to come up. The readers open before
+    // the manager's write ends close, so output of a jailer that fails at once is not discarded.
+    const output = await this.collectOutput(vm);
+    // The child holds its own copies; the manager only ever reads the FIFOs.
+    for (const fd of fds) closeSync(fd);
+
+    // The jailer execs Firecracker in place, so this pid and start time are the VMM's.
+    const identity = proc.pid ? await identifyVmm(proc.pid) : null;
+    if (identity) {
+      const record: VmmRecord = {
+        ...identity,
+        cgroupDir: this.cgroupDirs.get(vm.id),
+        placement: this.placement?.get(vm.id),
+        hugePages: this.hugePages.holds(vm.id) || undefined
+      };
+      this.processes.set(vm.id, record);
+      await writeVmmRecord(vmDir, record);
+    }
+    return { proc, output };
+  }
+
+  /** Jailer flags that put the VM in its own cgroup v2 with CPU, memory and NUMA limits. */
+  private cgroupArgs(vm: VmRecord): string[] {
+    const cgroups = this.options.cgroups;
+    if (!cgroups || !this.placement) return [];
+    // Placed each time the jailer starts; stop/destroy release the slot.
+    const placement = this.placement.place(vm.id, vm.cpu);
+    const quota = Math.round((vm.cpu + VMM_CPU_SHARE) * CPU_PERIOD_US);
+    // hugetlb pages are not charged to the memory controller, only the VMM overhead is.
+    const guestMb = this.hugePages.holds(vm.id) ? 0 : vm.memMb;
+    const memoryMax = (guestMb + cgroups.memoryOverheadMb) * 1024 * 1024;
+    this.cgroupDirs.set(vm.id, path.join(CGROUP_V2_ROOT, cgroups.parentCgroup, vm.id));
+    // eslint-disable-next-line no-console
+    console.info("[placement]", { vmId: vm.id, node: placement.node, cpus: formatCpuList(placement.vcpuCpus) });
+    return [
+      "--cgroup-version",
+      "2",
+      "--parent-cgroup",
+      cgroups.parentCgroup,
+      "--cgroup",
+      `cpuset.cpus=${formatCpuList(placement.cpuset)}`,
+      "--cgroup",
+      `cpuset.mems=${formatCpuList(placement.mems)}`,
+      "--cgroup",
+      `cpu.max=${quota} ${CPU_PERIOD_US}`,
+      "--cgroup",
+      `memory.max=${memoryMax}`
+    ];
+  }
+
+  /** Pipe the jailer's stdout (serial console) and stderr FIFOs into rotating, budgeted log files. */
+  private async collectOutput(vm: VmRecord): Promise<{ stdout: RotatingLogSink; stderr: RotatingLogSink }> {
+    const vmDir = jailerVmDir(this.options.jailerChrootBaseDir, vm.id);
+    const stdout = new RotatingLogSink(path.join(vm.logsDir, "firecracker.stdout.log"), this.options.logRotation);
+    const stderr = new RotatingLogSink(path.join(vm.logsDir, "firecracker.stderr.log"), this.options.logRotation);
+    (await openConsoleFifo(path.join(vmDir, CONSOLE_FIFO_FILES.stdout)))?.pipe(stdout);
+    (await openConsoleFifo(path.join(vmDir, CONSOLE_FIFO_FILES.stderr)))?.pipe(stderr);
+    this.outputs.set(vm.id, { stdout, stderr });
+    return { stdout, stderr };
+  }
+
+  private reserveHugePages(vm: VmRecord): boolean {
+    if (this.hugePages.tryReserve(vm.id, vm.memMb)) return true;
+    // eslint-disable-next-line no-console
+    console.warn("[hugepages] not enough free hugepages; using 4 KiB pages", {
+      vmId: vm.id,
+      memMb: vm.memMb,
+      availablePages: this.hugePages.usage().availablePages
+    });
+    return false;
+  }
+
+  private async removeCgroup(vmId: string): Promise<void> {
+    const dir = this.cgroupDirs.get(vmId);
+    if (!dir) return;
+    this.cgroupDirs.delete(vmId);
+    // Only empty cgroups can be removed, which also makes this safe while the process is exiting.
+    await fs.rmdir(dir).catch(() => undefined);
+  }
+
+  /** Best effort: Firecracker names its vCPU threads `fc_vcpu <n>`; pin each to its assigned CPU. */
+  private async pinVcpuThreads(vm: VmRecord): Promise<void> {
+    const placement = this.placement?.get(vm.id);
+    const pid = this.processes.get(vm.id)?.pid;
+    if (!this.options.cgroups?.pinVcpus || !placement || !pid) return;
+    try {
+      const taskDir = `/proc/${pid}/task`;
+      for (const tid of await fs.readdir(taskDir)) {
+        const comm = (await fs.readFile(path.join(taskDir, tid, "comm"), "utf-8").catch(() => "")).trim();
+        const match = /^fc_vcpu\s*(\d+)$/.exec(comm);
+        const cpu = match ? placement.vcpuCpus[Number(match[1])] : undefined;
+        if (cpu === undefined) continue;
+        await runTaskset(["-p", "-c", String(cpu), tid]);
+      }
+    } catch (err) {
+      // eslint-disable-next-line no-console
+      console.warn("[placement] vCPU pinning failed", { vmId: vm.id, err: String((err as any)?.message ?? err) });
+    }
+  }
+
   private request<T>(socketPath: string, method: string, pathName: string, body?: T): Promise<void> {
     const payload = body ? JSON.stringify(body) : "";
     return new Promise((resolve, reject) => {
@@ -447,12 +792,23 @@ export class FirecrackerManagerImpl implements FirecrackerManager {
   }
 }
 
+function runTaskset(args: string[]): Promise<void> {
+  return new Promise((resolve, reject) => {
+    const proc = spawn("taskset", args, { stdio: ["ignore", "ignore", "pipe"] });
+    let stderr = "";
+    proc.stderr?.on("data", (d) => (stderr += String(d)));
+    proc.on("error", reject);
+    proc.on("close", (code) => (code === 0 ? resolve() : reject(new Error(`taskset exited with code ${code}: ${stderr.slice(0, 200)}`))));
+  });
+}
+
 async function linkOrCopy(src: string, dest: string): Promise<void> {
   await fs.rm(dest, { force: true }).catch(() => undefined);
   try {
     await fs.link(src, dest);
   } catch {
-    await fs.copyFile(src, dest);
+    // Cross-filesystem: a plain copy would allocate every hole of a sparse memory file.
+    await copySparse(src, dest);
   }
 }
 
@@ -491,40 +847,3 @@ async function waitForSocket(socketPath: string, timeoutMs = 5000): Promise<void
   const suffix = lastError ? ` (${String((lastError as any)?.message ?? lastError)})` : "";
   throw new Error(`Firecracker API socket not ready${suffix}`);
 }
-
-async function waitForExit(proc: ReturnType<typeof spawn>, timeoutMs: number): Promise<boolean> {
-  if (hasExited(proc)) return true;
-  return new Promise((resolve) => {
-    let settled = false;
-    const finish = (value: boolean) => {
-      if (settled) return;
-      settled = true;
-      clearTimeout(t);
-      proc.off("exit", onExit);
-      proc.off("close", onClose);
-      resolve(value);
-    };
-    const onExit = () => finish(true);
-    const onClose = () => finish(true);
-    const t = setTimeout(() => finish(hasExited(proc)), timeoutMs);
-    proc.once("exit", onExit);
-    proc.once("close", onClose);
-    if (hasExited(proc)) finish(true);
-  });
-}
-
-function hasExited(proc: ReturnType<typeof spawn>): boolean {
-  return proc.exitCode !== null || proc.signalCode !== null;
-}
-
-function signalSafe(proc: ReturnType<typeof spawn>, signal: NodeJS.Signals): boolean {
-  try {
-    return proc.kill(signal);
-  } catch (error) {
-    const code = (error as NodeJS.ErrnoException | undefined)?.code;
-    if (code === "EPERM" || code === "ESRCH") {
-      return false;
-    }
-    throw error;
-  }
-}
@@ -0,0 +1,138 @@
+import { readFileSync, writeFileSync } from "node:fs";
+import path from "node:path";
+import type { HugePageUsage } from "../types/vm.js";
+
+/** Firecracker only supports 2 MiB hugetlbfs pages for guest memory. */
+export const HUGE_PAGE_MB = 2;
+const HUGE_PAGES_2M_DIR = "/sys/kernel/mm/hugepages/hugepages-2048kB";
+
+export interface HugePageCounters {
+  total: number;
+  free: number;
+  /** Pages promised to existing mappings but not faulted in yet. */
+  reserved: number;
+}
+
+/**
+ * Pages a new VM can still claim. Our own VMs are charged their full size up front (guest memory
+ * may be faulted in lazily, long after start); the kernel's free-minus-reserved count covers other
+ * hugetlb users, less the VMs whose memory is not mapped yet and so is invisible to the kernel.
+ */
+export function availableHugePages(counters: HugePageCounters, heldPages: number, pendingPages: number): number {
+  return Math.max(0, Math.min(counters.total - heldPages, counters.free - counters.reserved - pendingPages));
+}
+
+/**
+ * Host hugepage pool accounting for guest memory. VMs hold their pages from `tryReserve` until
+ * stop/destroy; between `tryReserve` and `settle` (Firecracker mapping guest memory at
+ * InstanceStart) they are also pending, so concurrent starts are never promised the same pages.
+ */
+export class HugePagePool {
+  private readonly held = new Map<string, number>();
+  private readonly pending = new Set<string>();
+  private fallbacks = 0;
+
+  constructor(private readonly sysfsDir = HUGE_PAGES_2M_DIR) {}
+
+  /** Best effort: grow (never shrink) the persistent pool to `poolMb`. Returns the resulting size in pages. */
+  configure(poolMb: number): number {
+    const target = Math.ceil(poolMb / HUGE_PAGE_MB);
+    const current = this.readCounters()?.total ?? 0;
+    if (target > current) {
+      try {
+        writeFileSync(path.join(this.sysfsDir, "nr_hugepages"), String(target));
+      } catch (err) {
+        // eslint-disable-next-line no-console
+        console.warn("[hugepages] unable to grow pool", { target, err: String((err as any)?.message ?? err) });
+      }
+    }
+    const total = this.readCounters()?.total ?? 0;
+    if (total < target) {
+      // The kernel allocates what it can; fragmented hosts get a partial pool.
+      // eslint-disable-next-line no-console
+      console.warn("[hugepages] pool smaller than requested", { requestedPages: target, pages: total });
+    }
+    return total;
+  }
+
+  /** Claim pages for a VM's guest memory; false means the VM must fall back to 4 KiB pages. */
+  tryReserve(vmId: string, memMb: number): boolean {
+    if (this.held.has(vmId)) return true;
+    const pages = memMb / HUGE_PAGE_MB;
+    const counters = this.readCounters();
+    // Firecracker rejects guest memory that is not a whole number of hugepages.
+    const fits =
+      Number.isInteger(pages) && counters !== null && availableHugePages(counters, this.heldPages(), this.pendingPages()) >= pages;
+    if (!fits) {
+      this.fallbacks += 1;
+      return false;
+    }
+    this.held.set(vmId, pages);
+    this.pending.add(vmId);
+    return true;
+  }
+
+  /** Firecracker has mapped the VM's memory; the kernel counters account for it from now on. */
+  settle(vmId: string): void {
+    this.pending.delete(vmId);
+  }
+
+  /** Charge the pages of a VM adopted after a manager restart; its memory is already mapped. */
+  restore(vmId: string, memMb: number): void {
+    this.held.set(vmId, memMb / HUGE_PAGE_MB);
+    this.pending.delete(vmId);
+  }
+
+  release(vmId: string): void {
+    this.held.delete(vmId);
+    this.pending.delete(vmId);
+  }
+
+  rename(oldId: string, newId: string): void {
+    const pages = this.held.get(oldId);
+    if (pages === undefined) return;
+    this.held.delete(oldId);
+    this.held.set(newId, pages);
+    if (this.pending.delete(oldId)) this.pending.add(newId);
+  }
+
+  holds(vmId: string): boolean {
+    return this.held.has(vmId);
+  }
+
+  usage(): HugePageUsage {
+    const counters = this.readCounters() ?? { total: 0, free: 0, reserved: 0 };
+    return {
+      pageSizeKb: HUGE_PAGE_MB * 1024,
+      totalPages: counters.total,
+      freePages: counters.free,
+      reservedPages: counters.reserved,
+      availablePages: availableHugePages(counters, this.heldPages(), this.pendingPages()),
+      vms: Object.fromEntries(this.held),
+      fallbacks: this.fallbacks
+    };
+  }
+
+  private heldPages(): number {
+    let sum = 0;
+    for (const pages of this.held.values()) sum += pages;
+    return sum;
+  }
+
+  private pendingPages(): number {
+    let sum = 0;
+    for (const vmId of this.pending) sum += this.held.get(vmId) ?? 0;
+    return sum;
+  }
+
+  private readCounters(): HugePageCounters | null {
+    try {
+      const read = (name: string) => Number(readFileSync(path.join(this.sysfsDir, name), "utf-8").trim());
+      const counters = { total: read("nr_hugepages"), free: read("free_hugepages"), reserved: read("resv_hugepages") };
+      return Object.values(counters).every(Number.isFinite) ? counters : null;
+    } catch {
+      // No hugetlb support (or no 2 MiB size) on this host.
+      return null;
+    }
+  }
+}
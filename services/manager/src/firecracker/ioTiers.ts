@@ -0,0 +1,63 @@
+import type { VmIoTier } from "../types/vm.js";
+
+/** Firecracker token bucket: `size` tokens (bytes or ops) refilled over `refill_time` ms. */
+export interface TokenBucket {
+  size: number;
+  refill_time: number;
+  one_time_burst?: number;
+}
+
+export interface RateLimiter {
+  bandwidth?: TokenBucket;
+  ops?: TokenBucket;
+}
+
+export interface IoLimits {
+  /** Shared base image; mostly served from the host page cache, so it gets the overlay's budget. */
+  rootfs: RateLimiter;
+  /** Overlay and workspace disks. */
+  disk: RateLimiter;
+  netRx: RateLimiter;
+  netTx: RateLimiter;
+}
+
+export const IO_TIERS: readonly VmIoTier[] = ["unlimited", "small", "standard", "large"];
+
+const MiB = 1024 * 1024;
+
+function perSecond(tokens: number, burst?: number): TokenBucket {
+  return { size: tokens, refill_time: 1000, ...(burst ? { one_time_burst: burst } : {}) };
+}
+
+function tier(diskMiBps: number, diskIops: number, netMiBps: number): IoLimits {
+  // The one-time burst lets boot, package installs and snapshot warm-up run at full speed.
+  const disk: RateLimiter = {
+    bandwidth: perSecond(diskMiBps * MiB, 8 * diskMiBps * MiB),
+    ops: perSecond(diskIops, 8 * diskIops)
+  };
+  const net: RateLimiter = { bandwidth: perSecond(netMiBps * MiB, 4 * netMiBps * MiB) };
+  return { rootfs: disk, disk, netRx: net, netTx: net };
+}
+
+const LIMITS: Record<Exclude<VmIoTier, "unlimited">, IoLimits> = {
+  small: tier(50, 2_000, 25),
+  standard: tier(150, 6_000, 100),
+  large: tier(400, 20_000, 250)
+};
+
+/** Token buckets for a tier, or null when the VM is not throttled. */
+export function ioLimitsForTier(name: VmIoTier | undefined): IoLimits | null {
+  if (!name || name === "unlimited") return null;
+  return LIMITS[name];
+}
+
+// Firecracker PATCH semantics: an omitted bucket is left as is, a zero-sized bucket is removed.
+const DISABLED: RateLimiter = {
+  bandwidth: { size: 0, refill_time: 0 },
+  ops: { size: 0, refill_time: 0 }
+};
+
+/** Rate limiter body for PATCH requests; always explicit so lowering a tier clears old buckets. */
+export function patchRateLimiter(limiter: RateLimiter | undefined): RateLimiter {
+  return { bandwidth: limiter?.bandwidth ?? DISABLED.bandwidth, ops: limiter?.ops ?? DISABLED.ops };
+}
@@ -0,0 +1,308 @@
+import fs, { type FileHandle } from "node:fs/promises";
+import { createReadStream, createWriteStream } from "node:fs";
+import { Writable } from "node:stream";
+import { pipeline } from "node:stream/promises";
+import { createGzip } from "node:zlib";
+
+export interface LogRotationOptions {
+  /** Rotate once the live file would grow past this size. */
+  maxFileBytes: number;
+  /** Rotated segments kept next to the live file; the oldest is dropped on rotation. */
+  maxFiles: number;
+  /** Gzip segments `.2` and older; `.1` stays plain so tails can span one rotation cheaply. */
+  compress: boolean;
+  /** Sustained write budget per stream; output beyond it is dropped and counted. 0 disables. */
+  bytesPerSec: number;
+}
+
+export const DEFAULT_LOG_ROTATION: LogRotationOptions = {
+  maxFileBytes: 8 * 1024 * 1024,
+  maxFiles: 3,
+  compress: true,
+  bytesPerSec: 1024 * 1024
+};
+
+const RECENT_BYTES = 8 * 1024;
+// Seconds of budget a quiet stream can bank, so boot output is never dropped.
+const BURST_SECONDS = 4;
+
+/**
+ * Destination for one VM output stream (jailer/Firecracker stdout with the serial console, or
+ * stderr). Piping into it applies backpressure: the source is paused while a write or rotation is
+ * in flight. Rotation only renames; the previous segment is gzipped in the background, so the
+ * console pipe never waits on compression. Output past the byte budget is
+ * consumed but not written, so a guest flooding its console costs neither disk nor much CPU.
+ * I/O errors are swallowed; logging must never fail a VM.
+ */
+export class RotatingLogSink extends Writable {
+  private handle: FileHandle | null = null;
+  private size = 0;
+  private tokens: number;
+  private lastRefill = Date.now();
+  private dropped = 0;
+  private readonly recent = Buffer.alloc(RECENT_BYTES);
+  private recentStart = 0;
+  private recentLength = 0;
+  // Writes and resets run one at a time, in call order.
+  private ops: Promise<void> = Promise.resolve();
+  // Background gzip of the segment rotated out last; settled before the next rotation or close.
+  private compressing: Promise<void> = Promise.resolve();
+
+  constructor(
+    private filePath: string,
+    private readonly options: LogRotationOptions = DEFAULT_LOG_ROTATION
+  ) {
+    super({ highWaterMark: 64 * 1024 });
+    this.tokens = options.bytesPerSec * BURST_SECONDS;
+  }
+
+  /** Live file currently written. */
+  get path(): string {
+    return this.filePath;
+  }
+
+  /**
+   * Continue writing to `filePath` instead, e.g. after the directory holding the log was renamed.
+   * Files already written are not moved; the next write opens the new path.
+   */
+  retarget(filePath: string): Promise<void> {
+    return this.enqueue(async () => {
+      await this.closeHandle();
+      await this.compressing;
+      this.filePath = filePath;
+      this.size = 0;
+    });
+  }
+
+  /** Last few KiB of output (including dropped bytes), for error messages. */
+  recentText(): string {
+    const end = this.recentStart + this.recentLength;
+    const bytes =
+      end <= RECENT_BYTES
+        ? this.recent.subarray(this.recentStart, end)
+        : Buffer.concat([this.recent.subarray(this.recentStart), this.recent.subarray(0, end - RECENT_BYTES)]);
+    return bytes.toString("utf-8");
+  }
+
+  /**
+   * Delete the live file and every rotated segment and forget the recent output, so nothing written
+   * so far can be read back (a recycled VM must not hand one tenant's console to the next). Later
+   * output starts a fresh file. Unlike writes, a failure here is reported.
+   */
+  reset(): Promise<void> {
+    this.recentStart = 0;
+    this.recentLength = 0;
+    return this.enqueue(async () => {
+      await this.closeHandle();
+      await this.compressing;
+      this.size = 0;
+      this.dropped = 0;
+      await fs.rm(this.filePath, { force: true });
+      for (let i = 1; i <= Math.max(this.options.maxFiles, 1); i += 1) {
+        await fs.rm(segmentPath(this.filePath, i, false), { force: true });
+        await fs.rm(segmentPath(this.filePath, i, true), { force: true });
+      }
+    });
+  }
+
+  override _write(chunk: Buffer, _encoding: BufferEncoding, callback: (error?: Error | null) => void): void {
+    this.remember(chunk);
+    this.enqueue(() => this.append(chunk)).then(
+      () => callback(),
+      () => callback()
+    );
+  }
+
+  override _final(callback: (error?: Error | null) => void): void {
+    this.enqueue(async () => {
+      await this.closeHandle();
+      await this.compressing;
+    }).then(
+      () => callback(),
+      () => callback()
+    );
+  }
+
+  override _destroy(error: Error | null, callback: (error?: Error | null) => void): void {
+    this.enqueue(async () => {
+      await this.closeHandle();
+      await this.compressing;
+    }).then(
+      () => callback(error),
+      () => callback(error)
+    );
+  }
+
+  private enqueue(op: () => Promise<void>): Promise<void> {
+    const run = this.ops.then(op);
+    this.ops = run.catch(() => undefined);
+    return run;
+  }
+
+  private remember(chunk: Buffer): void {
+    // Only the tail of an oversized chunk can survive in the ring anyway.
+    const data = chunk.length > RECENT_BYTES ? chunk.subarray(chunk.length - RECENT_BYTES) : chunk;
+    let writePos = (this.recentStart + this.recentLength) % RECENT_BYTES;
+    for (let offset = 0; offset < data.length; ) {
+      const n = Math.min(data.length - offset, RECENT_BYTES - writePos);
+      data.copy(this.recent, writePos, offset, offset + n);
+      offset += n;
+      writePos = (writePos + n) % RECENT_BYTES;
+    }
+    const length = this.recentLength + data.length;
+    this.recentStart = length > RECENT_BYTES ? writePos : this.recentStart;
+    this.recentLength = Math.min(length, RECENT_BYTES);
+  }
+
+  private async append(chunk: Buffer): Promise<void> {
+    if (!this.takeBudget(chunk.length)) {
+      this.dropped += chunk.length;
+      return;
+    }
+    if (this.dropped > 0) {
+      const marker = `\n[log-collector] dropped ${this.dropped} bytes over the ${this.options.bytesPerSec} B/s budget\n`;
+      this.dropped = 0;
+      await this.writeBytes(Buffer.from(marker));
+    }
+    await this.writeBytes(chunk);
+  }
+
+  private takeBudget(bytes: number): boolean {
+    const rate = this.options.bytesPerSec;
+    if (rate <= 0) return true;
+    const now = Date.now();
+    this.tokens = Math.min(rate * BURST_SECONDS, this.tokens + ((now - this.lastRefill) / 1000) * rate);
+    this.lastRefill = now;
+    if (this.tokens < bytes) return false;
+    this.tokens -= bytes;
+    return true;
+  }
+
+  private async writeBytes(data: Buffer): Promise<void> {
+    if (!this.handle) {
+      this.handle = await fs.open(this.filePath, "a");
+      this.size = (await this.handle.stat()).size;
+    }
+    if (this.size > 0 && this.size + data.length > this.options.maxFileBytes) {
+      await this.rotate();
+      this.handle = await fs.open(this.filePath, "a");
+      this.size = 0;
+    }
+    await this.handle.write(data);
+    this.size += data.length;
+  }
+
+  private async rotate(): Promise<void> {
+    await this.closeHandle();
+    const { maxFiles, compress } = this.options;
+    if (maxFiles <= 0) {
+      await fs.rm(this.filePath, { force: true });
+      return;
+    }
+    // A whole segment was written since the last rotation, so this has almost always finished.
+    await this.compressing;
+    const pending = `${this.filePath}.2`;
+    for (let i = maxFiles; i >= 2; i -= 1) {
+      // `.1` moves to a plain `.2` first; it is compressed below, off the write path.
+      const src = segmentPath(this.filePath, i - 1, compress);
+      const dst = i - 1 === 1 ? pending : segmentPath(this.filePath, i, compress);
+      await fs.rename(src, dst).catch(() => undefined);
+    }
+    await fs.rename(this.filePath, segmentPath(this.filePath, 1, compress));
+    if (compress && maxFiles >= 2) {
+      this.compressing = gzipFile(pending, segmentPath(this.filePath, 2, true)).catch(() => undefined);
+    }
+  }
+
+  private async closeHandle(): Promise<void> {
+    const handle = this.handle;
+    this.handle = null;
+    await handle?.close();
+  }
+}
+
+/** `<file>.1` is always plain; older segments are `<file>.<n>.gz` when compressed. */
+export function segmentPath(filePath: string, index: number, compress: boolean): string {
+  return compress && index >= 2 ? `${filePath}.${index}.gz` : `${filePath}.${index}`;
+}
+
+/** Replace `src` with its gzip at `dst`; readers see either the plain or the complete compressed file. */
+async function gzipFile(src: string, dst: string): Promise<void> {
+  await fs.access(src);
+  const tmp = `${dst}.tmp`;
+  try {
+    await pipeline(createReadStream(src), createGzip(), createWriteStream(tmp));
+    await fs.rename(tmp, dst);
+    await fs.rm(src, { force: true });
+  } finally {
+    await fs.rm(tmp, { force: true });
+  }
+}
+
+/**
+ * Read up to `maxBytes` from the end of a log, continuing into the plain `.1` segment when the live
+ * file was rotated recently. `truncated` means earlier output exists that was not returned;
+ * `startsMidLine` means the text begins part-way through a line, which callers should drop.
+ */
+export async function readLogTail(
+  filePath: string,
+  maxBytes: number
+): Promise<{ text: string; truncated: boolean; startsMidLine: boolean; mtime: Date } | null> {
+  const live = await fs.stat(filePath).catch(() => null);
+  if (!live) return null;
+
+  const parts: Buffer[] = [];
+  let remaining = maxBytes;
+  let truncated = false;
+  let startsMidLine = false;
+  for (const candidate of [filePath, segmentPath(filePath, 1, false)]) {
+    // With nothing left to read this still reports whether the segment ends part-way through a line.
+    const part = await readFileTail(candidate, remaining);
+    if (!part) break;
+    parts.unshift(part.data);
+    remaining -= part.data.length;
+    truncated = part.offset > 0;
+    startsMidLine = part.midLine;
+    // Only a file read from its first byte continues into the segment before it.
+    if (truncated) break;
+  }
+  if (!truncated && remaining > 0 && parts.length === 2) {
+    // Both plain segments fit; anything older is compressed and not part of the tail.
+    truncated = (await exists(segmentPath(filePath, 2, false))) || (await exists(segmentPath(filePath, 2, true)));
+  }
+  // A log truncated while its writer keeps an offset (Firecracker's own log) reads back a NUL-filled hole.
+  const text = Buffer.concat(parts).toString("utf-8").replace(/\0+/g, "");
+  return { text, truncated, startsMidLine, mtime: live.mtime };
+}
+
+async function readFileTail(
+  filePath: string,
+  maxBytes: number
+): Promise<{ data: Buffer; offset: number; midLine: boolean } | null> {
+  let handle: FileHandle;
+  try {
+    handle = await fs.open(filePath, "r");
+  } catch {
+    return null;
+  }
+  try {
+    const { size } = await handle.stat();
+    const length = Math.min(size, maxBytes);
+    const offset = size - length;
+    // One byte of lookbehind tells whether the read starts exactly at a line boundary.
+    const lookbehind = offset > 0 ? 1 : 0;
+    const data = Buffer.alloc(length + lookbehind);
+    const { bytesRead } = await handle.read(data, 0, data.length, offset - lookbehind);
+    const midLine = lookbehind > 0 && bytesRead > 0 && data[0] !== 0x0a;
+    return { data: data.subarray(lookbehind, Math.max(bytesRead, lookbehind)), offset, midLine };
+  } finally {
+    await handle.close().catch(() => undefined);
+  }
+}
+
+async function exists(filePath: string): Promise<boolean> {
+  return fs.access(filePath).then(
+    () => true,
+    () => false
+  );
+}
@@ -0,0 +1,132 @@
+import { readFileSync, readdirSync } from "node:fs";
+import os from "node:os";
+import path from "node:path";
+
+export interface NumaNode {
+  id: number;
+  cpus: number[];
+}
+
+export interface VmPlacement {
+  /** NUMA node the VM's memory and threads are confined to; null when it spans every node. */
+  node: number | null;
+  /** cgroup cpuset.cpus: every CPU of the node, so VMM/IO threads float within it. */
+  cpuset: number[];
+  /** cgroup cpuset.mems. */
+  mems: number[];
+  /** One host CPU per vCPU, used when vCPU threads are pinned. */
+  vcpuCpus: number[];
+}
+
+/** Parse a kernel cpulist ("0-3,8,10-11"). */
+export function parseCpuList(text: string): number[] {
+  const out: number[] = [];
+  for (const part of text.trim().split(",")) {
+    if (!part) continue;
+    const [lo, hi] = part.split("-").map((n) => Number(n));
+    if (!Number.isInteger(lo)) continue;
+    for (let cpu = lo; cpu <= (Number.isInteger(hi) ? hi : lo); cpu += 1) out.push(cpu);
+  }
+  return out;
+}
+
+export function formatCpuList(cpus: number[]): string {
+  const sorted = [...new Set(cpus)].sort((a, b) => a - b);
+  const ranges: string[] = [];
+  for (let i = 0; i < sorted.length; ) {
+    let j = i;
+    while (j + 1 < sorted.length && sorted[j + 1] === sorted[j] + 1) j += 1;
+    ranges.push(i === j ? String(sorted[i]) : `${sorted[i]}-${sorted[j]}`);
+    i = j + 1;
+  }
+  return ranges.join(",");
+}
+
+/** Host NUMA layout from sysfs; hosts without NUMA info are treated as a single node. */
+export function readHostTopology(nodeRoot = "/sys/devices/system/node"): NumaNode[] {
+  try {
+    const nodes = readdirSync(nodeRoot)
+      .filter((name) => /^node\d+$/.test(name))
+      .map((name) => ({
+        id: Number(name.slice("node".length)),
+        cpus: parseCpuList(readFileSync(path.join(nodeRoot, name, "cpulist"), "utf-8"))
+      }))
+      // Memory-only nodes (CXL, some NVDIMM setups) have no CPUs to run vCPUs on.
+      .filter((node) => node.cpus.length > 0)
+      .sort((a, b) => a.id - b.id);
+    if (nodes.length) return nodes;
+  } catch {
+    // Fall through to the single-node view.
+  }
+  return [{ id: 0, cpus: os.cpus().map((_cpu, i) => i) }];
+}
+
+/**
+ * Assigns VMs to NUMA nodes and host CPUs by committed vCPUs. A VM goes to the node with the lowest
+ * vCPUs-per-CPU ratio, so its memory is allocated locally and its threads never cross sockets;
+ * within that node each vCPU gets the least-used CPU. VMs larger than any node span all of them.
+ */
+export class PlacementScheduler {
+  private readonly placements = new Map<string, VmPlacement>();
+  private readonly cpuLoad = new Map<number, number>();
+
+  constructor(private readonly nodes: NumaNode[]) {}
+
+  place(vmId: string, vcpus: number): VmPlacement {
+    const existing = this.placements.get(vmId);
+    if (existing) return existing;
+
+    const fitting = this.nodes.filter((node) => node.cpus.length >= vcpus);
+    let placement: VmPlacement;
+    if (fitting.length === 0) {
+      const all = this.nodes.flatMap((node) => node.cpus);
+      placement = { node: null, cpuset: all, mems: this.nodes.map((n) => n.id), vcpuCpus: this.leastLoaded(all, vcpus) };
+    } else {
+      const node = fitting.reduce((best, candidate) =>
+        this.nodeRatio(candidate) < this.nodeRatio(best) ? candidate : best
+      );
+      placement = { node: node.id, cpuset: node.cpus, mems: [node.id], vcpuCpus: this.leastLoaded(node.cpus, vcpus) };
+    }
+    for (const cpu of placement.vcpuCpus) this.cpuLoad.set(cpu, (this.cpuLoad.get(cpu) ?? 0) + 1);
+    this.placements.set(vmId, placement);
+    return placement;
+  }
+
+  /** Take back the placement of a VM that kept running across a manager restart. */
+  restore(vmId: string, placement: VmPlacement): void {
+    this.release(vmId);
+    for (const cpu of placement.vcpuCpus) this.cpuLoad.set(cpu, (this.cpuLoad.get(cpu) ?? 0) + 1);
+    this.placements.set(vmId, placement);
+  }
+
+  release(vmId: string): void {
+    const placement = this.placements.get(vmId);
+    if (!placement) return;
+    for (const cpu of placement.vcpuCpus) this.cpuLoad.set(cpu, Math.max(0, (this.cpuLoad.get(cpu) ?? 0) - 1));
+    this.placements.delete(vmId);
+  }
+
+  rename(oldId: string, newId: string): void {
+    const placement = this.placements.get(oldId);
+    if (!placement) return;
+    this.placements.delete(oldId);
+    this.placements.set(newId, placement);
+  }
+
+  get(vmId: string): VmPlacement | undefined {
+    return this.placements.get(vmId);
+  }
+
+  private nodeRatio(node: NumaNode): number {
+    const committed = node.cpus.reduce((sum, cpu) => sum + (this.cpuLoad.get(cpu) ?? 0), 0);
+    return committed / node.cpus.length;
+  }
+
+  private leastLoaded(cpus: number[], count: number): number[] {
+    // Stable by CPU id among equally loaded CPUs, so placements are deterministic.
+    return [...cpus]
+      .sort((a, b) => (this.cpuLoad.get(a) ?? 0) - (this.cpuLoad.get(b) ?? 0) || a - b)
+      .slice(0, count)
+      .sort((a, b) => a - b);
+  }
+}
@@ -2,9 +2,14 @@ import path from "node:path";
 
 const JAILER_EXEC_FILE_DIRNAME = "firecracker";
 
+export function jailerExecDir(chrootBaseDir: string): string {
+  // Parent of every VM's jail directory.
+  return path.join(chrootBaseDir, JAILER_EXEC_FILE_DIRNAME);
+}
+
 export function jailerVmDir(chrootBaseDir: string, vmId: string): string {
   // Jailer creates: <chrootBaseDir>/<exec_file_name>/<id>/root/...
-  return path.join(chrootBaseDir, JAILER_EXEC_FILE_DIRNAME, vmId);
+  return path.join(jailerExecDir(chrootBaseDir), vmId);
 }
 
 export function jailerRootDir(chrootBaseDir: string, vmId: string): string {
@@ -28,6 +33,14 @@ export function firecrackerVsockUdsPath(chrootBaseDir: string, vmId: string): st
   return path.join(jailerRunDir(chrootBaseDir, vmId), "vsock.sock");
 }
 
+export function rebaseVmPath(p: string, oldId: string, newId: string): string {
+  // A VM's files live under its id; after a rekey they resolve under the new one.
+  return p
+    .split(path.sep)
+    .map((segment) => (segment === oldId ? newId : segment))
+    .join(path.sep);
+}
+
 export function inChrootPathForHostPath(jailRootHostPath: string, hostPath: string): string {
   // Convert a host path under <...>/<id>/root to an in-chroot absolute path.
   // Example:
@@ -0,0 +1,120 @@
+import fs from "node:fs/promises";
+import { constants as fsConstants, openSync } from "node:fs";
+import net from "node:net";
+import path from "node:path";
+import { execFile } from "node:child_process";
+import { promisify } from "node:util";
+import type { VmPlacement } from "./placement.js";
+
+const execFileAsync = promisify(execFile);
+
+/** Lives next to the jail root (not inside it), so the jailed Firecracker can neither read nor forge it. */
+export const VMM_RECORD_FILE = "vmm.json";
+export const CONSOLE_FIFO_FILES = { stdout: "stdout.fifo", stderr: "stderr.fifo" } as const;
+
+/**
+ * What a manager needs to take over a Firecracker process started by an earlier manager. The start
+ * time pins the pid to this process, so a pid reused after the VM exited is never signalled.
+ */
+export interface VmmRecord {
+  pid: number;
+  /** `starttime` from /proc/<pid>/stat (clock ticks since boot). */
+  startTime: string;
+  /** Jailer-created cgroup, named after the id the VM was started with. */
+  cgroupDir?: string;
+  placement?: VmPlacement;
+  hugePages?: boolean;
+}
+
+export interface ProcStat {
+  /** Single-letter state; `Z` is a zombie waiting to be reaped. */
+  state: string;
+  startTime: string;
+}
+
+export async function readProcStat(pid: number, procRoot = "/proc"): Promise<ProcStat | null> {
+  const text = await fs.readFile(path.join(procRoot, String(pid), "stat"), "utf-8").catch(() => null);
+  if (!text) return null;
+  // `comm` is parenthesised and may itself contain spaces or parentheses; fields resume after the last `)`.
+  const fields = text.slice(text.lastIndexOf(")") + 2).trim().split(/\s+/);
+  // fields[0] is field 3 (state); starttime is field 22.
+  const state = fields[0];
+  const startTime = fields[19];
+  if (!state || !startTime) return null;
+  return { state, startTime };
+}
+
+export async function identifyVmm(pid: number, procRoot?: string): Promise<Pick<VmmRecord, "pid" | "startTime"> | null> {
+  const stat = await readProcStat(pid, procRoot);
+  return stat ? { pid, startTime: stat.startTime } : null;
+}
+
+export async function isVmmAlive(record: Pick<VmmRecord, "pid" | "startTime">, procRoot?: string): Promise<boolean> {
+  const stat = await readProcStat(record.pid, procRoot);
+  return stat !== null && stat.state !== "Z" && stat.startTime === record.startTime;
+}
+
+/**
+ * Poll until the process is gone. Processes this manager did not start are not its children, so
+ * there is no exit event to wait for; polling works the same for both.
+ */
+export async function waitForVmmExit(record: Pick<VmmRecord, "pid" | "startTime">, timeoutMs: number, procRoot?: string): Promise<boolean> {
+  const deadline = Date.now() + timeoutMs;
+  while (await isVmmAlive(record, procRoot)) {
+    if (Date.now() >= deadline) return false;
+    await new Promise((resolve) => setTimeout(resolve, 50));
+  }
+  return true;
+}
+
+export function signalVmm(record: Pick<VmmRecord, "pid">, signal: NodeJS.Signals): boolean {
+  try {
+    return process.kill(record.pid, signal);
+  } catch (error) {
+    const code = (error as NodeJS.ErrnoException | undefined)?.code;
+    if (code === "EPERM" || code === "ESRCH") {
+      return false;
+    }
+    throw error;
+  }
+}
+
+export async function writeVmmRecord(vmDir: string, record: VmmRecord): Promise<void> {
+  const target = path.join(vmDir, VMM_RECORD_FILE);
+  const tmp = `${target}.tmp`;
+  await fs.writeFile(tmp, JSON.stringify(record), "utf-8");
+  await fs.rename(tmp, target);
+}
+
+export async function readVmmRecord(vmDir: string): Promise<VmmRecord | null> {
+  try {
+    const record = JSON.parse(await fs.readFile(path.join(vmDir, VMM_RECORD_FILE), "utf-8")) as VmmRecord;
+    return Number.isInteger(record.pid) && record.pid > 0 && typeof record.startTime === "string" ? record : null;
+  } catch {
+    return null;
+  }
+}
+
+/**
+ * Create the FIFO a VMM writes one of its output streams into and return the fd to hand it as that
+ * stream. The fd is opened read-write and non-blocking: the VMM itself always holds a reader, so
+ * its writes never fail with EPIPE while no manager is attached; they fill the pipe buffer and
+ * drop output beyond it rather than stalling the guest's console.
+ */
+export async function createConsoleFifo(fifoPath: string): Promise<number> {
+  await fs.rm(fifoPath, { force: true });
+  await execFileAsync("mkfifo", ["-m", "600", fifoPath]);
+  // A raw fd (not a FileHandle): it is passed to spawn and closed by the caller afterwards.
+  return openSync(fifoPath, fsConstants.O_RDWR | fsConstants.O_NONBLOCK);
+}
+
+/** Reader for a console FIFO; ends once the VMM (the last writer) exits. Null when the FIFO is gone. */
+export async function openConsoleFifo(fifoPath: string): Promise<net.Socket | null> {
+  try {
+    // Opening a FIFO's read end never blocks with O_NONBLOCK; the socket owns and closes the fd.
+    const fd = openSync(fifoPath, fsConstants.O_RDONLY | fsConstants.O_NONBLOCK);
+    return new net.Socket({ fd, readable: true, writable: false });
+  } catch {
+    return null;
+  }
+}
@@ -7,8 +7,12 @@ import { FirecrackerManagerImpl } from "./firecracker/firecrackerManager.js";
 import { firecrackerVsockUdsPath } from "./firecracker/socketPaths.js";
 import { SimpleNetworkManager } from "./network/networkManager.js";
 import { LocalStorageProvider } from "./storage/storageProvider.js";
+import { ThinStorageProvider } from "./storage/thinStorageProvider.js";
 import { SqlVmStore } from "./state/sqlVmStore.js";
 import { SqlVmPeerLinkStore } from "./state/sqlVmPeerLinkStore.js";
+import { SqlSnapshotCatalog } from "./state/sqlSnapshotCatalog.js";
+import { SnapshotCatalogReconciler } from "./reconciler/snapshotCatalogReconciler.js";
+import { VmReattachReconciler } from "./reconciler/vmReattachReconciler.js";
 import { VmService } from "./services/vmService.js";
 import { ActivityService } from "./telemetry/activityService.js";
 import { initOtel, shutdownOtel } from "./telemetry/otel.js";
@@ -16,9 +20,13 @@ import { ApiKeyService } from "./apiKey/apiKeyService.js";
 import fs from "node:fs/promises";
 import { computeSnapshotVersion } from "./snapshots/snapshotVersion.js";
 import { ImageService } from "./services/imageService.js";
+import { ImageUploadService } from "./services/imageUploadService.js";
 import { PeerService } from "./services/peer/peerService.js";
 import { WebhookService } from "./services/webhookService.js";
 import { WebhookDispatcher } from "./services/webhookDispatcher.js";
+import type { SnapshotCatalog } from "./types/interfaces.js";
+
+const SNAPSHOT_RECONCILE_INTERVAL_MS = 10 * 60 * 1000;
 
 async function main() {
   const env = loadEnv();
@@ -31,18 +39,12 @@ async function main() {
   await runMigrations({ dialect: db.dialect, db: db.db });
   const store = new SqlVmStore(db.db as any, db.vms as any);
   const vmPeerLinks = new SqlVmPeerLinkStore(db.db as any, (db as any).vmPeerLinks);
+  const snapshotCatalog = new SqlSnapshotCatalog(db.db as any, db.snapshots as any);
   const activityService = new ActivityService(db.db as any, db.activityEvents as any);
   const apiKeyService = new ApiKeyService(db.db as any, db.apiKeys as any);
   const webhookService = new WebhookService(db.db as any, db.webhooks as any);
   // Best-effort: subscribe to activity and deliver to configured webhooks (no retries/logs for now).
   new WebhookDispatcher(activityService, webhookService);
-  // After manager restart/recreate, Firecracker processes won't be running.
-  // Normalize any transient states so `GET /v1/vms` doesn't claim they're still RUNNING.
-  for (const vm of await store.list()) {
-    if (vm.state === "RUNNING" || vm.state === "STARTING" || vm.state === "STOPPING") {
-      await store.update(vm.id, { state: "STOPPED" });
-    }
-  }
   const firecracker = new FirecrackerManagerImpl({
     firecrackerBin: env.firecrackerBin,
     jailerBin: env.jailer.bin,
@@ -50,9 +52,25 @@ async function main() {
     jailerUid: env.jailer.uid,
     jailerGid: env.jailer.gid,
     logLevel: env.firecrackerLogLevel,
-    overlayDeviceWaitMs: env.overlayDeviceWaitMs
+    overlayDeviceWaitMs: env.overlayDeviceWaitMs,
+    entropyDevice: env.firecrackerEntropyDevice,
+    zramPercent: env.guestZramPercent,
+    cgroups: env.firecrackerCgroups,
+    hugePagesPoolMb: env.hugePagesPoolMb,
+    logRotation: env.vmLogRotation
   });
   const network = new SimpleNetworkManager({ subnetCidr: "172.16.0.0/24", gatewayIp: "172.16.0.1" });
+
+  // Firecracker runs in its own session, so VMs survive a manager restart: adopt the ones still
+  // answering, stop the rest. Runs before VmService exists, so the warm pool top-up picks up
+  // adopted pool VMs and new VMs never reuse an adopted VM's address, tap or vsock CID.
+  // A `snapshot-build` run may share the host with a live manager and leaves its VMs alone.
+  if (process.argv[2] !== "snapshot-build") {
+    await new VmReattachReconciler({ store, firecracker }).run();
+  }
+  const knownVms = (await store.list()).filter((vm) => vm.state !== "DELETED");
+  network.reserve(knownVms.map((vm) => vm.guestIp));
+  const vsockCidStart = Math.max(5000, ...knownVms.map((vm) => vm.vsockCid + 1));
   const agentClient = new VsockAgentClient({
     agentPort: env.agentVsockPort,
     // With jailer, the vsock UDS is inside the per-VM jail root; compute it deterministically.
@@ -61,17 +79,42 @@ async function main() {
     timeouts: { defaultMs: env.vsock.timeoutMs, healthMs: env.vsock.healthTimeoutMs, binaryMs: env.vsock.binaryTimeoutMs },
     limits: { maxJsonResponseBytes: env.vsock.maxJsonResponseBytes, maxBinaryResponseBytes: env.vsock.maxBinaryResponseBytes }
   });
-  const storage = new LocalStorageProvider({
+  const storageOptions = {
     storageRoot: env.storageRoot,
     jailerChrootBaseDir: env.jailer.chrootBaseDir,
     rootfsCloneMode: env.rootfsCloneMode,
-    overlaySizeBytes: env.overlaySizeBytes
-  });
+    overlaySizeBytes: env.overlaySizeBytes,
+    overlayPoolDepth: env.overlayPoolDepth
+  };
+  let storage: LocalStorageProvider;
+  if (env.storageBackend === "thin") {
+    const thinStorage = new ThinStorageProvider({
+      ...storageOptions,
+      thinPool: { ...env.thinPool, nodeOwner: { uid: env.jailer.uid, gid: env.jailer.gid } }
+    });
+    await thinStorage.init();
+    storage = thinStorage;
+  } else {
+    storage = new LocalStorageProvider(storageOptions);
+  }
+  storage.warmOverlayPool();
+
+  // The catalog must reflect STORAGE_ROOT/snapshots before anything lists or restores snapshots;
+  // the periodic pass picks up artifacts changed behind the manager's back.
+  const snapshotReconciler = new SnapshotCatalogReconciler({ storage, catalog: snapshotCatalog });
+  await snapshotReconciler.run();
+  setInterval(() => {
+    snapshotReconciler.run().catch((err) => {
+      // eslint-disable-next-line no-console
+      console.warn("[snapshot-catalog] reconcile failed", { err: String((err as any)?.message ?? err) });
+    });
+  }, SNAPSHOT_RECONCILE_INTERVAL_MS).unref();
 
   const images = new ImageService(db.db as any, db.guestImages as any, db.settings as any, db.vms as any, env.imagesDir, {
     kernelPath: env.kernelPath,
     baseRootfsPath: env.baseRootfsPath
   });
+  const imageUploads = new ImageUploadService(images, env.imagesDir);
 
   const snapshotVersion =
     env.kernelPath && env.baseRootfsPath
@@ -92,13 +135,18 @@ async function main() {
     network,
     agentClient,
     storage,
+    snapshotCatalog,
     images,
     peerService,
     limits: env.limits,
+    vsockCidStart,
+    defaultIoTier: env.defaultIoTier,
+    defaultHugePages: env.guestHugePages,
     activity: activityService,
     dnsServerIp: env.dnsServerIp,
     warmPool: env.warmPool,
-    snapshots: { enabled: true, version: snapshotVersion, templateCpu: env.snapshotTemplateCpu, templateMemMb: env.snapshotTemplateMemMb }
+    snapshots: { enabled: true, version: snapshotVersion, templateCpu: env.snapshotTemplateCpu, templateMemMb: env.snapshotTemplateMemMb },
+    seedSnapshots: env.seedSnapshots
   });
 
   const deps = {
@@ -110,6 +158,7 @@ async function main() {
     storage,
     storageRoot: env.storageRoot,
     images,
+    imageUploads,
     vmService,
     peerService,
     activityService,
@@ -126,6 +175,7 @@ async function main() {
       network,
       agentClient,
       storage,
+      snapshotCatalog,
       version: snapshotVersion,
       cpu: env.snapshotTemplateCpu,
       memMb: env.snapshotTemplateMemMb
@@ -154,6 +204,7 @@ async function buildTemplateSnapshot(input: {
   network: SimpleNetworkManager;
   agentClient: VsockAgentClient;
   storage: LocalStorageProvider;
+  snapshotCatalog: SnapshotCatalog;
   version: string;
   cpu: number;
   memMb: number;
@@ -187,29 +238,17 @@ async function buildTemplateSnapshot(input: {
     createdAt
   } as const;
 
-  const snapshot = await input.storage.getSnapshotArtifactPaths(input.version);
+  const snapshot = await input.storage.getSnapshotArtifactPaths(input.version, { create: true });
 
   try {
     await input.network.configure(vm as any, tapName);
     await input.firecracker.createAndStart(vm as any, rootfsPath, kernelPath, tapName);
     await input.agentClient.health(templateId);
+    await input.agentClient.prepareForSnapshot(templateId).catch(() => undefined);
     await input.firecracker.createSnapshot(vm as any, { memPath: snapshot.memPath, statePath: snapshot.statePath });
-    await fs.writeFile(
-      snapshot.metaPath,
-      JSON.stringify(
-        {
-          id: input.version,
-          kind: "template",
-          cpu: input.cpu,
-          memMb: input.memMb,
-          createdAt,
-          hasDisk: false
-        },
-        null,
-        2
-      ),
-      "utf-8"
-    );
+    const meta = { id: input.version, kind: "template", cpu: input.cpu, memMb: input.memMb, createdAt, hasDisk: false } as const;
+    await fs.writeFile(snapshot.metaPath, JSON.stringify(meta, null, 2), "utf-8");
+    await input.snapshotCatalog.put(meta);
     // eslint-disable-next-line no-console
     console.info("[snapshot] created", { version: input.version, dir: snapshot.dir });
   } finally {
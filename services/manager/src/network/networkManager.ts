@@ -22,6 +22,14 @@ export class SimpleNetworkManager implements NetworkManager {
     return { guestIp, tapName };
   }
 
+  /** Keep the addresses (and so tap names) of VMs that outlived a manager restart out of new allocations. */
+  reserve(guestIps: string[]): void {
+    for (const guestIp of guestIps) {
+      const host = Number(guestIp.split(".").pop());
+      if (Number.isInteger(host) && host >= this.nextHost) this.nextHost = host + 1;
+    }
+  }
+
   async configure(vm: VmRecord, tapName: string, options?: { up?: boolean; allowManagerGateway?: boolean }): Promise<void> {
     await this.ensureBridge();
     // If a previous session stopped without teardown, the tap may still exist.
@@ -0,0 +1,109 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { SnapshotCatalogReconciler } from "../snapshotCatalogReconciler.js";
+import type { SnapshotCatalog } from "../../types/interfaces.js";
+import type { SnapshotMeta } from "../../types/snapshot.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+function makeFixture() {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), "snapshot-catalog-"));
+  tempDirs.push(root);
+  const rows = new Map<string, SnapshotMeta>();
+  const reads: string[] = [];
+  const catalog: SnapshotCatalog = {
+    put: async (meta) => void rows.set(meta.id, meta),
+    get: async (id) => rows.get(id) ?? null,
+    delete: async (id) => void rows.delete(id),
+    list: async () => ({ items: [...rows.values()], nextCursor: null }),
+    ids: async () => {
+      reads.push("catalog");
+      return [...rows.keys()];
+    },
+    counts: async () => ({ snapshots: rows.size, templates: 0 })
+  };
+  const storage = {
+    listSnapshots: async () => {
+      reads.push("disk");
+      return fs.readdirSync(root);
+    },
+    // Like the storage provider: any unreadable or unparsable meta.json reads as null.
+    readSnapshotMeta: async (id: string) => {
+      try {
+        return JSON.parse(fs.readFileSync(path.join(root, id, "meta.json"), "utf-8")) as SnapshotMeta;
+      } catch {
+        return null;
+      }
+    },
+    getSnapshotArtifactPaths: async (id: string) => {
+      const dir = path.join(root, id);
+      return {
+        dir,
+        memPath: path.join(dir, "mem.snap"),
+        statePath: path.join(dir, "vmstate.snap"),
+        diskPath: path.join(dir, "disk.ext4"),
+        overlayPath: path.join(dir, "overlay.ext4"),
+        workspacePath: path.join(dir, "workspace.ext4"),
+        metaPath: path.join(dir, "meta.json")
+      };
+    }
+  };
+  const writeSnapshot = (id: string, withMeta = true) => {
+    fs.mkdirSync(path.join(root, id));
+    const meta: SnapshotMeta = { id, kind: "user_overlay", createdAt: new Date().toISOString(), cpu: 1, memMb: 256, hasDisk: false };
+    if (withMeta) fs.writeFileSync(path.join(root, id, "meta.json"), JSON.stringify(meta));
+    return meta;
+  };
+  return { root, rows, catalog, storage, writeSnapshot, reads };
+}
+
+describe("SnapshotCatalogReconciler", () => {
+  it("adopts snapshots missing from the catalog and drops rows whose artifacts are gone", async () => {
+    const { rows, catalog, storage, writeSnapshot } = makeFixture();
+    const kept = writeSnapshot("snap-kept");
+    await catalog.put(kept);
+    writeSnapshot("snap-legacy");
+    await catalog.put({ ...kept, id: "snap-gone" });
+
+    await new SnapshotCatalogReconciler({ storage, catalog }).run();
+    expect([...rows.keys()].sort()).toEqual(["snap-kept", "snap-legacy"]);
+  });
+
+  it("removes directories that never got a meta.json once the grace period has passed", async () => {
+    const { root, rows, catalog, storage, writeSnapshot } = makeFixture();
+    writeSnapshot("snap-writing", false);
+
+    await new SnapshotCatalogReconciler({ storage, catalog }).run();
+    expect(fs.existsSync(path.join(root, "snap-writing"))).toBe(true);
+
+    const later = Date.now() + 2 * 60 * 60 * 1000;
+    await new SnapshotCatalogReconciler({ storage, catalog, now: () => later }).run();
+    expect(fs.existsSync(path.join(root, "snap-writing"))).toBe(false);
+    expect(rows.size).toBe(0);
+  });
+
+  it("keeps directories whose meta.json is corrupt or names another snapshot", async () => {
+    const { root, catalog, storage, writeSnapshot } = makeFixture();
+    writeSnapshot("snap-corrupt", false);
+    fs.writeFileSync(path.join(root, "snap-corrupt", "meta.json"), "{\"id\": \"snap-cor");
+    const other = writeSnapshot("snap-moved", false);
+    fs.writeFileSync(path.join(root, "snap-moved", "meta.json"), JSON.stringify({ ...other, id: "snap-elsewhere" }));
+
+    const later = Date.now() + 2 * 60 * 60 * 1000;
+    await new SnapshotCatalogReconciler({ storage, catalog, now: () => later }).run();
+    expect(fs.existsSync(path.join(root, "snap-corrupt"))).toBe(true);
+    expect(fs.existsSync(path.join(root, "snap-moved"))).toBe(true);
+  });
+
+  it("reads the catalog before listing the snapshot directory", async () => {
+    const { catalog, storage, reads } = makeFixture();
+    await new SnapshotCatalogReconciler({ storage, catalog }).run();
+    expect(reads).toEqual(["catalog", "disk"]);
+  });
+});
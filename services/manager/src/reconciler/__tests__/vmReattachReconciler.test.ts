@@ -0,0 +1,77 @@
+import { describe, expect, it } from "vitest";
+import { VmReattachReconciler } from "../vmReattachReconciler.js";
+import type { VmRecord, VmState } from "../../types/vm.js";
+
+function vm(id: string, state: VmState): VmRecord {
+  return { id, state, cpu: 1, memMb: 256, guestIp: "172.16.0.2", tapName: "tap-2", vsockCid: 5000 } as VmRecord;
+}
+
+function makeFixture(records: VmRecord[], live: string[], unanswering: string[] = []) {
+  const states = new Map(records.map((r) => [r.id, r.state]));
+  const terminated: Array<{ vmId: string; removeJail: boolean }> = [];
+  let inFlight = 0;
+  let peak = 0;
+  const reconciler = new VmReattachReconciler({
+    store: {
+      list: async () => records,
+      update: async (id, patch) => void states.set(id, patch.state!)
+    },
+    firecracker: {
+      discover: async () => live,
+      adopt: async (record) => {
+        inFlight += 1;
+        peak = Math.max(peak, inFlight);
+        await new Promise((resolve) => setTimeout(resolve, 5));
+        inFlight -= 1;
+        return !unanswering.includes(record.id);
+      },
+      terminate: async (vmId, options) => void terminated.push({ vmId, removeJail: options?.removeJail ?? false })
+    },
+    concurrency: 4
+  });
+  return { reconciler, states, terminated, peak: () => peak };
+}
+
+describe("VmReattachReconciler", () => {
+  it("adopts running VMs whose process survived and stops the ones that did not", async () => {
+    const { reconciler, states, terminated } = makeFixture(
+      [vm("alive", "RUNNING"), vm("dead", "RUNNING"), vm("stopped", "STOPPED"), vm("gone", "DELETED")],
+      ["alive"]
+    );
+    const result = await reconciler.reattach();
+    expect(result).toEqual({ adopted: ["alive"], stopped: ["dead"], terminated: [] });
+    expect(states.get("alive")).toBe("RUNNING");
+    expect(states.get("dead")).toBe("STOPPED");
+    expect(states.get("stopped")).toBe("STOPPED");
+    expect(terminated).toEqual([]);
+  });
+
+  it("kills unadoptable, mid-transition and orphaned processes", async () => {
+    const { reconciler, states, terminated } = makeFixture(
+      [vm("hung", "RUNNING"), vm("booting", "STARTING"), vm("deleted", "DELETED")],
+      ["hung", "booting", "deleted", "recycled-half-way"],
+      ["hung"]
+    );
+    const result = await reconciler.reattach();
+    expect(result.adopted).toEqual([]);
+    expect([...result.stopped].sort()).toEqual(["booting", "hung"]);
+    expect([...states.values()]).toEqual(["STOPPED", "STOPPED", "DELETED"]);
+    expect([...terminated].sort((a, b) => a.vmId.localeCompare(b.vmId))).toEqual([
+      { vmId: "booting", removeJail: false },
+      { vmId: "deleted", removeJail: true },
+      { vmId: "hung", removeJail: false },
+      { vmId: "recycled-half-way", removeJail: true }
+    ]);
+  });
+
+  it("adopts VMs in parallel up to the concurrency limit", async () => {
+    const ids = Array.from({ length: 12 }, (_, i) => `vm-${i}`);
+    const { reconciler, peak } = makeFixture(
+      ids.map((id) => vm(id, "RUNNING")),
+      ids
+    );
+    const result = await reconciler.reattach();
+    expect(result.adopted).toHaveLength(12);
+    expect(peak()).toBe(4);
+  });
+});
@@ -0,0 +1,80 @@
+import fs from "node:fs/promises";
+import type { Reconciler, SnapshotCatalog, StorageProvider } from "../types/interfaces.js";
+
+/** Directories without meta.json younger than this may be snapshots still being written. */
+const ORPHAN_GRACE_MS = 60 * 60 * 1000;
+
+export interface SnapshotCatalogReconcilerOptions {
+  storage: Pick<StorageProvider, "listSnapshots" | "readSnapshotMeta" | "getSnapshotArtifactPaths">;
+  catalog: SnapshotCatalog;
+  now?: () => number;
+}
+
+/**
+ * Repairs drift between the snapshot catalog and STORAGE_ROOT/snapshots: adopts directories with
+ * a valid meta.json but no row (snapshots from before the catalog, or a crash between writing
+ * meta.json and the row), drops rows whose directory is gone, and removes stale directories that
+ * never got a meta.json. One directory listing and one id query; meta.json is only read on drift.
+ * A directory whose meta.json exists but is unreadable or names another id is logged and left
+ * alone: it may hold a tenant's only copy of a snapshot.
+ */
+export class SnapshotCatalogReconciler implements Reconciler {
+  private readonly now: () => number;
+
+  constructor(private readonly options: SnapshotCatalogReconcilerOptions) {
+    this.now = options.now ?? Date.now;
+  }
+
+  async run(): Promise<void> {
+    const { storage, catalog } = this.options;
+    // Catalog first: a snapshot created between the two reads is then seen on disk (and adopted),
+    // never in the catalog alone (and dropped as if its directory were gone).
+    const inCatalog = await catalog.ids();
+    const onDisk = await storage.listSnapshots();
+    const diskIds = new Set(onDisk);
+    const catalogIds = new Set(inCatalog);
+    let adopted = 0;
+    let dropped = 0;
+    let removed = 0;
+    let skipped = 0;
+
+    for (const id of inCatalog) {
+      if (diskIds.has(id)) continue;
+      await catalog.delete(id);
+      dropped += 1;
+    }
+
+    for (const id of onDisk) {
+      if (catalogIds.has(id)) continue;
+      const meta = await storage.readSnapshotMeta(id).catch(() => null);
+      if (meta && meta.id === id) {
+        await catalog.put(meta);
+        adopted += 1;
+        continue;
+      }
+      const { dir, metaPath } = await storage.getSnapshotArtifactPaths(id);
+      const metaMissing = await fs.stat(metaPath).then(
+        () => false,
+        (err) => (err as NodeJS.ErrnoException | undefined)?.code === "ENOENT"
+      );
+      if (!metaMissing) {
+        skipped += 1;
+        // eslint-disable-next-line no-console
+        console.warn("[snapshot-catalog] snapshot meta.json is unreadable or names another id; leaving it", {
+          snapshotId: id,
+          metaId: meta?.id
+        });
+        continue;
+      }
+      const st = await fs.stat(dir).catch(() => null);
+      if (!st || this.now() - st.mtimeMs < ORPHAN_GRACE_MS) continue;
+      await fs.rm(dir, { recursive: true, force: true }).catch(() => undefined);
+      removed += 1;
+    }
+
+    if (adopted + dropped + removed + skipped > 0) {
+      // eslint-disable-next-line no-console
+      console.info("[snapshot-catalog] reconciled", { adopted, dropped, removed, skipped });
+    }
+  }
+}
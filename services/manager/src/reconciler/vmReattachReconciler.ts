@@ -0,0 +1,94 @@
+import type { FirecrackerManager, Reconciler, VmStore } from "../types/interfaces.js";
+import type { VmRecord } from "../types/vm.js";
+
+const DEFAULT_CONCURRENCY = 16;
+
+export interface VmReattachReconcilerOptions {
+  store: Pick<VmStore, "list" | "update">;
+  firecracker: Pick<FirecrackerManager, "discover" | "adopt" | "terminate">;
+  /** VMs adopted or terminated at once; each adoption is a few file reads and one API round trip. */
+  concurrency?: number;
+}
+
+export interface VmReattachResult {
+  /** RUNNING VMs whose Firecracker process survived and now belongs to this manager. */
+  adopted: string[];
+  /** VMs moved to STOPPED because they were mid-transition or their process is gone. */
+  stopped: string[];
+  /** Live processes killed: unadoptable, mid-transition, or with no VM record at all. */
+  terminated: string[];
+}
+
+/**
+ * Startup pass that re-attaches this manager to VMs an earlier manager left running. Firecracker
+ * runs in its own session, so a manager restart leaves RUNNING VMs alive: those answering their API
+ * are adopted in place. VMs caught mid-start or mid-stop, RUNNING VMs whose process died, and
+ * processes in jails no VM record owns are stopped or killed, as before this existed.
+ */
+export class VmReattachReconciler implements Reconciler {
+  constructor(private readonly options: VmReattachReconcilerOptions) {}
+
+  async run(): Promise<void> {
+    await this.reattach();
+  }
+
+  async reattach(): Promise<VmReattachResult> {
+    const { store, firecracker } = this.options;
+    const started = Date.now();
+    const [live, records] = await Promise.all([firecracker.discover(), store.list()]);
+    const liveIds = new Set(live);
+    const vms = records.filter((vm) => vm.state !== "DELETED");
+    const known = new Set(vms.map((vm) => vm.id));
+    const result: VmReattachResult = { adopted: [], stopped: [], terminated: [] };
+
+    const reconcileVm = async (vm: VmRecord) => {
+      const alive = liveIds.has(vm.id);
+      if (vm.state === "RUNNING" && alive && (await firecracker.adopt(vm).catch(() => false))) {
+        result.adopted.push(vm.id);
+        return;
+      }
+      if (alive) {
+        await firecracker.terminate(vm.id);
+        result.terminated.push(vm.id);
+      }
+      if (vm.state === "RUNNING" || vm.state === "STARTING" || vm.state === "STOPPING") {
+        await store.update(vm.id, { state: "STOPPED" });
+        result.stopped.push(vm.id);
+      }
+    };
+    const reconcileOrphan = async (vmId: string) => {
+      // Nothing references this jail any more (e.g. a crash halfway through recycling a VM).
+      await firecracker.terminate(vmId, { removeJail: true });
+      result.terminated.push(vmId);
+    };
+
+    const tasks = [
+      ...vms.map((vm) => () => reconcileVm(vm)),
+      ...live.filter((id) => !known.has(id)).map((id) => () => reconcileOrphan(id))
+    ];
+    await runLimited(tasks, this.options.concurrency ?? DEFAULT_CONCURRENCY);
+
+    // eslint-disable-next-line no-console
+    console.info("[vm-reattach] reconciled", {
+      adopted: result.adopted.length,
+      stopped: result.stopped.length,
+      terminated: result.terminated.length,
+      durationMs: Date.now() - started
+    });
+    return result;
+  }
+}
+
+async function runLimited(tasks: Array<() => Promise<void>>, concurrency: number): Promise<void> {
+  let next = 0;
+  const worker = async () => {
+    while (next < tasks.length) {
+      const task = tasks[next++];
+      await task().catch((err) => {
+        // eslint-disable-next-line no-console
+        console.warn("[vm-reattach] reconcile step failed", { err: String((err as any)?.message ?? err) });
+      });
+    }
+  };
+  await Promise.all(Array.from({ length: Math.max(1, Math.min(concurrency, tasks.length)) }, () => worker()));
+}
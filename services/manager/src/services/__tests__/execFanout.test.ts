@@ -0,0 +1,73 @@
+import { describe, expect, it } from "vitest";
+import { percentile, runExecFanout, type ExecFanoutResult } from "../execFanout.js";
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+describe("runExecFanout", () => {
+  it("caps in-flight execs and reports results in completion order", async () => {
+    let inFlight = 0;
+    let peak = 0;
+    const results: ExecFanoutResult[] = [];
+    const summary = await runExecFanout({
+      vmIds: ["a", "b", "c", "d", "e"],
+      concurrency: 2,
+      deadlineMs: 1000,
+      run: async (vmId) => {
+        inFlight += 1;
+        peak = Math.max(peak, inFlight);
+        await sleep(vmId === "a" ? 40 : 5);
+        inFlight -= 1;
+        return { exitCode: vmId === "c" ? 1 : 0, stdout: vmId, stderr: "" };
+      },
+      onResult: (result) => void results.push(result)
+    });
+
+    expect(peak).toBe(2);
+    expect(results.map((r) => r.vmId).indexOf("a")).toBeGreaterThan(results.map((r) => r.vmId).indexOf("b"));
+    expect(summary).toMatchObject({ total: 5, succeeded: 4, failed: 1, timedOut: 0, skipped: 0 });
+  });
+
+  it("frees the slot of a VM that misses its deadline and counts transport errors as failures", async () => {
+    const results: ExecFanoutResult[] = [];
+    const summary = await runExecFanout({
+      vmIds: ["hung", "broken", "fine"],
+      concurrency: 1,
+      deadlineMs: 20,
+      run: async (vmId) => {
+        if (vmId === "hung") return new Promise(() => undefined);
+        if (vmId === "broken") throw new Error("vsock connect failed");
+        return { exitCode: 0, stdout: "", stderr: "" };
+      },
+      onResult: (result) => void results.push(result)
+    });
+
+    expect(results[0]).toMatchObject({ vmId: "hung", ok: false, timedOut: true });
+    expect(results[1]).toMatchObject({ vmId: "broken", ok: false, error: "vsock connect failed" });
+    expect(summary).toMatchObject({ total: 3, succeeded: 1, failed: 2, timedOut: 1 });
+  });
+
+  it("skips VMs not yet started once aborted", async () => {
+    let aborted = false;
+    const summary = await runExecFanout({
+      vmIds: ["a", "b", "c"],
+      concurrency: 1,
+      deadlineMs: 1000,
+      run: async () => ({ exitCode: 0, stdout: "", stderr: "" }),
+      onResult: () => {
+        aborted = true;
+      },
+      isAborted: () => aborted
+    });
+    expect(summary).toMatchObject({ total: 3, succeeded: 1, skipped: 2 });
+  });
+});
+
+describe("percentile", () => {
+  it("uses nearest rank", () => {
+    const sorted = Array.from({ length: 100 }, (_, i) => i + 1);
+    expect(percentile(sorted, 50)).toBe(50);
+    expect(percentile(sorted, 99)).toBe(99);
+    expect(percentile([7], 99)).toBe(7);
+    expect(percentile([], 50)).toBe(0);
+  });
+});
@@ -0,0 +1,124 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { createHash } from "node:crypto";
+import { Readable } from "node:stream";
+import { afterEach, describe, expect, it } from "vitest";
+import { ImageUploadService, type ImageUploadSession } from "../imageUploadService.js";
+import type { ImageArtifactKind, ImageService } from "../imageService.js";
+
+const MAX_CHUNK = 1024;
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+function sha256(data: string): string {
+  return createHash("sha256").update(data).digest("hex");
+}
+
+function chunk(data: string): Readable {
+  return Readable.from([Buffer.from(data)]);
+}
+
+function makeFixture() {
+  const imagesDir = fs.mkdtempSync(path.join(os.tmpdir(), "image-upload-"));
+  tempDirs.push(imagesDir);
+  const blobPathFor = (hex: string) => path.join(imagesDir, ".blobs", "sha256", hex);
+  const ingested: Array<{ imageId: string; kind: ImageArtifactKind; sha256: string; srcPath?: string }> = [];
+  const images = {
+    getById: async (id: string) => (id === "img-1" || id === "img-2" ? { id } : null),
+    blobPathFor,
+    hasBlob: async (hex: string) => fs.existsSync(blobPathFor(hex)),
+    ingestArtifact: async (imageId: string, kind: ImageArtifactKind, input: { sha256: string; srcPath?: string }) => {
+      ingested.push({ imageId, kind, ...input });
+      fs.mkdirSync(path.dirname(blobPathFor(input.sha256)), { recursive: true });
+      if (input.srcPath && !fs.existsSync(blobPathFor(input.sha256))) fs.renameSync(input.srcPath, blobPathFor(input.sha256));
+    }
+  } as unknown as ImageService;
+  const service = () => new ImageUploadService(images, imagesDir);
+  return { imagesDir, ingested, service };
+}
+
+async function begin(uploads: ImageUploadService, sizeBytes: number, sha?: string): Promise<ImageUploadSession> {
+  return (await uploads.begin("img-1", { kind: "rootfs", sizeBytes, sha256: sha })) as ImageUploadSession;
+}
+
+describe("ImageUploadService", () => {
+  it("rejects a chunk at the wrong offset with 409 and keeps the session where it was", async () => {
+    const { service } = makeFixture();
+    const uploads = service();
+    const session = await begin(uploads, 8);
+    await uploads.appendChunk("img-1", session.id, 0, chunk("abcd"), MAX_CHUNK);
+
+    await expect(uploads.appendChunk("img-1", session.id, 0, chunk("abcd"), MAX_CHUNK)).rejects.toMatchObject({ statusCode: 409 });
+    await expect(uploads.appendChunk("img-1", session.id, 6, chunk("gh"), MAX_CHUNK)).rejects.toMatchObject({ statusCode: 409 });
+    expect((await uploads.get("img-1", session.id)).offset).toBe(4);
+  });
+
+  it("rejects chunks past the declared size or the chunk cap with 413 and drops their bytes", async () => {
+    const { imagesDir, service } = makeFixture();
+    const uploads = service();
+    const session = await begin(uploads, 6, sha256("abcdef"));
+    await uploads.appendChunk("img-1", session.id, 0, chunk("abc"), MAX_CHUNK);
+
+    await expect(uploads.appendChunk("img-1", session.id, 3, chunk("defg"), MAX_CHUNK)).rejects.toMatchObject({ statusCode: 413 });
+    await expect(uploads.appendChunk("img-1", session.id, 3, chunk("def"), 2)).rejects.toMatchObject({ statusCode: 413 });
+    expect((await uploads.get("img-1", session.id)).offset).toBe(3);
+    expect(fs.statSync(path.join(imagesDir, ".uploads", session.id, "data.part")).size).toBe(3);
+
+    // The running digest was not advanced by the rejected chunks.
+    await uploads.appendChunk("img-1", session.id, 3, chunk("def"), MAX_CHUNK);
+    expect(await uploads.complete("img-1", session.id)).toMatchObject({ sha256: sha256("abcdef"), deduplicated: false });
+  });
+
+  it("fails completion with 422 on a sha256 mismatch and discards the upload", async () => {
+    const { imagesDir, ingested, service } = makeFixture();
+    const uploads = service();
+    const session = await begin(uploads, 4, sha256("abcd"));
+    await uploads.appendChunk("img-1", session.id, 0, chunk("abcX"), MAX_CHUNK);
+
+    await expect(uploads.complete("img-1", session.id)).rejects.toMatchObject({ statusCode: 422 });
+    expect(ingested).toEqual([]);
+    expect(fs.existsSync(path.join(imagesDir, ".uploads", session.id))).toBe(false);
+    await expect(uploads.get("img-1", session.id)).rejects.toMatchObject({ statusCode: 404 });
+  });
+
+  it("attaches content already in the blob store without a transfer", async () => {
+    const { ingested, service } = makeFixture();
+    const uploads = service();
+    const first = await begin(uploads, 4, sha256("abcd"));
+    await uploads.appendChunk("img-1", first.id, 0, chunk("abcd"), MAX_CHUNK);
+    expect(await uploads.complete("img-1", first.id)).toMatchObject({ deduplicated: false });
+
+    const second = await uploads.begin("img-2", { kind: "rootfs", sizeBytes: 4, sha256: sha256("abcd").toUpperCase() });
+    expect(second).toEqual({ imageId: "img-2", kind: "rootfs", sha256: sha256("abcd"), sizeBytes: 4, deduplicated: true });
+    expect(ingested[1]).toEqual({ imageId: "img-2", kind: "rootfs", sha256: sha256("abcd") });
+
+    // A declared size that disagrees with the stored blob is uploaded normally.
+    const mismatched = await uploads.begin("img-2", { kind: "rootfs", sizeBytes: 5, sha256: sha256("abcd") });
+    expect(mismatched).toMatchObject({ offset: 0, sizeBytes: 5 });
+  });
+
+  it("rebuilds the running hash from the part file when resumed after a restart", async () => {
+    const { imagesDir, ingested, service } = makeFixture();
+    const session = await begin(service(), 8, sha256("abcdefgh"));
+    await service().appendChunk("img-1", session.id, 0, chunk("abcd"), MAX_CHUNK);
+    // A chunk interrupted by the restart left bytes past the committed offset.
+    fs.appendFileSync(path.join(imagesDir, ".uploads", session.id, "data.part"), "zz");
+
+    const restarted = service();
+    expect((await restarted.get("img-1", session.id)).offset).toBe(4);
+    await restarted.appendChunk("img-1", session.id, 4, chunk("efgh"), MAX_CHUNK);
+    expect(await restarted.complete("img-1", session.id)).toEqual({
+      imageId: "img-1",
+      kind: "rootfs",
+      sha256: sha256("abcdefgh"),
+      sizeBytes: 8,
+      deduplicated: false
+    });
+    expect(fs.readFileSync(path.join(imagesDir, ".blobs", "sha256", sha256("abcdefgh")), "utf-8")).toBe("abcdefgh");
+    expect(ingested).toHaveLength(1);
+  });
+});
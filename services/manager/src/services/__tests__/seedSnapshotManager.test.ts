@@ -0,0 +1,119 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { SeedSnapshotManager, type SeedClass } from "../seedSnapshotManager.js";
+import type { SnapshotMeta } from "../../types/snapshot.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+function makeStorage() {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), "seed-mgr-"));
+  tempDirs.push(root);
+  const pathsFor = async (id: string) => {
+    const dir = path.join(root, id);
+    fs.mkdirSync(dir, { recursive: true });
+    return {
+      dir,
+      memPath: path.join(dir, "mem.snap"),
+      statePath: path.join(dir, "vmstate.snap"),
+      diskPath: path.join(dir, "disk.ext4"),
+      overlayPath: path.join(dir, "overlay.ext4"),
+      workspacePath: path.join(dir, "workspace.ext4"),
+      metaPath: path.join(dir, "meta.json")
+    };
+  };
+  return {
+    root,
+    getSnapshotArtifactPaths: pathsFor,
+    listSnapshots: async () => fs.readdirSync(root),
+    readSnapshotMeta: async (id: string) => {
+      const p = path.join(root, id, "meta.json");
+      return fs.existsSync(p) ? (JSON.parse(fs.readFileSync(p, "utf-8")) as SnapshotMeta) : null;
+    }
+  };
+}
+
+function makeManager(opts: { diskBudgetBytes?: number; minRequests?: number } = {}) {
+  const storage = makeStorage();
+  const built: string[] = [];
+  const manager: SeedSnapshotManager = new SeedSnapshotManager({
+    storage,
+    defaultClass: { cpu: 1, memMb: 256 },
+    policy: { diskBudgetBytes: opts.diskBudgetBytes ?? 0, minRequests: opts.minRequests ?? 2, maxConcurrentBuilds: 1 },
+    build: async (cls: SeedClass, seedSnapshotId: string) => {
+      built.push(seedSnapshotId);
+      const paths = await storage.getSnapshotArtifactPaths(seedSnapshotId);
+      const payload = Buffer.alloc(64 * 1024, 1);
+      fs.writeFileSync(paths.memPath, payload);
+      fs.writeFileSync(paths.statePath, payload);
+      fs.writeFileSync(paths.overlayPath, payload);
+      const meta: SnapshotMeta = {
+        id: seedSnapshotId,
+        kind: "image_seed",
+        createdAt: new Date().toISOString(),
+        cpu: cls.cpu,
+        memMb: cls.memMb,
+        imageId: cls.imageId,
+        hasDisk: false,
+        hasOverlay: true,
+        internal: true,
+        imageContentKey: "k:r"
+      };
+      fs.writeFileSync(paths.metaPath, JSON.stringify(meta));
+      return meta;
+    }
+  });
+  return { manager, storage, built };
+}
+
+describe("SeedSnapshotManager", () => {
+  it("queues non-default classes only after repeated demand", async () => {
+    const { manager, built } = makeManager({ minRequests: 2 });
+    const cls = { imageId: "img", cpu: 2, memMb: 512 };
+
+    await manager.recordRequest(cls);
+    expect(manager.stats()[0]?.status).toBe("idle");
+
+    await manager.recordRequest(cls);
+    const seedId = await manager.request(cls);
+    expect(seedId).toBe("seed-img-2c-512m");
+    expect(built).toEqual(["seed-img-2c-512m"]);
+
+    const pin = await manager.acquire(cls, "k:r");
+    expect(pin?.seedSnapshotId).toBe("seed-img-2c-512m");
+    pin?.release();
+  });
+
+  it("keeps the legacy id for the default class", async () => {
+    const { manager } = makeManager();
+    expect(await manager.request({ imageId: "img", cpu: 1, memMb: 256 })).toBe("seed-img");
+  });
+
+  it("drops seeds built from different image content", async () => {
+    const { manager, storage } = makeManager();
+    const cls = { imageId: "img", cpu: 1, memMb: 256 };
+    await manager.request(cls);
+
+    expect(await manager.acquire(cls, "other:content")).toBeNull();
+    expect(fs.existsSync(path.join(storage.root, "seed-img", "mem.snap"))).toBe(false);
+  });
+
+  it("evicts the least recently used seed when over the disk budget", async () => {
+    // Each fake seed allocates ~192 KiB; a 300 KiB budget fits exactly one.
+    const { manager, storage } = makeManager({ diskBudgetBytes: 300 * 1024 });
+    const a = { imageId: "a", cpu: 1, memMb: 256 };
+    const b = { imageId: "b", cpu: 1, memMb: 256 };
+
+    await manager.request(a);
+    await manager.request(b);
+
+    expect(fs.existsSync(path.join(storage.root, "seed-a"))).toBe(false);
+    expect(fs.existsSync(path.join(storage.root, "seed-b", "mem.snap"))).toBe(true);
+    expect(await manager.acquire(a, null)).toBeNull();
+  });
+});
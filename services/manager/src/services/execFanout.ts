@@ -0,0 +1,117 @@
+type ExecOutcome = { exitCode: number; stdout: string; stderr: string; memoryPressureKilled?: boolean };
+
+export interface ExecFanoutResult {
+  vmId: string;
+  /** Exit code 0 and no transport error. */
+  ok: boolean;
+  exitCode?: number;
+  stdout?: string;
+  stderr?: string;
+  memoryPressureKilled?: boolean;
+  error?: string;
+  timedOut?: boolean;
+  durationMs: number;
+}
+
+export interface ExecFanoutSummary {
+  total: number;
+  succeeded: number;
+  failed: number;
+  timedOut: number;
+  /** VMs never started because the client went away. */
+  skipped: number;
+  p50Ms: number;
+  p99Ms: number;
+  durationMs: number;
+}
+
+export interface ExecFanoutInput {
+  vmIds: string[];
+  concurrency: number;
+  /** Host-side deadline per VM; frees the slot even when the guest never answers. */
+  deadlineMs: number;
+  run: (vmId: string) => Promise<ExecOutcome>;
+  /** Awaited before the slot takes the next VM, so a slow reader throttles the fan-out. */
+  onResult: (result: ExecFanoutResult) => Promise<void> | void;
+  isAborted?: () => boolean;
+  now?: () => number;
+}
+
+/** Run `run` over `vmIds` with at most `concurrency` in flight, reporting each result as it lands. */
+export async function runExecFanout(input: ExecFanoutInput): Promise<ExecFanoutSummary> {
+  const now = input.now ?? Date.now;
+  const startedAt = now();
+  const durations: number[] = [];
+  let next = 0;
+  let succeeded = 0;
+  let failed = 0;
+  let timedOut = 0;
+  let skipped = 0;
+
+  const runOne = async (vmId: string): Promise<ExecFanoutResult> => {
+    const t0 = now();
+    let timer: NodeJS.Timeout | undefined;
+    const deadline = new Promise<"timeout">((resolve) => {
+      timer = setTimeout(() => resolve("timeout"), input.deadlineMs);
+    });
+    try {
+      const outcome = await Promise.race([input.run(vmId), deadline]);
+      const durationMs = now() - t0;
+      if (outcome === "timeout") {
+        return { vmId, ok: false, timedOut: true, error: `no result within ${input.deadlineMs}ms`, durationMs };
+      }
+      return {
+        vmId,
+        ok: outcome.exitCode === 0,
+        exitCode: outcome.exitCode,
+        stdout: outcome.stdout,
+        stderr: outcome.stderr,
+        ...(outcome.memoryPressureKilled ? { memoryPressureKilled: true } : {}),
+        durationMs
+      };
+    } catch (err) {
+      return { vmId, ok: false, error: String((err as any)?.message ?? err), durationMs: now() - t0 };
+    } finally {
+      clearTimeout(timer);
+    }
+  };
+
+  const worker = async () => {
+    while (next < input.vmIds.length) {
+      if (input.isAborted?.()) {
+        skipped += input.vmIds.length - next;
+        next = input.vmIds.length;
+        return;
+      }
+      const vmId = input.vmIds[next++];
+      const result = await runOne(vmId);
+      durations.push(result.durationMs);
+      if (result.ok) succeeded += 1;
+      else failed += 1;
+      if (result.timedOut) timedOut += 1;
+      await input.onResult(result);
+    }
+  };
+
+  const slots = Math.max(1, Math.min(input.concurrency, input.vmIds.length));
+  await Promise.all(Array.from({ length: slots }, () => worker()));
+
+  durations.sort((a, b) => a - b);
+  return {
+    total: input.vmIds.length,
+    succeeded,
+    failed,
+    timedOut,
+    skipped,
+    p50Ms: percentile(durations, 50),
+    p99Ms: percentile(durations, 99),
+    durationMs: now() - startedAt
+  };
+}
+
+/** Nearest-rank percentile of an ascending list (0 when empty). */
+export function percentile(sorted: number[], p: number): number {
+  if (sorted.length === 0) return 0;
+  const rank = Math.ceil((p / 100) * sorted.length);
+  return sorted[Math.min(sorted.length, Math.max(1, rank)) - 1];
+}
@@ -51,6 +51,11 @@ export class ExecLogService {
     await fs.appendFile(p, JSON.stringify(entry) + "\n", "utf-8");
   }
 
+  /** Drop every entry logged for a VM, e.g. before it is handed to another tenant. */
+  async clear(logsDir: string): Promise<void> {
+    await fs.rm(path.join(logsDir, this.fileName), { force: true });
+  }
+
   async tail(
     logsDir: string,
     opts?: { limit?: number; type?: ExecLogType | "all" }
@@ -1,5 +1,6 @@
 import { eq, and, ne } from "drizzle-orm";
 import fs from "node:fs/promises";
+import { constants as fsConstants } from "node:fs";
 import path from "node:path";
 import { randomUUID } from "node:crypto";
 import { HttpError } from "../api/httpErrors.js";
@@ -17,6 +18,8 @@ export type GuestImageRow = {
   baseRootfsBytes?: number | null;
   kernelUploadedAt?: string | null;
   rootfsUploadedAt?: string | null;
+  kernelSha256?: string | null;
+  rootfsSha256?: string | null;
   seedSnapshotId?: string | null;
   seedStatus?: "pending" | "ready" | "failed" | null;
   seedUpdatedAt?: string | null;
@@ -34,11 +37,17 @@ export type ResolvedGuestImage = {
   kernelSrcPath: string;
   baseRootfsPath: string;
   baseRootfsBytes: number;
+  /** Content hashes (when known) let the storage cache share artifacts across images. */
+  kernelSha256?: string;
+  rootfsSha256?: string;
 };
 
+export type ImageArtifactKind = "kernel" | "rootfs";
+
 const DEFAULT_KERNEL_FILENAME = "vmlinux";
 const DEFAULT_ROOTFS_FILENAME = "rootfs.ext4";
 const SETTINGS_DEFAULT_IMAGE_KEY = "defaultGuestImageId";
+const SHA256_HEX = /^[0-9a-f]{64}$/;
 
 export class ImageService {
   constructor(
@@ -69,6 +78,8 @@ export class ImageService {
         baseRootfsBytes: r.baseRootfsBytes ?? null,
         kernelUploadedAt: r.kernelUploadedAt ?? null,
         rootfsUploadedAt: r.rootfsUploadedAt ?? null,
+        kernelSha256: r.kernelSha256 ?? null,
+        rootfsSha256: r.rootfsSha256 ?? null,
         seedSnapshotId: r.seedSnapshotId ?? null,
         seedStatus: r.seedStatus ?? null,
         seedUpdatedAt: r.seedUpdatedAt ?? null,
@@ -133,6 +144,8 @@ export class ImageService {
       baseRootfsBytes: r.baseRootfsBytes ?? null,
       kernelUploadedAt: r.kernelUploadedAt ?? null,
       rootfsUploadedAt: r.rootfsUploadedAt ?? null,
+      kernelSha256: r.kernelSha256 ?? null,
+      rootfsSha256: r.rootfsSha256 ?? null,
       seedSnapshotId: r.seedSnapshotId ?? null,
       seedStatus: r.seedStatus ?? null,
       seedUpdatedAt: r.seedUpdatedAt ?? null,
@@ -152,18 +165,87 @@ export class ImageService {
     return path.join(this.imagesDir, imageId, rootfsFilename || DEFAULT_ROOTFS_FILENAME);
   }
 
-  async markKernelUploaded(imageId: string, filename = DEFAULT_KERNEL_FILENAME): Promise<void> {
+  /** Scratch file on the same filesystem as the blob store, so ingest is a rename. */
+  async stagingPath(): Promise<string> {
+    const dir = path.join(this.imagesDir, ".uploads");
+    await fs.mkdir(dir, { recursive: true });
+    return path.join(dir, `direct-${randomUUID()}.part`);
+  }
+
+  /** Content-addressed store shared by all images: IMAGES_DIR/.blobs/sha256/<hex>. */
+  blobPathFor(sha256: string): string {
+    if (!SHA256_HEX.test(sha256)) throw new HttpError(400, "sha256 must be 64 lowercase hex characters");
+    return path.join(this.imagesDir, ".blobs", "sha256", sha256);
+  }
+
+  async hasBlob(sha256: string): Promise<boolean> {
+    return fs
+      .stat(this.blobPathFor(sha256))
+      .then((st) => st.isFile())
+      .catch(() => false);
+  }
+
+  /**
+   * Attach content to an image. `srcPath` (already hashed by the caller) is moved into the
+   * blob store unless identical content is already there, in which case it is discarded.
+   * Omit `srcPath` to attach an existing blob. The image file is a hard link to the blob
+   * (reflink/copy as fallback), so identical uploads under different image ids share storage.
+   */
+  async ingestArtifact(imageId: string, kind: ImageArtifactKind, input: { sha256: string; srcPath?: string }): Promise<void> {
+    const img = await this.getById(imageId);
+    if (!img) throw new HttpError(404, "Image not found");
+    const blobPath = this.blobPathFor(input.sha256);
+    await fs.mkdir(path.dirname(blobPath), { recursive: true });
+
+    if (input.srcPath) {
+      if (await this.hasBlob(input.sha256)) {
+        await fs.rm(input.srcPath, { force: true });
+      } else {
+        await fs.chmod(input.srcPath, 0o444).catch(() => undefined);
+        await fs.rename(input.srcPath, blobPath);
+      }
+    } else if (!(await this.hasBlob(input.sha256))) {
+      throw new HttpError(404, "Artifact not found");
+    }
+
+    const filename = kind === "kernel" ? DEFAULT_KERNEL_FILENAME : DEFAULT_ROOTFS_FILENAME;
+    const dest = kind === "kernel" ? this.kernelPathFor(imageId, filename) : this.rootfsPathFor(imageId, filename);
+    await fs.mkdir(path.dirname(dest), { recursive: true });
+    // Always replace via rename so the blob inode is never truncated in place.
+    const tmp = `${dest}.tmp-${randomUUID()}`;
+    try {
+      await fs.link(blobPath, tmp).catch(() => fs.copyFile(blobPath, tmp, fsConstants.COPYFILE_FICLONE));
+      await fs.rename(tmp, dest);
+    } finally {
+      await fs.rm(tmp, { force: true }).catch(() => undefined);
+    }
+
+    if (kind === "kernel") {
+      await this.markKernelUploaded(imageId, filename, input.sha256);
+    } else {
+      await this.markRootfsUploaded(imageId, filename, input.sha256);
+    }
+    const previous = kind === "kernel" ? img.kernelSha256 : img.rootfsSha256;
+    if (previous && previous !== input.sha256) {
+      await this.releaseBlob(previous);
+    }
+  }
+
+  async markKernelUploaded(imageId: string, filename = DEFAULT_KERNEL_FILENAME, sha256: string | null = null): Promise<void> {
     const now = new Date().toISOString();
-    await this.db.update(this.guestImages).set({ kernelFilename: filename, kernelUploadedAt: now }).where(eq(this.guestImages.id, imageId));
+    await this.db
+      .update(this.guestImages)
+      .set({ kernelFilename: filename, kernelUploadedAt: now, kernelSha256: sha256 })
+      .where(eq(this.guestImages.id, imageId));
   }
 
-  async markRootfsUploaded(imageId: string, filename = DEFAULT_ROOTFS_FILENAME): Promise<void> {
+  async markRootfsUploaded(imageId: string, filename = DEFAULT_ROOTFS_FILENAME, sha256: string | null = null): Promise<void> {
     const full = this.rootfsPathFor(imageId, filename);
     const st = await fs.stat(full);
     const now = new Date().toISOString();
     await this.db
       .update(this.guestImages)
-      .set({ rootfsFilename: filename, baseRootfsBytes: st.size, rootfsUploadedAt: now })
+      .set({ rootfsFilename: filename, baseRootfsBytes: st.size, rootfsUploadedAt: now, rootfsSha256: sha256 })
       .where(eq(this.guestImages.id, imageId));
   }
 
@@ -200,8 +282,12 @@ export class ImageService {
     if (inUse?.[0]) {
       throw new HttpError(409, "Image is in use by an active VM");
     }
+    const img = await this.getById(imageId);
     await this.db.delete(this.guestImages).where(eq(this.guestImages.id, imageId));
     await fs.rm(this.imageDirForId(imageId), { recursive: true, force: true }).catch(() => undefined);
+    for (const sha of [img?.kernelSha256, img?.rootfsSha256]) {
+      if (sha) await this.releaseBlob(sha);
+    }
     const def = await this.getDefaultImageId();
     if (def === imageId) {
       await this.db.delete(this.settings).where(eq(this.settings.key, SETTINGS_DEFAULT_IMAGE_KEY)).catch(() => undefined);
@@ -216,7 +302,14 @@ export class ImageService {
       const kernelSrcPath = this.kernelPathFor(img.id, img.kernelFilename);
       const baseRootfsPath = this.rootfsPathFor(img.id, img.rootfsFilename);
       const baseRootfsBytes = typeof img.baseRootfsBytes === "number" ? img.baseRootfsBytes : (await fs.stat(baseRootfsPath)).size;
-      return { imageId: img.id, kernelSrcPath, baseRootfsPath, baseRootfsBytes };
+      return {
+        imageId: img.id,
+        kernelSrcPath,
+        baseRootfsPath,
+        baseRootfsBytes,
+        kernelSha256: img.kernelSha256 ?? undefined,
+        rootfsSha256: img.rootfsSha256 ?? undefined
+      };
     }
 
     const def = await this.getDefaultImageId();
@@ -234,4 +327,13 @@ export class ImageService {
 
     throw new HttpError(400, "No default image configured; upload an image and set it as default");
   }
+
+  /** Drop a blob once no image file links to it anymore (link count back to 1). */
+  private async releaseBlob(sha256: string): Promise<void> {
+    const blobPath = this.blobPathFor(sha256);
+    const st = await fs.stat(blobPath).catch(() => null);
+    if (st && st.nlink <= 1) {
+      await fs.rm(blobPath, { force: true }).catch(() => undefined);
+    }
+  }
 }
@@ -0,0 +1,224 @@
+import fs from "node:fs/promises";
+import { createReadStream } from "node:fs";
+import path from "node:path";
+import { createHash, randomUUID, type Hash } from "node:crypto";
+import type { Readable } from "node:stream";
+import { HttpError } from "../api/httpErrors.js";
+import type { ImageArtifactKind, ImageService } from "./imageService.js";
+
+export type ImageUploadSession = {
+  id: string;
+  imageId: string;
+  kind: ImageArtifactKind;
+  sizeBytes: number;
+  /** Expected sha256 (hex) declared by the client; verified on completion when present. */
+  sha256: string | null;
+  offset: number;
+  createdAt: string;
+  updatedAt: string;
+};
+
+export type ImageUploadCompleteResult = {
+  imageId: string;
+  kind: ImageArtifactKind;
+  sha256: string;
+  sizeBytes: number;
+  deduplicated: boolean;
+};
+
+const SHA256_HEX = /^[0-9a-f]{64}$/;
+
+/**
+ * Resumable, chunked image artifact uploads.
+ *
+ * Chunks are appended to IMAGES_DIR/.uploads/<uploadId>/data.part at the session offset and
+ * hashed as they stream in. Session state lives next to the data so uploads survive manager
+ * restarts; the in-memory hash is rebuilt from the part file when it is missing.
+ * Completed uploads are handed to ImageService.ingestArtifact (content-addressed storage).
+ */
+export class ImageUploadService {
+  private readonly hashes = new Map<string, { hash: Hash; offset: number }>();
+  private readonly locks = new Map<string, Promise<unknown>>();
+
+  constructor(
+    private readonly images: ImageService,
+    private readonly imagesDir: string
+  ) {}
+
+  async begin(
+    imageId: string,
+    input: { kind: ImageArtifactKind; sizeBytes: number; sha256?: string | null }
+  ): Promise<ImageUploadSession | ImageUploadCompleteResult> {
+    const img = await this.images.getById(imageId);
+    if (!img) throw new HttpError(404, "Image not found");
+    if (input.kind !== "kernel" && input.kind !== "rootfs") throw new HttpError(400, "kind must be kernel or rootfs");
+    if (!Number.isSafeInteger(input.sizeBytes) || input.sizeBytes <= 0) throw new HttpError(400, "sizeBytes must be a positive integer");
+    const sha256 = input.sha256 ? String(input.sha256).toLowerCase() : null;
+    if (sha256 && !SHA256_HEX.test(sha256)) throw new HttpError(400, "sha256 must be 64 hex characters");
+
+    // Dedup: identical content already stored for another image needs no transfer at all.
+    if (sha256 && (await this.images.hasBlob(sha256))) {
+      const st = await fs.stat(this.images.blobPathFor(sha256));
+      if (st.size === input.sizeBytes) {
+        await this.images.ingestArtifact(imageId, input.kind, { sha256 });
+        return { imageId, kind: input.kind, sha256, sizeBytes: st.size, deduplicated: true };
+      }
+    }
+
+    const now = new Date().toISOString();
+    const session: ImageUploadSession = {
+      id: `upl-${randomUUID()}`,
+      imageId,
+      kind: input.kind,
+      sizeBytes: input.sizeBytes,
+      sha256,
+      offset: 0,
+      createdAt: now,
+      updatedAt: now
+    };
+    await fs.mkdir(this.sessionDir(session.id), { recursive: true });
+    await fs.writeFile(this.dataPath(session.id), Buffer.alloc(0));
+    await this.saveSession(session);
+    this.hashes.set(session.id, { hash: createHash("sha256"), offset: 0 });
+    return session;
+  }
+
+  async get(imageId: string, uploadId: string): Promise<ImageUploadSession> {
+    const session = await this.loadSession(uploadId);
+    if (!session || session.imageId !== imageId) throw new HttpError(404, "Upload not found");
+    return session;
+  }
+
+  /**
+   * Append one chunk at `offset`. The offset must equal the bytes already received, so a client
+   * that lost a response can GET the session and resume from the reported offset.
+   */
+  async appendChunk(imageId: string, uploadId: string, offset: number, chunk: Readable, maxChunkBytes: number): Promise<ImageUploadSession> {
+    return this.withLock(uploadId, async () => {
+      const session = await this.get(imageId, uploadId);
+      if (offset !== session.offset) {
+        throw new HttpError(409, `Offset mismatch: upload is at ${session.offset}`);
+      }
+      const hashState = await this.hashFor(session);
+      // Hash a copy so a failed chunk does not poison the running digest.
+      const chunkHash = hashState.hash.copy();
+      const handle = await fs.open(this.dataPath(uploadId), "r+");
+      let written = 0;
+      try {
+        for await (const part of chunk) {
+          const buf = Buffer.isBuffer(part) ? part : Buffer.from(part);
+          if (written + buf.length > maxChunkBytes || session.offset + written + buf.length > session.sizeBytes) {
+            throw new HttpError(413, "Chunk exceeds upload size or chunk limit");
+          }
+          await handle.write(buf, 0, buf.length, session.offset + written);
+          chunkHash.update(buf);
+          written += buf.length;
+        }
+        await handle.sync();
+      } catch (err) {
+        await handle.truncate(session.offset).catch(() => undefined);
+        throw err;
+      } finally {
+        await handle.close();
+      }
+
+      session.offset += written;
+      session.updatedAt = new Date().toISOString();
+      await this.saveSession(session);
+      this.hashes.set(uploadId, { hash: chunkHash, offset: session.offset });
+      return session;
+    });
+  }
+
+  async complete(imageId: string, uploadId: string): Promise<ImageUploadCompleteResult> {
+    return this.withLock(uploadId, async () => {
+      const session = await this.get(imageId, uploadId);
+      if (session.offset !== session.sizeBytes) {
+        throw new HttpError(409, `Upload incomplete: received ${session.offset} of ${session.sizeBytes} bytes`);
+      }
+      const digest = (await this.hashFor(session)).hash.digest("hex");
+      this.hashes.delete(uploadId);
+      if (session.sha256 && session.sha256 !== digest) {
+        await this.abortUnlocked(uploadId);
+        throw new HttpError(422, `sha256 mismatch: expected ${session.sha256}, got ${digest}`);
+      }
+      const deduplicated = await this.images.hasBlob(digest);
+      await this.images.ingestArtifact(imageId, session.kind, { sha256: digest, srcPath: this.dataPath(uploadId) });
+      await fs.rm(this.sessionDir(uploadId), { recursive: true, force: true }).catch(() => undefined);
+      return { imageId, kind: session.kind, sha256: digest, sizeBytes: session.sizeBytes, deduplicated };
+    });
+  }
+
+  async abort(imageId: string, uploadId: string): Promise<void> {
+    await this.withLock(uploadId, async () => {
+      await this.get(imageId, uploadId);
+      await this.abortUnlocked(uploadId);
+    });
+  }
+
+  private async abortUnlocked(uploadId: string): Promise<void> {
+    this.hashes.delete(uploadId);
+    await fs.rm(this.sessionDir(uploadId), { recursive: true, force: true }).catch(() => undefined);
+  }
+
+  private async hashFor(session: ImageUploadSession): Promise<{ hash: Hash; offset: number }> {
+    const cached = this.hashes.get(session.id);
+    if (cached && cached.offset === session.offset) return cached;
+
+    // Manager restarted (or state drifted): rebuild the running digest from the received prefix.
+    const hash = createHash("sha256");
+    if (session.offset > 0) {
+      await new Promise<void>((resolve, reject) => {
+        const stream = createReadStream(this.dataPath(session.id), { start: 0, end: session.offset - 1 });
+        stream.on("data", (chunk) => hash.update(chunk));
+        stream.on("error", reject);
+        stream.on("end", resolve);
+      });
+    }
+    // Drop any bytes past the committed offset left by an interrupted chunk.
+    await fs.truncate(this.dataPath(session.id), session.offset).catch(() => undefined);
+    const state = { hash, offset: session.offset };
+    this.hashes.set(session.id, state);
+    return state;
+  }
+
+  private async withLock<T>(uploadId: string, fn: () => Promise<T>): Promise<T> {
+    const prev = this.locks.get(uploadId) ?? Promise.resolve();
+    const next = prev.catch(() => undefined).then(fn);
+    this.locks.set(uploadId, next);
+    try {
+      return await next;
+    } finally {
+      if (this.locks.get(uploadId) === next) this.locks.delete(uploadId);
+    }
+  }
+
+  private uploadsRoot(): string {
+    return path.join(this.imagesDir, ".uploads");
+  }
+
+  private sessionDir(uploadId: string): string {
+    if (!/^upl-[0-9a-f-]{36}$/.test(uploadId)) throw new HttpError(404, "Upload not found");
+    return path.join(this.uploadsRoot(), uploadId);
+  }
+
+  private dataPath(uploadId: string): string {
+    return path.join(this.sessionDir(uploadId), "data.part");
+  }
+
+  private async loadSession(uploadId: string): Promise<ImageUploadSession | null> {
+    try {
+      const text = await fs.readFile(path.join(this.sessionDir(uploadId), "session.json"), "utf-8");
+      return JSON.parse(text) as ImageUploadSession;
+    } catch {
+      return null;
+    }
+  }
+
+  private async saveSession(session: ImageUploadSession): Promise<void> {
+    const target = path.join(this.sessionDir(session.id), "session.json");
+    const tmp = `${target}.tmp`;
+    await fs.writeFile(tmp, JSON.stringify(session), "utf-8");
+    await fs.rename(tmp, target);
+  }
+}
@@ -72,6 +72,34 @@ class FakeAgentClient implements AgentClient {
   async applyAllowlist(): Promise<void> {}
   async configureNetwork(): Promise<void> {}
   async syncTime(): Promise<void> {}
+  async seedEntropy(): Promise<void> {}
+  async prepareForSnapshot() {
+    return { durationMs: 0, memFreeKbBefore: 0, memFreeKbAfter: 0, zeroedBytes: 0, warnings: [] };
+  }
+  async guestStats() {
+    return {
+      uptimeSec: 0,
+      memory: { memTotalKb: 0, memAvailableKb: 0, swapTotalKb: 0, swapFreeKb: 0, swapInPages: 0, swapOutPages: 0 }
+    };
+  }
+  async listCheckpoints() {
+    return [];
+  }
+  async createCheckpoint() {
+    return { id: "ckpt", createdAt: new Date(0).toISOString() };
+  }
+  async rollbackCheckpoint() {
+    return { id: "ckpt", createdAt: new Date(0).toISOString() };
+  }
+  async resetGuestForRecycle() {
+    return {
+      durationMs: 0,
+      killedProcesses: 0,
+      removedPaths: 0,
+      restoredPaths: 0,
+      memory: await this.prepareForSnapshot()
+    };
+  }
 
   async exec(): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown }> {
     return { exitCode: 0, stdout: "", stderr: "" };
@@ -103,6 +131,14 @@ class FakeAgentClient implements AgentClient {
   ): Promise<void> {
     this.replaceTreeCalls.push({ vmId, dest, data, options });
   }
+
+  async readRawFile(): Promise<{ statusCode: 200 | 206; data: Buffer; sha256: string }> {
+    return { statusCode: 200, data: Buffer.alloc(0), sha256: "" };
+  }
+
+  async writeRawFile(_vmId: string, path: string): Promise<{ path: string; size: number; sha256: string }> {
+    return { path, size: 0, sha256: "" };
+  }
 }
 
 const tempPaths: string[] = [];
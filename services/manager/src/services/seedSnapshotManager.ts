@@ -0,0 +1,338 @@
+import fs from "node:fs/promises";
+import type { SnapshotCatalog, StorageProvider } from "../types/interfaces.js";
+import type { SnapshotMeta } from "../types/snapshot.js";
+import { allocatedBytes } from "../utils/sparseFile.js";
+
+/** A seed is only reusable by VMs of the exact same image, vCPU count and memory size. */
+export type SeedClass = { imageId: string; cpu: number; memMb: number };
+
+export type SeedStatus = "idle" | "queued" | "building" | "ready" | "failed";
+
+export interface SeedSnapshotPolicy {
+  /** Total on-disk bytes seed artifacts may use before LRU eviction kicks in (0 = unlimited). */
+  diskBudgetBytes: number;
+  /** Creates observed for a non-default class before a seed is queued for it. */
+  minRequests: number;
+  /** Seed builds boot a full VM; keep this low so they do not starve user creates. */
+  maxConcurrentBuilds: number;
+}
+
+export interface SeedSnapshotManagerOptions {
+  storage: Pick<StorageProvider, "getSnapshotArtifactPaths" | "listSnapshots" | "readSnapshotMeta">;
+  /** When set, seeds are found through the catalog and evictions remove their rows. */
+  catalog?: Pick<SnapshotCatalog, "list" | "delete">;
+  /** The class seeded eagerly (and tracked on the image row), i.e. SNAPSHOT_TEMPLATE_CPU/MEM_MB. */
+  defaultClass: { cpu: number; memMb: number };
+  policy?: Partial<SeedSnapshotPolicy>;
+  /** Boots a temp VM for `cls` and snapshots it into `seedSnapshotId`; returns the written meta. */
+  build: (cls: SeedClass, seedSnapshotId: string) => Promise<SnapshotMeta | null>;
+  now?: () => number;
+}
+
+export type SeedSnapshotStats = {
+  seedSnapshotId: string;
+  imageId: string;
+  cpu: number;
+  memMb: number;
+  status: SeedStatus;
+  score: number;
+  sizeBytes: number;
+  lastUsedAt: string | null;
+};
+
+type SeedEntry = {
+  cls: SeedClass;
+  seedSnapshotId: string;
+  status: SeedStatus;
+  /** Exponentially decayed request count; recent demand outranks old bursts. */
+  score: number;
+  requests: number;
+  scoredAt: number;
+  lastUsedAt: number;
+  failedAt: number;
+  sizeBytes: number;
+  /** Image content (kernel/rootfs sha256) the seed was built from; a re-upload makes it stale. */
+  contentKey: string | null;
+  pins: number;
+  waiters: Array<(seedSnapshotId: string | null) => void>;
+};
+
+const SCORE_HALF_LIFE_MS = 60 * 60 * 1000;
+const FAILURE_COOLDOWN_MS = 10 * 60 * 1000;
+
+const DEFAULT_POLICY: SeedSnapshotPolicy = {
+  diskBudgetBytes: 0,
+  minRequests: 2,
+  maxConcurrentBuilds: 1
+};
+
+/**
+ * Keeps image seed snapshots per (image, cpu, memMb) class.
+ *
+ * Every create records demand for its class; classes that cross `minRequests` are queued and
+ * built in the background, most-requested first. Ready seeds are evicted least-recently-used
+ * once their artifacts exceed the disk budget. Seeds are pinned while a create restores from them.
+ */
+export class SeedSnapshotManager {
+  private readonly entries = new Map<string, SeedEntry>();
+  private readonly policy: SeedSnapshotPolicy;
+  private readonly now: () => number;
+  private building = 0;
+  private loaded: Promise<void> | null = null;
+
+  constructor(private readonly options: SeedSnapshotManagerOptions) {
+    this.policy = { ...DEFAULT_POLICY, ...options.policy };
+    this.now = options.now ?? Date.now;
+  }
+
+  seedIdFor(cls: SeedClass): string {
+    // The default class keeps the historical id so seeds built by older managers stay usable.
+    if (this.isDefaultClass(cls)) return `seed-${cls.imageId}`;
+    return `seed-${cls.imageId}-${cls.cpu}c-${cls.memMb}m`;
+  }
+
+  isDefaultClass(cls: Pick<SeedClass, "cpu" | "memMb">): boolean {
+    return cls.cpu === this.options.defaultClass.cpu && cls.memMb === this.options.defaultClass.memMb;
+  }
+
+  /**
+   * Record one create for `cls` and queue a build once the class is popular enough.
+   * The default class is always queued, matching the eager per-image seed.
+   */
+  async recordRequest(cls: SeedClass): Promise<void> {
+    await this.load();
+    const entry = this.entryFor(cls);
+    this.bumpScore(entry);
+    if (entry.status === "idle" || (entry.status === "failed" && this.now() - entry.failedAt >= FAILURE_COOLDOWN_MS)) {
+      if (this.isDefaultClass(cls) || entry.requests >= this.policy.minRequests) {
+        entry.status = "queued";
+        this.pump();
+      }
+    }
+  }
+
+  /** Queue `cls` regardless of demand and resolve once its seed is ready (or the build failed). */
+  async request(cls: SeedClass, contentKey: string | null = null): Promise<string | null> {
+    await this.load();
+    const entry = this.entryFor(cls);
+    if (entry.status === "ready") {
+      if (await this.isUsable(entry, contentKey)) return entry.seedSnapshotId;
+      // Stale but pinned by an in-flight restore; the next request rebuilds it.
+      if (entry.status === "ready") return null;
+    }
+    if (entry.status === "idle" || entry.status === "failed") {
+      entry.status = "queued";
+    }
+    const done = new Promise<string | null>((resolve) => entry.waiters.push(resolve));
+    this.pump();
+    return done;
+  }
+
+  /**
+   * Pin a ready seed for `cls` so eviction leaves it alone while a create restores from it.
+   * Returns null when no usable seed exists; callers must `release()` the returned pin.
+   */
+  async acquire(cls: SeedClass, contentKey: string | null): Promise<{ seedSnapshotId: string; release: () => void } | null> {
+    await this.load();
+    const entry = this.entries.get(classKey(cls));
+    if (!entry || entry.status !== "ready") return null;
+    if (!(await this.isUsable(entry, contentKey))) return null;
+    // Re-check after the await: an eviction may have run meanwhile. Pinning is synchronous from here.
+    if (entry.status !== "ready") return null;
+    entry.pins += 1;
+    let released = false;
+    const release = () => {
+      if (released) return;
+      released = true;
+      entry.pins -= 1;
+    };
+    entry.lastUsedAt = this.now();
+    return { seedSnapshotId: entry.seedSnapshotId, release };
+  }
+
+  stats(): SeedSnapshotStats[] {
+    return [...this.entries.values()]
+      .map((e) => ({
+        seedSnapshotId: e.seedSnapshotId,
+        imageId: e.cls.imageId,
+        cpu: e.cls.cpu,
+        memMb: e.cls.memMb,
+        status: e.status,
+        score: Number(this.decayedScore(e).toFixed(3)),
+        sizeBytes: e.sizeBytes,
+        lastUsedAt: e.lastUsedAt ? new Date(e.lastUsedAt).toISOString() : null
+      }))
+      .sort((a, b) => b.score - a.score);
+  }
+
+  private pump(): void {
+    while (this.building < this.policy.maxConcurrentBuilds) {
+      const next = this.nextQueued();
+      if (!next) return;
+      this.building += 1;
+      next.status = "building";
+      void this.runBuild(next).finally(() => {
+        this.building -= 1;
+        this.pump();
+      });
+    }
+  }
+
+  private nextQueued(): SeedEntry | null {
+    let best: SeedEntry | null = null;
+    for (const entry of this.entries.values()) {
+      if (entry.status !== "queued") continue;
+      if (!best || this.decayedScore(entry) > this.decayedScore(best)) best = entry;
+    }
+    return best;
+  }
+
+  private async runBuild(entry: SeedEntry): Promise<void> {
+    let result: string | null = null;
+    try {
+      const meta = await this.options.build(entry.cls, entry.seedSnapshotId);
+      if (meta) {
+        entry.status = "ready";
+        entry.contentKey = meta.imageContentKey ?? null;
+        entry.sizeBytes = await this.artifactBytes(entry.seedSnapshotId);
+        entry.lastUsedAt = this.now();
+        result = entry.seedSnapshotId;
+        await this.enforceBudget(entry);
+      } else {
+        entry.status = "failed";
+        entry.failedAt = this.now();
+      }
+    } catch (err) {
+      entry.status = "failed";
+      entry.failedAt = this.now();
+      // eslint-disable-next-line no-console
+      console.warn("[seed-snapshot] failed", { seedSnapshotId: entry.seedSnapshotId, err: String((err as any)?.message ?? err) });
+    }
+    const waiters = entry.waiters.splice(0);
+    for (const resolve of waiters) resolve(entry.status === "ready" ? result : null);
+  }
+
+  private async enforceBudget(justBuilt: SeedEntry): Promise<void> {
+    const budget = this.policy.diskBudgetBytes;
+    if (budget <= 0) return;
+    const ready = () => [...this.entries.values()].filter((e) => e.status === "ready");
+    let total = ready().reduce((n, e) => n + e.sizeBytes, 0);
+    const candidates = ready()
+      .filter((e) => e !== justBuilt)
+      .sort((a, b) => a.lastUsedAt - b.lastUsedAt);
+    for (const victim of candidates) {
+      if (total <= budget) break;
+      if (victim.pins > 0) continue;
+      total -= victim.sizeBytes;
+      await this.evict(victim, "disk_budget");
+    }
+  }
+
+  private async evict(entry: SeedEntry, reason: string): Promise<void> {
+    entry.status = "idle";
+    entry.sizeBytes = 0;
+    entry.contentKey = null;
+    const paths = await this.options.storage.getSnapshotArtifactPaths(entry.seedSnapshotId);
+    // meta.json goes first so the catalog reconciler cannot re-adopt a half-removed seed.
+    await fs.rm(paths.metaPath, { force: true }).catch(() => undefined);
+    await this.options.catalog?.delete(entry.seedSnapshotId).catch(() => undefined);
+    // Restores hard-link mem/state into the jail, so running VMs are unaffected by the removal.
+    await fs.rm(paths.dir, { recursive: true, force: true }).catch(() => undefined);
+    // eslint-disable-next-line no-console
+    console.info("[seed-snapshot] evicted", { seedSnapshotId: entry.seedSnapshotId, reason });
+  }
+
+  private async isUsable(entry: SeedEntry, contentKey: string | null): Promise<boolean> {
+    if (contentKey && entry.contentKey && entry.contentKey !== contentKey) {
+      if (entry.pins === 0) await this.evict(entry, "stale_image_content");
+      return false;
+    }
+    const paths = await this.options.storage.getSnapshotArtifactPaths(entry.seedSnapshotId);
+    const ok = await Promise.all([fs.stat(paths.memPath), fs.stat(paths.statePath), fs.stat(paths.overlayPath)])
+      .then(() => true)
+      .catch(() => false);
+    if (!ok) {
+      entry.status = "idle";
+      entry.sizeBytes = 0;
+    }
+    return ok;
+  }
+
+  private async artifactBytes(seedSnapshotId: string): Promise<number> {
+    const paths = await this.options.storage.getSnapshotArtifactPaths(seedSnapshotId);
+    const sizes = await Promise.all(
+      // Count allocated blocks: overlays and memory files are sparse.
+      [paths.memPath, paths.statePath, paths.overlayPath].map((p) => allocatedBytes(p).catch(() => 0))
+    );
+    return sizes.reduce((n, s) => n + s, 0);
+  }
+
+  private load(): Promise<void> {
+    if (!this.loaded) this.loaded = this.loadExisting();
+    return this.loaded;
+  }
+
+  /** Adopt seeds left on disk by a previous manager process. */
+  private async loadExisting(): Promise<void> {
+    for (const meta of await this.existingSeeds()) {
+      const id = meta.id;
+      if (!id.startsWith("seed-") || meta.kind !== "image_seed" || !meta.imageId) continue;
+      const entry = this.entryFor({ imageId: meta.imageId, cpu: meta.cpu, memMb: meta.memMb });
+      if (entry.seedSnapshotId !== id) continue;
+      entry.status = "ready";
+      entry.contentKey = meta.imageContentKey ?? null;
+      entry.sizeBytes = await this.artifactBytes(id);
+      entry.lastUsedAt = Date.parse(meta.createdAt) || 0;
+    }
+  }
+
+  private async existingSeeds(): Promise<SnapshotMeta[]> {
+    const { catalog, storage } = this.options;
+    if (catalog) {
+      return (await catalog.list({ kind: "image_seed" }).catch(() => null))?.items ?? [];
+    }
+    const ids = await storage.listSnapshots().catch(() => [] as string[]);
+    const metas = await Promise.all(
+      ids.filter((id) => id.startsWith("seed-")).map((id) => storage.readSnapshotMeta(id).catch(() => null))
+    );
+    return metas.filter((meta): meta is SnapshotMeta => meta !== null);
+  }
+
+  private entryFor(cls: SeedClass): SeedEntry {
+    const key = classKey(cls);
+    let entry = this.entries.get(key);
+    if (!entry) {
+      entry = {
+        cls: { imageId: cls.imageId, cpu: cls.cpu, memMb: cls.memMb },
+        seedSnapshotId: this.seedIdFor(cls),
+        status: "idle",
+        score: 0,
+        requests: 0,
+        scoredAt: this.now(),
+        lastUsedAt: 0,
+        failedAt: 0,
+        sizeBytes: 0,
+        contentKey: null,
+        pins: 0,
+        waiters: []
+      };
+      this.entries.set(key, entry);
+    }
+    return entry;
+  }
+
+  private bumpScore(entry: SeedEntry): void {
+    entry.score = this.decayedScore(entry) + 1;
+    entry.scoredAt = this.now();
+    entry.requests += 1;
+  }
+
+  private decayedScore(entry: SeedEntry): number {
+    const age = Math.max(0, this.now() - entry.scoredAt);
+    return entry.score * Math.pow(0.5, age / SCORE_HALF_LIFE_MS);
+  }
+}
+
+function classKey(cls: SeedClass): string {
+  return `${cls.imageId}:${cls.cpu}:${cls.memMb}`;
+}
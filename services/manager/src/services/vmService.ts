@@ -1,16 +1,64 @@
-import { randomUUID } from "node:crypto";
+import { randomBytes, randomUUID } from "node:crypto";
 import fs from "node:fs/promises";
 import path from "node:path";
-import type { AgentClient, FirecrackerManager, NetworkManager, StorageProvider, VmStore } from "../types/interfaces.js";
-import type { VmCreateRequest, VmProvisionMode, VmPublic, VmRecord } from "../types/vm.js";
+import type {
+  AgentClient,
+  FirecrackerManager,
+  NetworkManager,
+  SnapshotCatalog,
+  SnapshotListQuery,
+  SnapshotPage,
+  StorageProvider,
+  VmStore
+} from "../types/interfaces.js";
+import type {
+  VmCreateRequest,
+  VmGuestStats,
+  VmIoStats,
+  VmIoTier,
+  VmProvisionMode,
+  VmPublic,
+  VmRawFileReadResult,
+  VmRawFileWriteResult,
+  VmRecord,
+  VmWorkspaceCheckpoint
+} from "../types/vm.js";
 import type { SnapshotMeta } from "../types/snapshot.js";
 import { HttpError } from "../api/httpErrors.js";
+import { HUGE_PAGE_MB } from "../firecracker/hugePages.js";
+import { IO_TIERS } from "../firecracker/ioTiers.js";
+import { readLogTail } from "../firecracker/logCollector.js";
+import { rebaseVmPath } from "../firecracker/socketPaths.js";
 import type { ActivityService } from "../telemetry/activityService.js";
 import type { ImageService } from "./imageService.js";
 import { ExecLogService } from "./execLogService.js";
+import { SeedSnapshotManager, type SeedClass, type SeedSnapshotPolicy } from "./seedSnapshotManager.js";
+import { runExecFanout, type ExecFanoutResult, type ExecFanoutSummary } from "./execFanout.js";
 import type { PeerService } from "./peer/peerService.js";
 
 const LOG_FILES = new Set(["firecracker.log", "firecracker.stdout.log", "firecracker.stderr.log"]);
+const MAX_FANOUT_VM_IDS = 1000;
+/** Slack on top of the guest-side exec timeout before a fan-out slot gives up on a VM. */
+const FANOUT_DEADLINE_GRACE_MS = 5_000;
+
+export interface ExecFanoutRequest {
+  /** Running VMs matching every given field; `all: true` must be explicit to target the whole fleet. */
+  selector: { vmIds?: string[]; imageId?: string; all?: boolean };
+  cmd: string;
+  cwd?: string;
+  env?: Record<string, string>;
+  timeoutMs?: number;
+  concurrency?: number;
+}
+
+export interface ExecFanoutPlan {
+  vmIds: string[];
+  /** Selected by id but not runnable; reported as failed results without an exec. */
+  unavailable: Array<{ vmId: string; error: string }>;
+  payload: { cmd: string; cwd?: string; env?: Record<string, string>; timeoutMs?: number };
+  concurrency: number;
+  deadlineMs: number;
+}
 
 export interface VmServiceOptions {
   store: VmStore;
@@ -18,10 +66,12 @@ export interface VmServiceOptions {
   network: NetworkManager;
   agentClient: AgentClient;
   storage: StorageProvider;
+  snapshotCatalog: SnapshotCatalog;
   images: ImageService;
   peerService?: PeerService;
   activity?: ActivityService;
   snapshots?: { enabled: boolean; version: string; templateCpu: number; templateMemMb: number };
+  seedSnapshots?: Partial<SeedSnapshotPolicy>;
   vsockCidStart?: number;
   dnsServerIp?: string;
   limits?: {
@@ -31,11 +81,20 @@ export interface VmServiceOptions {
     maxAllowIps: number;
     maxExecTimeoutMs: number;
     maxRunTsTimeoutMs: number;
+    maxWorkspaceDiskMb?: number;
+    /** Upper bound on VMs a single exec fan-out runs at once. */
+    maxFanoutConcurrency?: number;
   };
+  /** Rate-limit tier for VMs created without an explicit `ioTier`. Default "unlimited". */
+  defaultIoTier?: VmIoTier;
+  /** Back guest memory with hugepages for VMs created without an explicit `hugePages`. Default false. */
+  defaultHugePages?: boolean;
   warmPool?: {
     enabled: boolean;
     target: number;
     maxVms: number;
+    /** Reset and reuse eligible VMs on destroy instead of tearing them down. */
+    recycle?: boolean;
   };
 }
 
@@ -45,17 +104,21 @@ export class VmService {
   private readonly network: NetworkManager;
   private readonly agentClient: AgentClient;
   private readonly storage: StorageProvider;
+  private readonly snapshotCatalog: SnapshotCatalog;
   private readonly images: ImageService;
   readonly peerService?: PeerService;
   private readonly activity?: ActivityService;
   private readonly snapshots?: { enabled: boolean; version: string; templateCpu: number; templateMemMb: number };
   private readonly limits: NonNullable<VmServiceOptions["limits"]>;
   private readonly dnsServerIp?: string;
-  private readonly warmPool?: { enabled: boolean; target: number; maxVms: number };
+  private readonly defaultIoTier: VmIoTier;
+  private readonly defaultHugePages: boolean;
+  private readonly warmPool?: NonNullable<VmServiceOptions["warmPool"]>;
   private nextVsockCid: number;
   private readonly execLogs: ExecLogService;
-  private readonly seedBuilds = new Map<string, Promise<string | null>>();
+  private readonly seeds: SeedSnapshotManager;
   private readonly warmPoolVmIds = new Set<string>();
+  private readonly recyclingVmIds = new Set<string>();
   private warmTopupRunning = false;
 
   constructor(options: VmServiceOptions) {
@@ -64,13 +127,23 @@ export class VmService {
     this.network = options.network;
     this.agentClient = options.agentClient;
     this.storage = options.storage;
+    this.snapshotCatalog = options.snapshotCatalog;
     this.images = options.images;
     this.peerService = options.peerService;
     this.activity = options.activity;
     this.snapshots = options.snapshots;
     this.dnsServerIp = options.dnsServerIp;
+    this.defaultIoTier = options.defaultIoTier ?? "unlimited";
+    this.defaultHugePages = options.defaultHugePages ?? false;
     this.warmPool = options.warmPool;
     this.execLogs = new ExecLogService();
+    this.seeds = new SeedSnapshotManager({
+      storage: this.storage,
+      catalog: this.snapshotCatalog,
+      defaultClass: { cpu: this.snapshots?.templateCpu ?? 1, memMb: this.snapshots?.templateMemMb ?? 256 },
+      policy: options.seedSnapshots,
+      build: (cls, seedSnapshotId) => this.buildImageSeedSnapshot(cls, seedSnapshotId)
+    });
     this.limits = options.limits ?? {
       maxVms: 20,
       maxCpu: 4,
@@ -112,15 +185,30 @@ export class VmService {
 
     const requestedOverlaySnapshotId = normalizeSnapshotId(request.userOverlaySnapshotId ?? request.snapshotId);
     if (requestedOverlaySnapshotId && !request.userOverlaySnapshotId) {
-      const legacy = await this.storage.readSnapshotMeta(requestedOverlaySnapshotId);
+      const legacy = await this.snapshotCatalog.get(requestedOverlaySnapshotId);
       // Backward compatibility: old "vm"/"template" snapshots via snapshotId keep legacy semantics.
       if (legacy && (legacy.kind === "vm" || legacy.kind === "template") && legacy.hasDisk && !legacy.baseSeedSnapshotId) {
+        if (request.workspaceDiskMb) {
+          throw new HttpError(400, "workspaceDiskMb is not supported with legacy snapshots");
+        }
+        // The restored memory image keeps the page size it was taken with (4 KiB).
+        if (request.hugePages) {
+          throw new HttpError(400, "hugePages is not supported with legacy snapshots");
+        }
         return this.createWithLegacySnapshotRestore(request, requestedOverlaySnapshotId);
       }
     }
 
     // Optional warm pool checkout path (only for plain creates without user overlay snapshot).
-    if (this.warmPool?.enabled && !requestedOverlaySnapshotId && !internal?.skipWarmCheckout && !(request.peerLinks?.length) && !(request.secretEnv?.length)) {
+    // Pool VMs have no workspace disk and one cannot be hot-attached.
+    if (
+      this.warmPool?.enabled &&
+      !requestedOverlaySnapshotId &&
+      !internal?.skipWarmCheckout &&
+      !(request.peerLinks?.length) &&
+      !(request.secretEnv?.length) &&
+      !request.workspaceDiskMb
+    ) {
       const fromPool = await this.tryCheckoutWarmVm(request);
       if (fromPool) return fromPool;
     }
@@ -130,6 +218,7 @@ export class VmService {
     const DEFAULT_DISK_MB = 512;
     const DEFAULT_DISK_HEADROOM_MB = 256;
 
+    const hugePages = request.hugePages ?? this.defaultHugePages;
     const tTotalStart = Date.now();
     const id = randomUUID();
     const createdAt = new Date().toISOString();
@@ -152,6 +241,8 @@ export class VmService {
     const prepared = await this.storage.prepareVmStorage(id, {
       kernelSrcPath: resolved.kernelSrcPath,
       baseRootfsPath: resolved.baseRootfsPath,
+      kernelSha256: resolved.kernelSha256,
+      rootfsSha256: resolved.rootfsSha256,
       diskSizeBytes: mbToBytes(requestedMb)
     });
     const rootfsPath = prepared.rootfsPath;
@@ -166,12 +257,36 @@ export class VmService {
       void this.ensureImageSeedSnapshot(imageId);
     }
 
+    // Restore from a seed of this exact (image, cpu, memMb) class when one is ready. User overlay
+    // baselines carry their own disk state, which the seed's memory image would not match; seeds
+    // also have no workspace drive, so workspace VMs always cold boot. Seeds are 4 KiB-page memory
+    // images and Firecracker only restores hugepage memory through a UFFD handler, so hugepage VMs
+    // cold boot as well.
+    let seedPin: Awaited<ReturnType<SeedSnapshotManager["acquire"]>> = null;
+    if (imageId && overlayPath && !requestedOverlaySnapshotId && !request.workspaceDiskMb && !hugePages) {
+      const seedClass: SeedClass = { imageId, cpu: request.cpu, memMb: request.memMb };
+      seedPin = await this.seeds.acquire(seedClass, imageContentKey(resolved)).catch(() => null);
+      void this.seeds.recordRequest(seedClass).catch(() => undefined);
+      if (seedPin) {
+        const tSnapshotStageStart = Date.now();
+        const seedPaths = await this.storage.getSnapshotArtifactPaths(seedPin.seedSnapshotId);
+        await this.storage.cloneDisk(seedPaths.overlayPath, overlayPath).catch((err) => {
+          seedPin?.release();
+          throw err;
+        });
+        baseSeedSnapshotId = seedPin.seedSnapshotId;
+        snapshotStageMs = Date.now() - tSnapshotStageStart;
+      }
+    }
+
+    let workspaceDiskMb = request.workspaceDiskMb;
+    let workspaceSrcPath: string | undefined;
     if (requestedOverlaySnapshotId) {
       if (!overlayPath) {
         throw new HttpError(500, "OverlayFS storage is required for user overlay snapshots");
       }
       const tSnapshotStageStart = Date.now();
-      const meta = await this.storage.readSnapshotMeta(requestedOverlaySnapshotId);
+      const meta = await this.snapshotCatalog.get(requestedOverlaySnapshotId);
       if (!meta) {
         throw new HttpError(404, "User overlay snapshot not found");
       }
@@ -182,11 +297,34 @@ export class VmService {
         throw new HttpError(400, `Snapshot image mismatch: snapshot=${meta.imageId} vm=${imageId}`);
       }
 
-      const src = await this.resolveOverlayBaselinePath(requestedOverlaySnapshotId, meta);
-      await this.storage.cloneDisk(src, overlayPath);
-      baseSeedSnapshotId = meta.baseSeedSnapshotId ?? baseSeedSnapshotId;
+      if (meta.hasWorkspace) {
+        // Workspace snapshots hold only user data; the system overlay starts fresh from the image.
+        const snapshotMb = meta.workspaceDiskMb ?? 0;
+        workspaceDiskMb = workspaceDiskMb ?? snapshotMb;
+        if (workspaceDiskMb < snapshotMb) {
+          throw new HttpError(400, `workspaceDiskMb too small for snapshot (min=${snapshotMb})`);
+        }
+        workspaceSrcPath = (await this.storage.getSnapshotArtifactPaths(requestedOverlaySnapshotId)).workspacePath;
+      } else {
+        if (workspaceDiskMb) {
+          throw new HttpError(400, "Snapshot has no workspace disk; omit workspaceDiskMb");
+        }
+        const src = await this.resolveOverlayBaselinePath(requestedOverlaySnapshotId, meta);
+        await this.storage.cloneDisk(src, overlayPath);
+        baseSeedSnapshotId = meta.baseSeedSnapshotId ?? baseSeedSnapshotId;
+      }
       snapshotStageMs = Date.now() - tSnapshotStageStart;
     }
+    let workspaceDiskPath: string | null = null;
+    if (workspaceDiskMb) {
+      if (!overlayPath) {
+        throw new HttpError(500, "OverlayFS storage is required for a workspace disk");
+      }
+      workspaceDiskPath = await this.storage.prepareWorkspaceDisk(id, {
+        sizeBytes: mbToBytes(workspaceDiskMb),
+        srcPath: workspaceSrcPath
+      });
+    }
     const storageMs = Date.now() - tStorageStart;
     const peerPatch = (await this.peerService?.buildCreatePatch(request, id)) ?? {};
 
@@ -203,6 +341,9 @@ export class VmService {
       imageId,
       rootfsPath,
       overlayPath,
+      ...(workspaceDiskPath ? { workspaceDiskPath, workspaceDiskMb } : {}),
+      ioTier: request.ioTier ?? this.defaultIoTier,
+      hugePages,
       kernelPath,
       logsDir,
       createdAt,
@@ -228,10 +369,14 @@ export class VmService {
       let networkMs = 0;
       const allowManagerGateway = hasPeerLinksInRequest(request);
 
-      let snapshotIdForBoot: string | undefined;
+      let snapshotIdForBoot: string | undefined = seedPin?.seedSnapshotId;
       const canUseLegacyTemplateSnapshot =
-        Boolean(this.snapshots?.enabled) && request.cpu === this.snapshots!.templateCpu && request.memMb === this.snapshots!.templateMemMb;
-      if (canUseLegacyTemplateSnapshot) {
+        Boolean(this.snapshots?.enabled) &&
+        !workspaceDiskPath &&
+        !hugePages &&
+        request.cpu === this.snapshots!.templateCpu &&
+        request.memMb === this.snapshots!.templateMemMb;
+      if (!snapshotIdForBoot && canUseLegacyTemplateSnapshot) {
         snapshotIdForBoot = this.snapshots!.version;
       }
 
@@ -270,6 +415,8 @@ export class VmService {
           }
         }
       }
+      // Restore has linked mem/state into the jail; the seed may be evicted from here on.
+      seedPin?.release();
 
       if (mode === "boot") {
         const tNetworkStart = Date.now();
@@ -286,6 +433,8 @@ export class VmService {
       const agentHealthMs = Date.now() - tAgentHealthStart;
       // Keep guest clock in sync so TLS validation works reliably (cert NotValidYet issues are usually clock skew).
       await this.agentClient.syncTime(vm.id, { unixTimeMs: Date.now() }).catch(() => undefined);
+      // Cold boots get their seed here too: over vsock it stays out of the guest-visible kernel cmdline.
+      await this.reseedGuestEntropy(vm.id);
 
       // After snapshot restore, reconfigure guest networking over VSock, then bring the tap up.
       if (mode === "snapshot") {
@@ -316,7 +465,11 @@ export class VmService {
       }
 
       await this.agentClient.applyAllowlist(vm.id, request.allowIps, vm.outboundInternet, { allowManagerGateway });
-      await this.store.update(vm.id, { state: "RUNNING", provisionMode: mode });
+      await this.store.update(vm.id, {
+        state: "RUNNING",
+        provisionMode: mode,
+        memoryPageSizeKb: this.firecracker.memoryPageSizeKb(vm.id)
+      });
       await this.peerService?.onVmRunning(vm.id);
       await this.activity?.logEvent({
         type: "vm.started",
@@ -344,6 +497,7 @@ export class VmService {
         this.scheduleWarmPoolTopup();
       }
     } catch (error) {
+      seedPin?.release();
       await this.store.update(vm.id, { state: "ERROR" });
       throw error;
     }
@@ -369,7 +523,7 @@ export class VmService {
 
     const tStorageStart = Date.now();
     const snap = await this.storage.getSnapshotArtifactPaths(snapshotId);
-    const meta = await this.storage.readSnapshotMeta(snapshotId);
+    const meta = await this.snapshotCatalog.get(snapshotId);
     if (!meta || !meta.hasDisk) {
       throw new HttpError(404, "Snapshot not found or missing disk baseline");
     }
@@ -382,7 +536,7 @@ export class VmService {
     if (!hasAll) {
       throw new HttpError(409, "Snapshot artifacts missing on disk");
     }
-    const diskBytes = (await fs.stat(snap.diskPath)).size;
+    const diskBytes = await this.storage.diskSize(snap.diskPath);
     const resolved = await this.images.resolveForVmCreate(meta.imageId ?? request.imageId);
     const imageId = resolved.imageId;
     const minMb = minDiskMb(diskBytes);
@@ -395,6 +549,7 @@ export class VmService {
     }
     const prepared = await this.storage.prepareVmStorageFromDisk(id, {
       kernelSrcPath: resolved.kernelSrcPath,
+      kernelSha256: resolved.kernelSha256,
       diskSrcPath: snap.diskPath,
       diskSizeBytes: mbToBytes(requestedMb)
     });
@@ -414,6 +569,7 @@ export class VmService {
       imageId,
       rootfsPath: prepared.rootfsPath,
       overlayPath: prepared.overlayPath,
+      ioTier: request.ioTier ?? this.defaultIoTier,
       kernelPath: prepared.kernelPath,
       logsDir: prepared.logsDir,
       createdAt,
@@ -458,6 +614,7 @@ export class VmService {
       const tAgentHealthStart = Date.now();
       await this.agentClient.health(vm.id);
       const agentHealthMs = Date.now() - tAgentHealthStart;
+      await this.reseedGuestEntropy(vm.id);
 
       await this.agentClient.configureNetwork(vm.id, {
         iface: "eth0",
@@ -472,7 +629,11 @@ export class VmService {
       networkMs += Date.now() - tBringTapStart;
 
       await this.agentClient.applyAllowlist(vm.id, request.allowIps, vm.outboundInternet, { allowManagerGateway });
-      await this.store.update(vm.id, { state: "RUNNING", provisionMode: mode });
+      await this.store.update(vm.id, {
+        state: "RUNNING",
+        provisionMode: mode,
+        memoryPageSizeKb: this.firecracker.memoryPageSizeKb(vm.id)
+      });
       await this.peerService?.onVmRunning(vm.id);
       const totalMs = Date.now() - tTotalStart;
       // eslint-disable-next-line no-console
@@ -523,11 +684,13 @@ export class VmService {
     if (!vm.overlayPath) {
       throw new HttpError(409, "OverlayFS snapshot requires a writable overlay disk");
     }
-    await syncDiskFile(vm.overlayPath);
-    const paths = await this.storage.getSnapshotArtifactPaths(snapshotId);
+    // With a workspace disk only user data is captured; the system overlay is ephemeral.
+    const sourceDiskPath = vm.workspaceDiskPath ?? vm.overlayPath;
+    await syncDiskFile(sourceDiskPath);
+    const paths = await this.storage.getSnapshotArtifactPaths(snapshotId, { create: true });
 
     // User snapshots are flattened overlay baselines only (no mem/state dependency).
-    await this.storage.cloneDisk(vm.overlayPath, paths.overlayPath);
+    await this.storage.cloneDisk(sourceDiskPath, vm.workspaceDiskPath ? paths.workspacePath : paths.overlayPath);
     await Promise.all([
       fs.rm(paths.memPath, { force: true }).catch(() => undefined),
       fs.rm(paths.statePath, { force: true }).catch(() => undefined),
@@ -544,9 +707,10 @@ export class VmService {
       baseSeedSnapshotId: vm.baseSeedSnapshotId,
       sourceVmId: vm.id,
       hasDisk: false,
-      hasOverlay: true
+      hasOverlay: !vm.workspaceDiskPath,
+      ...(vm.workspaceDiskPath ? { hasWorkspace: true, workspaceDiskMb: vm.workspaceDiskMb } : {})
     };
-    await fs.writeFile(paths.metaPath, JSON.stringify(meta, null, 2), "utf-8");
+    await this.recordSnapshot(paths, meta);
     await this.activity?.logEvent({
       type: "snapshot.created",
       entityType: "snapshot",
@@ -557,60 +721,55 @@ export class VmService {
     return meta;
   }
 
-  async listSnapshots(scope: "user" | "internal" | "all" = "user"): Promise<SnapshotMeta[]> {
-    const ids = await this.storage.listSnapshots();
-    const items = await Promise.all(
-      ids.map(async (sid) => {
-        const meta = await this.storage.readSnapshotMeta(sid);
-        return meta;
-      })
-    );
-    const metas = items.filter(Boolean) as SnapshotMeta[];
-    if (scope === "all") return metas;
-    if (scope === "internal") {
-      return metas.filter((m) => m.kind === "image_seed" || m.kind === "template" || m.internal === true);
+  async listSnapshots(
+    scope: "user" | "internal" | "all" = "user",
+    page: Omit<SnapshotListQuery, "scope"> = {}
+  ): Promise<SnapshotPage> {
+    return this.snapshotCatalog.list({ ...page, scope });
+  }
+
+  async countSnapshots(): Promise<{ snapshots: number; templates: number }> {
+    return this.snapshotCatalog.counts();
+  }
+
+  /**
+   * Publish a snapshot whose artifacts are complete: meta.json first, then the catalog row.
+   * If the row cannot be written the snapshot is removed so disk and catalog never disagree.
+   */
+  private async recordSnapshot(paths: { dir: string; metaPath: string }, meta: SnapshotMeta): Promise<void> {
+    await fs.writeFile(paths.metaPath, JSON.stringify(meta, null, 2), "utf-8");
+    try {
+      await this.snapshotCatalog.put(meta);
+    } catch (err) {
+      await fs.rm(paths.dir, { recursive: true, force: true }).catch(() => undefined);
+      throw err;
     }
-    // user scope
-    return metas.filter((m) => m.kind === "user_overlay" || m.kind === "vm");
   }
 
+  /**
+   * Ensure the default-class seed (SNAPSHOT_TEMPLATE_CPU/MEM_MB) exists for an image.
+   * Seeds for other sizes are queued on demand by `create()`.
+   */
   async ensureImageSeedSnapshot(imageId: string): Promise<string | null> {
     const current = await this.images.getById(imageId);
     if (!current || !current.kernelFilename || !current.rootfsFilename) {
       return null;
     }
-    if (current.seedStatus === "ready" && current.seedSnapshotId) {
-      const paths = await this.storage.getSnapshotArtifactPaths(current.seedSnapshotId);
-      const ok = await Promise.all([fs.stat(paths.memPath), fs.stat(paths.statePath), fs.stat(paths.overlayPath)])
-        .then(() => true)
-        .catch(() => false);
-      if (ok) return current.seedSnapshotId;
-    }
-
-    const existing = this.seedBuilds.get(imageId);
-    if (existing) return existing;
-
-    const build = this.buildImageSeedSnapshot(imageId)
-      .catch((err) => {
-        // eslint-disable-next-line no-console
-        console.warn("[seed-snapshot] failed", { imageId, err: String((err as any)?.message ?? err) });
-        return null;
-      })
-      .finally(() => {
-        this.seedBuilds.delete(imageId);
-      });
-    this.seedBuilds.set(imageId, build);
-    return build;
+    const resolved = await this.images.resolveForVmCreate(imageId);
+    return this.seeds.request(
+      { imageId, cpu: this.snapshots?.templateCpu ?? 1, memMb: this.snapshots?.templateMemMb ?? 256 },
+      imageContentKey(resolved)
+    );
   }
 
-  private async buildImageSeedSnapshot(imageId: string): Promise<string | null> {
+  private async buildImageSeedSnapshot(cls: SeedClass, seedSnapshotId: string): Promise<SnapshotMeta | null> {
+    const { imageId, cpu: seedCpu, memMb: seedMemMb } = cls;
     const image = await this.images.getById(imageId);
     if (!image || !image.kernelFilename || !image.rootfsFilename) return null;
 
-    await this.images.markSeedPending(imageId);
-    const seedSnapshotId = `seed-${imageId}`;
-    const seedCpu = this.snapshots?.templateCpu ?? 1;
-    const seedMemMb = this.snapshots?.templateMemMb ?? 256;
+    // Only the default class is reflected on the image row; other classes are tracked by the seed manager.
+    const tracksImageRow = this.seeds.isDefaultClass(cls);
+    if (tracksImageRow) await this.images.markSeedPending(imageId);
 
     // Keep temp VM id short to stay under UNIX socket path limits in jailer temp roots.
     const tempVmId = randomUUID();
@@ -619,10 +778,13 @@ export class VmService {
     const resolved = await this.images.resolveForVmCreate(imageId);
     const storage = await this.storage.prepareVmStorage(tempVmId, {
       kernelSrcPath: resolved.kernelSrcPath,
-      baseRootfsPath: resolved.baseRootfsPath
+      baseRootfsPath: resolved.baseRootfsPath,
+      kernelSha256: resolved.kernelSha256,
+      rootfsSha256: resolved.rootfsSha256
     });
     if (!storage.overlayPath) {
-      await this.images.markSeedFailed(imageId, "overlay disk not available for seed snapshot");
+      if (tracksImageRow) await this.images.markSeedFailed(imageId, "overlay disk not available for seed snapshot");
+      await this.storage.cleanupVmStorage(tempVmId).catch(() => undefined);
       return null;
     }
 
@@ -644,12 +806,22 @@ export class VmService {
       createdAt
     };
 
-    const snapshotPaths = await this.storage.getSnapshotArtifactPaths(seedSnapshotId);
+    const snapshotPaths = await this.storage.getSnapshotArtifactPaths(seedSnapshotId, { create: true });
     try {
       await this.network.configure(vm, tapName, { up: false });
       await this.firecracker.createAndStart(vm, vm.rootfsPath, vm.kernelPath, tapName, vm.overlayPath);
       // Seed build VMs can take longer to expose the vsock endpoint; tolerate slower health readiness.
       await this.waitForAgentHealth(vm.id, 30_000);
+      // Shrink the captured memory (caches, garbage, stale free pages); older guest images lack the endpoint.
+      const prepared = await this.agentClient.prepareForSnapshot(vm.id).catch((err) => {
+        // eslint-disable-next-line no-console
+        console.warn("[seed-snapshot] guest prepare failed", { seedSnapshotId, err: String((err as any)?.message ?? err) });
+        return null;
+      });
+      if (prepared) {
+        // eslint-disable-next-line no-console
+        console.info("[seed-snapshot] guest prepared", { seedSnapshotId, ...prepared });
+      }
       await this.firecracker.createSnapshot(vm, { memPath: snapshotPaths.memPath, statePath: snapshotPaths.statePath });
       await this.storage.cloneDisk(vm.overlayPath!, snapshotPaths.overlayPath);
       await fs.rm(snapshotPaths.diskPath, { force: true }).catch(() => undefined);
@@ -662,21 +834,24 @@ export class VmService {
         imageId,
         hasDisk: false,
         hasOverlay: true,
-        internal: true
+        internal: true,
+        imageContentKey: imageContentKey(resolved)
       };
-      await fs.writeFile(snapshotPaths.metaPath, JSON.stringify(meta, null, 2), "utf-8");
-      await this.images.markSeedReady(imageId, seedSnapshotId);
+      await this.recordSnapshot(snapshotPaths, meta);
+      if (tracksImageRow) await this.images.markSeedReady(imageId, seedSnapshotId);
       await this.activity?.logEvent({
         type: "snapshot.seed_ready",
         entityType: "image",
         entityId: imageId,
-        message: "Image seed snapshot ready",
-        meta: { imageId, seedSnapshotId }
+        message: `Image seed snapshot ready (${seedCpu} vCPU, ${seedMemMb} MiB)`,
+        meta: { imageId, seedSnapshotId, cpu: seedCpu, memMb: seedMemMb }
       });
-      return seedSnapshotId;
+      return meta;
     } catch (err: any) {
-      await this.images.markSeedFailed(imageId, String(err?.message ?? err));
-      return null;
+      if (tracksImageRow) await this.images.markSeedFailed(imageId, String(err?.message ?? err));
+      // Do not leave half-written artifacts behind for the next lookup to trip over.
+      await fs.rm(snapshotPaths.dir, { recursive: true, force: true }).catch(() => undefined);
+      throw err;
     } finally {
       await this.firecracker.destroy(vm).catch(() => undefined);
       await this.network.teardown(vm, tapName).catch(() => undefined);
@@ -684,6 +859,19 @@ export class VmService {
     }
   }
 
+  /**
+   * Post a fresh host seed over vsock, which the guest credits and reseeds its CRNG from. Restored
+   * VMs resume with the CRNG state captured in the snapshot, so every clone of one snapshot would
+   * otherwise produce the same random stream until the kernel reseeds; cold boots get one too, as
+   * the seed is never put anywhere the guest's own processes can read it back.
+   */
+  private async reseedGuestEntropy(vmId: string): Promise<void> {
+    await this.agentClient.seedEntropy(vmId, { seedHex: randomBytes(32).toString("hex") }).catch((err) => {
+      // eslint-disable-next-line no-console
+      console.warn("[vm-provision] guest entropy reseed failed", { vmId, err: String((err as any)?.message ?? err) });
+    });
+  }
+
   private async waitForAgentHealth(vmId: string, timeoutMs: number): Promise<void> {
     const started = Date.now();
     let lastErr: unknown;
@@ -713,11 +901,27 @@ export class VmService {
       }
       if (vm.cpu !== request.cpu || vm.memMb !== request.memMb) continue;
       if ((vm.imageId ?? "") !== (resolved.imageId ?? "")) continue;
+      // Page size is fixed when guest memory is mapped at boot; a hugepage VM that fell back to
+      // 4 KiB pages is not what a hugepage request asked for.
+      if ((vm.memoryPageSizeKb === HUGE_PAGE_MB * 1024) !== (request.hugePages ?? this.defaultHugePages)) continue;
 
       this.warmPoolVmIds.delete(vmId);
+      // Pool VMs boot with the default tier; retune the running VM's rate limiters in place.
+      const ioTier = request.ioTier ?? this.defaultIoTier;
+      if ((vm.ioTier ?? "unlimited") !== ioTier) {
+        try {
+          await this.firecracker.updateIoTier(vm, ioTier);
+        } catch (err) {
+          this.warmPoolVmIds.add(vmId);
+          // eslint-disable-next-line no-console
+          console.warn("[warm-pool] io tier update failed; cold creating instead", { vmId, err: String(err) });
+          return null;
+        }
+      }
       await this.store.update(vm.id, {
         allowIps: request.allowIps,
         outboundInternet: request.outboundInternet ?? false,
+        ioTier,
         poolTag: undefined
       });
       const latest = await this.store.get(vm.id);
@@ -748,13 +952,23 @@ export class VmService {
     const target = Math.min(Math.max(0, this.warmPool.target), this.warmPool.maxVms);
     if (target === 0) return;
 
-    const currentWarm = (await this.store.list()).filter((vm) => vm.poolTag === "warm" && vm.state !== "DELETED");
+    const warm = (await this.store.list()).filter((vm) => vm.poolTag === "warm" && vm.state !== "DELETED");
+    // Pool VMs the reattach pass could not adopt after a manager restart are never checked out; replace them.
+    for (const vm of warm.filter((candidate) => candidate.state === "STOPPED")) {
+      await this.destroy(vm.id).catch((err) => {
+        // eslint-disable-next-line no-console
+        console.warn("[warm-pool] failed to discard stopped warm VM", { vmId: vm.id, err: String((err as any)?.message ?? err) });
+      });
+    }
+    const currentWarm = warm.filter((vm) => vm.state !== "STOPPED");
     for (const vm of currentWarm) {
       this.warmPoolVmIds.add(vm.id);
     }
-    if (currentWarm.length >= target) return;
+    // VMs being recycled will rejoin the pool shortly; don't boot replacements for them.
+    const pending = currentWarm.length + this.recyclingVmIds.size;
+    if (pending >= target) return;
 
-    const deficit = Math.min(target - currentWarm.length, this.warmPool.maxVms);
+    const deficit = Math.min(target - pending, this.warmPool.maxVms);
     for (let i = 0; i < deficit; i += 1) {
       try {
         const image = await this.images.resolveForVmCreate(undefined);
@@ -785,31 +999,53 @@ export class VmService {
 
     try {
       // Re-prepare VM storage since the jailer directory was cleaned up when the VM was stopped.
-      // Use the persistent disk (saved during stop) to preserve user data.
+      // The persistent disk (saved during stop) is linked into the jail, not copied: the VM
+      // writes it in place, so a start costs the same however much data the VM holds.
       const tStorageStart = Date.now();
       const image = await this.images.resolveForVmCreate(vm.imageId ?? undefined);
       const persistentDiskPath = this.storage.persistentDiskPath(vm.id);
       const hadOverlay = Boolean(vm.overlayPath);
       let storageResult: { rootfsPath: string; logsDir: string; kernelPath: string; overlayPath?: string | null };
 
-      if (await this.storage.hasPersistentDisk(vm.id)) {
+      let workspaceDiskPath: string | null = null;
+
+      if (vm.workspaceDiskPath) {
+        // Only the workspace disk was persisted; the system overlay is recreated from the image.
+        storageResult = await this.storage.prepareVmStorage(vm.id, {
+          kernelSrcPath: image.kernelSrcPath,
+          baseRootfsPath: image.baseRootfsPath,
+          kernelSha256: image.kernelSha256,
+          rootfsSha256: image.rootfsSha256
+        });
+        const persistentWorkspacePath = this.storage.persistentWorkspaceDiskPath(vm.id);
+        const hasPersistentWorkspace = await fs.stat(persistentWorkspacePath).then(() => true).catch(() => false);
+        if (!hasPersistentWorkspace) {
+          // eslint-disable-next-line no-console
+          console.warn("[vm-start] No persistent workspace disk found, starting with an empty workspace", { vmId: vm.id });
+        }
+        workspaceDiskPath = await this.storage.prepareWorkspaceDisk(vm.id, {
+          sizeBytes: (vm.workspaceDiskMb ?? 0) * 1024 * 1024,
+          srcPath: hasPersistentWorkspace ? persistentWorkspacePath : undefined,
+          inPlace: true
+        });
+      } else if (await this.storage.hasPersistentDisk(vm.id)) {
         if (hadOverlay) {
           // Overlay mode: persistent disk contains the writable overlay layer.
-          // Recreate a fresh VM storage layout (base rootfs + overlay disk), then
-          // restore the persisted overlay contents onto the new overlay disk.
+          // Recreate the VM storage layout (base rootfs + overlay disk) around it.
           storageResult = await this.storage.prepareVmStorage(vm.id, {
             kernelSrcPath: image.kernelSrcPath,
-            baseRootfsPath: image.baseRootfsPath
+            baseRootfsPath: image.baseRootfsPath,
+            kernelSha256: image.kernelSha256,
+            rootfsSha256: image.rootfsSha256,
+            persistentOverlay: true
           });
-          if (!storageResult.overlayPath) {
-            throw new HttpError(500, "overlay disk was expected for VM restart but is unavailable");
-          }
-          await this.storage.cloneDisk(persistentDiskPath, storageResult.overlayPath);
         } else {
           // Legacy mode (no overlay): persistent disk is the full rootfs.
           storageResult = await this.storage.prepareVmStorageFromDisk(vm.id, {
             kernelSrcPath: image.kernelSrcPath,
-            diskSrcPath: persistentDiskPath
+            kernelSha256: image.kernelSha256,
+            diskSrcPath: persistentDiskPath,
+            inPlace: true
           });
         }
       } else {
@@ -818,7 +1054,9 @@ export class VmService {
         console.warn("[vm-start] No persistent disk found, using base image (user data will be lost)", { vmId: vm.id });
         storageResult = await this.storage.prepareVmStorage(vm.id, {
           kernelSrcPath: image.kernelSrcPath,
-          baseRootfsPath: image.baseRootfsPath
+          baseRootfsPath: image.baseRootfsPath,
+          kernelSha256: image.kernelSha256,
+          rootfsSha256: image.rootfsSha256
         });
       }
       const storageMs = Date.now() - tStorageStart;
@@ -828,7 +1066,8 @@ export class VmService {
         rootfsPath: storageResult.rootfsPath,
         kernelPath: storageResult.kernelPath,
         logsDir: storageResult.logsDir,
-        overlayPath: storageResult.overlayPath
+        overlayPath: storageResult.overlayPath,
+        ...(workspaceDiskPath ? { workspaceDiskPath } : {})
       });
 
       // Fetch updated VM record
@@ -844,8 +1083,14 @@ export class VmService {
       await this.agentClient.health(updatedVm.id);
       const agentHealthMs = Date.now() - tAgentHealthStart;
       await this.agentClient.syncTime(updatedVm.id, { unixTimeMs: Date.now() }).catch(() => undefined);
+      await this.reseedGuestEntropy(updatedVm.id);
       await this.agentClient.applyAllowlist(updatedVm.id, updatedVm.allowIps, updatedVm.outboundInternet, { allowManagerGateway });
-      await this.store.update(updatedVm.id, { state: "RUNNING", provisionMode: "boot" });
+      await this.store.update(updatedVm.id, {
+        state: "RUNNING",
+        provisionMode: "boot",
+        // A hugepage VM that fell back to 4 KiB pages last time may get hugepages now, or the reverse.
+        memoryPageSizeKb: this.firecracker.memoryPageSizeKb(updatedVm.id)
+      });
       await this.peerService?.onVmRunning(updatedVm.id);
       await this.activity?.logEvent({
         type: "vm.started",
@@ -878,17 +1123,24 @@ export class VmService {
     await this.agentClient.exec(vm.id, { cmd: "sync; sync; sync" }).catch(() => undefined);
     await new Promise((resolve) => setTimeout(resolve, 2500));
 
-    // Stop the VM first so we don't clone the disk while it's being written to.
+    // Stop the VM first so we don't save the disk while it's being written to.
     await this.firecracker.stop(vm);
-    // Give host block flush a brief moment after VM exit before cloning the writable layer.
+    // Give host block flush a brief moment after VM exit before saving the writable layer.
     await new Promise((resolve) => setTimeout(resolve, 2500));
 
-    // Now that the VM is stopped, clone the writable disk to persistent storage.
+    // Now that the VM is stopped, save the writable disk to persistent storage. A disk linked in
+    // place on start already is the persistent disk; one created in the jail is moved out.
     // In overlay mode that's the overlay disk; in legacy mode it's the rootfs disk.
+    // A workspace disk replaces both: the system overlay is discarded.
     const tSaveStart = Date.now();
-    const writableDiskPath = vm.overlayPath || vm.rootfsPath;
-    await syncDiskFile(writableDiskPath);
-    await this.storage.saveDiskToPersistent(vm.id, writableDiskPath);
+    if (vm.workspaceDiskPath) {
+      await syncDiskFile(vm.workspaceDiskPath);
+      await this.storage.saveDiskToPersistent(vm.id, vm.workspaceDiskPath, "workspace");
+    } else {
+      const writableDiskPath = vm.overlayPath || vm.rootfsPath;
+      await syncDiskFile(writableDiskPath);
+      await this.storage.saveDiskToPersistent(vm.id, writableDiskPath);
+    }
     const saveMs = Date.now() - tSaveStart;
 
     // Clean up the jailer runtime dir so a later `start` can recreate it cleanly.
@@ -910,31 +1162,134 @@ export class VmService {
     const vm = await this.requireVm(id);
     this.warmPoolVmIds.delete(vm.id);
     await this.peerService?.deleteConsumerMetadata(vm.id);
-    const errors: string[] = [];
-    await this.firecracker
-      .destroy(vm)
-      .catch((err) => errors.push(`firecracker.destroy: ${String((err as any)?.message ?? err)}`));
-    await this.network
-      .teardown(vm, vm.tapName)
-      .catch((err) => errors.push(`network.teardown: ${String((err as any)?.message ?? err)}`));
-    await this.storage
-      .cleanupVmStorage(vm.id)
-      .catch((err) => errors.push(`storage.cleanup: ${String((err as any)?.message ?? err)}`));
+    const recycle = await this.isRecyclable(vm);
+    const errors = recycle ? [] : await this.teardownVm(vm);
     await this.store.update(vm.id, { state: "DELETED" });
     await this.activity?.logEvent({
       type: "vm.deleted",
       entityType: "vm",
       entityId: vm.id,
       message: "VM deleted",
-      meta: errors.length ? { warnings: errors } : undefined
+      meta: errors.length ? { warnings: errors } : recycle ? { recycled: true } : undefined
     });
     if (errors.length) {
       // eslint-disable-next-line no-console
       console.warn("[vm-destroy] Completed with warnings", { vmId: vm.id, errors });
     }
+    if (recycle) {
+      // The old id is gone for the tenant as of now; the guest is scrubbed in the background.
+      this.recyclingVmIds.add(vm.id);
+      void this.recycleIntoWarmPool(vm).finally(() => {
+        this.recyclingVmIds.delete(vm.id);
+        this.scheduleWarmPoolTopup();
+      });
+      return;
+    }
     this.scheduleWarmPoolTopup();
   }
 
+  private async teardownVm(vm: VmRecord): Promise<string[]> {
+    const errors: string[] = [];
+    await this.firecracker
+      .destroy(vm)
+      .catch((err) => errors.push(`firecracker.destroy: ${String((err as any)?.message ?? err)}`));
+    await this.network
+      .teardown(vm, vm.tapName)
+      .catch((err) => errors.push(`network.teardown: ${String((err as any)?.message ?? err)}`));
+    await this.storage
+      .cleanupVmStorage(vm.id)
+      .catch((err) => errors.push(`storage.cleanup: ${String((err as any)?.message ?? err)}`));
+    return errors;
+  }
+
+  /**
+   * A destroyed VM may be recycled only if it is indistinguishable from a fresh warm VM once its
+   * guest state is reset: warm shape and default image, deny-all egress (host rules are per tap and
+   * are not rewritten), overlay root, and no peer/secret wiring tied to the old tenant.
+   */
+  private async isRecyclable(vm: VmRecord): Promise<boolean> {
+    if (!this.warmPool?.enabled || !this.warmPool.recycle) return false;
+    if (vm.state !== "RUNNING" || vm.poolTag === "warm" || !vm.overlayPath || vm.workspaceDiskPath) return false;
+    if (vm.outboundInternet || vm.allowIps.length > 0) return false;
+    if (vm.secretEnvCiphertext || vm.bridgeTokenHash) return false;
+    if (vm.cpu !== (this.snapshots?.templateCpu ?? 1) || vm.memMb !== (this.snapshots?.templateMemMb ?? 256)) return false;
+    if ((await this.peerService?.hasPeerLinks(vm.id)) === true) return false;
+    const target = Math.min(Math.max(0, this.warmPool.target), this.warmPool.maxVms);
+    if (this.warmPoolVmIds.size + this.recyclingVmIds.size >= target) return false;
+    const image = await this.images.resolveForVmCreate(undefined).catch(() => null);
+    return Boolean(image) && (vm.imageId ?? "") === (image?.imageId ?? "");
+  }
+
+  /**
+   * Reset the guest of a destroyed VM and return it to the warm pool under a fresh id.
+   * Any failure falls back to a full teardown so tenant state never outlives a failed reset.
+   */
+  private async recycleIntoWarmPool(vm: VmRecord): Promise<void> {
+    const started = Date.now();
+    const newId = randomUUID();
+    let current: VmRecord = vm;
+    try {
+      const reset = await this.agentClient.resetGuestForRecycle(vm.id);
+      await this.agentClient.applyAllowlist(vm.id, [], false, { allowManagerGateway: false });
+      await this.firecracker.rekey(vm, newId);
+      const rebase = (p: string) => rebaseVmPath(p, vm.id, newId);
+      current = {
+        ...vm,
+        id: newId,
+        state: "RUNNING",
+        allowIps: [],
+        outboundInternet: false,
+        rootfsPath: rebase(vm.rootfsPath),
+        overlayPath: vm.overlayPath ? rebase(vm.overlayPath) : vm.overlayPath,
+        kernelPath: rebase(vm.kernelPath),
+        logsDir: rebase(vm.logsDir),
+        createdAt: new Date().toISOString(),
+        poolTag: "warm",
+        secretEnvCiphertext: undefined,
+        bridgeTokenHash: undefined
+      };
+      await this.waitForAgentHealth(newId, 10_000);
+      await this.agentClient.syncTime(newId, { unixTimeMs: Date.now() }).catch(() => undefined);
+      await this.reseedGuestEntropy(newId);
+      if (this.dnsServerIp) {
+        // Sandbox reset rewrote resolv.conf from the gateway; restore the manager-level DNS server.
+        await this.agentClient.configureNetwork(newId, {
+          iface: "eth0",
+          ip: vm.guestIp,
+          cidr: 24,
+          gateway: "172.16.0.1",
+          mac: generateMac(vm.id),
+          dns: this.dnsServerIp,
+          dnsOnly: true
+        });
+      }
+      // The next tenant must not read this one's console output, exec history or I/O counters.
+      await this.firecracker.resetLogs(current);
+      await this.execLogs.clear(current.logsDir);
+      await this.store.create(current);
+      this.warmPoolVmIds.add(newId);
+      await this.storage.cleanupVmStorage(vm.id).catch(() => undefined);
+      // eslint-disable-next-line no-console
+      console.info("[warm-pool] recycled VM", {
+        fromVmId: vm.id,
+        vmId: newId,
+        resetMs: reset.durationMs,
+        killedProcesses: reset.killedProcesses,
+        removedPaths: reset.removedPaths,
+        restoredPaths: reset.restoredPaths,
+        totalMs: Date.now() - started
+      });
+    } catch (err) {
+      // eslint-disable-next-line no-console
+      console.warn("[warm-pool] recycle failed; destroying VM", {
+        vmId: vm.id,
+        err: String((err as any)?.message ?? err)
+      });
+      await this.teardownVm(current);
+      if (current.id !== vm.id) await this.storage.cleanupVmStorage(vm.id).catch(() => undefined);
+    }
+  }
+
   async exec(id: string, payload: { cmd: string; cwd?: string; env?: Record<string, string>; timeoutMs?: number }) {
     const vm = await this.requireVm(id);
     if (typeof payload.timeoutMs === "number" && payload.timeoutMs > this.limits.maxExecTimeoutMs) {
@@ -971,6 +1326,80 @@ export class VmService {
     return result;
   }
 
+  /** Validate a fan-out request and resolve its selector; throws HttpError before any output is sent. */
+  async planExecFanout(request: ExecFanoutRequest): Promise<ExecFanoutPlan> {
+    const { selector } = request;
+    if (!selector.vmIds && !selector.imageId && selector.all !== true) {
+      throw new HttpError(400, "selector needs vmIds, imageId or all: true");
+    }
+    if (selector.vmIds && selector.vmIds.length > MAX_FANOUT_VM_IDS) {
+      throw new HttpError(400, `selector.vmIds exceeds ${MAX_FANOUT_VM_IDS} entries`);
+    }
+    if (typeof request.timeoutMs === "number" && request.timeoutMs > this.limits.maxExecTimeoutMs) {
+      throw new HttpError(400, `timeoutMs exceeds maxExecTimeoutMs=${this.limits.maxExecTimeoutMs}`);
+    }
+
+    const vms = (await this.store.list()).filter((vm) => vm.state !== "DELETED" && vm.poolTag !== "warm");
+    const byId = new Map(vms.map((vm) => [vm.id, vm]));
+    const vmIds: string[] = [];
+    const unavailable: ExecFanoutPlan["unavailable"] = [];
+    const candidates = selector.vmIds ? [...new Set(selector.vmIds)] : vms.map((vm) => vm.id);
+    for (const id of candidates) {
+      const vm = byId.get(id);
+      if (!vm) {
+        unavailable.push({ vmId: id, error: `VM ${id} not found` });
+      } else if (selector.imageId && vm.imageId !== selector.imageId) {
+        if (selector.vmIds) unavailable.push({ vmId: id, error: `VM ${id} does not run image ${selector.imageId}` });
+      } else if (vm.state !== "RUNNING") {
+        if (selector.vmIds) unavailable.push({ vmId: id, error: `VM ${id} is not RUNNING (state=${vm.state})` });
+      } else {
+        vmIds.push(id);
+      }
+    }
+
+    const maxConcurrency = this.limits.maxFanoutConcurrency ?? 16;
+    return {
+      vmIds,
+      unavailable,
+      payload: { cmd: request.cmd, cwd: request.cwd, env: request.env, timeoutMs: request.timeoutMs },
+      concurrency: Math.max(1, Math.min(maxConcurrency, Math.floor(request.concurrency ?? maxConcurrency))),
+      deadlineMs: (request.timeoutMs ?? this.limits.maxExecTimeoutMs) + FANOUT_DEADLINE_GRACE_MS
+    };
+  }
+
+  /**
+   * Run a planned fan-out: each VM goes through `exec()` (exec log and activity event included)
+   * with at most `plan.concurrency` in flight. Results reach `onResult` in completion order.
+   */
+  async execFanout(
+    plan: ExecFanoutPlan,
+    onResult: (result: ExecFanoutResult) => Promise<void> | void,
+    isAborted?: () => boolean
+  ): Promise<ExecFanoutSummary> {
+    for (const { vmId, error } of plan.unavailable) {
+      await onResult({ vmId, ok: false, error, durationMs: 0 });
+    }
+    const summary = await runExecFanout({
+      vmIds: plan.vmIds,
+      concurrency: plan.concurrency,
+      deadlineMs: plan.deadlineMs,
+      run: (vmId) => this.exec(vmId, plan.payload),
+      onResult,
+      isAborted
+    });
+    const result = {
+      ...summary,
+      total: summary.total + plan.unavailable.length,
+      failed: summary.failed + plan.unavailable.length
+    };
+    await this.activity?.logEvent({
+      type: "exec.fanout",
+      message: `Exec fan-out across ${result.total} VMs`,
+      meta: { cmd: plan.payload.cmd, ...result }
+    });
+    return result;
+  }
+
   async runTs(
     id: string,
     payload: { path?: string; code?: string; args?: string[]; denoFlags?: string[]; timeoutMs?: number; env?: string[] }
@@ -1075,50 +1504,30 @@ export class VmService {
     const type = normalizeLogType(input.type);
     const tail = clampTail(input.tail);
     const logPath = path.join(vm.logsDir, type);
-    let stat: { size: number; mtime: Date } | null = null;
-
-    try {
-      const raw = await fs.stat(logPath);
-      stat = { size: raw.size, mtime: raw.mtime };
-    } catch (err: any) {
-      if (err?.code === "ENOENT") {
-        return { type, lines: [], truncated: false };
-      }
-      throw err;
-    }
-
-    if (!stat || stat.size === 0) {
-      return { type, lines: [], truncated: false, updatedAt: stat?.mtime?.toISOString() };
+    // Console logs rotate; the tail may continue into the previous segment.
+    const tailed = await readLogTail(logPath, 256 * 1024);
+    if (!tailed) {
+      return { type, lines: [], truncated: false };
     }
-
-    const maxBytes = 256 * 1024;
-    const readBytes = Math.min(stat.size, maxBytes);
-    const start = Math.max(0, stat.size - readBytes);
-    const handle = await fs.open(logPath, "r");
-    let text = "";
-    try {
-      const buffer = Buffer.alloc(readBytes);
-      await handle.read(buffer, 0, readBytes, start);
-      text = buffer.toString("utf-8");
-    } finally {
-      await handle.close().catch(() => undefined);
+    if (!tailed.text) {
+      return { type, lines: [], truncated: false, updatedAt: tailed.mtime.toISOString() };
     }
 
-    let lines = text.split(/\r?\n/);
-    if (start > 0 && lines.length > 0) {
+    let lines = tailed.text.split(/\r?\n/);
+    if (tailed.startsMidLine && lines.length > 0) {
       lines = lines.slice(1);
     }
     if (lines.length > 0 && lines[lines.length - 1] === "") {
       lines.pop();
     }
 
-    let truncated = start > 0;
+    let truncated = tailed.truncated;
     if (lines.length > tail) {
       lines = lines.slice(-tail);
       truncated = true;
     }
 
-    return { type, lines, truncated, updatedAt: stat.mtime.toISOString() };
+    return { type, lines, truncated, updatedAt: tailed.mtime.toISOString() };
   }
 
   async uploadFiles(id: string, dest: string, data: Buffer): Promise<void> {
@@ -1131,6 +1540,84 @@ export class VmService {
     return this.agentClient.download(vm.id, path);
   }
 
+  async readRawFile(id: string, path: string, options?: { range?: string; ifMatch?: string }): Promise<VmRawFileReadResult> {
+    const vm = await this.requireVm(id);
+    try {
+      return await this.agentClient.readRawFile(vm.id, path, options);
+    } catch (err) {
+      throw toAgentHttpError(err);
+    }
+  }
+
+  async writeRawFile(id: string, path: string, data: Buffer, options?: { ifMatch?: string }): Promise<VmRawFileWriteResult> {
+    const vm = await this.requireVm(id);
+    try {
+      return await this.agentClient.writeRawFile(vm.id, path, data, options);
+    } catch (err) {
+      throw toAgentHttpError(err);
+    }
+  }
+
+  async getGuestStats(id: string): Promise<VmGuestStats> {
+    const vm = await this.requireVm(id);
+    if (vm.state !== "RUNNING") {
+      throw new HttpError(409, `VM must be RUNNING to read guest stats (state=${vm.state})`);
+    }
+    try {
+      return await this.agentClient.guestStats(vm.id);
+    } catch (err) {
+      throw toAgentHttpError(err);
+    }
+  }
+
+  async getIoStats(id: string): Promise<VmIoStats> {
+    const vm = await this.requireVm(id);
+    const metrics = await this.firecracker.readIoMetrics(vm);
+    return { tier: vm.ioTier ?? "unlimited", ...metrics };
+  }
+
+  /** Change a VM's disk/network rate limits; applied live when it is running, otherwise on next start. */
+  async setIoTier(id: string, tier: VmIoTier): Promise<VmPublic> {
+    if (!IO_TIERS.includes(tier)) {
+      throw new HttpError(400, `Invalid ioTier (one of: ${IO_TIERS.join(", ")})`);
+    }
+    const vm = await this.requireVm(id);
+    if (vm.state === "RUNNING") {
+      await this.firecracker.updateIoTier(vm, tier);
+    } else if (vm.state !== "STOPPED") {
+      throw new HttpError(409, `VM must be RUNNING or STOPPED to change ioTier (state=${vm.state})`);
+    }
+    await this.store.update(vm.id, { ioTier: tier });
+    return toPublic({ ...vm, ioTier: tier });
+  }
+
+  async listCheckpoints(id: string): Promise<VmWorkspaceCheckpoint[]> {
+    const vm = await this.requireVm(id);
+    try {
+      return await this.agentClient.listCheckpoints(vm.id);
+    } catch (err) {
+      throw toAgentHttpError(err);
+    }
+  }
+
+  async createCheckpoint(id: string, payload: { label?: string }): Promise<VmWorkspaceCheckpoint> {
+    const vm = await this.requireVm(id);
+    try {
+      return await this.agentClient.createCheckpoint(vm.id, payload);
+    } catch (err) {
+      throw toAgentHttpError(err);
+    }
+  }
+
+  async rollbackCheckpoint(id: string, checkpointId: string): Promise<VmWorkspaceCheckpoint> {
+    const vm = await this.requireVm(id);
+    try {
+      return await this.agentClient.rollbackCheckpoint(vm.id, checkpointId);
+    } catch (err) {
+      throw toAgentHttpError(err);
+    }
+  }
+
   async syncPeers(id: string): Promise<void> {
     await this.requireVm(id);
     if (!this.peerService) {
@@ -1178,6 +1665,18 @@ function validateCreateRequest(req: VmCreateRequest, limits: VmService["limits"]
       throw new HttpError(400, "diskSizeMb too large");
     }
   }
+  if (req.workspaceDiskMb !== undefined) {
+    const maxMb = limits.maxWorkspaceDiskMb ?? 10_240;
+    if (!Number.isInteger(req.workspaceDiskMb) || req.workspaceDiskMb < 64 || req.workspaceDiskMb > maxMb) {
+      throw new HttpError(400, `Invalid workspaceDiskMb (min=64, maxWorkspaceDiskMb=${maxMb})`);
+    }
+  }
+  if (req.ioTier !== undefined && !IO_TIERS.includes(req.ioTier)) {
+    throw new HttpError(400, `Invalid ioTier (one of: ${IO_TIERS.join(", ")})`);
+  }
+  if (req.hugePages !== undefined && typeof req.hugePages !== "boolean") {
+    throw new HttpError(400, "hugePages must be a boolean");
+  }
   if (!Array.isArray(req.allowIps)) {
     throw new HttpError(400, "allowIps must be an array");
   }
@@ -1205,10 +1704,20 @@ function toPublic(vm: VmRecord): VmPublic {
     outboundInternet: vm.outboundInternet,
     createdAt: vm.createdAt,
     provisionMode: vm.provisionMode,
-    imageId: vm.imageId
+    imageId: vm.imageId,
+    ...(vm.workspaceDiskMb ? { workspaceDiskMb: vm.workspaceDiskMb } : {}),
+    ioTier: vm.ioTier ?? "unlimited",
+    hugePages: vm.hugePages ?? false,
+    ...(vm.memoryPageSizeKb ? { memoryPageSizeKb: vm.memoryPageSizeKb } : {})
   };
 }
 
+function imageContentKey(resolved: { kernelSha256?: string | null; rootfsSha256?: string | null }): string | null {
+  if (!resolved.kernelSha256 && !resolved.rootfsSha256) return null;
+  return `${resolved.kernelSha256 ?? ""}:${resolved.rootfsSha256 ?? ""}`;
+}
+
+/** Swap the `<vmId>` segment of a jail path after the jail directory was renamed. */
 function generateMac(seed: string) {
   const hash = Buffer.from(seed.replace(/-/g, "")).slice(0, 6);
   hash[0] = (hash[0] & 0xfe) | 0x02;
@@ -1232,6 +1741,24 @@ function clampTail(tail?: number): number {
   return Math.min(parsed, 1000);
 }
 
+function toAgentHttpError(err: unknown): unknown {
+  // Surface the guest-agent's client errors (404 missing file/checkpoint, 409 conflicts,
+  // 412 If-Match mismatch, 416 bad range, 413 too large) instead of collapsing them into a 500.
+  const statusCode = (err as any)?.statusCode;
+  if (typeof statusCode !== "number" || statusCode < 400 || statusCode >= 500) return err;
+  const raw = String((err as any)?.message ?? err);
+  const jsonStart = raw.indexOf("{");
+  let message = raw;
+  if (jsonStart !== -1) {
+    try {
+      message = String(JSON.parse(raw.slice(jsonStart))?.message ?? raw);
+    } catch {
+      // Keep the raw agent error text.
+    }
+  }
+  return new HttpError(statusCode, message);
+}
+
 function normalizeSnapshotId(raw?: string): string | undefined {
   if (!raw) return undefined;
   const value = String(raw).trim();
@@ -0,0 +1,111 @@
+import { and, count, desc, eq, inArray, lt, or, type SQL } from "drizzle-orm";
+import type { SnapshotCatalog, SnapshotListQuery, SnapshotPage } from "../types/interfaces.js";
+import type { SnapshotMeta } from "../types/snapshot.js";
+
+type AnyDb = any;
+type AnySnapshotsTable = any;
+
+const MAX_PAGE = 500;
+
+export class SqlSnapshotCatalog implements SnapshotCatalog {
+  constructor(
+    private readonly db: AnyDb,
+    private readonly snapshots: AnySnapshotsTable
+  ) {}
+
+  async put(meta: SnapshotMeta): Promise<void> {
+    const row = toRow(meta);
+    const { id: _id, ...update } = row;
+    await this.db.insert(this.snapshots).values(row).onConflictDoUpdate({ target: this.snapshots.id, set: update });
+  }
+
+  async get(snapshotId: string): Promise<SnapshotMeta | null> {
+    const rows = await this.db.select().from(this.snapshots).where(eq(this.snapshots.id, snapshotId)).limit(1);
+    const row = rows?.[0];
+    return row ? fromRow(row) : null;
+  }
+
+  async delete(snapshotId: string): Promise<void> {
+    await this.db.delete(this.snapshots).where(eq(this.snapshots.id, snapshotId));
+  }
+
+  async list(query: SnapshotListQuery = {}): Promise<SnapshotPage> {
+    const t = this.snapshots;
+    const conditions: SQL[] = [];
+    if (query.scope === "user") conditions.push(inArray(t.kind, ["user_overlay", "vm"]));
+    if (query.scope === "internal") conditions.push(or(inArray(t.kind, ["image_seed", "template"]), eq(t.internal, true))!);
+    if (query.kind) conditions.push(eq(t.kind, query.kind));
+    if (query.imageId) conditions.push(eq(t.imageId, query.imageId));
+    const after = query.cursor ? decodeCursor(query.cursor) : null;
+    if (after) {
+      conditions.push(or(lt(t.createdAt, after.createdAt), and(eq(t.createdAt, after.createdAt), lt(t.id, after.id)))!);
+    }
+
+    let select = this.db
+      .select()
+      .from(t)
+      .where(conditions.length > 0 ? and(...conditions) : undefined)
+      .orderBy(desc(t.createdAt), desc(t.id));
+    const limit =
+      typeof query.limit === "number" && Number.isFinite(query.limit) ? Math.max(1, Math.min(MAX_PAGE, Math.floor(query.limit))) : null;
+    // One extra row tells whether another page exists.
+    if (limit !== null) select = select.limit(limit + 1);
+    const rows: any[] = (await select) ?? [];
+
+    const hasMore = limit !== null && rows.length > limit;
+    const items = (hasMore ? rows.slice(0, limit) : rows).map(fromRow);
+    const last = items[items.length - 1];
+    return { items, nextCursor: hasMore && last ? encodeCursor(last) : null };
+  }
+
+  async ids(): Promise<string[]> {
+    const rows = await this.db.select({ id: this.snapshots.id }).from(this.snapshots);
+    return (rows ?? []).map((row: any) => String(row.id));
+  }
+
+  async counts(): Promise<{ snapshots: number; templates: number }> {
+    const rows = await this.db
+      .select({ kind: this.snapshots.kind, n: count() })
+      .from(this.snapshots)
+      .groupBy(this.snapshots.kind);
+    let snapshots = 0;
+    let templates = 0;
+    for (const row of rows ?? []) {
+      if (row.kind === "template") templates += Number(row.n);
+      else snapshots += Number(row.n);
+    }
+    return { snapshots, templates };
+  }
+}
+
+function toRow(meta: SnapshotMeta) {
+  return {
+    id: meta.id,
+    kind: meta.kind,
+    imageId: meta.imageId ?? null,
+    sourceVmId: meta.sourceVmId ?? null,
+    internal: meta.internal === true,
+    createdAt: meta.createdAt,
+    metaJson: JSON.stringify(meta)
+  };
+}
+
+function fromRow(row: any): SnapshotMeta {
+  return JSON.parse(String(row.metaJson)) as SnapshotMeta;
+}
+
+export function encodeCursor(meta: Pick<SnapshotMeta, "createdAt" | "id">): string {
+  return Buffer.from(JSON.stringify([meta.createdAt, meta.id]), "utf-8").toString("base64url");
+}
+
+export function decodeCursor(cursor: string): { createdAt: string; id: string } | null {
+  try {
+    const parsed = JSON.parse(Buffer.from(cursor, "base64url").toString("utf-8"));
+    if (Array.isArray(parsed) && typeof parsed[0] === "string" && typeof parsed[1] === "string") {
+      return { createdAt: parsed[0], id: parsed[1] };
+    }
+  } catch {
+    // fall through
+  }
+  return null;
+}
@@ -67,6 +67,11 @@ function toRow(vm: VmRecord) {
     imageId: vm.imageId ?? null,
     rootfsPath: vm.rootfsPath,
     overlayPath: vm.overlayPath ?? null,
+    workspaceDiskPath: vm.workspaceDiskPath ?? null,
+    workspaceDiskMb: vm.workspaceDiskMb ?? null,
+    ioTier: vm.ioTier ?? null,
+    hugePages: vm.hugePages ?? null,
+    memoryPageSizeKb: vm.memoryPageSizeKb ?? null,
     kernelPath: vm.kernelPath,
     logsDir: vm.logsDir,
     createdAt: vm.createdAt,
@@ -92,6 +97,11 @@ function fromRow(row: any): VmRecord {
     imageId: row.imageId ?? undefined,
     rootfsPath: String(row.rootfsPath),
     overlayPath: row.overlayPath == null ? null : String(row.overlayPath),
+    workspaceDiskPath: row.workspaceDiskPath == null ? null : String(row.workspaceDiskPath),
+    workspaceDiskMb: row.workspaceDiskMb == null ? undefined : Number(row.workspaceDiskMb),
+    ioTier: row.ioTier ?? undefined,
+    hugePages: row.hugePages == null ? undefined : Boolean(row.hugePages),
+    memoryPageSizeKb: row.memoryPageSizeKb == null ? undefined : Number(row.memoryPageSizeKb),
     kernelPath: String(row.kernelPath),
     logsDir: String(row.logsDir),
     createdAt: String(row.createdAt),
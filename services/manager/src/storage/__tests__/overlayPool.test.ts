@@ -0,0 +1,62 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { OverlayPool } from "../overlayPool.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+function makePool(depth: number, fill?: (dest: string, sizeBytes: number) => Promise<void>) {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), "overlay-pool-"));
+  tempDirs.push(root);
+  const jail = path.join(root, "jail");
+  fs.mkdirSync(jail);
+  const pool = new OverlayPool({
+    dir: path.join(root, ".overlay-pool"),
+    depth,
+    fill: fill ?? (async (dest, sizeBytes) => fs.promises.writeFile(dest, `blank-${sizeBytes}`))
+  });
+  return { pool, jail };
+}
+
+async function waitFor(check: () => boolean): Promise<void> {
+  for (let i = 0; i < 200 && !check(); i += 1) await new Promise((resolve) => setTimeout(resolve, 5));
+  expect(check()).toBe(true);
+}
+
+describe("OverlayPool", () => {
+  it("misses while empty, then serves pre-cloned disks by rename and refills", async () => {
+    const { pool, jail } = makePool(2);
+    const first = path.join(jail, "a.ext4");
+    expect(await pool.take(1024, first)).toBe(false);
+    await waitFor(() => pool.stats().ready["1024"] === 2);
+
+    expect(await pool.take(1024, first)).toBe(true);
+    expect(fs.readFileSync(first, "utf-8")).toBe("blank-1024");
+    await waitFor(() => pool.stats().ready["1024"] === 2);
+
+    const stats = pool.stats();
+    expect(stats).toMatchObject({ depth: 2, hits: 1, misses: 1, refills: 3, refillErrors: 0 });
+  });
+
+  it("keeps sizes apart", async () => {
+    const { pool, jail } = makePool(1);
+    pool.warm(1024);
+    await waitFor(() => pool.stats().ready["1024"] === 1);
+    expect(await pool.take(2048, path.join(jail, "b.ext4"))).toBe(false);
+    expect(await pool.take(1024, path.join(jail, "c.ext4"))).toBe(true);
+  });
+
+  it("counts failed refills and stops until the next take", async () => {
+    const { pool, jail } = makePool(2, async () => {
+      throw new Error("no space");
+    });
+    expect(await pool.take(1024, path.join(jail, "d.ext4"))).toBe(false);
+    await waitFor(() => pool.stats().refillErrors === 1);
+    expect(pool.stats().ready["1024"]).toBe(0);
+  });
+});
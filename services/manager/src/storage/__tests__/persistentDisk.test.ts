@@ -0,0 +1,58 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { LocalStorageProvider } from "../storageProvider.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+function makeStorage() {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), "persistent-disk-"));
+  tempDirs.push(root);
+  const kernelSrcPath = path.join(root, "vmlinux");
+  fs.writeFileSync(kernelSrcPath, "kernel");
+  const storage = new LocalStorageProvider({ storageRoot: root, jailerChrootBaseDir: path.join(root, "jailer"), overlayPoolDepth: 0 });
+  return { storage, kernelSrcPath };
+}
+
+describe("persistent disks across stop/start", () => {
+  it("moves the jail disk out on first stop, then links it in place on start", async () => {
+    const { storage, kernelSrcPath } = makeStorage();
+    const persistPath = storage.persistentDiskPath("vm1");
+
+    // First stop after create: the jail disk becomes the persistent disk without a copy.
+    const created = await storage.prepareWorkspaceDisk("vm1", { sizeBytes: 0, srcPath: kernelSrcPath });
+    fs.writeFileSync(created, "v1");
+    const createdIno = fs.statSync(created).ino;
+    await storage.saveDiskToPersistent("vm1", created);
+    expect(fs.existsSync(created)).toBe(false);
+    expect(fs.statSync(persistPath).ino).toBe(createdIno);
+
+    // Start: the VM writes the persistent disk itself, and stop has nothing left to save.
+    const started = await storage.prepareVmStorageFromDisk("vm1", { kernelSrcPath, diskSrcPath: persistPath, inPlace: true });
+    expect(fs.statSync(started.rootfsPath).ino).toBe(createdIno);
+    fs.writeFileSync(started.rootfsPath, "v2");
+    // The kernel comes from the artifact cache, not a per-start copy.
+    expect(fs.statSync(started.kernelPath).nlink).toBeGreaterThan(1);
+
+    await storage.saveDiskToPersistent("vm1", started.rootfsPath);
+    await storage.cleanupJailerVmDir("vm1");
+    expect(fs.readFileSync(persistPath, "utf-8")).toBe("v2");
+  });
+
+  it("keeps workspace disks apart and removes both on destroy", async () => {
+    const { storage, kernelSrcPath } = makeStorage();
+    const workspace = await storage.prepareWorkspaceDisk("vm2", { sizeBytes: 0, srcPath: kernelSrcPath });
+    await storage.saveDiskToPersistent("vm2", workspace, "workspace");
+    const persistPath = storage.persistentWorkspaceDiskPath("vm2");
+    expect(fs.readFileSync(persistPath, "utf-8")).toBe("kernel");
+    expect(await storage.hasPersistentDisk("vm2")).toBe(false);
+
+    await storage.cleanupVmStorage("vm2");
+    expect(fs.existsSync(persistPath)).toBe(false);
+  });
+});
@@ -0,0 +1,41 @@
+import { describe, expect, it } from "vitest";
+import { makeDev, parseThinPoolStatus, thinMetadataBytes } from "../thinPool.js";
+
+describe("parseThinPoolStatus", () => {
+  it("reads metadata/data block counts and the pool mode", () => {
+    const line = "0 209715200 thin-pool 7 2304/26214 48123/1638400 - rw discard_passdown queue_if_no_space - 1024\n";
+    expect(parseThinPoolStatus(line)).toEqual({
+      usedMetadataBlocks: 2304,
+      totalMetadataBlocks: 26214,
+      usedDataBlocks: 48123,
+      totalDataBlocks: 1638400,
+      mode: "rw"
+    });
+  });
+
+  it("reports out-of-space pools and rejects failed or foreign targets", () => {
+    expect(parseThinPoolStatus("0 128 thin-pool 3 10/100 100/100 - out_of_data_space discard_passdown queue_if_no_space -")?.mode).toBe(
+      "out_of_data_space"
+    );
+    expect(parseThinPoolStatus("0 128 thin-pool Fail")).toBeNull();
+    expect(parseThinPoolStatus("0 128 linear 7:0 0")).toBeNull();
+  });
+});
+
+describe("makeDev", () => {
+  it("matches glibc makedev for small and large minors", () => {
+    expect(makeDev(253, 0)).toBe(0xfd00);
+    expect(makeDev(253, 5)).toBe(0xfd05);
+    // Minors above 255 move their high bits above the major.
+    expect(makeDev(253, 300)).toBe(0x10fd2c);
+    expect(makeDev(7, 1)).toBe(0x701);
+  });
+});
+
+describe("thinMetadataBytes", () => {
+  it("sizes metadata at ~0.1% of data within kernel bounds", () => {
+    expect(thinMetadataBytes(1024 ** 3)).toBe(64 * 1024 * 1024);
+    expect(thinMetadataBytes(1024 ** 4)).toBe(Math.ceil(1024 ** 4 / 1000 / 4096) * 4096);
+    expect(thinMetadataBytes(1024 ** 5 * 100)).toBe(16 * 1024 ** 3);
+  });
+});
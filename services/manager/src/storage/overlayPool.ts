@@ -0,0 +1,102 @@
+import fs from "node:fs/promises";
+import path from "node:path";
+import { randomUUID } from "node:crypto";
+import type { OverlayPoolStats } from "../types/interfaces.js";
+
+export interface OverlayPoolOptions {
+  /** Must be on the same filesystem as the jail roots so `take` is a rename. */
+  dir: string;
+  /** Ready disks kept per size. */
+  depth: number;
+  /** Produce one blank overlay disk of `sizeBytes` at `dest`. */
+  fill: (dest: string, sizeBytes: number) => Promise<void>;
+}
+
+/**
+ * Blank overlay disks cloned ahead of time, so a VM create moves a ready disk into its jail
+ * instead of cloning (a full copy on hosts without reflink) on the critical path. Each size is
+ * refilled in the background by one clone at a time, which keeps refill I/O from competing with
+ * the creates it is meant to speed up.
+ */
+export class OverlayPool {
+  private readonly ready = new Map<number, string[]>();
+  private readonly filling = new Set<number>();
+  private reset: Promise<void> | null = null;
+  private hits = 0;
+  private misses = 0;
+  private refills = 0;
+  private refillErrors = 0;
+  private refillMsTotal = 0;
+
+  constructor(private readonly options: OverlayPoolOptions) {}
+
+  /** Start filling the pool for `sizeBytes` without waiting for a create to ask for it. */
+  warm(sizeBytes: number): void {
+    void this.refill(sizeBytes);
+  }
+
+  /** Move a ready disk to `dest`. false means the pool was empty and the caller must clone inline. */
+  async take(sizeBytes: number, dest: string): Promise<boolean> {
+    const src = this.ready.get(sizeBytes)?.shift();
+    void this.refill(sizeBytes);
+    if (!src) {
+      this.misses += 1;
+      return false;
+    }
+    try {
+      await fs.rename(src, dest);
+    } catch {
+      await fs.rm(src, { force: true }).catch(() => undefined);
+      this.misses += 1;
+      return false;
+    }
+    this.hits += 1;
+    return true;
+  }
+
+  stats(): OverlayPoolStats {
+    return {
+      depth: this.options.depth,
+      ready: Object.fromEntries([...this.ready].map(([size, files]) => [String(size), files.length])),
+      hits: this.hits,
+      misses: this.misses,
+      refills: this.refills,
+      refillErrors: this.refillErrors,
+      avgRefillMs: this.refills > 0 ? Math.round(this.refillMsTotal / this.refills) : 0
+    };
+  }
+
+  private async refill(sizeBytes: number): Promise<void> {
+    if (this.filling.has(sizeBytes)) return;
+    this.filling.add(sizeBytes);
+    try {
+      // Disks left by a previous manager process may predate the current template; start clean.
+      this.reset ??= fs.rm(this.options.dir, { recursive: true, force: true }).catch(() => undefined);
+      await this.reset;
+      const sizeDir = path.join(this.options.dir, String(sizeBytes));
+      await fs.mkdir(sizeDir, { recursive: true });
+      const files = this.ready.get(sizeBytes) ?? [];
+      this.ready.set(sizeBytes, files);
+      while (files.length < this.options.depth) {
+        const dest = path.join(sizeDir, `overlay-${randomUUID()}.ext4`);
+        const startedAt = Date.now();
+        try {
+          await this.options.fill(dest, sizeBytes);
+        } catch (err) {
+          await fs.rm(dest, { force: true }).catch(() => undefined);
+          throw err;
+        }
+        this.refills += 1;
+        this.refillMsTotal += Date.now() - startedAt;
+        files.push(dest);
+      }
+    } catch (err) {
+      // Refills run detached from any request; a failure (including a vanished pool dir) only stops this round.
+      this.refillErrors += 1;
+      // eslint-disable-next-line no-console
+      console.warn("[overlay-pool] refill failed", { sizeBytes, err: String((err as any)?.message ?? err) });
+    } finally {
+      this.filling.delete(sizeBytes);
+    }
+  }
+}
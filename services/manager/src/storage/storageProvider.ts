@@ -3,8 +3,9 @@ import path from "node:path";
 import { createHash } from "node:crypto";
 import { execFile } from "node:child_process";
 import { promisify } from "node:util";
-import type { StorageProvider, VmStorageResult } from "../types/interfaces.js";
+import type { PersistentDiskKind, StorageProvider, StorageUsage, VmStorageResult } from "../types/interfaces.js";
 import { jailerRootDir, jailerVmDir } from "../firecracker/socketPaths.js";
+import { OverlayPool } from "./overlayPool.js";
 
 const execFileAsync = promisify(execFile);
 
@@ -13,14 +14,43 @@ export interface LocalStorageOptions {
   jailerChrootBaseDir: string;
   rootfsCloneMode?: "auto" | "reflink" | "copy";
   overlaySizeBytes?: number;
+  /** Ready-made overlay disks kept per size (0 disables the pool). */
+  overlayPoolDepth?: number;
 }
 
 export class LocalStorageProvider implements StorageProvider {
-  constructor(private readonly options: LocalStorageOptions) {}
+  private readonly overlayPool: OverlayPool | null;
+
+  constructor(private readonly options: LocalStorageOptions) {
+    const depth = options.overlayPoolDepth ?? 0;
+    this.overlayPool =
+      depth > 0
+        ? new OverlayPool({
+            dir: path.join(options.jailerChrootBaseDir, ".overlay-pool"),
+            depth,
+            fill: async (dest, sizeBytes) => {
+              await this.cloneDisk(await this.ensureOverlayTemplate(sizeBytes), dest);
+              await fs.chmod(dest, 0o666).catch(() => undefined);
+            }
+          })
+        : null;
+  }
+
+  /** Begin filling the overlay pool for the default overlay size. */
+  warmOverlayPool(): void {
+    this.overlayPool?.warm(this.options.overlaySizeBytes ?? 512 * 1024 * 1024);
+  }
 
   async prepareVmStorage(
     vmId: string,
-    input: { kernelSrcPath: string; baseRootfsPath: string; diskSizeBytes?: number }
+    input: {
+      kernelSrcPath: string;
+      baseRootfsPath: string;
+      diskSizeBytes?: number;
+      kernelSha256?: string;
+      rootfsSha256?: string;
+      persistentOverlay?: boolean;
+    }
   ): Promise<VmStorageResult> {
     const jailRoot = jailerRootDir(this.options.jailerChrootBaseDir, vmId);
     const logsDir = path.join(jailRoot, "logs");
@@ -34,16 +64,21 @@ export class LocalStorageProvider implements StorageProvider {
 
     // Overlay mode is always enabled: stage immutable image artifacts into a storage-local
     // cache so hard links to per-VM jail roots work even when IMAGES_DIR is on another fs.
-    const cachedKernelPath = await this.ensureCachedArtifact("kernel", input.kernelSrcPath);
-    const cachedRootfsPath = await this.ensureCachedArtifact("rootfs", input.baseRootfsPath);
+    const cachedKernelPath = await this.ensureCachedArtifact("kernel", input.kernelSrcPath, input.kernelSha256);
+    const cachedRootfsPath = await this.ensureCachedArtifact("rootfs", input.baseRootfsPath, input.rootfsSha256);
     await hardLinkOrCopy(cachedKernelPath, kernelPath);
     await hardLinkOrCopy(cachedRootfsPath, rootfsPath);
 
-    // Clone from a pre-formatted overlay template to avoid mkfs.ext4 on every VM create.
+    // Restarts link the VM's persistent overlay in place. New VMs take a pre-cloned overlay from
+    // the pool, or clone the pre-formatted template inline (either way no mkfs.ext4 on create).
     const overlayPath = path.join(jailRoot, "overlay.ext4");
     const overlaySizeBytes = this.options.overlaySizeBytes ?? 512 * 1024 * 1024;
-    const overlayTemplatePath = await this.ensureOverlayTemplate(overlaySizeBytes);
-    await cloneRootfs(overlayTemplatePath, overlayPath, this.options.rootfsCloneMode ?? "auto");
+    if (input.persistentOverlay) {
+      await this.linkDisk(this.persistentPath(vmId, "rootfs"), overlayPath);
+    } else if (!(await this.overlayPool?.take(overlaySizeBytes, overlayPath))) {
+      const overlayTemplatePath = await this.ensureOverlayTemplate(overlaySizeBytes);
+      await this.cloneDisk(overlayTemplatePath, overlayPath);
+    }
 
     // Firecracker runs as an unprivileged uid/gid after jailer drops privileges.
     await fs.chmod(rootfsPath, 0o444).catch(() => undefined); // Read-only for base
@@ -55,7 +90,7 @@ export class LocalStorageProvider implements StorageProvider {
 
   async prepareVmStorageFromDisk(
     vmId: string,
-    input: { kernelSrcPath: string; diskSrcPath: string; diskSizeBytes?: number }
+    input: { kernelSrcPath: string; diskSrcPath: string; diskSizeBytes?: number; kernelSha256?: string; inPlace?: boolean }
   ): Promise<VmStorageResult> {
     const jailRoot = jailerRootDir(this.options.jailerChrootBaseDir, vmId);
     const logsDir = path.join(jailRoot, "logs");
@@ -65,12 +100,17 @@ export class LocalStorageProvider implements StorageProvider {
     await fs.mkdir(runDir, { recursive: true });
 
     const kernelPath = path.join(jailRoot, "vmlinux");
-    await fs.copyFile(input.kernelSrcPath, kernelPath);
+    await hardLinkOrCopy(await this.ensureCachedArtifact("kernel", input.kernelSrcPath, input.kernelSha256), kernelPath);
+    await fs.chmod(kernelPath, 0o444).catch(() => undefined);
 
     const rootfsPath = path.join(jailRoot, "rootfs.ext4");
-    await this.cloneDisk(input.diskSrcPath, rootfsPath);
+    if (input.inPlace) {
+      await this.linkDisk(input.diskSrcPath, rootfsPath);
+    } else {
+      await this.cloneDisk(input.diskSrcPath, rootfsPath);
+    }
     if (typeof input.diskSizeBytes === "number" && Number.isFinite(input.diskSizeBytes) && input.diskSizeBytes > 0) {
-      await ensureExt4Size(rootfsPath, input.diskSizeBytes);
+      await this.growDisk(rootfsPath, input.diskSizeBytes);
     }
     await fs.chmod(rootfsPath, 0o666).catch(() => undefined);
 
@@ -84,6 +124,7 @@ export class LocalStorageProvider implements StorageProvider {
   async cleanupVmStorage(vmId: string): Promise<void> {
     // VM metadata lives under STORAGE_ROOT/<vmId>, while runtime artifacts live under the jailer chroot base.
     await fs.rm(path.join(this.options.storageRoot, vmId), { recursive: true, force: true });
+    await fs.rm(path.dirname(this.persistentDiskPath(vmId)), { recursive: true, force: true });
     await fs.rm(path.join(this.options.jailerChrootBaseDir, vmId), { recursive: true, force: true });
   }
 
@@ -100,13 +141,26 @@ export class LocalStorageProvider implements StorageProvider {
   }
 
   /**
-   * Save the VM's rootfs from the jailer directory to persistent storage.
-   * Called before jailer cleanup during stop.
+   * Make the persistent disk hold the stopped VM's final state. A disk that was linked in place
+   * on start already is the persistent disk; otherwise (first stop, cross-filesystem jail) the
+   * jail copy is moved out, so callers must not use `currentDiskPath` afterwards.
    */
-  async saveDiskToPersistent(vmId: string, currentRootfsPath: string): Promise<void> {
-    const persistPath = this.persistentDiskPath(vmId);
+  async saveDiskToPersistent(vmId: string, currentDiskPath: string, kind: PersistentDiskKind = "rootfs"): Promise<void> {
+    const persistPath = this.persistentPath(vmId, kind);
+    if (await sameFile(currentDiskPath, persistPath)) return;
     await fs.mkdir(path.dirname(persistPath), { recursive: true });
-    await this.cloneDisk(currentRootfsPath, persistPath);
+    try {
+      await fs.rename(currentDiskPath, persistPath);
+    } catch {
+      await this.cloneDisk(currentDiskPath, persistPath);
+    }
+  }
+
+  async diskSize(diskPath: string): Promise<number> {
+    const st = await fs.stat(diskPath);
+    if (!st.isBlockDevice()) return st.size;
+    const { stdout } = await execFileAsync("blockdev", ["--getsize64", diskPath]);
+    return Number(stdout.trim());
   }
 
   /**
@@ -121,17 +175,55 @@ export class LocalStorageProvider implements StorageProvider {
     }
   }
 
+  async prepareWorkspaceDisk(vmId: string, input: { sizeBytes: number; srcPath?: string; inPlace?: boolean }): Promise<string> {
+    const jailRoot = jailerRootDir(this.options.jailerChrootBaseDir, vmId);
+    await fs.mkdir(jailRoot, { recursive: true });
+    const workspacePath = path.join(jailRoot, "workspace.ext4");
+    if (input.srcPath) {
+      if (input.inPlace) {
+        await this.linkDisk(input.srcPath, workspacePath);
+      } else {
+        await this.cloneDisk(input.srcPath, workspacePath);
+      }
+      await this.growDisk(workspacePath, input.sizeBytes);
+    } else {
+      // Blank workspaces share the pre-formatted template cache with overlay disks.
+      const templatePath = await this.ensureOverlayTemplate(input.sizeBytes);
+      await this.cloneDisk(templatePath, workspacePath);
+    }
+    await fs.chmod(workspacePath, 0o666).catch(() => undefined);
+    return workspacePath;
+  }
+
+  /**
+   * Persistent copy of a VM's workspace disk, saved on stop instead of the overlay when the VM
+   * has a dedicated workspace disk.
+   */
+  persistentWorkspaceDiskPath(vmId: string): string {
+    return path.join(this.options.storageRoot, "vms", vmId, "workspace.ext4");
+  }
+
   async getSnapshotArtifactPaths(
-    snapshotId: string
-  ): Promise<{ dir: string; memPath: string; statePath: string; diskPath: string; overlayPath: string; metaPath: string }> {
+    snapshotId: string,
+    opts: { create?: boolean } = {}
+  ): Promise<{
+    dir: string;
+    memPath: string;
+    statePath: string;
+    diskPath: string;
+    overlayPath: string;
+    workspacePath: string;
+    metaPath: string;
+  }> {
     const dir = path.join(this.options.storageRoot, "snapshots", snapshotId);
-    await fs.mkdir(dir, { recursive: true });
+    if (opts.create) await fs.mkdir(dir, { recursive: true });
     return {
       dir,
       memPath: path.join(dir, "mem.snap"),
       statePath: path.join(dir, "vmstate.snap"),
       diskPath: path.join(dir, "disk.ext4"),
       overlayPath: path.join(dir, "overlay.ext4"),
+      workspacePath: path.join(dir, "workspace.ext4"),
       metaPath: path.join(dir, "meta.json")
     };
   }
@@ -156,21 +248,59 @@ export class LocalStorageProvider implements StorageProvider {
     await cloneRootfs(src, dest, this.options.rootfsCloneMode ?? "auto");
   }
 
-  private cacheRoot(): string {
+  protected persistentPath(vmId: string, kind: PersistentDiskKind): string {
+    return kind === "workspace" ? this.persistentWorkspaceDiskPath(vmId) : this.persistentDiskPath(vmId);
+  }
+
+  /**
+   * Put a VM's own persistent disk into its jail without copying: the hard link makes the running
+   * VM write the persistent disk in place. Falls back to a clone across filesystems.
+   */
+  private async linkDisk(src: string, dest: string): Promise<void> {
+    await fs.rm(dest, { force: true });
+    try {
+      await fs.link(src, dest);
+    } catch {
+      await this.cloneDisk(src, dest);
+    }
+  }
+
+  async storageUsage(): Promise<StorageUsage> {
+    return { backend: "file", ...(this.overlayPool ? { overlayPool: this.overlayPool.stats() } : {}) };
+  }
+
+  /** Grow a disk and its ext4 filesystem to `sizeBytes` (no-op when already that large). */
+  protected async growDisk(diskPath: string, sizeBytes: number): Promise<void> {
+    await ensureExt4Size(diskPath, sizeBytes);
+  }
+
+  /** Create a blank ext4 disk at `filePath` (overlay and workspace templates). */
+  protected async createBlankDisk(filePath: string, sizeBytes: number): Promise<void> {
+    await createSparseExt4(filePath, sizeBytes);
+  }
+
+  protected cacheRoot(): string {
     return path.join(this.options.storageRoot, ".cache");
   }
 
-  private async ensureCachedArtifact(kind: "kernel" | "rootfs", srcPath: string): Promise<string> {
-    const st = await fs.stat(srcPath);
-    const key = createHash("sha256")
-      .update(kind)
-      .update("\0")
-      .update(srcPath)
-      .update("\0")
-      .update(String(st.size))
-      .update("\0")
-      .update(String(Math.trunc(st.mtimeMs)))
-      .digest("hex");
+  private async ensureCachedArtifact(kind: "kernel" | "rootfs", srcPath: string, contentSha256?: string): Promise<string> {
+    // Content-addressed images share one cache entry regardless of image id or upload time;
+    // legacy images without a recorded hash fall back to a path/size/mtime key.
+    let key: string;
+    if (contentSha256 && /^[0-9a-f]{64}$/.test(contentSha256)) {
+      key = `sha256-${contentSha256}`;
+    } else {
+      const st = await fs.stat(srcPath);
+      key = createHash("sha256")
+        .update(kind)
+        .update("\0")
+        .update(srcPath)
+        .update("\0")
+        .update(String(st.size))
+        .update("\0")
+        .update(String(Math.trunc(st.mtimeMs)))
+        .digest("hex");
+    }
     const ext = path.extname(srcPath) || (kind === "kernel" ? ".bin" : ".ext4");
     const cacheDir = path.join(this.cacheRoot(), "artifacts");
     const cachedPath = path.join(cacheDir, `${kind}-${key}${ext}`);
@@ -182,11 +312,8 @@ export class LocalStorageProvider implements StorageProvider {
 
     const tempPath = `${cachedPath}.tmp-${process.pid}-${Date.now()}-${Math.random().toString(16).slice(2)}`;
     try {
-      if (kind === "rootfs") {
-        await cloneRootfs(srcPath, tempPath, this.options.rootfsCloneMode ?? "auto");
-      } else {
-        await fs.copyFile(srcPath, tempPath);
-      }
+      // Reflink when IMAGES_DIR and STORAGE_ROOT share a CoW filesystem; full copy otherwise.
+      await cloneRootfs(srcPath, tempPath, this.options.rootfsCloneMode ?? "auto");
       await fs.rename(tempPath, cachedPath);
     } catch (err: any) {
       if (err?.code !== "EEXIST") {
@@ -210,7 +337,7 @@ export class LocalStorageProvider implements StorageProvider {
 
     const tempPath = `${templatePath}.tmp-${process.pid}-${Date.now()}-${Math.random().toString(16).slice(2)}`;
     try {
-      await createSparseExt4(tempPath, sizeBytes);
+      await this.createBlankDisk(tempPath, sizeBytes);
       await fs.chmod(tempPath, 0o444).catch(() => undefined);
       await fs.rename(tempPath, templatePath);
     } catch (err: any) {
@@ -225,6 +352,11 @@ export class LocalStorageProvider implements StorageProvider {
   }
 }
 
+async function sameFile(a: string, b: string): Promise<boolean> {
+  const [sa, sb] = await Promise.all([fs.stat(a).catch(() => null), fs.stat(b).catch(() => null)]);
+  return sa !== null && sb !== null && sa.dev === sb.dev && sa.ino === sb.ino;
+}
+
 async function fileExists(filePath: string): Promise<boolean> {
   try {
     await fs.stat(filePath);
@@ -285,6 +417,11 @@ async function ensureExt4Size(diskPath: string, requestedBytes: number): Promise
   if (requestedBytes <= st.size) return;
 
   await fs.truncate(diskPath, requestedBytes);
+  await resizeExt4(diskPath);
+}
+
+/** Check the filesystem on `diskPath` and grow it to fill the underlying file or device. */
+export async function resizeExt4(diskPath: string): Promise<void> {
   // Best-effort: ensure filesystem is consistent and then grow to fill the new file size.
   // -p: automatic repair (safe defaults), -f: force check, but keep it conservative.
   await execFileAsync("e2fsck", ["-pf", diskPath]).catch(() => undefined);
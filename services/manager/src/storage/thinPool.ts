@@ -0,0 +1,372 @@
+import fs from "node:fs/promises";
+import path from "node:path";
+import { execFile } from "node:child_process";
+import { promisify } from "node:util";
+import type { ThinPoolUsage } from "../types/interfaces.js";
+
+const execFileAsync = promisify(execFile);
+
+const SECTOR_BYTES = 512;
+/** Pool allocation unit (64 KiB): small enough that CoW after a snapshot stays cheap. */
+export const THIN_BLOCK_SECTORS = 128;
+const METADATA_BLOCK_BYTES = 4096;
+const MIN_METADATA_BYTES = 64 * 1024 * 1024;
+// Kernel limit for thin-pool metadata devices.
+const MAX_METADATA_BYTES = 16 * 1024 * 1024 * 1024;
+// Volumes younger than this are never swept: their node may not be linked into a scanned tree yet.
+const SWEEP_GRACE_MS = 60_000;
+
+// The manager usually runs in a container without udev; let dmsetup manage /dev/mapper itself.
+const DM_ENV = { ...process.env, DM_DISABLE_UDEV: "1" };
+
+export interface ThinPoolOptions {
+  /** Holds the loop-backed data/metadata files and the volume registry. */
+  stateDir: string;
+  /** Prefix for device-mapper names: `<name>-pool` and `<name>-<thinId>`. */
+  name: string;
+  dataSizeBytes: number;
+  /** Owner of volume nodes: the jailer uid/gid Firecracker runs as. Nodes are created 0600. */
+  nodeOwner?: { uid: number; gid: number };
+}
+
+interface ThinVolume {
+  /** Last path a node for this volume was seen at; used to recreate the node after a host reboot. */
+  path: string;
+  sectors: number;
+  createdAt: number;
+}
+
+interface Registry {
+  nextId: number;
+  volumes: Record<string, ThinVolume>;
+}
+
+/** Fields of a `thin-pool` target status line (`dmsetup status <pool>`). */
+export function parseThinPoolStatus(line: string): {
+  usedMetadataBlocks: number;
+  totalMetadataBlocks: number;
+  usedDataBlocks: number;
+  totalDataBlocks: number;
+  mode: string;
+} | null {
+  const fields = line.trim().split(/\s+/);
+  const at = fields.indexOf("thin-pool");
+  if (at < 0 || fields[at + 1] === "Fail") return null;
+  const [usedMeta, totalMeta] = (fields[at + 2] ?? "").split("/").map(Number);
+  const [usedData, totalData] = (fields[at + 3] ?? "").split("/").map(Number);
+  const values = [usedMeta, totalMeta, usedData, totalData];
+  if (!values.every((v) => Number.isFinite(v))) return null;
+  return {
+    usedMetadataBlocks: usedMeta,
+    totalMetadataBlocks: totalMeta,
+    usedDataBlocks: usedData,
+    totalDataBlocks: totalData,
+    mode: fields[at + 5] ?? "unknown"
+  };
+}
+
+/** glibc `makedev()`, to compare `dmsetup info` numbers against `fs.Stats.rdev`. */
+export function makeDev(major: number, minor: number): number {
+  return (major & 0xfff) * 0x100 + (minor & 0xff) + (minor & 0xfff00) * 0x1000 + (major & 0xfffff000) * 0x100000000;
+}
+
+/** Metadata device size for a pool: ~0.1% of data, within the kernel's bounds. */
+export function thinMetadataBytes(dataSizeBytes: number): number {
+  const bytes = Math.min(MAX_METADATA_BYTES, Math.max(MIN_METADATA_BYTES, Math.ceil(dataSizeBytes / 1000)));
+  return Math.ceil(bytes / METADATA_BLOCK_BYTES) * METADATA_BLOCK_BYTES;
+}
+
+/**
+ * A device-mapper thin pool on two loop-backed sparse files. Volumes are handed out as block
+ * device nodes (`mknod`) at ordinary disk paths, so jail roots, persistent disks and snapshot
+ * directories keep their layout and Firecracker opens the node like any other drive.
+ *
+ * Nodes are deleted with plain `fs.rm` by code that does not know about the pool; `sweep` finds
+ * volumes no node refers to any more and deletes them. All pool mutations are serialized.
+ */
+export class ThinPool {
+  private registry: Registry = { nextId: 1, volumes: {} };
+  private readonly rdevById = new Map<number, number>();
+  private poolDev = "";
+  private queue: Promise<unknown> = Promise.resolve();
+
+  constructor(private readonly options: ThinPoolOptions) {}
+
+  /** Attach the backing files, create or reuse the pool, and reactivate registered volumes. */
+  async open(): Promise<void> {
+    await this.serialized(async () => {
+      await fs.mkdir(this.options.stateDir, { recursive: true, mode: 0o700 });
+      this.registry = await this.readRegistry();
+
+      const poolName = `${this.options.name}-pool`;
+      if (!(await dmExists(poolName))) {
+        const dataSectors =
+          Math.floor(this.options.dataSizeBytes / SECTOR_BYTES / THIN_BLOCK_SECTORS) * THIN_BLOCK_SECTORS;
+        if (dataSectors <= 0) throw new Error("thin pool data size is too small");
+        // A fresh sparse metadata file reads as zeroes, which the kernel formats on first use.
+        const metaLoop = await attachLoop(path.join(this.options.stateDir, "metadata.img"), thinMetadataBytes(this.options.dataSizeBytes));
+        const dataLoop = await attachLoop(path.join(this.options.stateDir, "data.img"), dataSectors * SECTOR_BYTES);
+        const lowWaterBlocks = Math.max(1, Math.floor(dataSectors / THIN_BLOCK_SECTORS / 10));
+        // Discards from thin volumes are passed down to the loop devices, which punch holes in data.img.
+        await dmsetup(["create", poolName, "--table", `0 ${dataSectors} thin-pool ${metaLoop} ${dataLoop} ${THIN_BLOCK_SECTORS} ${lowWaterBlocks}`]);
+      }
+      this.poolDev = await dmDevNumbers(poolName);
+
+      for (const [key, volume] of Object.entries(this.registry.volumes)) {
+        const id = Number(key);
+        try {
+          await this.activate(id, volume.sectors);
+          // Nodes left from before a host reboot carry stale device numbers.
+          const st = await fs.lstat(volume.path).catch(() => null);
+          if (st?.isBlockDevice() && st.rdev !== this.rdevFor(id)) await this.mknod(id, volume.path);
+        } catch (err) {
+          // eslint-disable-next-line no-console
+          console.warn("[thin-pool] unable to reactivate volume", { id, path: volume.path, err: String((err as any)?.message ?? err) });
+        }
+      }
+    });
+  }
+
+  /** Create an empty volume of `sizeBytes` with its node at `dest`. */
+  async createVolume(dest: string, sizeBytes: number): Promise<void> {
+    await this.serialized(async () => {
+      const id = this.allocateId();
+      const sectors = Math.ceil(sizeBytes / SECTOR_BYTES);
+      await this.poolMessage(`create_thin ${id}`);
+      await this.register(id, dest, sectors);
+    });
+  }
+
+  /** Copy a regular disk image into a new volume; zero blocks are skipped and stay unprovisioned. */
+  async importFile(src: string, dest: string): Promise<void> {
+    const { size } = await fs.stat(src);
+    await this.createVolume(dest, size);
+    await execFileAsync("dd", [`if=${src}`, `of=${dest}`, "bs=1M", "conv=sparse,notrunc,fsync", "status=none"]);
+  }
+
+  /** Constant-time copy-on-write clone of the volume behind `src` (which may be in use). */
+  async snapshot(src: string, dest: string): Promise<void> {
+    await this.serialized(async () => {
+      const originId = await this.volumeIdForPath(src);
+      if (originId === null) throw new Error(`not a thin volume: ${src}`);
+      const origin = this.registry.volumes[originId];
+      const id = this.allocateId();
+      // The origin must be suspended so in-flight writes land before the snapshot is taken.
+      await dmsetup(["suspend", this.volumeName(originId)]);
+      try {
+        await this.poolMessage(`create_snap ${id} ${originId}`);
+      } finally {
+        await dmsetup(["resume", this.volumeName(originId)]);
+      }
+      await this.register(id, dest, origin.sectors);
+    });
+  }
+
+  /** Grow the volume behind `nodePath` to at least `sizeBytes`. Returns false when it is not a volume. */
+  async grow(nodePath: string, sizeBytes: number): Promise<boolean> {
+    return this.serialized(async () => {
+      const id = await this.volumeIdForPath(nodePath);
+      if (id === null) return false;
+      const volume = this.registry.volumes[id];
+      const sectors = Math.ceil(sizeBytes / SECTOR_BYTES);
+      if (sectors <= volume.sectors) return true;
+      const name = this.volumeName(id);
+      await dmsetup(["suspend", name]);
+      try {
+        await dmsetup(["reload", name, "--table", this.thinTable(id, sectors)]);
+      } finally {
+        await dmsetup(["resume", name]);
+      }
+      volume.sectors = sectors;
+      await this.writeRegistry();
+      return true;
+    });
+  }
+
+  async isVolume(nodePath: string): Promise<boolean> {
+    return (await this.volumeIdForPath(nodePath)) !== null;
+  }
+
+  /**
+   * Delete volumes no block node under `roots` refers to. Volumes still held open (a running
+   * Firecracker) fail to deactivate and are retried on the next sweep.
+   */
+  async sweep(roots: string[]): Promise<number> {
+    return this.serialized(async () => {
+      const seen = new Map<number, string>();
+      for (const root of roots) await collectBlockNodes(root, this.options.stateDir, seen);
+
+      let removed = 0;
+      let changed = false;
+      for (const [key, volume] of Object.entries(this.registry.volumes)) {
+        const id = Number(key);
+        const rdev = this.rdevFor(id);
+        const seenAt = rdev === undefined ? undefined : seen.get(rdev);
+        if (seenAt) {
+          if (seenAt !== volume.path) {
+            volume.path = seenAt;
+            changed = true;
+          }
+          continue;
+        }
+        if (Date.now() - volume.createdAt < SWEEP_GRACE_MS) continue;
+        try {
+          await dmsetup(["remove", this.volumeName(id)]);
+        } catch {
+          continue;
+        }
+        await this.poolMessage(`delete ${id}`).catch(() => undefined);
+        delete this.registry.volumes[key];
+        this.rdevById.delete(id);
+        removed += 1;
+        changed = true;
+      }
+      if (changed) await this.writeRegistry();
+      return removed;
+    });
+  }
+
+  async usage(): Promise<ThinPoolUsage> {
+    const { stdout } = await dmsetup(["status", `${this.options.name}-pool`]);
+    const status = parseThinPoolStatus(stdout);
+    if (!status) throw new Error(`unexpected thin-pool status: ${stdout.trim()}`);
+    return {
+      dataUsedBytes: status.usedDataBlocks * THIN_BLOCK_SECTORS * SECTOR_BYTES,
+      dataTotalBytes: status.totalDataBlocks * THIN_BLOCK_SECTORS * SECTOR_BYTES,
+      metadataUsedBytes: status.usedMetadataBlocks * METADATA_BLOCK_BYTES,
+      metadataTotalBytes: status.totalMetadataBlocks * METADATA_BLOCK_BYTES,
+      mode: status.mode,
+      volumes: Object.keys(this.registry.volumes).length
+    };
+  }
+
+  private serialized<T>(fn: () => Promise<T>): Promise<T> {
+    const run = this.queue.then(fn, fn);
+    this.queue = run.catch(() => undefined);
+    return run;
+  }
+
+  private allocateId(): number {
+    // Thin device ids are 24-bit.
+    if (this.registry.nextId >= 1 << 24) throw new Error("thin pool device ids exhausted");
+    return this.registry.nextId++;
+  }
+
+  private async register(id: number, dest: string, sectors: number): Promise<void> {
+    this.registry.volumes[id] = { path: dest, sectors, createdAt: Date.now() };
+    await this.writeRegistry();
+    await this.activate(id, sectors);
+    await this.mknod(id, dest);
+  }
+
+  private async activate(id: number, sectors: number): Promise<void> {
+    const name = this.volumeName(id);
+    if (!(await dmExists(name))) {
+      await dmsetup(["create", name, "--table", this.thinTable(id, sectors)]);
+    }
+    const [major, minor] = (await dmDevNumbers(name)).split(":").map(Number);
+    this.rdevById.set(id, makeDev(major, minor));
+  }
+
+  private async mknod(id: number, dest: string): Promise<void> {
+    const rdev = this.rdevFor(id);
+    if (rdev === undefined) throw new Error(`thin volume ${id} is not active`);
+    await fs.rm(dest, { force: true });
+    const [major, minor] = (await dmDevNumbers(this.volumeName(id))).split(":");
+    // Firecracker opens drives after the jailer drops to its unprivileged uid; only that uid (and
+    // root) may open the node, not every local user.
+    await execFileAsync("mknod", ["-m", "0600", dest, "b", major, minor]);
+    const owner = this.options.nodeOwner;
+    if (owner) await fs.chown(dest, owner.uid, owner.gid);
+  }
+
+  private async volumeIdForPath(nodePath: string): Promise<number | null> {
+    const st = await fs.lstat(nodePath).catch(() => null);
+    if (!st?.isBlockDevice()) return null;
+    for (const [id, rdev] of this.rdevById) {
+      if (rdev === st.rdev) return id;
+    }
+    return null;
+  }
+
+  private rdevFor(id: number): number | undefined {
+    return this.rdevById.get(id);
+  }
+
+  private volumeName(id: number): string {
+    return `${this.options.name}-${id}`;
+  }
+
+  private thinTable(id: number, sectors: number): string {
+    return `0 ${sectors} thin ${this.poolDev} ${id}`;
+  }
+
+  private async poolMessage(message: string): Promise<void> {
+    await dmsetup(["message", `${this.options.name}-pool`, "0", message]);
+  }
+
+  private registryPath(): string {
+    return path.join(this.options.stateDir, "volumes.json");
+  }
+
+  private async readRegistry(): Promise<Registry> {
+    try {
+      const parsed = JSON.parse(await fs.readFile(this.registryPath(), "utf-8"));
+      return { nextId: Number(parsed.nextId) || 1, volumes: parsed.volumes ?? {} };
+    } catch {
+      return { nextId: 1, volumes: {} };
+    }
+  }
+
+  private async writeRegistry(): Promise<void> {
+    const tmp = `${this.registryPath()}.tmp`;
+    await fs.writeFile(tmp, JSON.stringify(this.registry), { mode: 0o600 });
+    await fs.rename(tmp, this.registryPath());
+  }
+}
+
+async function dmsetup(args: string[]): Promise<{ stdout: string }> {
+  return execFileAsync("dmsetup", args, { env: DM_ENV });
+}
+
+async function dmExists(name: string): Promise<boolean> {
+  return dmsetup(["info", name]).then(
+    () => true,
+    () => false
+  );
+}
+
+async function dmDevNumbers(name: string): Promise<string> {
+  const { stdout } = await dmsetup(["info", "-c", "--noheadings", "-o", "major,minor", "--separator", ":", name]);
+  return stdout.trim();
+}
+
+/** Attach `file` (created sparse at `sizeBytes` if missing) to a loop device, reusing an existing attachment. */
+async function attachLoop(file: string, sizeBytes: number): Promise<string> {
+  const handle = await fs.open(file, "a");
+  try {
+    if ((await handle.stat()).size < sizeBytes) await handle.truncate(sizeBytes);
+  } finally {
+    await handle.close();
+  }
+  const { stdout: existing } = await execFileAsync("losetup", ["-j", file]);
+  const attached = existing.split("\n")[0]?.split(":")[0]?.trim();
+  if (attached) return attached;
+  // Direct I/O keeps pool data out of the host page cache a second time.
+  const { stdout } = await execFileAsync("losetup", ["--find", "--show", "--direct-io=on", file]);
+  return stdout.trim();
+}
+
+async function collectBlockNodes(dir: string, skipDir: string, seen: Map<number, string>): Promise<void> {
+  if (dir === skipDir) return;
+  const entries = await fs.readdir(dir, { withFileTypes: true }).catch(() => []);
+  for (const entry of entries) {
+    const p = path.join(dir, entry.name);
+    if (entry.isDirectory()) {
+      await collectBlockNodes(p, skipDir, seen);
+    } else if (entry.isBlockDevice()) {
+      const st = await fs.lstat(p).catch(() => null);
+      if (st && !seen.has(st.rdev)) seen.set(st.rdev, p);
+    }
+  }
+}
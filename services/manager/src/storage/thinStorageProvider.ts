@@ -0,0 +1,126 @@
+import path from "node:path";
+import { execFile } from "node:child_process";
+import { promisify } from "node:util";
+import type { PersistentDiskKind, StorageUsage } from "../types/interfaces.js";
+import { LocalStorageProvider, resizeExt4, type LocalStorageOptions } from "./storageProvider.js";
+import { ThinPool } from "./thinPool.js";
+
+const execFileAsync = promisify(execFile);
+
+const MAINTENANCE_INTERVAL_MS = 60_000;
+const USAGE_WARN_PERCENT = 90;
+
+export interface ThinStorageOptions extends LocalStorageOptions {
+  thinPool: {
+    /** Device-mapper name prefix; must be unique per manager on a host. */
+    name: string;
+    dataSizeBytes: number;
+    nodeOwner?: { uid: number; gid: number };
+  };
+}
+
+/**
+ * Storage for hosts without reflink support (ext4): writable disks (overlays, workspaces,
+ * persistent and snapshot disks, legacy rootfs) are dm-thin volumes, so every clone is a
+ * constant-time thin snapshot instead of a full file copy. Read-only kernel and base rootfs
+ * artifacts stay plain files and are still hard-linked into jail roots.
+ *
+ * Regular image files met as a clone source (first use of a file-backend disk) are imported
+ * once with a sparse copy. Requires root, dmsetup/losetup, and jail roots on a filesystem
+ * mounted without `nodev`.
+ */
+export class ThinStorageProvider extends LocalStorageProvider {
+  private readonly pool: ThinPool;
+
+  constructor(private readonly thinOptions: ThinStorageOptions) {
+    super(thinOptions);
+    this.pool = new ThinPool({
+      stateDir: path.join(thinOptions.storageRoot, ".thin"),
+      name: thinOptions.thinPool.name,
+      dataSizeBytes: thinOptions.thinPool.dataSizeBytes,
+      nodeOwner: thinOptions.thinPool.nodeOwner
+    });
+  }
+
+  /** Attach the pool and reactivate its volumes; must complete before any VM storage is prepared. */
+  async init(): Promise<void> {
+    await this.pool.open();
+    await this.maintain();
+    setInterval(() => void this.maintain(), MAINTENANCE_INTERVAL_MS).unref();
+  }
+
+  override async cloneDisk(src: string, dest: string): Promise<void> {
+    if (await this.pool.isVolume(src)) {
+      await this.pool.snapshot(src, dest);
+    } else {
+      await this.pool.importFile(src, dest);
+    }
+  }
+
+  override async saveDiskToPersistent(vmId: string, currentDiskPath: string, kind: PersistentDiskKind = "rootfs"): Promise<void> {
+    await super.saveDiskToPersistent(vmId, currentDiskPath, kind);
+    // Firecracker does not forward guest discards, so blocks the guest freed are still mapped.
+    // The VM is stopped here: trim the saved disk offline to hand them back to the pool.
+    await execFileAsync("e2fsck", ["-pf", "-E", "discard", this.persistentPath(vmId, kind)]).catch(() => undefined);
+  }
+
+  override async cleanupVmStorage(vmId: string): Promise<void> {
+    await super.cleanupVmStorage(vmId);
+    await this.sweep();
+  }
+
+  override async cleanupJailerVmDir(vmId: string): Promise<void> {
+    await super.cleanupJailerVmDir(vmId);
+    await this.sweep();
+  }
+
+  override async storageUsage(): Promise<StorageUsage> {
+    return { ...(await super.storageUsage()), backend: "thin", thinPool: await this.pool.usage() };
+  }
+
+  protected override async growDisk(diskPath: string, sizeBytes: number): Promise<void> {
+    if (!(await this.pool.grow(diskPath, sizeBytes))) {
+      await super.growDisk(diskPath, sizeBytes);
+      return;
+    }
+    await resizeExt4(diskPath);
+  }
+
+  protected override async createBlankDisk(filePath: string, sizeBytes: number): Promise<void> {
+    await this.pool.createVolume(filePath, sizeBytes);
+    // Same layout as the file backend's sparse template; a fresh thin volume has nothing to discard.
+    await execFileAsync("mkfs.ext4", ["-F", "-m", "0", "-O", "^has_journal", "-E", "nodiscard", filePath]);
+  }
+
+  protected override cacheRoot(): string {
+    // Overlay templates here are thin volumes; keep them apart from file-backend templates.
+    return path.join(this.thinOptions.storageRoot, ".cache", "thin");
+  }
+
+  private async sweep(): Promise<void> {
+    const { storageRoot, jailerChrootBaseDir } = this.thinOptions;
+    const jailerInsideStorage = !path.relative(storageRoot, jailerChrootBaseDir).startsWith("..");
+    const roots = jailerInsideStorage ? [storageRoot] : [storageRoot, jailerChrootBaseDir];
+    await this.pool.sweep(roots).catch((err) => {
+      // eslint-disable-next-line no-console
+      console.warn("[thin-pool] sweep failed", { err: String((err as any)?.message ?? err) });
+    });
+  }
+
+  private async maintain(): Promise<void> {
+    await this.sweep();
+    const usage = await this.pool.usage().catch(() => null);
+    if (!usage) return;
+    const dataPercent = (usage.dataUsedBytes / Math.max(1, usage.dataTotalBytes)) * 100;
+    const metadataPercent = (usage.metadataUsedBytes / Math.max(1, usage.metadataTotalBytes)) * 100;
+    if (dataPercent >= USAGE_WARN_PERCENT || metadataPercent >= USAGE_WARN_PERCENT || usage.mode !== "rw") {
+      // Once full, the pool queues and then fails guest writes; delete unused VMs or snapshots.
+      // eslint-disable-next-line no-console
+      console.warn("[thin-pool] pool nearly full", {
+        dataPercent: Math.round(dataPercent),
+        metadataPercent: Math.round(metadataPercent),
+        mode: usage.mode
+      });
+    }
+  }
+}
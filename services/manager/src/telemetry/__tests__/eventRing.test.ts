@@ -0,0 +1,100 @@
+import { describe, expect, it } from "vitest";
+import { EventRing, SseConnection, type SseSink } from "../eventRing.js";
+
+/** Socket stand-in whose buffer only empties when the test says so. */
+class FakeSink implements SseSink {
+  chunks: string[] = [];
+  writableLength = 0;
+  destroyed = false;
+  private readonly handlers = { drain: [] as Array<() => void>, close: [] as Array<() => void> };
+
+  constructor(private readonly highWaterMark: number) {}
+
+  write(chunk: string): boolean {
+    this.chunks.push(chunk);
+    this.writableLength += Buffer.byteLength(chunk);
+    return this.writableLength < this.highWaterMark;
+  }
+
+  on(event: "drain" | "close", listener: () => void) {
+    this.handlers[event].push(listener);
+    return this;
+  }
+
+  drain(): void {
+    this.writableLength = 0;
+    for (const h of this.handlers.drain) h();
+  }
+
+  close(): void {
+    this.destroyed = true;
+    for (const h of this.handlers.close) h();
+  }
+
+  events(): string[] {
+    return this.chunks.flatMap((c) => /^event: (\w+)/m.exec(c)?.[1] ?? []);
+  }
+
+  ids(): string[] {
+    return this.chunks.flatMap((c) => /^id: (\S+)/m.exec(c)?.[1] ?? []);
+  }
+}
+
+describe("EventRing", () => {
+  it("bounds retained events by count and bytes", () => {
+    const ring = new EventRing({ capacity: 3, maxBytes: 1024 * 1024 });
+    for (let i = 1; i <= 5; i += 1) ring.push("activity", { i });
+    expect([ring.firstSeq, ring.lastSeq]).toEqual([3, 5]);
+    expect(ring.frame(2)).toBeNull();
+    expect(ring.frame(4)).toContain('"i":4');
+
+    const small = new EventRing({ capacity: 100, maxBytes: 200 });
+    for (let i = 0; i < 10; i += 1) small.push("activity", { pad: "x".repeat(50) });
+    expect(small.lastSeq - small.firstSeq + 1).toBeLessThan(3);
+  });
+
+  it("resumes after Last-Event-ID and replays everything for ids from another process", () => {
+    const ring = new EventRing({ capacity: 10, maxBytes: 1024 * 1024 });
+    for (let i = 1; i <= 4; i += 1) ring.push("activity", { i });
+    expect(ring.cursorFor(undefined)).toBe(4);
+    expect(ring.cursorFor(`${ring.epoch}-2`)).toBe(2);
+    expect(ring.cursorFor("0-2")).toBe(0);
+    expect(ring.cursorFor("garbage")).toBe(4);
+  });
+});
+
+describe("SseConnection", () => {
+  it("stops writing at the buffer cap and continues from its cursor on drain", () => {
+    const ring = new EventRing({ capacity: 100, maxBytes: 1024 * 1024 });
+    const sink = new FakeSink(1);
+    new SseConnection(ring, sink, { maxBufferedBytes: 1 });
+    ring.push("activity", { i: 1 });
+    ring.push("activity", { i: 2 });
+    ring.push("activity", { i: 3 });
+    expect(sink.ids()).toEqual([`${ring.epoch}-1`]);
+
+    sink.drain();
+    sink.drain();
+    expect(sink.ids()).toEqual([1, 2, 3].map((n) => `${ring.epoch}-${n}`));
+  });
+
+  it("replays missed events on reconnect and reports events lost to eviction", () => {
+    const ring = new EventRing({ capacity: 2, maxBytes: 1024 * 1024 });
+    for (let i = 1; i <= 5; i += 1) ring.push("activity", { i });
+
+    const resumed = new FakeSink(1024 * 1024);
+    new SseConnection(ring, resumed, { maxBufferedBytes: 1024 * 1024, lastEventId: `${ring.epoch}-1` });
+    expect(resumed.events()).toEqual(["resync", "activity", "activity"]);
+    expect(resumed.chunks[0]).toContain('"dropped":2');
+    expect(resumed.ids()).toEqual([`${ring.epoch}-4`, `${ring.epoch}-5`]);
+  });
+
+  it("stops following the ring once the socket closes", () => {
+    const ring = new EventRing({ capacity: 10, maxBytes: 1024 * 1024 });
+    const sink = new FakeSink(1024 * 1024);
+    new SseConnection(ring, sink, { maxBufferedBytes: 1024 * 1024 });
+    sink.close();
+    ring.push("activity", { i: 1 });
+    expect(sink.chunks).toEqual([]);
+  });
+});
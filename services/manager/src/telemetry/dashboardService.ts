@@ -1,4 +1,4 @@
-import type { StorageProvider, VmStore } from "../types/interfaces.js";
+import type { SnapshotCatalog, VmStore } from "../types/interfaces.js";
 import { getCpuCapacityCores, getCpuUsagePct, getFsBytes, getMemoryBytes } from "./systemStats.js";
 
 export interface DashboardOverview {
@@ -25,7 +25,7 @@ export interface DashboardOverview {
 export class DashboardService {
   constructor(
     private readonly store: VmStore,
-    private readonly storageProvider: StorageProvider,
+    private readonly snapshots: Pick<SnapshotCatalog, "counts">,
     private readonly storageRoot: string
   ) {}
 
@@ -38,7 +38,7 @@ export class DashboardService {
       getCpuUsagePct(500),
       getMemoryBytes(),
       getFsBytes(this.storageRoot),
-      this.getSnapshotCounts()
+      this.snapshots.counts()
     ]);
 
     const memUsed = mem ? Math.max(0, mem.total - mem.available) : null;
@@ -65,18 +65,5 @@ export class DashboardService {
       }
     };
   }
-
-  private async getSnapshotCounts(): Promise<{ snapshots: number; templates: number }> {
-    const ids = await this.storageProvider.listSnapshots();
-    const metas = await Promise.all(ids.map((id) => this.storageProvider.readSnapshotMeta(id)));
-    let snapshots = 0;
-    let templates = 0;
-    for (const m of metas) {
-      if (!m) continue;
-      if (m.kind === "template") templates += 1;
-      else snapshots += 1;
-    }
-    return { snapshots, templates };
-  }
 }
 
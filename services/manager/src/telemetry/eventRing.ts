@@ -0,0 +1,125 @@
+export interface EventRingOptions {
+  /** Events retained for replay and for subscribers that fell behind. */
+  capacity: number;
+  /** Upper bound on retained frame bytes; the oldest events go first. */
+  maxBytes: number;
+}
+
+interface RingEntry {
+  seq: number;
+  /** Complete SSE frame, serialized once and shared by every connection. */
+  frame: string;
+}
+
+/**
+ * Bounded, shared history of server-sent events. Every event gets a sequence number; each
+ * connection only keeps a cursor into the ring, so memory is bounded by the ring plus each
+ * socket's write buffer cap, however many dashboards are open or how slow they read.
+ */
+export class EventRing {
+  /** Distinguishes sequence numbers of this process from ones a client saw before a restart. */
+  readonly epoch = Date.now().toString(36);
+  private readonly entries: RingEntry[] = [];
+  private readonly listeners = new Set<() => void>();
+  private bytes = 0;
+  private seq = 0;
+
+  constructor(private readonly options: EventRingOptions) {}
+
+  get lastSeq(): number {
+    return this.seq;
+  }
+
+  /** Oldest retained sequence number (lastSeq + 1 when empty). */
+  get firstSeq(): number {
+    return this.entries[0]?.seq ?? this.seq + 1;
+  }
+
+  push(event: string, data: unknown): number {
+    this.seq += 1;
+    const frame = `id: ${this.epoch}-${this.seq}\nevent: ${event}\ndata: ${JSON.stringify(data)}\n\n`;
+    this.entries.push({ seq: this.seq, frame });
+    this.bytes += Buffer.byteLength(frame);
+    while (this.entries.length > 1 && (this.entries.length > this.options.capacity || this.bytes > this.options.maxBytes)) {
+      this.bytes -= Buffer.byteLength(this.entries.shift()!.frame);
+    }
+    for (const listener of this.listeners) listener();
+    return this.seq;
+  }
+
+  /** Frame of event `seq`, or null once it has been evicted (or does not exist yet). */
+  frame(seq: number): string | null {
+    const entry = this.entries[seq - this.firstSeq];
+    return entry?.seq === seq ? entry.frame : null;
+  }
+
+  onPush(listener: () => void): () => void {
+    this.listeners.add(listener);
+    return () => {
+      this.listeners.delete(listener);
+    };
+  }
+
+  /**
+   * Cursor (last delivered seq) for a new connection. A `Last-Event-ID` from this process
+   * resumes after that event; one from an earlier process replays everything retained, since
+   * all of it is newer than what the client saw. Without an id the client only gets new events.
+   */
+  cursorFor(lastEventId: string | undefined): number {
+    const match = /^([0-9a-z]+)-(\d+)$/.exec(String(lastEventId ?? "").trim());
+    if (!match) return this.seq;
+    if (match[1] !== this.epoch) return this.firstSeq - 1;
+    return Math.min(Number(match[2]), this.seq);
+  }
+}
+
+/** The parts of a Node ServerResponse (or any Writable) an SSE connection needs. */
+export interface SseSink {
+  write(chunk: string): boolean;
+  readonly writableLength: number;
+  readonly destroyed: boolean;
+  on(event: "drain" | "close", listener: () => void): unknown;
+}
+
+/**
+ * One SSE client reading from an EventRing. Writes only while the socket buffers less than
+ * `maxBufferedBytes`; the rest waits in the ring until the socket drains. A client that falls
+ * behind the ring loses the evicted events and gets a `resync` event with the count instead.
+ */
+export class SseConnection {
+  private cursor: number;
+  private readonly unsubscribe: () => void;
+
+  constructor(
+    private readonly ring: EventRing,
+    private readonly sink: SseSink,
+    private readonly options: { maxBufferedBytes: number; lastEventId?: string }
+  ) {
+    this.cursor = ring.cursorFor(options.lastEventId);
+    this.unsubscribe = ring.onPush(() => this.pump());
+    sink.on("drain", () => this.pump());
+    sink.on("close", () => this.unsubscribe());
+    this.pump();
+  }
+
+  /** Write a comment (connect banner, heartbeat) unless the socket is already backed up. */
+  comment(text: string): void {
+    if (this.sink.destroyed || this.sink.writableLength >= this.options.maxBufferedBytes) return;
+    this.sink.write(`: ${text}\n\n`);
+  }
+
+  private pump(): void {
+    while (!this.sink.destroyed && this.cursor < this.ring.lastSeq && this.sink.writableLength < this.options.maxBufferedBytes) {
+      const dropped = this.ring.firstSeq - 1 - this.cursor;
+      if (dropped > 0) {
+        this.cursor = this.ring.firstSeq - 1;
+        if (!this.sink.write(`event: resync\ndata: ${JSON.stringify({ dropped })}\n\n`)) return;
+        continue;
+      }
+      const frame = this.ring.frame(this.cursor + 1);
+      if (frame === null) return;
+      this.cursor += 1;
+      if (!this.sink.write(frame)) return;
+    }
+  }
+}
@@ -3,6 +3,7 @@ import type { VmService } from "../services/vmService.js";
 import type { ActivityService } from "../telemetry/activityService.js";
 import type { ApiKeyService } from "../apiKey/apiKeyService.js";
 import type { ImageService } from "../services/imageService.js";
+import type { ImageUploadService } from "../services/imageUploadService.js";
 import type { PeerService } from "../services/peer/peerService.js";
 import type { WebhookService } from "../services/webhookService.js";
 import type { VmPeerLinkStore } from "./interfaces.js";
@@ -15,6 +16,7 @@ export interface AppDeps {
   storage: StorageProvider;
   storageRoot: string;
   images: ImageService;
+  imageUploads?: ImageUploadService;
   vmService: VmService;
   vmPeerLinks?: VmPeerLinkStore;
   peerService?: PeerService;
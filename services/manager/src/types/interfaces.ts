@@ -1,4 +1,21 @@
-import type { VmCreateRequest, VmExecRequest, VmPeerLink, VmPeerSourceMode, VmRecord, VmRunJsRequest, VmRunTsRequest } from "./vm.js";
+import type {
+  HugePageUsage,
+  VmCreateRequest,
+  VmExecRequest,
+  VmGuestResetResult,
+  VmGuestStats,
+  VmIoStats,
+  VmIoTier,
+  VmPeerLink,
+  VmPeerSourceMode,
+  VmRawFileReadResult,
+  VmRawFileWriteResult,
+  VmRecord,
+  VmRunJsRequest,
+  VmRunTsRequest,
+  VmSnapshotPrepareResult,
+  VmWorkspaceCheckpoint
+} from "./vm.js";
 
 export interface VmStore {
   create(vm: VmRecord): Promise<void>;
@@ -29,6 +46,24 @@ export interface FirecrackerManager {
   createSnapshot(vm: VmRecord, snapshot: { memPath: string; statePath: string }): Promise<void>;
   stop(vm: VmRecord): Promise<void>;
   destroy(vm: VmRecord): Promise<void>;
+  /** Move a running VM's jail and process handle to a new id (used when recycling into the warm pool). */
+  rekey(vm: VmRecord, newId: string): Promise<void>;
+  /** Empty a running VM's console, Firecracker log and metrics files (used when recycling into the warm pool). */
+  resetLogs(vm: VmRecord): Promise<void>;
+  /** Replace the rate limiters of a running VM's drives and network interface. */
+  updateIoTier(vm: VmRecord, tier: VmIoTier): Promise<void>;
+  /** Cumulative block/net counters (including throttling) from the VM's Firecracker metrics file. */
+  readIoMetrics(vm: VmRecord): Promise<Omit<VmIoStats, "tier">>;
+  /** Host hugepage pool counters and the pages held by hugepage-backed VMs. */
+  hugePageUsage(): HugePageUsage;
+  /** Page size (KiB) a started VM's memory is mapped with: 2048 when it holds hugepages, else 4. */
+  memoryPageSizeKb(vmId: string): number;
+  /** Ids of jails with a live Firecracker process, including ones started by an earlier manager. */
+  discover(): Promise<string[]>;
+  /** Take over a VM whose Firecracker process outlived the previous manager; false if it cannot be. */
+  adopt(vm: VmRecord): Promise<boolean>;
+  /** Kill a Firecracker process without a guest shutdown (unadoptable or orphaned VMs). */
+  terminate(vmId: string, options?: { removeJail?: boolean }): Promise<void>;
 }
 
 export interface NetworkManager {
@@ -46,12 +81,21 @@ export interface AgentClient {
     payload: { ip: string; gateway: string; cidr?: number; mac?: string; iface?: string; dns?: string; dnsOnly?: boolean }
   ): Promise<void>;
   syncTime(vmId: string, payload: { unixTimeMs: number }): Promise<void>;
-  exec(vmId: string, payload: VmExecRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown }>;
-  runTs(vmId: string, payload: VmRunTsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown }>;
-  runJs(vmId: string, payload: VmRunJsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown }>;
+  seedEntropy(vmId: string, payload: { seedHex: string }): Promise<void>;
+  exec(vmId: string, payload: VmExecRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown; memoryPressureKilled?: boolean }>;
+  runTs(vmId: string, payload: VmRunTsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown; memoryPressureKilled?: boolean }>;
+  runJs(vmId: string, payload: VmRunJsRequest): Promise<{ exitCode: number; stdout: string; stderr: string; result?: unknown; error?: unknown; memoryPressureKilled?: boolean }>;
   upload(vmId: string, dest: string, data: Buffer): Promise<void>;
   download(vmId: string, path: string): Promise<Buffer>;
   replaceTree(vmId: string, dest: string, data: Buffer, options?: { ownership?: "root" | "user"; readOnly?: boolean }): Promise<void>;
+  readRawFile(vmId: string, path: string, options?: { range?: string; ifMatch?: string }): Promise<VmRawFileReadResult>;
+  writeRawFile(vmId: string, path: string, data: Buffer, options?: { ifMatch?: string }): Promise<VmRawFileWriteResult>;
+  prepareForSnapshot(vmId: string): Promise<VmSnapshotPrepareResult>;
+  resetGuestForRecycle(vmId: string): Promise<VmGuestResetResult>;
+  guestStats(vmId: string): Promise<VmGuestStats>;
+  listCheckpoints(vmId: string): Promise<VmWorkspaceCheckpoint[]>;
+  createCheckpoint(vmId: string, payload: { label?: string }): Promise<VmWorkspaceCheckpoint>;
+  rollbackCheckpoint(vmId: string, checkpointId: string): Promise<VmWorkspaceCheckpoint>;
 }
 
 export interface VmStorageResult {
@@ -61,30 +105,129 @@ export interface VmStorageResult {
   kernelPath: string;
 }
 
+export interface ThinPoolUsage {
+  dataUsedBytes: number;
+  dataTotalBytes: number;
+  metadataUsedBytes: number;
+  metadataTotalBytes: number;
+  /** Pool mode from device-mapper: `rw`, `ro` or `out_of_data_space`. */
+  mode: string;
+  volumes: number;
+}
+
+export interface OverlayPoolStats {
+  /** Target number of ready disks per size. */
+  depth: number;
+  /** Ready disks by overlay size in bytes. */
+  ready: Record<string, number>;
+  /** Creates served from the pool vs. cloned inline. */
+  hits: number;
+  misses: number;
+  /** Background clones completed/failed since manager start and their mean duration. */
+  refills: number;
+  refillErrors: number;
+  avgRefillMs: number;
+}
+
+export interface StorageUsage {
+  backend: "file" | "thin";
+  /** Present for the dm-thin backend. */
+  thinPool?: ThinPoolUsage;
+  /** Present when OVERLAY_POOL_DEPTH > 0. */
+  overlayPool?: OverlayPoolStats;
+}
+
+/** The overlay (or legacy rootfs) disk, or the dedicated workspace disk. */
+export type PersistentDiskKind = "rootfs" | "workspace";
+
 export interface StorageProvider {
   prepareVmStorage(
     vmId: string,
-    input: { kernelSrcPath: string; baseRootfsPath: string; diskSizeBytes?: number }
+    input: {
+      kernelSrcPath: string;
+      baseRootfsPath: string;
+      diskSizeBytes?: number;
+      kernelSha256?: string;
+      rootfsSha256?: string;
+      /** Restart: use the VM's persistent disk as the overlay, linked in place rather than copied. */
+      persistentOverlay?: boolean;
+    }
   ): Promise<VmStorageResult>;
   prepareVmStorageFromDisk(
     vmId: string,
-    input: { kernelSrcPath: string; diskSrcPath: string; diskSizeBytes?: number }
+    /** `inPlace`: `diskSrcPath` is this VM's persistent disk; link it into the jail instead of cloning. */
+    input: { kernelSrcPath: string; diskSrcPath: string; diskSizeBytes?: number; kernelSha256?: string; inPlace?: boolean }
   ): Promise<VmStorageResult>;
   cleanupVmStorage(vmId: string): Promise<void>;
   /** Remove the jailer runtime directory for a VM (but keep persistent storage under STORAGE_ROOT). */
   cleanupJailerVmDir(vmId: string): Promise<void>;
+  /** Artifact paths of a snapshot; `create` also makes its directory (writers only). */
   getSnapshotArtifactPaths(
-    snapshotId: string
-  ): Promise<{ dir: string; memPath: string; statePath: string; diskPath: string; overlayPath: string; metaPath: string }>;
+    snapshotId: string,
+    opts?: { create?: boolean }
+  ): Promise<{
+    dir: string;
+    memPath: string;
+    statePath: string;
+    diskPath: string;
+    overlayPath: string;
+    workspacePath: string;
+    metaPath: string;
+  }>;
   cloneDisk(src: string, dest: string): Promise<void>;
+  /** Snapshot directories on disk; only the catalog reconciler should need this scan. */
   listSnapshots(): Promise<string[]>;
   readSnapshotMeta(snapshotId: string): Promise<import("./snapshot.js").SnapshotMeta | null>;
   /** Get the persistent disk path for a VM that survives jailer cleanup. */
   persistentDiskPath(vmId: string): string;
-  /** Save the VM's rootfs to persistent storage (called before stop). */
-  saveDiskToPersistent(vmId: string, currentRootfsPath: string): Promise<void>;
+  /**
+   * After stop, before jailer cleanup: make the persistent disk hold the VM's final state. Moves
+   * (or, when it was linked in place on start, leaves) the disk rather than copying it.
+   */
+  saveDiskToPersistent(vmId: string, currentDiskPath: string, kind?: PersistentDiskKind): Promise<void>;
   /** Check if a persistent disk exists for a VM. */
   hasPersistentDisk(vmId: string): Promise<boolean>;
+  /** Size in bytes of a disk image or volume node (`stat` reports 0 for block devices). */
+  diskSize(diskPath: string): Promise<number>;
+  /**
+   * Create the VM's workspace disk in its jail root: a clone of `srcPath` (grown to `sizeBytes`)
+   * or, without a source, a blank ext4 volume. Returns the jail-local path.
+   */
+  prepareWorkspaceDisk(vmId: string, input: { sizeBytes: number; srcPath?: string; inPlace?: boolean }): Promise<string>;
+  /** Get the persistent workspace disk path for a VM that survives jailer cleanup. */
+  persistentWorkspaceDiskPath(vmId: string): string;
+  /** Storage backend in use and, for dm-thin, pool occupancy. */
+  storageUsage(): Promise<StorageUsage>;
+}
+
+export interface SnapshotListQuery {
+  /** "user": user_overlay/vm snapshots; "internal": seeds, templates and internal snapshots. */
+  scope?: "user" | "internal" | "all";
+  kind?: import("./snapshot.js").SnapshotKind;
+  imageId?: string;
+  /** Page size; omitted returns every match. */
+  limit?: number;
+  /** `nextCursor` of the previous page. */
+  cursor?: string;
+}
+
+export interface SnapshotPage {
+  /** Newest first. */
+  items: import("./snapshot.js").SnapshotMeta[];
+  nextCursor: string | null;
+}
+
+/**
+ * Indexed copy of every snapshot's meta.json. Artifacts stay on disk; this is what listings,
+ * lookups and counts read. Rows are written after the artifacts and removed before them.
+ */
+export interface SnapshotCatalog {
+  put(meta: import("./snapshot.js").SnapshotMeta): Promise<void>;
+  get(snapshotId: string): Promise<import("./snapshot.js").SnapshotMeta | null>;
+  delete(snapshotId: string): Promise<void>;
+  list(query?: SnapshotListQuery): Promise<SnapshotPage>;
+  ids(): Promise<string[]>;
+  counts(): Promise<{ snapshots: number; templates: number }>;
 }
 
 export interface Reconciler {
@@ -13,5 +13,9 @@ export interface SnapshotMeta {
   sourceVmId?: string;
   hasDisk: boolean;
   hasOverlay?: boolean; // true if snapshot includes overlay disk (overlayfs mode)
+  hasWorkspace?: boolean; // true if snapshot holds a workspace disk instead of the overlay
+  workspaceDiskMb?: number;
   internal?: boolean;
+  /** Image kernel/rootfs sha256 pair a seed was built from; seeds of re-uploaded images are stale. */
+  imageContentKey?: string;
 }
@@ -8,6 +8,8 @@ export type VmState =
   | "ERROR";
 
 export type VmProvisionMode = "boot" | "snapshot";
+/** Disk and network bandwidth/ops budget enforced by Firecracker rate limiters. */
+export type VmIoTier = "unlimited" | "small" | "standard" | "large";
 export type VmPeerSourceMode = "hidden" | "mounted";
 
 export interface VmPeerLink {
@@ -29,6 +31,13 @@ export interface VmRecord {
   imageId?: string;
   rootfsPath: string;
   overlayPath?: string | null; // Path to overlay disk when using overlayfs mode
+  workspaceDiskPath?: string | null; // Path to the dedicated /home/user disk, when requested
+  workspaceDiskMb?: number;
+  ioTier?: VmIoTier;
+  /** Back guest memory with 2 MiB hugepages when the host pool has room (4 KiB pages otherwise). */
+  hugePages?: boolean;
+  /** Page size guest memory was actually mapped with on the last start: 2048 with hugepages, else 4. */
+  memoryPageSizeKb?: number;
   kernelPath: string;
   logsDir: string;
   createdAt: string;
@@ -50,6 +59,11 @@ export interface VmPublic {
   provisionMode?: VmProvisionMode;
   imageId?: string;
   peerLinks?: VmPeerLink[];
+  workspaceDiskMb?: number;
+  ioTier?: VmIoTier;
+  hugePages?: boolean;
+  /** Effective guest page size in KiB; 4 when a hugepage VM fell back to regular pages. */
+  memoryPageSizeKb?: number;
 }
 
 export interface VmCreateRequest {
@@ -62,6 +76,18 @@ export interface VmCreateRequest {
   snapshotId?: string;
   imageId?: string;
   diskSizeMb?: number;
+  /**
+   * Size of a dedicated workspace disk mounted at /home/user. When set, snapshots and stop/start
+   * persist only this disk and the root overlay is recreated from the image on every boot.
+   */
+  workspaceDiskMb?: number;
+  /** Rate-limit tier for disks and network; defaults to DEFAULT_IO_TIER. */
+  ioTier?: VmIoTier;
+  /**
+   * Back guest memory with 2 MiB hugepages; defaults to GUEST_HUGE_PAGES. Such VMs always cold boot
+   * and fall back to 4 KiB pages when the host pool is exhausted.
+   */
+  hugePages?: boolean;
   secretEnv?: string[];
   peerLinks?: VmPeerLink[];
 }
@@ -99,3 +125,99 @@ export interface VmRunJsRequest {
    */
   env?: string[];
 }
+
+export interface VmRawFileReadResult {
+  /** 200 for the whole file, 206 for a byte range. */
+  statusCode: 200 | 206;
+  data: Buffer;
+  /** sha256 of the whole file (hex), usable with If-Match. */
+  sha256: string;
+  contentRange?: string;
+}
+
+export interface VmRawFileWriteResult {
+  path: string;
+  size: number;
+  sha256: string;
+}
+
+export interface VmSnapshotPrepareResult {
+  durationMs: number;
+  memFreeKbBefore: number;
+  memFreeKbAfter: number;
+  /** Free memory overwritten with zeros so mem.snap stores it as holes. */
+  zeroedBytes: number;
+  warnings: string[];
+}
+
+export interface VmWorkspaceCheckpoint {
+  id: string;
+  createdAt: string;
+  label?: string;
+}
+
+export interface VmGuestStats {
+  uptimeSec: number;
+  memory: {
+    memTotalKb: number;
+    memAvailableKb: number;
+    swapTotalKb: number;
+    swapFreeKb: number;
+    /** Pages swapped in/out since guest boot. */
+    swapInPages: number;
+    swapOutPages: number;
+    /** Present when guest swap is backed by zram (see GUEST_ZRAM_PERCENT). */
+    zram?: {
+      diskSizeBytes: number;
+      origDataBytes: number;
+      comprDataBytes: number;
+      memUsedBytes: number;
+    };
+  };
+}
+
+export interface VmIoDeviceStats {
+  readBytes: number;
+  writeBytes: number;
+  readOps: number;
+  writeOps: number;
+  /** Requests delayed because the drive's token bucket was empty. */
+  throttledEvents: number;
+}
+
+export interface VmIoStats {
+  tier: VmIoTier;
+  /** Keyed by drive id (rootfs, overlay, workspace); `all` on Firecracker builds without per-drive metrics. */
+  drives: Record<string, VmIoDeviceStats>;
+  net: {
+    rxBytes: number;
+    txBytes: number;
+    /** Packets delayed because the interface's token bucket was empty. */
+    rxThrottled: number;
+    txThrottled: number;
+  };
+}
+
+export interface HugePageUsage {
+  pageSizeKb: number;
+  /** Host-wide counters from sysfs. */
+  totalPages: number;
+  freePages: number;
+  reservedPages: number;
+  /** Pages a new hugepage VM can still claim. */
+  availablePages: number;
+  /** Pages held per running VM id. */
+  vms: Record<string, number>;
+  /** Hugepage VMs started on 4 KiB pages because the pool was short, since manager start. */
+  fallbacks: number;
+}
+
+export interface VmGuestResetResult {
+  durationMs: number;
+  killedProcesses: number;
+  /** Overlay entries created by the tenant that were deleted. */
+  removedPaths: number;
+  /** Overlay entries copied back from the image. */
+  restoredPaths: number;
+  memory: VmSnapshotPrepareResult;
+}
@@ -0,0 +1,46 @@
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { copySparse, SPARSE_PAGE_BYTES } from "../sparseFile.js";
+
+const tempDirs: string[] = [];
+
+afterEach(() => {
+  for (const dir of tempDirs.splice(0)) fs.rmSync(dir, { recursive: true, force: true });
+});
+
+describe("copySparse", () => {
+  it("preserves content while skipping zero pages", async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), "sparse-"));
+    tempDirs.push(dir);
+    const src = path.join(dir, "mem.snap");
+    const dest = path.join(dir, "out.snap");
+
+    // 8 pages: data, zero, zero, data (partially), zero..., trailing partial data page.
+    const content = Buffer.alloc(SPARSE_PAGE_BYTES * 7 + 100);
+    content.fill(0xab, 0, SPARSE_PAGE_BYTES);
+    content[SPARSE_PAGE_BYTES * 3 + 17] = 1;
+    content.fill(0xcd, SPARSE_PAGE_BYTES * 7);
+    fs.writeFileSync(src, content);
+
+    const result = await copySparse(src, dest);
+
+    expect(result.sizeBytes).toBe(content.length);
+    expect(result.dataBytes).toBe(SPARSE_PAGE_BYTES * 2 + 100);
+    expect(fs.readFileSync(dest).equals(content)).toBe(true);
+  });
+
+  it("can rewrite a file in place", async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), "sparse-"));
+    tempDirs.push(dir);
+    const file = path.join(dir, "mem.snap");
+    fs.writeFileSync(file, Buffer.alloc(SPARSE_PAGE_BYTES * 4));
+
+    const result = await copySparse(file, file);
+
+    expect(result.dataBytes).toBe(0);
+    expect(fs.statSync(file).size).toBe(SPARSE_PAGE_BYTES * 4);
+    expect(fs.readdirSync(dir)).toEqual(["mem.snap"]);
+  });
+});
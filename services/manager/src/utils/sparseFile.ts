@@ -0,0 +1,80 @@
+import fs from "node:fs/promises";
+import type { FileHandle } from "node:fs/promises";
+import { randomUUID } from "node:crypto";
+
+/** Guest memory is scanned at page granularity; only whole zero pages become holes. */
+export const SPARSE_PAGE_BYTES = 4096;
+const SCAN_CHUNK_BYTES = 4 * 1024 * 1024;
+const ZERO_CHUNK = Buffer.alloc(SCAN_CHUNK_BYTES);
+
+export type SparseCopyResult = {
+  /** Logical file size (unchanged by the copy). */
+  sizeBytes: number;
+  /** Bytes actually written, i.e. non-zero pages. */
+  dataBytes: number;
+};
+
+/**
+ * Copy `src` to `dest`, skipping all-zero pages so they become holes in `dest`.
+ *
+ * Firecracker `Full` snapshots write every guest page, including never-touched ones; a restore
+ * mmaps the file, so holes read back as zero pages without disk or page-cache cost.
+ * `src` and `dest` may be the same path (the file is rewritten via a sibling temp + rename).
+ */
+export async function copySparse(src: string, dest: string): Promise<SparseCopyResult> {
+  const tmp = `${dest}.sparse-${randomUUID()}.tmp`;
+  const input = await fs.open(src, "r");
+  let output: FileHandle | null = null;
+  try {
+    output = await fs.open(tmp, "wx", 0o644);
+    const sizeBytes = (await input.stat()).size;
+    const buf = Buffer.allocUnsafe(SCAN_CHUNK_BYTES);
+    let position = 0;
+    let dataBytes = 0;
+    while (position < sizeBytes) {
+      const { bytesRead } = await input.read(buf, 0, buf.length, position);
+      if (bytesRead === 0) break;
+      // Buffer.equals is a memcmp, so whole-chunk and per-page zero checks stay vectorised.
+      if (!isZero(buf, 0, bytesRead)) {
+        let runStart = -1;
+        for (let off = 0; off < bytesRead; off += SPARSE_PAGE_BYTES) {
+          const end = Math.min(off + SPARSE_PAGE_BYTES, bytesRead);
+          const zero = isZero(buf, off, end);
+          if (!zero && runStart < 0) runStart = off;
+          if (zero && runStart >= 0) {
+            await output.write(buf, runStart, off - runStart, position + runStart);
+            dataBytes += off - runStart;
+            runStart = -1;
+          }
+        }
+        if (runStart >= 0) {
+          await output.write(buf, runStart, bytesRead - runStart, position + runStart);
+          dataBytes += bytesRead - runStart;
+        }
+      }
+      position += bytesRead;
+    }
+    // Extends the file over any trailing zero pages without allocating them.
+    await output.truncate(sizeBytes);
+    await output.close();
+    output = null;
+    await fs.rename(tmp, dest);
+    return { sizeBytes, dataBytes };
+  } catch (err) {
+    await output?.close().catch(() => undefined);
+    await fs.rm(tmp, { force: true }).catch(() => undefined);
+    throw err;
+  } finally {
+    await input.close().catch(() => undefined);
+  }
+}
+
+/** Bytes a file actually occupies on disk (holes excluded). */
+export async function allocatedBytes(filePath: string): Promise<number> {
+  const st = await fs.stat(filePath);
+  return st.blocks ? st.blocks * 512 : st.size;
+}
+
+function isZero(buf: Buffer, start: number, end: number): boolean {
+  return buf.subarray(start, end).equals(ZERO_CHUNK.subarray(0, end - start));
+}
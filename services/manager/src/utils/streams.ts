@@ -1,5 +1,6 @@
 import type { Readable } from "node:stream";
 import fs from "node:fs";
+import { createHash } from "node:crypto";
 import { pipeline } from "node:stream/promises";
 
 export class BodyTooLargeError extends Error {
@@ -44,15 +45,23 @@ export async function readStreamToBuffer(stream: Readable | Buffer | Uint8Array,
   return Buffer.concat(chunks, bufferedTotal);
 }
 
-export async function writeStreamToFile(stream: Readable, destPath: string, maxBytes: number): Promise<{ bytesWritten: number }> {
+export async function writeStreamToFile(
+  stream: Readable,
+  destPath: string,
+  maxBytes: number
+): Promise<{ bytesWritten: number; sha256: string }> {
   let total = 0;
+  // Hash while streaming so callers get a content address without re-reading the file.
+  const hash = createHash("sha256");
   stream.on("data", (chunk) => {
     total += Buffer.isBuffer(chunk) ? chunk.length : Buffer.byteLength(chunk);
     if (total > maxBytes) {
       stream.destroy(new Error(`Body too large (maxBytes=${maxBytes})`));
+      return;
     }
+    hash.update(chunk);
   });
   await pipeline(stream, fs.createWriteStream(destPath, { mode: 0o644 }));
-  return { bytesWritten: total };
+  return { bytesWritten: total, sha256: hash.digest("hex") };
 }
 